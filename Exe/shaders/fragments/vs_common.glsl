@@ -8,6 +8,12 @@ layout(location = 3) in vec2 inUV;
 layout(location = 4) in vec3 inTangent;
 layout(location = 5) in vec3 inBiTangent;
 
+// Packed vertex inputs, used by version 2 binary meshes instead of the normal, tangent and bitangent above
+// Octahedral encoded normal
+layout(location = 6) in vec2 inPackedNormal;
+// Octahedral encoded tangent in xy, z is 1 if the mesh has no vertex colors, w is the sign of the bitangent
+layout(location = 7) in vec4 inPackedTangent;
+
 // Standard vertex shader outputs
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outColor;
@@ -17,3 +23,33 @@ layout(location = 4) out mat3 outTBN;
 
 // Include the matrices and frame level parameters
 #include "frame_uniforms.glsl"
+
+// Decodes a unit vector stored with octahedral encoding
+vec3 OctDecode(vec2 f) {
+	vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+// Attributes that aren't bound read as zero, so a mesh that has no float normal is using the packed inputs
+bool IsPackedVertex() {
+	return dot(inNormal, inNormal) == 0.0;
+}
+
+vec3 GetVertexNormal() {
+	return IsPackedVertex() ? OctDecode(inPackedNormal) : inNormal;
+}
+
+vec3 GetVertexTangent() {
+	return IsPackedVertex() ? OctDecode(inPackedTangent.xy) : inTangent;
+}
+
+vec3 GetVertexBiTangent() {
+	return IsPackedVertex() ? cross(OctDecode(inPackedNormal), OctDecode(inPackedTangent.xy)) * inPackedTangent.w : inBiTangent;
+}
+
+vec3 GetVertexColor() {
+	return IsPackedVertex() && inPackedTangent.z > 0.5 ? vec3(1.0) : inColor;
+}
@@ -12,12 +12,12 @@ void main() {
 	outWorldPos = (u_Model * vec4(inPosition, 1.0)).xyz;
 
 	// Normals
-	outNormal = mat3(u_NormalMatrix) * inNormal;
+	outNormal = mat3(u_NormalMatrix) * GetVertexNormal();
 
     // We use a TBN matrix for tangent space normal mapping
-    vec3 T = normalize(vec3(mat3(u_NormalMatrix) * inTangent));
-    vec3 B = normalize(vec3(mat3(u_NormalMatrix) * inBiTangent));
-    vec3 N = normalize(vec3(mat3(u_NormalMatrix) * inNormal));
+    vec3 T = normalize(vec3(mat3(u_NormalMatrix) * GetVertexTangent()));
+    vec3 B = normalize(vec3(mat3(u_NormalMatrix) * GetVertexBiTangent()));
+    vec3 N = normalize(vec3(mat3(u_NormalMatrix) * GetVertexNormal()));
     mat3 TBN = mat3(T, B, N);
 
     // We can pass the TBN matrix to the fragment shader to save computation
@@ -27,7 +27,7 @@ void main() {
 	outUV = inUV;
 
 	///////////
-	outColor = inColor;
+	outColor = GetVertexColor();
 
 }
 
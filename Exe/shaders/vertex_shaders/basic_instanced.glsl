@@ -3,7 +3,7 @@
 // Include our common vertex shader attributes and uniforms
 #include "../fragments/vs_common.glsl"
 
-// Attributes 0-5 are used by our common inputs, so let's skip to 8 to leave some space
+// Attributes 0-7 are used by our common inputs, so we start at 8
 // This will consume 4 slots, since it's essentially 4 vec4s in memory
 layout(location = 8) in mat4 inModelTransform;
 // This will consume 3 slots in memory
@@ -18,12 +18,12 @@ void main() {
 	outWorldPos = (inModelTransform * vec4(inPosition, 1.0)).xyz;
 
 	// Normals
-	outNormal = mat3(inNormalMatrix) * inNormal;
+	outNormal = mat3(inNormalMatrix) * GetVertexNormal();
 
     // We use a TBN matrix for tangent space normal mapping
-    vec3 T = normalize(vec3(mat3(inNormalMatrix) * inTangent));
-    vec3 B = normalize(vec3(mat3(inNormalMatrix) * inBiTangent));
-    vec3 N = normalize(vec3(mat3(inNormalMatrix) * inNormal));
+    vec3 T = normalize(vec3(mat3(inNormalMatrix) * GetVertexTangent()));
+    vec3 B = normalize(vec3(mat3(inNormalMatrix) * GetVertexBiTangent()));
+    vec3 N = normalize(vec3(mat3(inNormalMatrix) * GetVertexNormal()));
     mat3 TBN = mat3(T, B, N);
 
     // We can pass the TBN matrix to the fragment shader to save computation
@@ -33,7 +33,7 @@ void main() {
 	outUV = inUV;
 
 	///////////
-	outColor = inColor;
+	outColor = GetVertexColor();
 
 }
 
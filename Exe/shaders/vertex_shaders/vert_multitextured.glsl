@@ -16,11 +16,11 @@ void main() {
 	// Pass vertex pos in world space to frag shader
 	outWorldPos = (u_Model * vec4(inPosition, 1.0)).xyz;
 	// Normals
-	outNormal = mat3(u_NormalMatrix) * inNormal;
+	outNormal = mat3(u_NormalMatrix) * GetVertexNormal();
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
 	///////////
-	outColor = inColor;
+	outColor = GetVertexColor();
 
     // We have some calculation to determine the texture weights
     // In this case, we are going to use cos and sin to generate texture
@@ -38,6 +38,12 @@ layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
 #define FLAG_ENABLE_COOL (1 << 9)
 #define FLAG_ENABLE_CUSTOMLUT (1 << 10)
 
+// Shader variants bake the render flags in at compile time, so flag checks fold
+// to constants and the compiler can strip out any branches that are not taken
+#ifdef RENDER_FLAGS
+#define IsFlagSet(flag) ((RENDER_FLAGS & (flag)) != 0)
+#else
 bool IsFlagSet(uint flag) {
     return (u_Flags & flag) != 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
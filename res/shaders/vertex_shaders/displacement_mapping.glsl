@@ -17,7 +17,7 @@ void main() {
     // We'll use our surface normal for the dispalcement. We could use a normal map,
     // but this should give us OK results. Note that our displacement will be in
     // object space
-    vec3 displacedPos = inPosition + (inNormal * displacement);
+    vec3 displacedPos = inPosition + (GetVertexNormal() * displacement);
 
     // Transform to world position
 	gl_Position = u_ModelViewProjection * vec4(displacedPos, 1.0);
@@ -26,9 +26,9 @@ void main() {
 	outWorldPos = (u_Model * vec4(displacedPos, 1.0)).xyz;
 
     // We use a TBN matrix for tangent space normal mapping
-    vec3 T = normalize(vec3(mat3(u_NormalMatrix) * inTangent));
-    vec3 B = normalize(vec3(mat3(u_NormalMatrix) * inBiTangent));
-    vec3 N = normalize(vec3(mat3(u_NormalMatrix) * inNormal));
+    vec3 T = normalize(vec3(mat3(u_NormalMatrix) * GetVertexTangent()));
+    vec3 B = normalize(vec3(mat3(u_NormalMatrix) * GetVertexBiTangent()));
+    vec3 N = normalize(vec3(mat3(u_NormalMatrix) * GetVertexNormal()));
     mat3 TBN = mat3(T, B, N);
 
     // We can pass the TBN matrix to the fragment shader to save computation
@@ -48,6 +48,6 @@ void main() {
 	outUV = inUV;
 
 	///////////
-	outColor = inColor;
+	outColor = GetVertexColor();
 
 }
\ No newline at end of file
@@ -17,9 +17,9 @@ void main() {
 	gl_Position = u_ViewProjection * vec4(outWorldPos, 1);
 
 	// Normals
-	outNormal = mat3(u_NormalMatrix) * inNormal;
+	outNormal = mat3(u_NormalMatrix) * GetVertexNormal();
 	// Pass our UV coords to the fragment shader
 	outUV = inUV;
-	outColor = inColor;
+	outColor = GetVertexColor();
 }
 
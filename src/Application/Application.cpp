@@ -10,6 +10,7 @@
 #include <filesystem>
 #include "Layers/GLAppLayer.h"
 #include "Utils/FileHelpers.h"
+#include "Utils/AssetPackage.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
 
@@ -22,6 +23,7 @@
 #include "Graphics/Textures/Texture2D.h"
 #include "Graphics/Textures/Texture3D.h"
 #include "Graphics/Textures/TextureCube.h"
+#include "Graphics/Textures/TextureLoader.h"
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Font.h"
 #include "Graphics/GuiBatcher.h"
@@ -112,12 +114,23 @@ void Application::Quit() {
 }
 
 bool Application::LoadScene(const std::string& path) {
-	if (std::filesystem::exists(path)) { 
+	// If the scene has been packed, we serve all of it's assets from the package
+	std::string packagePath = AssetPackage::GetPackagePath(path);
+	if (std::filesystem::exists(packagePath)) {
+		AssetPackage::Mount(packagePath);
+	} else {
+		AssetPackage::Unmount();
+	}
+
+	if (FileHelpers::Exists(path)) { 
 
 		std::string manifestPath = std::filesystem::path(path).stem().string() + "-manifest.json";
-		if (std::filesystem::exists(manifestPath)) {
+		if (FileHelpers::Exists(manifestPath)) {
 			LOG_INFO("Loading manifest from \"{}\"", manifestPath);
-			ResourceManager::LoadManifest(manifestPath);
+			// Preloading lets us do all the file IO and parsing in parallel, rather than one asset at a time as the scene asks for them
+			ResourceManager::LoadManifest(manifestPath, true, [](const ResourceManager::LoadProgress& progress) {
+				LOG_TRACE("Loaded {} ({}/{}, {:.0f}%)", progress.TypeName, progress.Completed, progress.Total, progress.GetPercent() * 100.0f);
+			});
 		}
 
 		Gameplay::Scene::Sptr scene = Gameplay::Scene::Load(path);
@@ -192,6 +205,12 @@ void Application::_Run()
 		// Receive events like input and window position/size changes from GLFW
 		glfwPollEvents();
 
+		// Upload any textures that have finished loading in the background
+		TextureLoader::Update();
+
+		// Track resource usage, and unload cold resources if we're over budget
+		ResourceManager::Update();
+
 		// Handle closing the app via the close button
 		if (glfwWindowShouldClose(_window)) {
 			_isRunning = false;
@@ -312,6 +331,12 @@ void Application::_RegisterClasses()
 	ResourceManager::RegisterType<Font>();
 	ResourceManager::RegisterType<Framebuffer>();
 
+	// Apply the memory budgets from our settings now that the types exist
+	nlohmann::json budgets = JsonGet<nlohmann::json>(_appSettings, "resource_budgets_mb", nlohmann::json::object());
+	for (auto& [typeName, megabytes] : budgets.items()) {
+		ResourceManager::SetMemoryBudget(typeName, megabytes.get<size_t>() * 1024 * 1024);
+	}
+
 	// Register all of our component types so we can load them from files
 	ComponentManager::RegisterType<Camera>();
 	ComponentManager::RegisterType<RenderComponent>();
@@ -519,6 +544,15 @@ nlohmann::json Application::_GetDefaultAppSettings()
 
 	result["window_width"]  = DEFAULT_WINDOW_WIDTH;
 	result["window_height"] = DEFAULT_WINDOW_HEIGHT;
+
+	// Memory budgets for resource types, in megabytes, keyed by the type's name in the manifest
+	result["resource_budgets_mb"] = {
+		{ StringTools::SanitizeClassName(typeid(Texture2D).name()),              512 },
+		{ StringTools::SanitizeClassName(typeid(TextureCube).name()),            256 },
+		{ StringTools::SanitizeClassName(typeid(Texture3D).name()),              64 },
+		{ StringTools::SanitizeClassName(typeid(Gameplay::MeshResource).name()), 256 },
+		{ StringTools::SanitizeClassName(typeid(Font).name()),                   32 }
+	};
 	return result;
 }
 
@@ -185,7 +185,11 @@ void DefaultSceneLayer::_CreateScene()
 		toonLut->SetWrap(WrapMode::ClampToEdge);
 
 		// Here we'll load in the cubemap, as well as a special shader to handle drawing the skybox
-		TextureCube::Sptr testCubemap = ResourceManager::CreateAsset<TextureCube>("cubemaps/ocean/ocean.jpg");
+		// The skybox is our biggest texture, so we store it block compressed
+		TextureCubeDescription skyboxDescription = TextureCubeDescription();
+		skyboxDescription.Filename = "cubemaps/ocean/ocean.jpg";
+		skyboxDescription.UseCompression = true;
+		TextureCube::Sptr testCubemap = ResourceManager::CreateAsset<TextureCube>(skyboxDescription);
 		ShaderProgram::Sptr      skyboxShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
 			{ ShaderPartType::Vertex, "shaders/vertex_shaders/skybox_vert.glsl" },
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/skybox_frag.glsl" }
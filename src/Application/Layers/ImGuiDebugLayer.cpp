@@ -5,6 +5,10 @@
 #include "Gameplay/Scene.h"
 #include "../Timing.h"
 #include "Utils/Windows/FileDialogs.h"
+#include "Utils/ObjParser.h"
+#include "Utils/TangentGenerator.h"
+#include "Gameplay/Physics/PhysicsStressTest.h"
+#include "Gameplay/Physics/PhysicsBenchmark.h"
 #include <filesystem>
 #include "RenderLayer.h"
 #include "../Windows/HierarchyWindow.h"
@@ -12,6 +16,7 @@
 #include "../Windows/MaterialsWindow.h"
 #include "../Windows/TextureWindow.h"
 #include "../Windows/DebugWindow.h"
+#include "../Windows/GpuMemoryWindow.h"
 
 ImGuiDebugLayer::ImGuiDebugLayer() :
 	ApplicationLayer(),
@@ -33,6 +38,7 @@ void ImGuiDebugLayer::OnAppLoad(const nlohmann::json& config)
 	RegisterWindow<MaterialsWindow>();
 	RegisterWindow<TextureWindow>();
 	RegisterWindow<DebugWindow>();
+	RegisterWindow<GpuMemoryWindow>();
 }
 
 void ImGuiDebugLayer::OnAppUnload()
@@ -175,6 +181,46 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 					}
 				}
 
+				// Packs a saved scene and everything it references into a single file
+				if (ImGui::MenuItem("Package Scene", NULL, false)) {
+					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json\0\0");
+					if (path.has_value()) {
+						AssetPackage::Build(path.value());
+					}
+				}
+
+				// Compares the OBJ loaders on a file, results are written to the log
+				if (ImGui::MenuItem("Benchmark OBJ Loaders", NULL, false)) {
+					std::optional<std::string> path = FileDialogs::OpenFile("OBJ File\0*.obj\0\0");
+					if (path.has_value()) {
+						ObjParser::Benchmark(path.value());
+					}
+				}
+
+				// Times tangent generation on a generated 1M triangle mesh, results are written to the log
+				if (ImGui::MenuItem("Benchmark Tangent Generation", NULL, false)) {
+					TangentGenerator::Benchmark();
+				}
+
+				// Scenes with thousands of falling boxes, for comparing physics step times in the debug window
+				if (ImGui::MenuItem("Physics Stress Test", NULL, false)) {
+					app.LoadScene(Gameplay::Physics::PhysicsStressTest::CreateScene(4000, false));
+				}
+				if (ImGui::MenuItem("Physics Stress Test (Multithreaded)", NULL, false)) {
+					app.LoadScene(Gameplay::Physics::PhysicsStressTest::CreateScene(4000, true));
+				}
+
+				// Steps a fresh copy of a scene without rendering it, and writes the time spent in each physics phase to the log
+				if (ImGui::MenuItem("Benchmark Physics (Current Scene File)", NULL, false, !app.CurrentScene()->GetFilePath().empty())) {
+					Gameplay::Physics::PhysicsBenchmark::RunFile(app.CurrentScene()->GetFilePath());
+					// Awaking the benchmark's scene replaced our lights and shader settings
+					app.CurrentScene()->SetupShaderAndLights();
+				}
+				if (ImGui::MenuItem("Benchmark Physics Broadphases", NULL, false)) {
+					Gameplay::Physics::PhysicsBenchmark::CompareBroadphases();
+					app.CurrentScene()->SetupShaderAndLights();
+				}
+
 				ImGui::EndMenu();
 			}
 
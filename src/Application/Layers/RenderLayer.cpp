@@ -27,6 +27,7 @@ RenderLayer::RenderLayer() :
 {
 	Name = "Rendering";
 	Overrides = AppLayerFunctions::OnAppLoad | AppLayerFunctions::OnRender | AppLayerFunctions::OnWindowResize;
+	SetRenderFlags(RenderFlags::None);
 }
 
 RenderLayer::~RenderLayer() = default;
@@ -132,10 +133,10 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 		// Note: This is a good reason why we should be sorting the render components in ComponentManager
 		if (renderable->GetMaterial() != currentMat) {
 			currentMat = renderable->GetMaterial();
-			shader = currentMat->GetShader();
+			shader = _GetShaderVariant(currentMat->GetShader());
 
 			shader->Bind();
-			currentMat->Apply();
+			currentMat->Apply(shader);
 		}
 
 		// Grab the game object so we can do some stuff with it
@@ -153,7 +154,8 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	});
 
 	// Use our cubemap to draw our skybox
-	app.CurrentScene()->DrawSkybox();
+	ShaderProgram::Sptr skyboxShader = app.CurrentScene()->GetSkyboxShader();
+	app.CurrentScene()->DrawSkybox(skyboxShader != nullptr ? _GetShaderVariant(skyboxShader) : nullptr);
 
 	// Unbind our primary framebuffer so subsequent draw calls do not modify it
 	//_primaryFBO->Unbind();
@@ -227,8 +229,17 @@ void RenderLayer::SetClearColor(const glm::vec4 & value) {
 
 void RenderLayer::SetRenderFlags(RenderFlags value) {
 	_renderFlags = value;
+
+	// Shaders see the flags as a compile time constant, see fragments/frame_uniforms.glsl
+	_variantDefines ={ "RENDER_FLAGS " + std::to_string(*_renderFlags) };
 }
 
 RenderFlags RenderLayer::GetRenderFlags() const {
 	return _renderFlags;
 }
+
+ShaderProgram::Sptr RenderLayer::_GetShaderVariant(const ShaderProgram::Sptr& shader) {
+	// Variants are compiled on first use and cached in the shader, keyed on our flags
+	ShaderProgram::Sptr variant = shader->GetVariant(*_renderFlags, _variantDefines);
+	return variant != nullptr ? variant : shader;
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "../ApplicationLayer.h"
 #include "Graphics/Framebuffer.h"
 #include "Graphics/Buffers/UniformBuffer.h"
+#include "Graphics/ShaderProgram.h"
 
 ENUM_FLAGS(RenderFlags, uint32_t,
 	None = 0,
@@ -89,4 +90,13 @@ protected:
 
 	const int INSTANCE_UBO_BINDING = 1;
 	UniformBuffer<InstanceLevelUniforms>::Sptr _instanceUniforms;
+
+	// The defines that shader variants are built with for the current render flags
+	std::vector<std::string> _variantDefines;
+
+	/// <summary>
+	/// Gets the variant of a shader that has the current render flags baked in, or
+	/// the shader itself if the variant could not be built
+	/// </summary>
+	ShaderProgram::Sptr _GetShaderVariant(const ShaderProgram::Sptr& shader);
 };
\ No newline at end of file
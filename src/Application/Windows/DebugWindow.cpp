@@ -2,6 +2,7 @@
 #include "Application/Application.h"
 #include "Application/ApplicationLayer.h"
 #include "Application/Layers/RenderLayer.h"
+#include "Gameplay/Physics/CollisionShapeCache.h"
 
 DebugWindow::DebugWindow() :
 	IEditorWindow()
@@ -23,6 +24,11 @@ void DebugWindow::RenderMenuBar()
 	if (BulletDebugDraw::DrawModeGui("Physics Debug Mode:", physicsDrawMode)) {
 		app.CurrentScene()->SetPhysicsDebugDrawMode(physicsDrawMode);
 	}
+	ImGui::Text("Physics: %.2fms%s", app.CurrentScene()->GetPhysicsStepTime() * 1000.0, app.CurrentScene()->GetMultithreadedPhysics() ? " (multithreaded)" : "");
+	const Gameplay::Scene::PhysicsSyncStats& syncStats = app.CurrentScene()->GetPhysicsSyncStats();
+	ImGui::Text("Transforms Pushed: %d (%d skipped)", syncStats.Pushed, syncStats.PushSkipped);
+	ImGui::Text("Transforms Pulled: %d (%d asleep)", syncStats.Pulled, syncStats.PullSkipped);
+	ImGui::Text("Collision Shapes: %zu (%zu users)", Gameplay::Physics::CollisionShapeCache::GetShapeCount(), Gameplay::Physics::CollisionShapeCache::GetReferenceCount());
 
 	ImGui::Separator();
 
@@ -0,0 +1,76 @@
+#include "GpuMemoryWindow.h"
+#include <vector>
+#include <algorithm>
+
+/**
+ * Formats a size in bytes as a human readable string (ex: 12.50 MB)
+ */
+static std::string FormatBytes(size_t bytes) {
+	static const char* units[] = { "B", "KB", "MB", "GB" };
+	double value = (double)bytes;
+	int unit = 0;
+	while (value >= 1024.0 && unit < 3) {
+		value /= 1024.0;
+		unit++;
+	}
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.2f %s", value, units[unit]);
+	return buffer;
+}
+
+GpuMemoryWindow::GpuMemoryWindow() :
+	IEditorWindow(),
+	_nameFilter("")
+{
+	Name = "GPU Memory";
+	ParentName = "Materials";
+	SplitDirection = ImGuiDir_::ImGuiDir_Right;
+	SplitDepth = 0.5f;
+}
+
+GpuMemoryWindow::~GpuMemoryWindow() = default;
+
+void GpuMemoryWindow::Render()
+{
+	std::map<std::string, IGraphicsResource::MemoryStats> byType = IGraphicsResource::GetGpuMemoryUsageByType();
+
+	size_t count = 0;
+	for (const auto& [type, stats] : byType) {
+		count += stats.Count;
+	}
+	ImGui::Text("Total: %s in %d resources", FormatBytes(IGraphicsResource::GetTotalGpuMemoryUsage()).c_str(), (int)count);
+	ImGui::Separator();
+
+	if (ImGui::CollapsingHeader("By Type", ImGuiTreeNodeFlags_DefaultOpen)) {
+		_RenderTable("gpu_by_type", "Type", byType);
+	}
+	if (ImGui::CollapsingHeader("By Name")) {
+		ImGui::InputText("Filter", _nameFilter, sizeof(_nameFilter));
+		_RenderTable("gpu_by_name", "Name", IGraphicsResource::GetGpuMemoryUsageByName(), _nameFilter);
+	}
+}
+
+void GpuMemoryWindow::_RenderTable(const char* id, const char* label, const std::map<std::string, IGraphicsResource::MemoryStats>& stats, const std::string& filter)
+{
+	// Largest first, so the things worth looking at are at the top
+	std::vector<std::pair<std::string, IGraphicsResource::MemoryStats>> rows(stats.begin(), stats.end());
+	std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+		return a.second.Bytes > b.second.Bytes;
+	});
+
+	ImGui::Columns(3, id);
+	ImGui::Text("%s", label); ImGui::NextColumn();
+	ImGui::Text("Count"); ImGui::NextColumn();
+	ImGui::Text("Memory"); ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (const auto& [name, row] : rows) {
+		if (!filter.empty() && name.find(filter) == std::string::npos) {
+			continue;
+		}
+		ImGui::Text("%s", name.c_str()); ImGui::NextColumn();
+		ImGui::Text("%d", (int)row.Count); ImGui::NextColumn();
+		ImGui::Text("%s", FormatBytes(row.Bytes).c_str()); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Application/IEditorWindow.h"
+#include "Graphics/IGraphicsResource.h"
+
+/**
+ * Displays how much GPU memory our graphics resources are using, grouped by type and by debug name
+ */
+class GpuMemoryWindow final : public IEditorWindow {
+public:
+	MAKE_PTRS(GpuMemoryWindow);
+	GpuMemoryWindow();
+	virtual ~GpuMemoryWindow();
+
+	// Inherited from IEditorWindow
+
+	virtual void Render() override;
+
+protected:
+	// Only names containing this text will be shown
+	char _nameFilter[128];
+
+	/**
+	 * Renders a table of memory stats, sorted from largest to smallest
+	 * @param id The ImGui ID for the table
+	 * @param label The header for the first column
+	 * @param stats The stats to display
+	 * @param filter Only rows containing this text will be shown, or empty to show all rows
+	 */
+	void _RenderTable(const char* id, const char* label, const std::map<std::string, IGraphicsResource::MemoryStats>& stats, const std::string& filter = "");
+};
@@ -61,7 +61,15 @@ namespace Gameplay {
 	}
 
 	void Material::Apply() {
-		if (_shader != nullptr) {
+		Apply(_shader);
+	}
+
+	void Material::Apply(const ShaderProgram::Sptr& shader) {
+		if (shader != nullptr) {
+			// If we're targeting a different program (ex: a variant), uniform locations
+			// need to be looked up by name, since they may differ from our shader's
+			const bool remap = shader != _shader;
+
 			// Skip the reserved # of texture slots
 			int textureSlot = 0;
 			
@@ -71,6 +79,8 @@ namespace Gameplay {
 				// ex: float, matrix, texture, etc...
 				ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
 
+				int location = remap ? shader->GetUniformLocation(name) : data.Location;
+
 				// If the uniform is a texture, we try and bind it, then move to the next slot
 				if (typeCode == ShaderDataTypecode::Texture) {
 					if (textureSlot >= MAX_TEXTURE_SLOTS) {
@@ -85,13 +95,15 @@ namespace Gameplay {
 							ITexture::Unbind(textureSlot);
 						}
 						// Send the slot to the shader
-						_shader->SetUniform(data.Location, data.Type, &textureSlot);
+						if (location != -1) {
+							shader->SetUniform(location, data.Type, &textureSlot);
+						}
 						textureSlot++;
 					}
 				}
 				// The uniform is a plain ol' value type, send it in
-				else {
-					_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+				else if (location != -1) {
+					shader->SetUniform(location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
 				}
 			}
 		}
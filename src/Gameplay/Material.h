@@ -65,6 +65,12 @@ namespace Gameplay {
 		/// Will bind the shader, update material uniforms, and bind textures
 		/// </summary>
 		virtual void Apply();
+		/// <summary>
+		/// Applies this material's state to a different shader than the one the material was
+		/// created with, for instance a variant of the material's shader. Uniforms are matched by name
+		/// </summary>
+		/// <param name="shader">The shader to send the material's uniforms to</param>
+		void Apply(const ShaderProgram::Sptr& shader);
 
 		/// <summary>
 		/// Renders some UI controls for manipulating a material at runtime
@@ -1,15 +1,27 @@
 #include "MeshResource.h"
 #include <filesystem>
+#include <cstdio>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/ObjParser.h"
+#include "Utils/FileHelpers.h"
 
 namespace Gameplay {
+	std::mutex MeshResource::_prefetchMutex;
+	std::unordered_map<std::string, std::shared_ptr<ObjMeshData>> MeshResource::_prefetched;
+	std::mutex MeshResource::_generatedMutex;
+	std::unordered_map<uint64_t, MeshResource::GeneratedMesh> MeshResource::_generatedMeshes;
+
 	MeshResource::MeshResource() :
 		IResource(),
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		CpuData(nullptr),
+		ConvexHull(nullptr),
+		HullGeneration(0),
+		KeepCpuData(false)
 	{ }
 
 	MeshResource::MeshResource(const std::string& filename) :
@@ -17,7 +29,10 @@ namespace Gameplay {
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		CpuData(nullptr),
+		ConvexHull(nullptr),
+		HullGeneration(0),
+		KeepCpuData(false)
 	{
 		Mesh = ObjLoader::LoadFromFile(filename);
 	}
@@ -36,29 +51,53 @@ namespace Gameplay {
 		} else {
 			result["filename"] = Filename.empty() ? "null" : Filename;
 		}
+		if (KeepCpuData) {
+			result["keep_cpu_data"] = true;
+		}
 		return result;
 	}
 
+	size_t MeshResource::GetMemoryUsage() const {
+		return (Mesh != nullptr ? Mesh->GetBufferMemoryUsage() : 0) +
+			(CpuData != nullptr ? CpuData->GetMemoryUsage() : 0);
+	}
+
 	MeshResource::Sptr MeshResource::FromJson(const nlohmann::json & blob)
 	{
 		MeshResource::Sptr result = std::make_shared<MeshResource>();
+		result->KeepCpuData = JsonGet(blob, "keep_cpu_data", false);
 		if (blob.contains("params") && blob["params"].is_array()) {
 			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
-			MeshBuilder<VertexPosNormTexColTangents> mesh;
 			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result->MeshBuilderParams.push_back(p);
-				MeshFactory::AddParameterized(mesh, p);
+				result->MeshBuilderParams.push_back(MeshBuilderParam::FromJson(meshbuilderParams[ix]));
 			}
-			MeshFactory::CalculateTBN(mesh);
-			result->Mesh = mesh.Bake();
+			result->Mesh = _GetGeneratedMesh(result->MeshBuilderParams, result->KeepCpuData ? &result->CpuData : nullptr);
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
-			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
+			if (result->Filename != "null" && FileHelpers::Exists(result->Filename)) {
 				#ifdef OPTIMIZED_OBJ_LOADER
-				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
+				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename, result->KeepCpuData ? &result->CpuData : nullptr);
 				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
+				// If the mesh was already parsed on a worker thread, we only need to upload it
+				std::shared_ptr<ObjMeshData> prefetched = nullptr;
+				{
+					std::lock_guard<std::mutex> lock(_prefetchMutex);
+					auto it = _prefetched.find(result->Filename);
+					if (it != _prefetched.end()) {
+						prefetched = it->second;
+						_prefetched.erase(it);
+					}
+				}
+				if (prefetched == nullptr) {
+					prefetched = std::make_shared<ObjMeshData>();
+					ObjParser::ParseFile(result->Filename, *prefetched);
+				}
+				MeshBuilder<VertexPosNormTexCol> mesh;
+				prefetched->ToMesh(mesh);
+				result->Mesh = mesh.Bake();
+				if (result->KeepCpuData) {
+					result->CpuData = MeshCpuData::FromBuilder(mesh);
+				}
 				#endif
 
 			}
@@ -66,13 +105,111 @@ namespace Gameplay {
 		return result;
 	}
 
+	void MeshResource::PrefetchJson(const nlohmann::json& blob) {
+		// Generated meshes are cheap enough to just build in FromJson
+		std::string filename = JsonGet<std::string>(blob, "filename", "null");
+		if (filename == "null" || blob.contains("params") || !FileHelpers::Exists(filename)) {
+			return;
+		}
+
+		#ifdef OPTIMIZED_OBJ_LOADER
+		// Converting to a binary file is the expensive part, loading the result is quick. The loader makes sure
+		// that two resources sharing a file don't convert it at once, while different files convert in parallel
+		if (std::filesystem::path(filename).extension() == ".obj") {
+			OptimizedObjLoader::ConvertIfStale(filename);
+		}
+		#else
+		// Prefetches already run in parallel with each other, but a single large file can still keep a
+		// worker busy for a long time, so let the parser split it up across the pool as well
+		std::shared_ptr<ObjMeshData> mesh = std::make_shared<ObjMeshData>();
+		if (ObjParser::ParseFile(filename, *mesh)) {
+			std::lock_guard<std::mutex> lock(_prefetchMutex);
+			_prefetched[filename] = mesh;
+		}
+		#endif
+	}
+
+	void MeshResource::ClearPrefetched() {
+		std::lock_guard<std::mutex> lock(_prefetchMutex);
+		_prefetched.clear();
+	}
+
 	void MeshResource::GenerateMesh() {
-		MeshBuilder<VertexPosNormTexColTangents> mesh;
-		for (auto& param : MeshBuilderParams) {
-			MeshFactory::AddParameterized(mesh, param);
+		// Anything we worked out from the old mesh is out of date now, colliders will rebuild the hull when they next need it
+		CpuData = nullptr;
+		ConvexHull = nullptr;
+		HullGeneration++;
+		Mesh = _GetGeneratedMesh(MeshBuilderParams, KeepCpuData ? &CpuData : nullptr);
+	}
+
+	std::string MeshResource::GetGeneratedCachePath(uint64_t paramsHash) {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(paramsHash));
+		return (std::filesystem::path("cache") / "meshes" / name).string();
+	}
+
+	std::string MeshResource::GetConvexHullCachePath() const {
+		if (!Filename.empty() && Filename != "null") {
+			return std::filesystem::path(Filename).replace_extension(".hull").string();
+		} else if (!MeshBuilderParams.empty()) {
+			return std::filesystem::path(GetGeneratedCachePath(MeshBuilderParam::Hash(MeshBuilderParams))).replace_extension(".hull").string();
 		}
-		MeshFactory::CalculateTBN(mesh);
-		Mesh = mesh.Bake();
+		return "";
+	}
+
+	VertexArrayObject::Sptr MeshResource::_GetGeneratedMesh(const std::vector<MeshBuilderParam>& params, MeshCpuData::Sptr* cpuData) {
+		uint64_t hash = MeshBuilderParam::Hash(params);
+
+		// We hold the lock while building, so that resources sharing params don't build the same mesh at once
+		std::lock_guard<std::mutex> lock(_generatedMutex);
+
+		// Another resource already has this mesh loaded. If we need CPU data and nobody kept it, we load it all again
+		auto it = _generatedMeshes.find(hash);
+		if (it != _generatedMeshes.end()) {
+			VertexArrayObject::Sptr existing = it->second.Mesh.lock();
+			MeshCpuData::Sptr existingCpuData = it->second.CpuData.lock();
+			if (existing != nullptr && (cpuData == nullptr || existingCpuData != nullptr)) {
+				if (cpuData != nullptr) {
+					*cpuData = existingCpuData;
+				}
+				return existing;
+			}
+		}
+
+		// Built in a previous run, only needs to be uploaded. Files from an older binary format fail to load and get rebuilt
+		VertexArrayObject::Sptr result = nullptr;
+		std::string cachePath = GetGeneratedCachePath(hash);
+		if (FileHelpers::Exists(cachePath)) {
+			result = OptimizedObjLoader::LoadFromFile(cachePath, cpuData);
+		}
+
+		if (result == nullptr) {
+			std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>> mesh = std::make_shared<MeshBuilder<VertexPosNormTexColTangents>>();
+			for (const auto& param : params) {
+				MeshFactory::AddParameterized(*mesh, param);
+			}
+			MeshFactory::CalculateTBN(*mesh);
+			result = mesh->Bake();
+			if (cpuData != nullptr) {
+				*cpuData = MeshCpuData::FromBuilder(*mesh);
+			}
+
+			// Optimizing and packing the mesh for the cache is slower than generating it, so that's done in the background
+			if (mesh->GetIndexCount() > 0) {
+				std::error_code error;
+				std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+				if (!error) {
+					OptimizedObjLoader::SavePackedBinaryFileAsync(mesh, cachePath);
+				}
+			}
+		}
+
+		GeneratedMesh& entry = _generatedMeshes[hash];
+		entry.Mesh = result;
+		if (cpuData != nullptr) {
+			entry.CpuData = *cpuData;
+		}
+		return result;
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
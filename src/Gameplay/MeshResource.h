@@ -1,10 +1,11 @@
 #pragma once
+#include <mutex>
+#include <unordered_map>
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Utils/MeshFactory.h"
-
-// bullet triangle mesh pre-declaration
-class btTriangleMesh;
+#include "Utils/ObjParser.h"
+#include "Utils/MeshCpuData.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -40,19 +41,33 @@ namespace Gameplay {
 		/// The VAO for rendering this mesh in OpenGL
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
-
+		/// <summary>
+		/// A CPU side copy of the mesh's positions and indices, kept when KeepCpuData is set so that
+		/// colliders don't need to read the mesh back from the GPU. Counts towards the mesh memory budget. May be null
+		/// </summary>
+		MeshCpuData::Sptr               CpuData;
 
 		/// <summary>
 		/// The optional mesh resource for generating colliders from this mesh
 		/// </summary>
 		MeshResource::Sptr             ColliderMeshData;
 		/// <summary>
-		/// Allows for bullet to generate a triangle mesh from this mesh and cache it
+		/// The points of the reduced convex hull of this mesh, shared between all convex colliders using it
+		/// </summary>
+		std::shared_ptr<const std::vector<glm::vec3>> ConvexHull;
+		/// <summary>
+		/// Incremented each time the mesh is regenerated, so that hulls from older versions of this mesh can be told apart
 		/// </summary>
-		std::shared_ptr<btTriangleMesh> BulletTriMesh;
+		uint32_t                       HullGeneration;
 
 		/// <summary>
-		/// Generates a new mesh from the mesh builder parameters
+		/// True if this mesh should keep a CPU copy of it's positions and indices when it is loaded or generated.
+		/// Off by default, since convex colliders can read the mesh back from the GPU (and usually have a cached hull)
+		/// </summary>
+		bool                           KeepCpuData;
+
+		/// <summary>
+		/// Generates a new mesh from the mesh builder parameters, clearing the CPU data and convex hull of the old mesh
 		/// </summary>
 		void GenerateMesh();
 		/// <summary>
@@ -64,6 +79,47 @@ namespace Gameplay {
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
+		virtual size_t GetMemoryUsage() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+		/// <summary>
+		/// Parses (or converts) the mesh file for a manifest entry ahead of FromJson, called from worker threads
+		/// </summary>
+		static void PrefetchJson(const nlohmann::json& blob);
+		/// <summary>
+		/// Drops any meshes that were prefetched but never loaded (ex: the load failed)
+		/// </summary>
+		static void ClearPrefetched();
+
+		/// <summary>
+		/// Gets the path that the mesh generated from a set of mesh builder params is cached to
+		/// </summary>
+		/// <param name="paramsHash">The hash of the params, see MeshBuilderParam::Hash</param>
+		static std::string GetGeneratedCachePath(uint64_t paramsHash);
+		/// <summary>
+		/// Gets the path that the convex hull of this mesh is cached to, next to the mesh's file
+		/// </summary>
+		std::string GetConvexHullCachePath() const;
+
+	protected:
+		/// <summary>
+		/// Gets the VAO for a set of mesh builder params. Meshes are shared between resources with the same params while
+		/// they are in use, and are saved to the disk cache after they are first generated
+		/// </summary>
+		/// <param name="params">The params to generate the mesh from</param>
+		/// <param name="cpuData">If not null, will receive a CPU copy of the mesh's positions and indices</param>
+		static VertexArrayObject::Sptr _GetGeneratedMesh(const std::vector<MeshBuilderParam>& params, MeshCpuData::Sptr* cpuData = nullptr);
+
+		struct GeneratedMesh {
+			std::weak_ptr<VertexArrayObject> Mesh;
+			std::weak_ptr<MeshCpuData>       CpuData;
+		};
+
+		// Generated meshes that are currently loaded, by the hash of their params
+		static std::mutex _generatedMutex;
+		static std::unordered_map<uint64_t, GeneratedMesh> _generatedMeshes;
+
+		// Meshes that have been parsed by PrefetchJson, waiting for FromJson to upload them
+		static std::mutex _prefetchMutex;
+		static std::unordered_map<std::string, std::shared_ptr<ObjMeshData>> _prefetched;
 	};
 }
\ No newline at end of file
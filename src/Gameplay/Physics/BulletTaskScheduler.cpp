@@ -0,0 +1,72 @@
+#include "Gameplay/Physics/BulletTaskScheduler.h"
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include "Utils/ThreadPool.h"
+
+/// <summary>
+/// Tells bullet that tasks are running for the duration of a parallel loop, even if the loop throws
+/// </summary>
+struct ThreadsRunningScope {
+	ThreadsRunningScope() { btPushThreadsAreRunning(); }
+	~ThreadsRunningScope() { btPopThreadsAreRunning(); }
+};
+
+BulletTaskScheduler::BulletTaskScheduler() :
+	btITaskScheduler("ThreadPool"),
+	// Bullet's per thread storage is a fixed size, so large pools only lend it some of their workers
+	_numThreads(std::min(static_cast<int>(ThreadPool::Get().GetThreadCount()) + 1, BT_MAX_THREAD_COUNT))
+{
+	// Bullet gives out thread indices in the order threads first ask for one, and expects the main thread to be 0
+	btGetCurrentThreadIndex();
+}
+
+BulletTaskScheduler::~BulletTaskScheduler() = default;
+
+int BulletTaskScheduler::getMaxNumThreads() const {
+	return _numThreads;
+}
+
+int BulletTaskScheduler::getNumThreads() const {
+	return _numThreads;
+}
+
+void BulletTaskScheduler::setNumThreads(int numThreads) {
+	// Our pool has a fixed size, and bullet sizes it's per thread storage from getNumThreads
+}
+
+void BulletTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) {
+	if (iEnd <= iBegin) {
+		return;
+	}
+	ThreadsRunningScope running;
+	ThreadPool::Get().ParallelFor(static_cast<size_t>(iEnd - iBegin), static_cast<size_t>(std::max(grainSize, 1)), [&](size_t begin, size_t end) {
+		body.forLoop(iBegin + static_cast<int>(begin), iBegin + static_cast<int>(end));
+	}, static_cast<uint32_t>(_numThreads));
+}
+
+btScalar BulletTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) {
+	if (iEnd <= iBegin) {
+		return btScalar(0);
+	}
+
+	// Each chunk gets it's own slot, and they're added in order so that the result doesn't depend on timing
+	size_t chunkSize = static_cast<size_t>(std::max(grainSize, 1));
+	size_t count = static_cast<size_t>(iEnd - iBegin);
+	std::vector<btScalar> sums((count + chunkSize - 1) / chunkSize, btScalar(0));
+	ThreadsRunningScope running;
+	ThreadPool::Get().ParallelFor(count, chunkSize, [&](size_t begin, size_t end) {
+		sums[begin / chunkSize] = body.sumLoop(iBegin + static_cast<int>(begin), iBegin + static_cast<int>(end));
+	}, static_cast<uint32_t>(_numThreads));
+	return std::accumulate(sums.begin(), sums.end(), btScalar(0));
+}
+
+BulletTaskScheduler* BulletTaskScheduler::Get() {
+	static BulletTaskScheduler scheduler;
+	if (btGetTaskScheduler() != &scheduler) {
+		btSetTaskScheduler(&scheduler);
+	}
+	return &scheduler;
+}
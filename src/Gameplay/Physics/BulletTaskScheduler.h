@@ -0,0 +1,34 @@
+#pragma once
+#include "LinearMath/btThreads.h"
+
+/// <summary>
+/// Implements the btITaskScheduler interface on top of our shared ThreadPool, so that bullet's
+/// multithreaded world uses the same workers as the rest of the engine instead of starting it's own
+///
+/// Bullet only runs tasks on other threads when it was built with BT_THREADSAFE
+/// </summary>
+class BulletTaskScheduler final : public btITaskScheduler
+{
+public:
+	BulletTaskScheduler();
+	virtual ~BulletTaskScheduler();
+
+	// Inherited from btITaskScheduler
+
+	virtual int getMaxNumThreads() const override;
+	virtual int getNumThreads() const override;
+	virtual void setNumThreads(int numThreads) override;
+	virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+	virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+	/// <summary>
+	/// Gets the shared scheduler, and makes it bullet's active task scheduler. Should be called
+	/// from the main thread before creating any multithreaded bullet objects
+	/// </summary>
+	static BulletTaskScheduler* Get();
+
+private:
+	// The main thread plus the pool's workers, up to BT_MAX_THREAD_COUNT. Only this many threads may ever run bullet
+	// tasks, since bullet gives each thread an index the first time it calls in
+	int _numThreads;
+};
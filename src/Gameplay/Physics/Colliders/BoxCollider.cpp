@@ -29,6 +29,10 @@ namespace Gameplay::Physics {
 		blob["extents"] = _extents;
 	}
 
+	void BoxCollider::HashShape(ShapeKey& key) const {
+		key.Add(_extents);
+	}
+
 	void BoxCollider::DrawImGui() {
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat3, "Extents  ", &_extents.x, 0.01f, 0.01f);
 	}
@@ -25,6 +25,11 @@ namespace Gameplay::Physics {
 		blob["height"] = _height;
 	}
 
+	void CapsuleCollider::HashShape(ShapeKey& key) const {
+		key.Add(_radius);
+		key.Add(_height);
+	}
+
 	void CapsuleCollider::FromJson(const nlohmann::json& data)
 	{
 		_radius = data["radius"];
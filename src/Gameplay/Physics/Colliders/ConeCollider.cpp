@@ -25,6 +25,11 @@ namespace Gameplay::Physics {
 		blob["height"] = _height;
 	}
 
+	void ConeCollider::HashShape(ShapeKey& key) const {
+		key.Add(_radius);
+		key.Add(_height);
+	}
+
 	void ConeCollider::FromJson(const nlohmann::json & data)
 	{
 		_radius = data["radius"];
@@ -39,6 +39,7 @@ namespace Gameplay::Physics {
 		virtual void DrawImGui() override;
 		virtual void ToJson(nlohmann::json& blob) const override;
 		virtual void FromJson(const nlohmann::json& data) override;
+		virtual void HashShape(ShapeKey& key) const override;
 
 	protected:
 		virtual btCollisionShape* CreateShape() const override;
@@ -1,13 +1,21 @@
 #include "ConvexMeshCollider.h"
 #include <BulletCollision/CollisionShapes/btShapeHull.h>
+#include <filesystem>
+#include <cstring>
 
 #include "Gameplay/GameObject.h"
 #include "Gameplay/MeshResource.h"
 #include "Gameplay/Components/RenderComponent.h"
 
 #include "Utils/GlmBulletConversions.h"
+#include "Utils/FileHelpers.h"
+#include "Utils/MemoryMappedFile.h"
 
 namespace Gameplay::Physics {
+	// Identifies our hull cache files, and the version of their layout
+	static const char HULL_HEADER_BYTES[4] = { 'H', 'U', 'L', 'L' };
+	static const uint32_t HULL_VERSION = 1;
+
 	ConvexMeshCollider::Sptr ConvexMeshCollider::Create() {
 		return std::shared_ptr<ConvexMeshCollider>(new ConvexMeshCollider());
 	}
@@ -16,25 +24,22 @@ namespace Gameplay::Physics {
 
 	ConvexMeshCollider::ConvexMeshCollider() :
 		ICollider(ColliderType::ConvexMesh),
-		_triMesh(nullptr)
+		_hull(nullptr),
+		_meshGuid(),
+		_hullGeneration(0)
 	{ }
 
 	btCollisionShape* ConvexMeshCollider::CreateShape() const {
-		// https://pybullet.org/Bullet/phpBB3/viewtopic.php?t=4513
-		if (_triMesh == nullptr) {
+		if (_hull == nullptr || _hull->empty()) {
 			return nullptr;
 		}
-		btConvexShape* result = new btConvexTriangleMeshShape(_triMesh);
-
-		// The hull shape will calculate the convex hull that contains our shape
-		//btShapeHull* hull = new btShapeHull(result);
-		//float margin = result->getMargin();
-		//bool build = hull->buildHull(margin);
-		//if (!build) {
-		//	LOG_WARN("Failed to build hull for convex mesh");
-		//}
-		//delete hull;
 
+		// The hull was already reduced, so bullet only needs to copy the points
+		btConvexHullShape* result = new btConvexHullShape();
+		for (const glm::vec3& point : *_hull) {
+			result->addPoint(btVector3(point.x, point.y, point.z), false);
+		}
+		result->recalcLocalAabb();
 		return result;
 	}
 
@@ -54,112 +59,203 @@ namespace Gameplay::Physics {
 		if (mesh->ColliderMeshData != nullptr) {
 			mesh = mesh->ColliderMeshData;
 		}
+		_meshGuid = mesh->GetGUID();
+		_hullGeneration = mesh->HullGeneration;
 
-		// We've already calculated the mesh, use existing
-		if (mesh->BulletTriMesh != nullptr) {
-			_triMesh = mesh->BulletTriMesh.get();
+		// We've already calculated the hull, use existing
+		if (mesh->ConvexHull != nullptr) {
+			_hull = mesh->ConvexHull;
+			return;
 		}
-		// We need to calculate the triangle mesh from the mesh data
-		else {
-			// Get the VAO from the mesh and make sure it exists
-			VertexArrayObject::Sptr vao = mesh->Mesh;
-			if (vao == nullptr) {
-				LOG_WARN("Mesh resource not fully configured!");
+
+		// See if we calculated the hull in a previous run. Generated meshes are cached by the hash of their params,
+		// so their hull can never be out of date
+		std::string hullPath = mesh->GetConvexHullCachePath();
+		bool isGenerated = mesh->Filename.empty() || mesh->Filename == "null";
+		if (!hullPath.empty() && (isGenerated ? FileHelpers::Exists(hullPath) : FileHelpers::IsNewerThan(hullPath, { mesh->Filename }))) {
+			std::shared_ptr<std::vector<glm::vec3>> hull = _LoadHull(hullPath);
+			if (hull != nullptr) {
+				mesh->ConvexHull = hull;
+				_hull = hull;
 				return;
 			}
+		}
 
-			// Get the vertex declaration from the VAO so we can pull out positions
-			const VertexArrayObject::VertexDeclaration& VDecl = vao->GetVDecl();
-			if (VDecl.size() == 0) {
-				LOG_WARN("Mesh does not have a vertex declaration, unable to determine position elements");
+		// We need to calculate the hull from the mesh data, reading it back from the GPU if we didn't keep a copy
+		MeshCpuData::Sptr cpuData = mesh->CpuData;
+		if (cpuData == nullptr) {
+			if (mesh->Mesh == nullptr) {
+				LOG_WARN("Mesh resource not fully configured!");
 				return;
 			}
-
-			// Get the attribute for positions from the vertex declaration
-			auto& it = std::find_if(VDecl.begin(), VDecl.end(), [](const BufferAttribute& attrib) {
-				return attrib.Usage == AttribUsage::Position;
-			});
-			if (it == VDecl.end()) {
-				LOG_WARN("Mesh vertex declaration does not have a position element");
+			cpuData = _ReadBackMesh(mesh->Mesh);
+			if (cpuData == nullptr) {
 				return;
 			}
-			BufferAttribute posAttrib = *it;
-
-			// Get the VBO that contains our data about the position elements
-			const auto* vertBuff = vao->GetBufferBinding(AttribUsage::Position);
-			if (vertBuff != nullptr) {
-				// Shorthand our buffers
-				IndexBuffer::Sptr indexBuff = vao->GetIndexBuffer();
-				VertexBuffer::Sptr vertexBuff = vertBuff->GetBuffer();
-
-				// Create the bullet physics triangle mesh
-				_triMesh = new btTriangleMesh();
-
-				// Helper for extracting an int from a raw index buffer datastore
-				auto getBufferIndex = [](IndexBuffer::Sptr buff, uint8_t* dataStore, int offset) {
-					switch (buff->GetElementType())
-					{
-						case IndexType::UByte:
-							return (int)*(dataStore + offset);
-						case IndexType::UShort:
-							return (int)*(reinterpret_cast<uint16_t*>(dataStore) + offset);
-						case IndexType::UInt:
-							return (int)*(reinterpret_cast<uint32_t*>(dataStore) + offset);
-						case IndexType::Unknown:
-						default:
-							return 0;
-					}
-				};
-
-				// Allocate some space to read data from OpenGL and read our buffer data back into CPU memory
-				uint8_t* vertexStore = reinterpret_cast<uint8_t*>(malloc(vertexBuff->GetTotalSize()));
-				glGetNamedBufferSubData(vertexBuff->GetHandle(), 0, vertexBuff->GetTotalSize(), vertexStore);
-				_triMesh->preallocateVertices(vao->GetVertexCount());
-
-				// If our data is indexed, we use the index buffer to add our triangles
-				if (indexBuff != nullptr) {
-					// Allocate and read space for the indices
-					uint8_t* indexStore = reinterpret_cast<uint8_t*>(malloc(indexBuff->GetTotalSize()));
-					glGetNamedBufferSubData(indexBuff->GetHandle(), 0, indexBuff->GetTotalSize(), indexStore);
-
-					// Iterate over index triangles
-					for (size_t ix = 0; ix < indexBuff->GetElementCount(); ix+=3) {
-						// Extract index from the raw data
-						int i1 = getBufferIndex(indexBuff, indexStore, static_cast<int>(ix));
-						int i2 = getBufferIndex(indexBuff, indexStore, static_cast<int>(ix + 1));
-						int i3 = getBufferIndex(indexBuff, indexStore, static_cast<int>(ix + 2));
-
-						// Find the positions for the indices
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + (posAttrib.Stride * i1) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + (posAttrib.Stride * i2) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + (posAttrib.Stride * i3) + posAttrib.Offset);
-
-						// Add the triangle
-						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
-					}
-			
-					// Free the data we copied the indices into
-					free(indexStore);
+		}
 
+		std::shared_ptr<std::vector<glm::vec3>> hull = _BuildHull(*cpuData);
+		if (hull == nullptr) {
+			return;
+		}
+
+		// Store the hull in the MeshResource so other colliders can share it, and save it for next time
+		mesh->ConvexHull = hull;
+		_hull = hull;
+		if (!hullPath.empty()) {
+			_SaveHull(hullPath, *hull);
+		}
+	}
+
+	MeshCpuData::Sptr ConvexMeshCollider::_ReadBackMesh(const VertexArrayObject::Sptr& vao) {
+		// Get the vertex declaration from the VAO so we can pull out positions
+		const VertexArrayObject::VertexDeclaration& VDecl = vao->GetVDecl();
+		if (VDecl.size() == 0) {
+			LOG_WARN("Mesh does not have a vertex declaration, unable to determine position elements");
+			return nullptr;
+		}
+
+		// Get the attribute for positions from the vertex declaration
+		auto it = std::find_if(VDecl.begin(), VDecl.end(), [](const BufferAttribute& attrib) {
+			return attrib.Usage == AttribUsage::Position;
+		});
+		if (it == VDecl.end()) {
+			LOG_WARN("Mesh vertex declaration does not have a position element");
+			return nullptr;
+		}
+		BufferAttribute posAttrib = *it;
+
+		// Get the VBO that contains our data about the position elements
+		const auto* vertBuff = vao->GetBufferBinding(AttribUsage::Position);
+		if (vertBuff == nullptr) {
+			return nullptr;
+		}
+
+		// Shorthand our buffers
+		IndexBuffer::Sptr indexBuff = vao->GetIndexBuffer();
+		VertexBuffer::Sptr vertexBuff = vertBuff->GetBuffer();
+
+		MeshCpuData::Sptr result = std::make_shared<MeshCpuData>();
+
+		// Read our buffer data back into CPU memory, and pull out the positions
+		std::vector<uint8_t> vertexStore(vertexBuff->GetTotalSize());
+		glGetNamedBufferSubData(vertexBuff->GetHandle(), 0, vertexBuff->GetTotalSize(), vertexStore.data());
+		result->Positions.resize(vertexBuff->GetElementCount());
+		for (size_t ix = 0; ix < result->Positions.size(); ix++) {
+			memcpy(&result->Positions[ix], vertexStore.data() + (posAttrib.Stride * ix) + posAttrib.Offset, sizeof(glm::vec3));
+		}
+
+		// If our data is indexed, we read back the indices as well
+		if (indexBuff != nullptr) {
+			std::vector<uint8_t> indexStore(indexBuff->GetTotalSize());
+			glGetNamedBufferSubData(indexBuff->GetHandle(), 0, indexBuff->GetTotalSize(), indexStore.data());
+
+			result->Indices.resize(indexBuff->GetElementCount());
+			for (size_t ix = 0; ix < result->Indices.size(); ix++) {
+				switch (indexBuff->GetElementType()) {
+					case IndexType::UByte:
+						result->Indices[ix] = indexStore[ix];
+						break;
+					case IndexType::UShort:
+						result->Indices[ix] = reinterpret_cast<uint16_t*>(indexStore.data())[ix];
+						break;
+					case IndexType::UInt:
+						result->Indices[ix] = reinterpret_cast<uint32_t*>(indexStore.data())[ix];
+						break;
+					case IndexType::Unknown:
+					default:
+						result->Indices[ix] = 0;
+						break;
 				}
-				// We only have vertex data, create triangles sequentially
-				else {
-					// Iterate over triangles, and add each to the mesh
-					for (size_t ix = 0; ix < vertexBuff->GetElementCount(); ix+=3) {
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 0) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 1) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 2) * posAttrib.Stride) + posAttrib.Offset);
-						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
-					}
-				}
+			}
+		}
+		// We only have vertex data, create triangles sequentially
+		else {
+			result->Indices.resize(result->Positions.size());
+			for (uint32_t ix = 0; ix < result->Indices.size(); ix++) {
+				result->Indices[ix] = ix;
+			}
+		}
 
-				// free our vertex store data
-				free(vertexStore);
+		return result;
+	}
 
-				// Store the bullet tri mesh in the MeshResource in case we want it later
-				mesh->BulletTriMesh = std::shared_ptr<btTriangleMesh>(_triMesh);
+	std::shared_ptr<std::vector<glm::vec3>> ConvexMeshCollider::_BuildHull(const MeshCpuData& mesh) {
+		// Only points that are part of a triangle should be in the hull
+		std::vector<bool> used(mesh.Positions.size(), false);
+		btConvexHullShape fullHull;
+		for (uint32_t index : mesh.Indices) {
+			if (index < used.size() && !used[index]) {
+				used[index] = true;
+				const glm::vec3& point = mesh.Positions[index];
+				fullHull.addPoint(btVector3(point.x, point.y, point.z), false);
 			}
 		}
+		if (fullHull.getNumPoints() == 0) {
+			LOG_WARN("Convex mesh does not have any triangles");
+			return nullptr;
+		}
+		fullHull.recalcLocalAabb();
+
+		// https://pybullet.org/Bullet/phpBB3/viewtopic.php?t=4513
+		// The hull shape will calculate the convex hull that contains our shape, with far fewer points than the mesh
+		btShapeHull reduced(&fullHull);
+		if (!reduced.buildHull(fullHull.getMargin())) {
+			LOG_WARN("Failed to build hull for convex mesh");
+			return nullptr;
+		}
+
+		std::shared_ptr<std::vector<glm::vec3>> result = std::make_shared<std::vector<glm::vec3>>();
+		result->resize(reduced.numVertices());
+		for (int ix = 0; ix < reduced.numVertices(); ix++) {
+			(*result)[ix] = ToGlm(reduced.getVertexPointer()[ix]);
+		}
+		return result;
+	}
+
+	std::shared_ptr<std::vector<glm::vec3>> ConvexMeshCollider::_LoadHull(const std::string& filename) {
+		// Mapping the file lets hulls be served from the mounted asset package
+		MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
+		if (file == nullptr) {
+			return nullptr;
+		}
+
+		const size_t headerSize = sizeof(HULL_HEADER_BYTES) + sizeof(uint32_t) * 2;
+		const uint8_t* data = file->GetData();
+		uint32_t version = 0;
+		uint32_t count = 0;
+		if (file->GetSize() >= headerSize) {
+			memcpy(&version, data + sizeof(HULL_HEADER_BYTES), sizeof(uint32_t));
+			memcpy(&count, data + sizeof(HULL_HEADER_BYTES) + sizeof(uint32_t), sizeof(uint32_t));
+		}
+		if (file->GetSize() < headerSize || memcmp(data, HULL_HEADER_BYTES, sizeof(HULL_HEADER_BYTES)) != 0 || version != HULL_VERSION || count == 0) {
+			LOG_WARN("\"{}\" is not a valid hull file, rebuilding", filename);
+			return nullptr;
+		}
+
+		if (file->GetSize() < headerSize + count * sizeof(glm::vec3)) {
+			LOG_WARN("\"{}\" is truncated, rebuilding", filename);
+			return nullptr;
+		}
+
+		std::shared_ptr<std::vector<glm::vec3>> result = std::make_shared<std::vector<glm::vec3>>(count);
+		memcpy(result->data(), data + headerSize, count * sizeof(glm::vec3));
+		return result;
+	}
+
+	void ConvexMeshCollider::_SaveHull(const std::string& filename, const std::vector<glm::vec3>& points) {
+		namespace fs = std::filesystem;
+		std::error_code error;
+		fs::create_directories(fs::path(filename).parent_path(), error);
+
+		FileHelpers::WriteFileAtomic(filename, [&](std::ostream& file) {
+			uint32_t count = static_cast<uint32_t>(points.size());
+			file.write(HULL_HEADER_BYTES, sizeof(HULL_HEADER_BYTES));
+			file.write(reinterpret_cast<const char*>(&HULL_VERSION), sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(&count), sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(glm::vec3));
+			return true;
+		});
 	}
 
 	void ConvexMeshCollider::FromJson(const nlohmann::json& data) {
@@ -168,6 +264,13 @@ namespace Gameplay::Physics {
 	void ConvexMeshCollider::ToJson(nlohmann::json& blob) const {
 	}
 
+	void ConvexMeshCollider::HashShape(ShapeKey& key) const {
+		// Colliders on the same version of a mesh share the same hull, unless we failed to build it
+		key.AddBytes(_meshGuid.bytes(), 16);
+		key.Add(_hullGeneration);
+		key.Add(_hull != nullptr);
+	}
+
 	void ConvexMeshCollider::DrawImGui() {
 	}
 }
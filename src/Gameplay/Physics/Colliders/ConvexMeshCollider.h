@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Gameplay/Physics/ICollider.h"
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/MeshCpuData.h"
 
 namespace Gameplay::Physics {
 	/// <summary>
@@ -17,11 +19,30 @@ namespace Gameplay::Physics {
 		virtual void DrawImGui() override;
 		virtual void ToJson(nlohmann::json& blob) const override;
 		virtual void FromJson(const nlohmann::json& data) override;
+		virtual void HashShape(ShapeKey& key) const override;
 
 	protected:
-		btTriangleMesh* _triMesh;
+		// The points of the reduced hull, shared with the mesh resource
+		std::shared_ptr<const std::vector<glm::vec3>> _hull;
+		// The mesh the hull was built from, and it's hull generation when we got the hull
+		Guid     _meshGuid;
+		uint32_t _hullGeneration;
 		ConvexMeshCollider();
 
 		virtual btCollisionShape* CreateShape() const override;
+
+		/// <summary>
+		/// Reads the positions and indices of a mesh back from the GPU, for meshes that were loaded without keeping CPU data
+		/// </summary>
+		static MeshCpuData::Sptr _ReadBackMesh(const VertexArrayObject::Sptr& vao);
+		/// <summary>
+		/// Builds the reduced convex hull of the triangles in a mesh
+		/// </summary>
+		static std::shared_ptr<std::vector<glm::vec3>> _BuildHull(const MeshCpuData& mesh);
+		/// <summary>
+		/// Loads a hull saved by _SaveHull, returns nullptr if the file is missing or invalid
+		/// </summary>
+		static std::shared_ptr<std::vector<glm::vec3>> _LoadHull(const std::string& filename);
+		static void _SaveHull(const std::string& filename, const std::vector<glm::vec3>& points);
 	};
 }
\ No newline at end of file
@@ -24,6 +24,10 @@ namespace Gameplay::Physics {
 		blob["half_extents"] = (_extents);
 	}
 
+	void CylinderCollider::HashShape(ShapeKey& key) const {
+		key.Add(_extents);
+	}
+
 	void CylinderCollider::FromJson(const nlohmann::json & data)
 	{
 		_extents = (data["half_extents"]);
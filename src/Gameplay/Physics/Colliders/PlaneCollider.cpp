@@ -23,6 +23,10 @@ namespace Gameplay::Physics {
 		blob["normal"] = (_normal);
 	}
 
+	void PlaneCollider::HashShape(ShapeKey& key) const {
+		key.Add(_normal);
+	}
+
 	void PlaneCollider::FromJson(const nlohmann::json& data) {
 		_normal = (data["normal"]);
 	}
@@ -36,6 +36,10 @@ namespace Gameplay::Physics {
 		blob["radius"] = _radius;
 	}
 
+	void SphereCollider::HashShape(ShapeKey& key) const {
+		key.Add(_radius);
+	}
+
 	void SphereCollider::DrawImGui() {
 		_isDirty |= LABEL_LEFT(ImGui::DragFloat, "Radius", &_radius, 0.01f);
 	}
@@ -0,0 +1,121 @@
+#include "Gameplay/Physics/CollisionShapeCache.h"
+
+#include "Utils/GlmBulletConversions.h"
+#include "Logging.h"
+
+namespace Gameplay::Physics {
+	std::unordered_map<uint64_t, CollisionShapeCache::Entry> CollisionShapeCache::_entries;
+	std::unordered_map<const btCompoundShape*, uint64_t> CollisionShapeCache::_keys;
+
+	btCompoundShape* CollisionShapeCache::Acquire(const std::vector<ICollider::Sptr>& colliders, const glm::vec3& baseScale, const glm::vec3& scale) {
+		uint64_t key = _GetKey(colliders, baseScale, scale);
+
+		auto it = _entries.find(key);
+		if (it == _entries.end()) {
+			Entry entry;
+			entry.RefCount = 0;
+			entry.Children.resize(colliders.size(), nullptr);
+
+			// Colliders are added after the object's starting scale, so only changes in scale since then affect them
+			entry.Shape = new btCompoundShape(true, static_cast<int>(colliders.size()));
+			entry.Shape->setLocalScaling(ToBt(baseScale));
+			for (size_t ix = 0; ix < colliders.size(); ix++) {
+				const ICollider::Sptr& collider = colliders[ix];
+				btCollisionShape* child = collider->CreateShape();
+				if (child == nullptr) {
+					continue;
+				}
+
+				// We convert our shape parameters to a bullet transform
+				btTransform transform;
+				transform.setIdentity();
+				transform.setOrigin(ToBt(collider->_position));
+				transform.setRotation(ToBt(glm::quat(glm::radians(collider->_rotation))));
+				child->setLocalScaling(ToBt(collider->_scale));
+
+				entry.Shape->addChildShape(transform, child);
+				entry.Children[ix] = child;
+			}
+			if (scale != baseScale) {
+				entry.Shape->setLocalScaling(ToBt(scale));
+			}
+
+			_keys[entry.Shape] = key;
+			it = _entries.emplace(key, std::move(entry)).first;
+		}
+
+		Entry& entry = it->second;
+		entry.RefCount++;
+		for (size_t ix = 0; ix < colliders.size(); ix++) {
+			colliders[ix]->_shape = entry.Children[ix];
+		}
+		return entry.Shape;
+	}
+
+	void CollisionShapeCache::Release(btCompoundShape* shape) {
+		auto keyIt = _keys.find(shape);
+		if (keyIt == _keys.end()) {
+			LOG_WARN("Releasing a shape that did not come from the shape cache!");
+			return;
+		}
+
+		auto it = _entries.find(keyIt->second);
+		Entry& entry = it->second;
+		if (--entry.RefCount == 0) {
+			for (btCollisionShape* child : entry.Children) {
+				delete child;
+			}
+			delete entry.Shape;
+			_entries.erase(it);
+			_keys.erase(keyIt);
+		}
+	}
+
+	bool CollisionShapeCache::TryRescale(btCompoundShape* shape, const std::vector<ICollider::Sptr>& colliders, const glm::vec3& baseScale, const glm::vec3& scale) {
+		auto keyIt = _keys.find(shape);
+		if (keyIt == _keys.end()) {
+			return false;
+		}
+
+		// Other objects still need the old scale, and if another object has our new scale we should share with it
+		auto it = _entries.find(keyIt->second);
+		uint64_t newKey = _GetKey(colliders, baseScale, scale);
+		if (it->second.RefCount != 1 || _entries.count(newKey) != 0) {
+			return false;
+		}
+
+		Entry entry = std::move(it->second);
+		_entries.erase(it);
+		entry.Shape->setLocalScaling(ToBt(scale));
+		_entries.emplace(newKey, std::move(entry));
+		keyIt->second = newKey;
+		return true;
+	}
+
+	size_t CollisionShapeCache::GetShapeCount() {
+		return _entries.size();
+	}
+
+	size_t CollisionShapeCache::GetReferenceCount() {
+		size_t result = 0;
+		for (const auto& [key, entry] : _entries) {
+			result += entry.RefCount;
+		}
+		return result;
+	}
+
+	uint64_t CollisionShapeCache::_GetKey(const std::vector<ICollider::Sptr>& colliders, const glm::vec3& baseScale, const glm::vec3& scale) {
+		ShapeKey key;
+		key.Add(baseScale);
+		key.Add(scale);
+		key.Add(colliders.size());
+		for (const auto& collider : colliders) {
+			key.Add(static_cast<int>(collider->_type));
+			key.Add(collider->_position);
+			key.Add(collider->_rotation);
+			key.Add(collider->_scale);
+			collider->HashShape(key);
+		}
+		return key.Hash;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+#include "Gameplay/Physics/ICollider.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Shares the compound shapes built for physics objects, so that objects with the same colliders and
+	/// scale use a single set of bullet shapes. Shapes are reference counted, and are deleted once the last
+	/// object using them releases them
+	/// </summary>
+	class CollisionShapeCache {
+	public:
+		CollisionShapeCache() = delete;
+
+		/// <summary>
+		/// Gets a compound shape containing the given colliders, building it if no other object is using it.
+		/// Each collider's shape will be set to the matching child of the compound
+		/// </summary>
+		/// <param name="colliders">The colliders to add to the shape</param>
+		/// <param name="baseScale">The scale of the object when it first built it's shape, colliders are added after this scale is applied</param>
+		/// <param name="scale">The current scale of the object</param>
+		/// <returns>A shape that must be given back with Release</returns>
+		static btCompoundShape* Acquire(const std::vector<ICollider::Sptr>& colliders, const glm::vec3& baseScale, const glm::vec3& scale);
+		/// <summary>
+		/// Releases a shape from Acquire, deleting it if no other objects are using it
+		/// </summary>
+		/// <param name="shape">The shape to release</param>
+		static void Release(btCompoundShape* shape);
+		/// <summary>
+		/// Changes the scale of a shape from Acquire without re-creating it. Only works if the caller is the
+		/// only one using the shape and no other shape already has the new scale, otherwise the caller should
+		/// Acquire a new shape instead
+		/// </summary>
+		/// <param name="shape">The shape to rescale</param>
+		/// <param name="colliders">The colliders the shape was built from</param>
+		/// <param name="baseScale">The scale of the object when it first built it's shape</param>
+		/// <param name="scale">The new scale of the object</param>
+		/// <returns>True if the shape was rescaled in place</returns>
+		static bool TryRescale(btCompoundShape* shape, const std::vector<ICollider::Sptr>& colliders, const glm::vec3& baseScale, const glm::vec3& scale);
+
+		/// <summary>
+		/// Gets the number of unique shapes that are currently in use
+		/// </summary>
+		static size_t GetShapeCount();
+		/// <summary>
+		/// Gets the number of objects that are currently using a shape from the cache
+		/// </summary>
+		static size_t GetReferenceCount();
+
+	protected:
+		struct Entry {
+			btCompoundShape*               Shape;
+			// The shape for each collider, in the same order as the colliders (may contain nulls)
+			std::vector<btCollisionShape*> Children;
+			uint32_t                       RefCount;
+		};
+
+		/// <summary>
+		/// Hashes everything that affects the shape made from a set of colliders, so that colliders that
+		/// would produce the same shape have the same key. This runs whenever an object's scale changes
+		/// </summary>
+		static uint64_t _GetKey(const std::vector<ICollider::Sptr>& colliders, const glm::vec3& baseScale, const glm::vec3& scale);
+
+		static std::unordered_map<uint64_t, Entry> _entries;
+		static std::unordered_map<const btCompoundShape*, uint64_t> _keys;
+	};
+}
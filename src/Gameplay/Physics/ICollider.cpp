@@ -21,27 +21,21 @@ namespace Gameplay::Physics {
 	ICollider::ICollider(ColliderType type) :
 		_type(type),
 		_shape(nullptr),
+		_isDirty(true),
 		_position(glm::vec3(0.0f)),
 		_rotation(glm::vec3(0.0f)),
 		_scale(glm::vec3(1.0f)),
 		_guid(Guid::New())
 	{ }
 
-	ICollider::~ICollider() {
-		if (_shape != nullptr) {
-			delete _shape;
-			_shape = nullptr;
-		}
-	}
+	// Our shape belongs to the CollisionShapeCache, and is cleaned up when our physics object releases it
+	ICollider::~ICollider() = default;
 
 	ColliderType ICollider::GetType() const {
 		return _type;
 	}
 
 	btCollisionShape* ICollider::GetShape() const {
-		if (_shape == nullptr) {
-			_shape = CreateShape();
-		}
 		return _shape;
 	}
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <type_traits>
 #include <json.hpp>
 #include <EnumToString.h>
 #include <GLM/glm.hpp>
@@ -44,6 +47,28 @@ namespace Gameplay::Physics {
 	// of all collider types
 	extern const char* ColliderTypeComboNames;
 
+	/// <summary>
+	/// Builds an FNV-1a hash of everything that affects a collision shape, used by the CollisionShapeCache to
+	/// find colliders that can share their shapes
+	/// </summary>
+	struct ShapeKey {
+		uint64_t Hash = 0xcbf29ce484222325ull;
+
+		void AddBytes(const void* data, size_t size) {
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+			for (size_t ix = 0; ix < size; ix++) {
+				Hash ^= bytes[ix];
+				Hash *= 0x100000001b3ull;
+			}
+		}
+
+		template <typename T>
+		void Add(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be added to a shape key");
+			AddBytes(&value, sizeof(T));
+		}
+	};
+
 	/// <summary>
 	/// Base class for collider types,
 	/// will be inherited from for all collider types
@@ -76,6 +101,18 @@ namespace Gameplay::Physics {
 		/// </summary>
 		/// <param name="data">The JSON data to unpack into this instance</param>
 		virtual void FromJson(const nlohmann::json& data) = 0;
+		/// <summary>
+		/// Adds everything that affects the shape made by CreateShape to a key. Colliders with the same type,
+		/// transform and shape key share their shapes, see CollisionShapeCache. Defaults to hashing ToJson,
+		/// which is slow enough that colliders should override it
+		/// </summary>
+		/// <param name="key">The key to add to</param>
+		virtual void HashShape(ShapeKey& key) const {
+			nlohmann::json blob;
+			ToJson(blob);
+			std::string dump = blob.dump();
+			key.AddBytes(dump.data(), dump.size());
+		}
 
 		/// <summary>
 		/// Allows colliders to perform initialization on object awake, 
@@ -89,7 +126,8 @@ namespace Gameplay::Physics {
 		/// </summary>
 		virtual ColliderType GetType() const;
 		/// <summary>
-		/// Gets this collider's bullet collision shape
+		/// Gets this collider's bullet collision shape, or nullptr if it has not been added
+		/// to a physics object yet. The shape may be shared with other colliders
 		/// </summary>
 		btCollisionShape* GetShape() const;
 
@@ -144,7 +182,7 @@ namespace Gameplay::Physics {
 	protected:
 		// Stores type 
 		ColliderType _type;
-		// Stores shape, note that mutable lets us modify in const functions
+		// Stores shape, owned by the CollisionShapeCache. Note that mutable lets us modify in const functions
 		mutable btCollisionShape* _shape;
 		mutable bool _isDirty;
 
@@ -159,6 +197,7 @@ namespace Gameplay::Physics {
 	private:
 		// Allow RigidBody to access protected and private members
 		friend class PhysicsBase;
+		friend class CollisionShapeCache;
 
 		// These are private so derived classes don't accidentally use these
 		glm::vec3 _position;
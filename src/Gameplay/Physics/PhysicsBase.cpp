@@ -2,6 +2,7 @@
 
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Scene.h"
+#include "Gameplay/Physics/CollisionShapeCache.h"
 
 #include "Utils/GlmBulletConversions.h"
 #include "Utils/ImGuiHelper.h"
@@ -17,12 +18,15 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		_isShapeDirty(true),
 		_collisionGroup(0x01),
 		_collisionMask(0xFFFFFFFF),
-		_prevScale(glm::vec3(1.0f))
+		_prevScale(glm::vec3(1.0f)),
+		_baseScale(glm::vec3(1.0f)),
+		_syncedPosition(glm::vec3(0.0f)),
+		_syncedRotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f))
 	{ }
 
 	PhysicsBase::~PhysicsBase() {
-		if (_scene != nullptr) {
-			delete _shape;
+		if (_shape != nullptr) {
+			CollisionShapeCache::Release(_shape);
 		}
 	}
 
@@ -147,59 +151,71 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 	}
 
 	void PhysicsBase::RemoveCollider(const ICollider::Sptr& collider) {
-		auto& it = std::find(_colliders.begin(), _colliders.end(), collider);
+		auto it = std::find(_colliders.begin(), _colliders.end(), collider);
 		if (it != _colliders.end()) {
-			if (collider->GetShape() != nullptr) {
-				_shape->removeChildShape(collider->GetShape());
-				_isShapeDirty = true;
-			}
+			// Our shape may be shared, so we switch to one without the collider instead of modifying it
 			_colliders.erase(it);
+			collider->_shape = nullptr;
+			_isShapeDirty = true;
 		}
 	}
 
 
-	void PhysicsBase::_AddColliderToShape(ICollider* collider) {
-		// Create the bullet collision shape from the collider
-		btCollisionShape* newShape = collider->CreateShape();
-		collider->_shape = newShape;
-
-		// If the shape actually exists
-		if (newShape != nullptr) {
-			// We convert our shape parameters to a bullet transform
-			btTransform transform;
-			transform.setIdentity();
-			transform.setOrigin(ToBt(collider->_position));
-			transform.setRotation(ToBt(glm::quat(glm::radians(collider->_rotation))));
-			newShape->setLocalScaling(ToBt(collider->_scale));
+	void PhysicsBase::_RebuildShape() {
+		// Grab the new shape before releasing the old one, so that shapes we share with ourselves aren't rebuilt
+		btCompoundShape* oldShape = _shape;
+		_shape = CollisionShapeCache::Acquire(_colliders, _baseScale, _prevScale);
+		for (auto& collider : _colliders) {
+			collider->_isDirty = false;
+		}
+		_isShapeDirty = false;
 
-			// Add the shape to the compound shape
-			_shape->addChildShape(transform, newShape);
+		btCollisionObject* object = _GetCollisionObject();
+		if (object != nullptr) {
+			object->setCollisionShape(_shape);
+			// Sleeping bodies need to wake up to notice that their shape has changed
+			object->activate();
 
 			// Remove any existing collision manifolds, so that our body can properly be updated with it's new shape
 			if (_scene != nullptr) {
 				_scene->GetPhysicsWorld()->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_GetBroadphaseHandle(), _scene->GetPhysicsWorld()->getDispatcher());
 			}
+		}
 
-			// Our inertia has changed, so flag mass as dirty so it's recalculated
-			_isShapeDirty = true;
+		if (oldShape != nullptr) {
+			CollisionShapeCache::Release(oldShape);
+		}
+	}
+
+	void PhysicsBase::_RescaleShape() {
+		// If our colliders have changed, the shape needs rebuilding anyways
+		bool isDirty = _isShapeDirty || _shape == nullptr;
+		for (auto& collider : _colliders) {
+			isDirty |= collider->_isDirty;
+		}
+
+		// Objects that scale every frame would otherwise re-create their shapes and contacts every frame
+		if (isDirty || !CollisionShapeCache::TryRescale(_shape, _colliders, _baseScale, _prevScale)) {
+			_RebuildShape();
+			return;
+		}
+
+		btCollisionObject* object = _GetCollisionObject();
+		if (object != nullptr) {
+			object->activate();
 		}
 	}
 
 	bool PhysicsBase::_HandleShapeDirty() {
-		bool wasDirty = false;
+		bool wasDirty = _isShapeDirty;
 		for (auto& collider : _colliders) {
-			if (collider->_isDirty) {
-				// If the collider already had a shape, delete it
-				if (collider->_shape != nullptr) {
-					_shape->removeChildShape(collider->_shape);
-					delete collider->_shape;
-				}
-				_AddColliderToShape(collider.get());
-				collider->_isDirty = false;
-				wasDirty = true;
-			}
+			wasDirty |= collider->_isDirty;
 		}
 
+		// Shapes can be shared with other objects, so any change means switching to a different shape
+		if (wasDirty) {
+			_RebuildShape();
+		}
 		return wasDirty;
 	}
 
@@ -224,9 +240,8 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		transform.setOrigin(ToBt(context->GetPosition()));	 
 		transform.setRotation(ToBt(context->GetRotation()));
 		if (context->GetScale() != _prevScale) {
-			_shape->setLocalScaling(ToBt(context->GetScale()));
-			_scene->GetPhysicsWorld()->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_GetBroadphaseHandle(), _scene->GetPhysicsWorld()->getDispatcher());
 			_prevScale = context->GetScale();
+			_RescaleShape();
 		}
 	}
 
@@ -237,4 +252,27 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		context->SetPostion(ToGlm(transform.getOrigin()));
 		context->SetRotation(ToGlm(transform.getRotation()));
 	}
+
+	bool PhysicsBase::_HasGameobjectMoved() const {
+		GameObject* context = GetGameObject();
+		return context->GetPosition() != _syncedPosition || context->GetRotation() != _syncedRotation;
+	}
+
+	void PhysicsBase::_MarkGameobjectSynced() {
+		GameObject* context = GetGameObject();
+		_syncedPosition = context->GetPosition();
+		_syncedRotation = context->GetRotation();
+	}
+
+	void PhysicsBase::_CountPush(bool synced) {
+		if (_scene != nullptr) {
+			(synced ? _scene->_physicsSyncStats.Pushed : _scene->_physicsSyncStats.PushSkipped)++;
+		}
+	}
+
+	void PhysicsBase::_CountPull(bool synced) {
+		if (_scene != nullptr) {
+			(synced ? _scene->_physicsSyncStats.Pulled : _scene->_physicsSyncStats.PullSkipped)++;
+		}
+	}
 }
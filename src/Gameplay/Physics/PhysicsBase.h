@@ -1,4 +1,6 @@
 #pragma once
+#include <GLM/gtc/quaternion.hpp>
+
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Physics/ICollider.h"
 
@@ -89,7 +91,7 @@ namespace Gameplay {
 		protected:
 			Scene*        _scene;
 
-			// Stores the bullet shape associated with the physics object
+			// Stores the bullet shape associated with the physics object, shared through the CollisionShapeCache
 			btCompoundShape* _shape;
 
 			// List of colliders and whether they have been changed
@@ -102,6 +104,13 @@ namespace Gameplay {
 			mutable bool _isGroupMaskDirty;
 
 			glm::vec3 _prevScale;
+			// The scale of the object when it first built it's shape
+			glm::vec3 _baseScale;
+
+			// The gameobject transform we last sent to or got back from Bullet, if it's changed since
+			// then it's been moved by outside code
+			glm::vec3 _syncedPosition;
+			glm::quat _syncedRotation;
 
 			PhysicsBase();
 
@@ -110,8 +119,10 @@ namespace Gameplay {
 			void ToJsonBase(nlohmann::json& output) const;
 			void FromJsonBase(const nlohmann::json& input);
 
-			// Handles adding a collider to our compound shape
-			void _AddColliderToShape(ICollider* collider);
+			// Replaces our compound shape with one from the shape cache that matches our current colliders and scale
+			void _RebuildShape();
+			// Applies a change in scale to our shape, scaling it in place when nothing else shares it
+			void _RescaleShape();
 
 			// Handles resolving any dirty state stuff for our object
 			bool _HandleShapeDirty();
@@ -122,8 +133,19 @@ namespace Gameplay {
 			void _CopyGameobjectTransformTo(btTransform& transform);
 			void _CopyGameobjectTransformFrom(const btTransform& transform);
 
+			// Checks whether the gameobject has been moved since we last synced it with Bullet
+			bool _HasGameobjectMoved() const;
+			// Marks the gameobject's current transform as matching Bullet
+			void _MarkGameobjectSynced();
+
+			// Adds an object to the scene's transform sync counts for this frame
+			void _CountPush(bool synced);
+			void _CountPull(bool synced);
+
 			// Gets the bullet broadphase proxy that we can use for clearing collisions
 			virtual btBroadphaseProxy* _GetBroadphaseHandle() = 0;
+			// Gets the bullet object that our shape is attached to, or nullptr if it hasn't been created yet
+			virtual btCollisionObject* _GetCollisionObject() = 0;
 
 			static int _editorSelectedColliderType;
 		};
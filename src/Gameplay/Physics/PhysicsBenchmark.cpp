@@ -0,0 +1,128 @@
+#include "Gameplay/Physics/PhysicsBenchmark.h"
+
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#include <LinearMath/btQuickprof.h>
+
+#include "Gameplay/Physics/PhysicsStressTest.h"
+#include "Utils/FileHelpers.h"
+
+namespace Gameplay::Physics {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// The time spent in the Bullet zones we care about while a benchmark is running, in seconds
+	struct ZoneTotals {
+		double Broadphase;
+		double Narrowphase;
+		double Solver;
+	};
+
+	// Zones are only tracked on the thread running the benchmark, the multithreaded world enters
+	// zones on it's worker threads as well, but those are already covered by the main thread's zones
+	static std::thread::id BenchmarkThread;
+	static std::vector<std::pair<const char*, Clock::time_point>> ZoneStack;
+	static ZoneTotals Totals;
+
+	void PhysicsBenchmark::_EnterProfileZone(const char* name) {
+		if (std::this_thread::get_id() == BenchmarkThread) {
+			ZoneStack.push_back({ name, Clock::now() });
+		}
+	}
+
+	void PhysicsBenchmark::_LeaveProfileZone() {
+		if (std::this_thread::get_id() != BenchmarkThread || ZoneStack.empty()) {
+			return;
+		}
+		std::chrono::duration<double> elapsed = Clock::now() - ZoneStack.back().second;
+		const char* name = ZoneStack.back().first;
+		ZoneStack.pop_back();
+
+		// These are the zone names used by btDiscreteDynamicsWorld and btCollisionWorld
+		if (strcmp(name, "updateAabbs") == 0 || strcmp(name, "calculateOverlappingPairs") == 0) {
+			Totals.Broadphase += elapsed.count();
+		} else if (strcmp(name, "dispatchAllCollisionPairs") == 0) {
+			Totals.Narrowphase += elapsed.count();
+		} else if (strcmp(name, "solveConstraints") == 0) {
+			Totals.Solver += elapsed.count();
+		}
+	}
+
+	PhysicsBenchmark::Result PhysicsBenchmark::Run(const Scene::Sptr& scene, int frames, float frameTime, const std::string& name) {
+		LOG_ASSERT(!scene->GetIsAwake(), "Physics benchmarks need a scene that hasn't been awoken yet!");
+		frames = std::max(frames, 1);
+
+		Result result = Result();
+		result.Frames = frames;
+
+		scene->Awake();
+		scene->IsPlaying = true;
+
+		// Swap in our own profiling hooks for the duration of the run
+		btEnterProfileZoneFunc* prevEnter = btGetCurrentEnterProfileZoneFunc();
+		btLeaveProfileZoneFunc* prevLeave = btGetCurrentLeaveProfileZoneFunc();
+		BenchmarkThread = std::this_thread::get_id();
+		ZoneStack.clear();
+		Totals = ZoneTotals();
+		btSetCustomEnterProfileZoneFunc(&PhysicsBenchmark::_EnterProfileZone);
+		btSetCustomLeaveProfileZoneFunc(&PhysicsBenchmark::_LeaveProfileZone);
+
+		double stepTime = 0.0;
+		for (int ix = 0; ix < frames; ix++) {
+			auto start = Clock::now();
+			scene->DoPhysics(frameTime);
+			std::chrono::duration<double> elapsed = Clock::now() - start;
+
+			result.Total    += elapsed.count();
+			result.PreSync  += scene->GetPhysicsPreSyncTime();
+			result.PostSync += scene->GetPhysicsPostSyncTime();
+			stepTime        += scene->GetPhysicsStepTime();
+		}
+
+		btSetCustomEnterProfileZoneFunc(prevEnter);
+		btSetCustomLeaveProfileZoneFunc(prevLeave);
+		BenchmarkThread = std::thread::id();
+
+		// Convert to average milliseconds per frame
+		double scale = 1000.0 / frames;
+		result.Total       *= scale;
+		result.PreSync     *= scale;
+		result.PostSync    *= scale;
+		result.Broadphase  = Totals.Broadphase * scale;
+		result.Narrowphase = Totals.Narrowphase * scale;
+		result.Solver      = Totals.Solver * scale;
+		result.OtherStep   = std::max(0.0, stepTime * scale - result.Broadphase - result.Narrowphase - result.Solver);
+
+		LOG_INFO("Physics benchmark for {} ({} frames, {} broadphase, {} solver iterations, {}):", name, frames,
+				 ~scene->GetPhysicsBroadphase(), scene->GetPhysicsSolverIterations(), scene->GetMultithreadedPhysics() ? "multithreaded" : "single threaded");
+		LOG_INFO("\tPre sync:     {:.3f}ms", result.PreSync);
+		LOG_INFO("\tBroadphase:   {:.3f}ms", result.Broadphase);
+		LOG_INFO("\tNarrowphase:  {:.3f}ms", result.Narrowphase);
+		LOG_INFO("\tSolver:       {:.3f}ms", result.Solver);
+		LOG_INFO("\tOther step:   {:.3f}ms", result.OtherStep);
+		LOG_INFO("\tPost sync:    {:.3f}ms", result.PostSync);
+		LOG_INFO("\tTotal:        {:.3f}ms", result.Total);
+		if (Totals.Broadphase + Totals.Narrowphase + Totals.Solver == 0.0) {
+			LOG_WARN("No Bullet profiling zones were recorded, Bullet may have been built with BT_NO_PROFILE");
+		}
+
+		return result;
+	}
+
+	PhysicsBenchmark::Result PhysicsBenchmark::RunFile(const std::string& path, int frames, float frameTime) {
+		if (!FileHelpers::Exists(path)) {
+			LOG_WARN("Could not find \"{}\" for the physics benchmark", path);
+			return Result();
+		}
+		return Run(Scene::Load(path), frames, frameTime, path);
+	}
+
+	void PhysicsBenchmark::CompareBroadphases(int bodyCount, int frames) {
+		for (PhysicsBroadphaseType type : { PhysicsBroadphaseType::Dbvt, PhysicsBroadphaseType::AxisSweep }) {
+			Scene::Sptr scene = PhysicsStressTest::CreateScene(bodyCount, false);
+			scene->SetPhysicsBroadphase(type);
+			Run(scene, frames, 1.0f / 60.0f, "stress test");
+		}
+	}
+}
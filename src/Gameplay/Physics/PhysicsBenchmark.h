@@ -0,0 +1,72 @@
+#pragma once
+#include "Gameplay/Scene.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Steps a scene's physics for a number of frames without updating or rendering it, and reports how
+	/// long each phase of the physics update took. Used for comparing broadphases and solver settings
+	///
+	/// Bullet's phases are measured with it's profiling zones, so they will read as zero if bullet was
+	/// built with BT_NO_PROFILE
+	/// </summary>
+	class PhysicsBenchmark {
+	public:
+		PhysicsBenchmark() = delete;
+
+		/// <summary>
+		/// The average time spent in each phase per frame, in milliseconds
+		/// </summary>
+		struct Result {
+			int    Frames;
+			// Sending gameobject transforms to Bullet
+			double PreSync;
+			// Updating bounding boxes and finding overlapping pairs
+			double Broadphase;
+			// Finding contact points for the overlapping pairs
+			double Narrowphase;
+			// Solving contacts and constraints
+			double Solver;
+			// The rest of the physics step, integration, islands, activation, etc...
+			double OtherStep;
+			// Copying transforms back from Bullet and sending trigger events
+			double PostSync;
+			// The whole of Scene::DoPhysics
+			double Total;
+		};
+
+		/// <summary>
+		/// Runs the benchmark on a scene that has not been awoken yet. The scene is awoken and put into play
+		/// mode, and should not be used for anything else afterwards
+		///
+		/// Awaking the scene awakes every component, not just the physics ones, and runs SetupShaderAndLights,
+		/// which uploads the scene's lights to the shared light buffer and it's settings to any shared shaders.
+		/// Gameplay components are never updated, but anything they do in Awake will still happen
+		/// </summary>
+		/// <param name="scene">The scene to benchmark</param>
+		/// <param name="frames">The number of frames to step</param>
+		/// <param name="frameTime">The time in seconds to advance each frame</param>
+		/// <param name="name">The name to show in the log</param>
+		static Result Run(const Scene::Sptr& scene, int frames = 600, float frameTime = 1.0f / 60.0f, const std::string& name = "scene");
+		/// <summary>
+		/// Loads a scene from a file and runs the benchmark on it. The current scene is not replaced, but
+		/// awaking the loaded scene has the same side effects as in Run, so the current scene's lights
+		/// should be set up again before rendering it (see Scene::SetupShaderAndLights)
+		/// </summary>
+		/// <param name="path">The path to the scene file</param>
+		/// <param name="frames">The number of frames to step</param>
+		/// <param name="frameTime">The time in seconds to advance each frame</param>
+		static Result RunFile(const std::string& path, int frames = 600, float frameTime = 1.0f / 60.0f);
+		/// <summary>
+		/// Runs the benchmark on the physics stress test scene once with each broadphase. Scenes with more
+		/// than AXIS_SWEEP_16BIT_HANDLES bodies use the 32 bit axis sweep
+		/// </summary>
+		/// <param name="bodyCount">The number of bodies in the stress test</param>
+		/// <param name="frames">The number of frames to step</param>
+		static void CompareBroadphases(int bodyCount = 4000, int frames = 600);
+
+	protected:
+		// Hooked into Bullet's profiling zones while a benchmark is running
+		static void _EnterProfileZone(const char* name);
+		static void _LeaveProfileZone();
+	};
+}
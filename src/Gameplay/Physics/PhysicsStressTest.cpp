@@ -0,0 +1,49 @@
+#include "Gameplay/Physics/PhysicsStressTest.h"
+
+#include "Gameplay/Components/Camera.h"
+#include "Gameplay/Components/SimpleCameraControl.h"
+#include "Gameplay/Physics/RigidBody.h"
+#include "Gameplay/Physics/Colliders/BoxCollider.h"
+
+namespace Gameplay::Physics {
+	Scene::Sptr PhysicsStressTest::CreateScene(int bodyCount, bool multithreaded) {
+		Scene::Sptr scene = std::make_shared<Scene>();
+		scene->SetMultithreadedPhysics(multithreaded);
+
+		// Stack the boxes in columns on a square grid, with a small gap so they start out of contact
+		const float spacing = 1.1f;
+		int gridSize = glm::max(1, static_cast<int>(glm::ceil(glm::sqrt(bodyCount / 10.0f))));
+		float halfWidth = gridSize * spacing * 0.5f;
+
+		GameObject::Sptr floor = scene->CreateGameObject("Floor");
+		{
+			RigidBody::Sptr physics = floor->Add<RigidBody>(/*static by default*/);
+			physics->AddCollider(BoxCollider::Create(glm::vec3(halfWidth + 10.0f, halfWidth + 10.0f, 1.0f)))->SetPosition({ 0.0f, 0.0f, -1.0f });
+		}
+
+		for (int ix = 0; ix < bodyCount; ix++) {
+			int column = ix % (gridSize * gridSize);
+			int layer = ix / (gridSize * gridSize);
+
+			GameObject::Sptr box = scene->CreateGameObject("Box");
+			box->HideInHierarchy = true;
+			box->SetPostion({
+				(column % gridSize) * spacing - halfWidth,
+				(column / gridSize) * spacing - halfWidth,
+				0.6f + layer * spacing
+			});
+
+			RigidBody::Sptr physics = box->Add<RigidBody>(RigidBodyType::Dynamic);
+			physics->AddCollider(BoxCollider::Create(glm::vec3(0.5f)));
+		}
+
+		GameObject::Sptr camera = scene->MainCamera->GetGameObject()->SelfRef();
+		{
+			camera->SetPostion({ -halfWidth * 1.5f, -halfWidth * 1.5f, halfWidth + 10.0f });
+			camera->LookAt(glm::vec3(0.0f));
+			camera->Add<SimpleCameraControl>();
+		}
+
+		return scene;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "Gameplay/Scene.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Builds scenes with large numbers of dynamic bodies, for measuring how physics scales
+	/// with the number of bodies and threads. Step times are shown in the debug window
+	/// </summary>
+	class PhysicsStressTest {
+	public:
+		PhysicsStressTest() = delete;
+
+		/// <summary>
+		/// Creates a scene with a grid of dynamic boxes stacked above a static floor. The boxes share a
+		/// single collision shape, and have no renderers (use the physics debug draw to see them)
+		/// </summary>
+		/// <param name="bodyCount">The number of dynamic bodies to create</param>
+		/// <param name="multithreaded">True to use the multithreaded physics world</param>
+		static Scene::Sptr CreateScene(int bodyCount = 4000, bool multithreaded = true);
+	};
+}
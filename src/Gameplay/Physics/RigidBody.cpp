@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
 
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Scene.h"
@@ -27,7 +28,10 @@ namespace Gameplay::Physics {
 		_angularVelocity(btVector3(0, 0, 0)),
 		_angularVelocityDirty(false),
 		_angularFactor(btVector3(1,1,1)),
-		_angularFactorDirty(false)
+		_angularFactorDirty(false),
+		_prevTransform(btTransform::getIdentity()),
+		_lastMovedStep(0),
+		_isInterpolating(false)
 	{ }
 
 	RigidBody::~RigidBody() {
@@ -101,35 +105,53 @@ namespace Gameplay::Physics {
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce) {
+		_body->activate();
 		_body->applyCentralForce(ToBt(worldForce));
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce, const glm::vec3& localOffset) {
+		_body->activate();
 		_body->applyForce(ToBt(worldForce), ToBt(localOffset));
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce) {
+		_body->activate();
 		_body->applyCentralImpulse(ToBt(worldForce));
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce, const glm::vec3& localOffset) {
+		_body->activate();
 		_body->applyImpulse(ToBt(worldForce), ToBt(localOffset));
 	}
 
 	void RigidBody::ApplyTorque(const glm::vec3& worldTorque) {
+		_body->activate();
 		_body->applyTorque(ToBt(worldTorque));
 	}
 
 	void RigidBody::ApplyTorqueImpulse(const glm::vec3& worldTorque) {
+		_body->activate();
 		_body->applyTorqueImpulse(ToBt(worldTorque));
 	}
 
 	void RigidBody::SetType(RigidBodyType type) {
 		_type = type;
 		if (_body != nullptr) {
+			// Bullet sorts bodies into static and dynamic when they're added to the world, so we take ourselves out while we change
+			_scene->GetPhysicsWorld()->removeRigidBody(_body);
+
 			// Remove any static or kinematic flags for the object
 			int flags = _body->getCollisionFlags() & ~btCollisionObject::CF_STATIC_OBJECT;
-			flags = _body->getCollisionFlags() & ~btCollisionObject::CF_KINEMATIC_OBJECT;
+			flags &= ~btCollisionObject::CF_KINEMATIC_OBJECT;
+
+			// Statics have no mass, this also lets Bullet treat them as static. setMassProps updates the static flag, so it goes first
+			if (_type == RigidBodyType::Static) {
+				_inertia = btVector3(0.0f, 0.0f, 0.0f);
+			} else {
+				_shape->calculateLocalInertia(_mass, _inertia);
+			}
+			_body->setMassProps(GetMass(), _inertia);
+			_isMassDirty = false;
 
 			// Set appropriate flags
 			if (_type == RigidBodyType::Kinematic) {
@@ -137,13 +159,27 @@ namespace Gameplay::Physics {
 			}
 			// If the object is static, disable it's gravity and notify bullet
 			else if (_type == RigidBodyType::Static) {
-				_body->setCollisionFlags(flags | btCollisionObject::CF_KINEMATIC_OBJECT);
+				_body->setCollisionFlags(flags | btCollisionObject::CF_STATIC_OBJECT);
 				_body->setGravity(btVector3(0.0f, 0.0f, 0.0f));
+				_body->setLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+				_body->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
 			} else {
-				// If dynamic, we need to restore gravity from the scene
 				_body->setCollisionFlags(flags);
+			}
+
+			_scene->GetPhysicsWorld()->addRigidBody(_body);
+			_body->getBroadphaseProxy()->m_collisionFilterGroup = _collisionGroup;
+			_body->getBroadphaseProxy()->m_collisionFilterMask  = _collisionMask;
+
+			// If dynamic, we need to restore gravity from the scene (this is after adding, since adding sets the world's gravity)
+			if (_type == RigidBodyType::Dynamic) {
 				_body->setGravity(_scene->GetPhysicsWorld()->getGravity());
 			}
+
+			// Bullet only reads the motion state of kinematics while they're awake, so they have to stay that way. Everything
+			// else is allowed to fall asleep, statics never wake up so they don't keep the bodies resting on them awake
+			_body->forceActivationState(_type == RigidBodyType::Kinematic ? DISABLE_DEACTIVATION : ACTIVE_TAG);
+			_body->activate(true);
 		}
 	}
 
@@ -159,25 +195,55 @@ namespace Gameplay::Physics {
 			btTransform transform;
 			_CopyGameobjectTransformTo(transform);
 
-			// Copy to body and to it's motion state
-			if (_type == RigidBodyType::Dynamic) {
-				_body->setWorldTransform(transform);
-			} else {
-				// Kinematics prefer to be driven my motion state for some reason :|
-				_body->getMotionState()->setWorldTransform(transform);
+			// The gameobject has the transform we last synced with, so we only send it to Bullet if something else has moved it
+			bool moved = _HasGameobjectMoved();
+			if (moved) {
+				if (_type == RigidBodyType::Dynamic) {
+					// We don't interpolate across the move, so the object doesn't slide to it's new position
+					_body->setWorldTransform(transform);
+					_body->setInterpolationWorldTransform(transform);
+					_body->activate();
+					_motionState->Transform = transform;
+					_prevTransform = transform;
+					_isInterpolating = false;
+				} else {
+					// Kinematics prefer to be driven my motion state for some reason :|
+					_motionState->Transform = transform;
+				}
+				_MarkGameobjectSynced();
 			}
+			_CountPush(moved);
 		}
 	}
 
 	void RigidBody::PhysicsPostStep(float dt) {
 		// Kinematics are driven externally and statics don't move, so only need to get data out for dynamics!
 		if (_type == RigidBodyType::Dynamic) {
-			btTransform transform = _body->getWorldTransform();
-			_CopyGameobjectTransformFrom(transform);
+			// Bodies that Bullet hasn't moved are already where the gameobject has them
+			if (!_isInterpolating) {
+				_CountPull(false);
+				return;
+			}
+
+			// If Bullet didn't move us in the most recent step we've fallen asleep, so this is the last time we need to copy our transform
+			if (_lastMovedStep != _scene->GetPhysicsStepCount()) {
+				_prevTransform = _motionState->Transform;
+				_isInterpolating = false;
+			}
+
+			// Frames don't line up with physics steps, so we show the body part way between the last two steps
+			const btTransform& transform = _motionState->Transform;
+			float alpha = _scene->GetPhysicsInterpolation();
+
+			GameObject* context = GetGameObject();
+			context->SetPostion(glm::mix(ToGlm(_prevTransform.getOrigin()), ToGlm(transform.getOrigin()), alpha));
+			context->SetRotation(glm::slerp(ToGlm(_prevTransform.getRotation()), ToGlm(transform.getRotation()), alpha));
+			_MarkGameobjectSynced();
 
 			// Store a copy of our velocities
 			_linearVelocity = _body->getLinearVelocity();
 			_angularVelocity = _body->getAngularVelocity();
+			_CountPull(true);
 		}
 	}
 
@@ -192,30 +258,31 @@ namespace Gameplay::Physics {
 			collider->Awake(context);
 		}
 
-		// Create our compound shape and add all colliders
-		_shape = new btCompoundShape(true, _colliders.size());
-		_shape->setLocalScaling(ToBt(context->GetScale()));
-		for (auto& collider : _colliders) {
-			_AddColliderToShape(collider.get());
-		}
-		_isShapeDirty = false;
+		// Get a compound shape with all of our colliders, shared with any other objects with the same colliders and scale
+		_baseScale = _prevScale;
+		_RebuildShape();
 
-		// Update inertia
-		_shape->calculateLocalInertia(_mass, _inertia);
+		// Update inertia, statics have no mass so they don't have any
+		if (_type == RigidBodyType::Static) {
+			_inertia = btVector3(0.0f, 0.0f, 0.0f);
+		} else {
+			_shape->calculateLocalInertia(_mass, _inertia);
+		}
 		_isMassDirty = false;
 
-		// Create a default motion state instance for tracking the bodies motion
-		_motionState = new btDefaultMotionState();
-
 		// Get the object's starting transform, create a bullet representation for it
 		btTransform transform; 
 		transform.setIdentity();
 		transform.setOrigin(ToBt(context->GetPosition()));
 		transform.setRotation(ToBt(context->GetRotation()));
-		_motionState->setWorldTransform(transform);
 
-		// Create the bullet rigidbody and add it to the physics scene
-		_body = new btRigidBody(_mass, _motionState, _shape, _inertia);
+		// Create our motion state for passing transforms to and from bullet
+		_motionState = new MotionState(this, transform);
+		_prevTransform = transform;
+		_MarkGameobjectSynced();
+
+		// Create the bullet rigidbody and add it to the physics scene. Bodies with no mass are created as static by Bullet
+		_body = new btRigidBody(GetMass(), _motionState, _shape, _inertia);
 		// Add a pointer to our own weak reference to allow getting this component as a shared_ptr later
 		_body->setUserPointer(&SelfRef());
 
@@ -228,10 +295,15 @@ namespace Gameplay::Physics {
 		// If the object is static, disable it's gravity and notify bullet
 		else if (_type == RigidBodyType::Static) {
 			_body->setGravity(btVector3(0.0f, 0.0f, 0.0f));
-			_body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+			_body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_STATIC_OBJECT);
 		}
 	
-		_body->setActivationState(DISABLE_DEACTIVATION);
+		// Dynamic bodies can fall asleep once they come to rest, so that Bullet can skip them until something wakes them up.
+		// Bullet only reads the motion state of kinematics while they're awake, so they have to stay that way. Statics are
+		// never simulated, and keeping them awake would keep everything resting on them awake as well
+		if (_type == RigidBodyType::Kinematic) {
+			_body->setActivationState(DISABLE_DEACTIVATION);
+		}
 
 		// Copy over group and mask info
 		_body->getBroadphaseProxy()->m_collisionFilterGroup = _collisionGroup;
@@ -273,12 +345,14 @@ namespace Gameplay::Physics {
 		if (_type == RigidBodyType::Dynamic) {
 			// If outside code has changed our velocity, send that to Bullet
 			if (_linearVelocityDirty) {
+				_body->activate();
 				_body->setLinearVelocity(_linearVelocity);
 				_linearVelocityDirty = false;
 			}
 
 			// If outside code has changed our angular velocity, send that to Bullet
 			if (_angularVelocityDirty) {
+				_body->activate();
 				_body->setAngularVelocity(_angularVelocity);
 				_angularVelocityDirty = false;
 			}
@@ -309,14 +383,37 @@ namespace Gameplay::Physics {
 				// Recalulcate our inertia properties and send to bullet
 				_shape->calculateLocalInertia(_mass, _inertia);
 				_body->setMassProps(_mass, _inertia);
+				_body->activate();
 			}
 			_isMassDirty = false;
 		}
 	}
 
+	RigidBody::MotionState::MotionState(RigidBody* body, const btTransform& transform) :
+		btMotionState(),
+		Transform(transform),
+		_body(body)
+	{ }
+
+	void RigidBody::MotionState::getWorldTransform(btTransform& worldTrans) const {
+		worldTrans = Transform;
+	}
+
+	void RigidBody::MotionState::setWorldTransform(const btTransform& worldTrans) {
+		// This may be called from Bullet's worker threads, so we only touch our own body's state here
+		_body->_prevTransform = Transform;
+		Transform = worldTrans;
+		_body->_lastMovedStep = _body->_scene->GetPhysicsStepCount();
+		_body->_isInterpolating = true;
+	}
+
 	btBroadphaseProxy* RigidBody::_GetBroadphaseHandle() {
 		return _body != nullptr ? _body->getBroadphaseProxy() : nullptr;
 	}
 
+	btCollisionObject* RigidBody::_GetCollisionObject() {
+		return _body;
+	}
+
 }
 
@@ -174,6 +174,26 @@ namespace Gameplay::Physics {
 
 
 	protected:
+		/// <summary>
+		/// Passes transforms between our body and Bullet. Bullet only gives transforms back for bodies
+		/// that are awake, so bodies that have come to rest don't need to be copied back to their gameobjects
+		/// </summary>
+		class MotionState : public btMotionState {
+		public:
+			MotionState(RigidBody* body, const btTransform& transform);
+
+			// Bullet reads this for kinematic bodies every step, and when the body is created
+			virtual void getWorldTransform(btTransform& worldTrans) const override;
+			// Bullet calls this after every step that the body was awake for
+			virtual void setWorldTransform(const btTransform& worldTrans) override;
+
+			// The transform a kinematic body will move to, or where Bullet last put a dynamic body
+			btTransform Transform;
+
+		private:
+			RigidBody* _body;
+		};
+
 		// The physics update mode for the body (static, dynamic, kinematic)
 		RigidBodyType _type;
 
@@ -189,7 +209,7 @@ namespace Gameplay::Physics {
 
 		// Our bullet state stuff
 		btRigidBody*     _body;
-		btMotionState*   _motionState;
+		MotionState*     _motionState;
 		btVector3        _inertia;
 		btVector3        _linearVelocity;
 		bool             _linearVelocityDirty;
@@ -198,9 +218,16 @@ namespace Gameplay::Physics {
 		btVector3        _angularFactor;
 		bool             _angularFactorDirty;
 
+		// Where the body was before the last step it moved in, for interpolation
+		btTransform      _prevTransform;
+		// The scene's step count when Bullet last moved us, and whether we still need to copy our transform to the gameobject
+		uint64_t         _lastMovedStep;
+		bool             _isInterpolating;
+
 		// Handles resolving any dirty state stuff for our object
 		void _HandleStateDirty();
 
 		virtual btBroadphaseProxy* _GetBroadphaseHandle() override;
+		virtual btCollisionObject* _GetCollisionObject() override;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "Gameplay/Physics/SpatialQueryBatch.h"
+
+#include <btBulletCollisionCommon.h>
+
+#include "Gameplay/Components/IComponent.h"
+#include "Gameplay/Physics/BulletTaskScheduler.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay::Physics {
+	// The number of queries each thread pool job handles, queries are fairly cheap so we don't want too many jobs
+	static const size_t QueryChunkSize = 32;
+
+	// Batches smaller than this aren't worth splitting across threads
+	static const size_t MinParallelQueries = QueryChunkSize * 2;
+
+	/// <summary>
+	/// Gets the gameobject that owns a bullet object, physics components store a pointer to their own weak reference in their user pointers
+	/// </summary>
+	static GameObject::Wptr GetOwningGameObject(const btCollisionObject* object) {
+		if (object != nullptr && object->getUserPointer() != nullptr) {
+			IComponent::Sptr component = reinterpret_cast<std::weak_ptr<IComponent>*>(object->getUserPointer())->lock();
+			if (component != nullptr) {
+				return component->GetGameObject()->SelfRef();
+			}
+		}
+		return GameObject::Wptr();
+	}
+
+	/// <summary>
+	/// Adds trigger filtering to one of bullet's closest hit callbacks. Our queries belong to every
+	/// collision group, so only the query's mask decides what it can hit
+	/// </summary>
+	template <typename Base>
+	struct FilteredClosestCallback : public Base {
+		bool HitTriggers;
+
+		FilteredClosestCallback(const btVector3& from, const btVector3& to, int collisionMask, bool hitTriggers) :
+			Base(from, to),
+			HitTriggers(hitTriggers)
+		{
+			this->m_collisionFilterGroup = -1;
+			this->m_collisionFilterMask  = collisionMask;
+		}
+
+		virtual bool needsCollision(btBroadphaseProxy* proxy) const override {
+			const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+			if (!HitTriggers && (object->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE)) {
+				return false;
+			}
+			return Base::needsCollision(proxy);
+		}
+	};
+
+	/// <summary>
+	/// Collects the objects that a sphere overlaps from the broadphase, writing them straight into
+	/// the batch's object array
+	/// </summary>
+	struct SphereOverlapCallback : public btBroadphaseAabbCallback {
+		btVector3 Center;
+		btScalar  Radius;
+		int       CollisionMask;
+		bool      HitTriggers;
+
+		GameObject::Wptr* Objects;
+		uint32_t          MaxObjects;
+		uint32_t          ObjectCount;
+		bool              Truncated;
+
+		// Returns true to keep searching
+		virtual bool process(const btBroadphaseProxy* proxy) override {
+			if ((proxy->m_collisionFilterGroup & CollisionMask) == 0) {
+				return true;
+			}
+
+			const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+			if (!HitTriggers && (object->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE)) {
+				return true;
+			}
+
+			// The broadphase bounds are padded, so we test against the object's actual bounding box
+			btVector3 aabbMin, aabbMax;
+			object->getCollisionShape()->getAabb(object->getWorldTransform(), aabbMin, aabbMax);
+			btVector3 closest = Center;
+			closest.setMax(aabbMin);
+			closest.setMin(aabbMax);
+			if (closest.distance2(Center) > Radius * Radius) {
+				return true;
+			}
+
+			if (ObjectCount < MaxObjects) {
+				Objects[ObjectCount++] = GetOwningGameObject(object);
+				return true;
+			}
+
+			// We're out of room, there's no point searching any further
+			Truncated = true;
+			return false;
+		}
+	};
+
+	SpatialQueryBatch::SpatialQueryBatch() :
+		Rays(std::vector<RayQuery>()),
+		SphereSweeps(std::vector<SphereSweepQuery>()),
+		SphereOverlaps(std::vector<SphereOverlapQuery>()),
+		RayHits(std::vector<Hit>()),
+		SphereSweepHits(std::vector<Hit>()),
+		SphereOverlapResults(std::vector<OverlapResult>()),
+		OverlapObjects(std::vector<GameObject::Wptr>())
+	{ }
+
+	uint32_t SpatialQueryBatch::AddRay(const glm::vec3& from, const glm::vec3& to, int collisionMask, bool hitTriggers) {
+		Rays.push_back({ from, to, collisionMask, hitTriggers });
+		return static_cast<uint32_t>(Rays.size() - 1);
+	}
+
+	uint32_t SpatialQueryBatch::AddSphereSweep(const glm::vec3& from, const glm::vec3& to, float radius, int collisionMask, bool hitTriggers) {
+		SphereSweeps.push_back({ from, to, radius, collisionMask, hitTriggers });
+		return static_cast<uint32_t>(SphereSweeps.size() - 1);
+	}
+
+	uint32_t SpatialQueryBatch::AddSphereOverlap(const glm::vec3& center, float radius, uint32_t maxHits, int collisionMask, bool hitTriggers) {
+		SphereOverlaps.push_back({ center, radius, collisionMask, hitTriggers, maxHits });
+		return static_cast<uint32_t>(SphereOverlaps.size() - 1);
+	}
+
+	void SpatialQueryBatch::Clear() {
+		Rays.clear();
+		SphereSweeps.clear();
+		SphereOverlaps.clear();
+		RayHits.clear();
+		SphereSweepHits.clear();
+		SphereOverlapResults.clear();
+		OverlapObjects.clear();
+	}
+
+	size_t SpatialQueryBatch::GetQueryCount() const {
+		return Rays.size() + SphereSweeps.size() + SphereOverlaps.size();
+	}
+
+	void SpatialQueryBatch::Run(btCollisionWorld* world) {
+		// Size all our results up front, so that the queries only ever write into their own slots
+		RayHits.resize(Rays.size());
+		SphereSweepHits.resize(SphereSweeps.size());
+		SphereOverlapResults.resize(SphereOverlaps.size());
+
+		uint32_t objectCount = 0;
+		for (size_t ix = 0; ix < SphereOverlaps.size(); ix++) {
+			SphereOverlapResults[ix] = { objectCount, 0, false };
+			objectCount += SphereOverlaps[ix].MaxHits;
+		}
+		OverlapObjects.resize(objectCount);
+
+		size_t queryCount = GetQueryCount();
+		#if BT_THREADSAFE
+		if (queryCount >= MinParallelQueries) {
+			// Stick to the threads bullet has given indices to
+			ThreadPool::Get().ParallelFor(queryCount, QueryChunkSize, [&](size_t begin, size_t end) {
+				_RunRange(world, begin, end);
+			}, static_cast<uint32_t>(BulletTaskScheduler::Get()->getNumThreads()));
+			return;
+		}
+		#endif
+		_RunRange(world, 0, queryCount);
+	}
+
+	void SpatialQueryBatch::_RunRange(btCollisionWorld* world, size_t begin, size_t end) {
+		const size_t sweepStart   = Rays.size();
+		const size_t overlapStart = sweepStart + SphereSweeps.size();
+
+		for (size_t ix = begin; ix < end; ix++) {
+			if (ix < sweepStart) {
+				_RunRay(world, static_cast<uint32_t>(ix));
+			} else if (ix < overlapStart) {
+				_RunSphereSweep(world, static_cast<uint32_t>(ix - sweepStart));
+			} else {
+				_RunSphereOverlap(world, static_cast<uint32_t>(ix - overlapStart));
+			}
+		}
+	}
+
+	void SpatialQueryBatch::_RunRay(btCollisionWorld* world, uint32_t index) {
+		const RayQuery& query = Rays[index];
+		Hit& hit = RayHits[index];
+
+		btVector3 from = btVector3(query.From.x, query.From.y, query.From.z);
+		btVector3 to = btVector3(query.To.x, query.To.y, query.To.z);
+		FilteredClosestCallback<btCollisionWorld::ClosestRayResultCallback> callback(from, to, query.CollisionMask, query.HitTriggers);
+		world->rayTest(from, to, callback);
+
+		hit.HasHit = callback.hasHit();
+		if (hit.HasHit) {
+			hit.Object   = GetOwningGameObject(callback.m_collisionObject);
+			hit.Point    = ToGlm(callback.m_hitPointWorld);
+			hit.Normal   = ToGlm(callback.m_hitNormalWorld);
+			hit.Fraction = callback.m_closestHitFraction;
+		} else {
+			hit.Object.reset();
+			hit.Fraction = 1.0f;
+		}
+	}
+
+	void SpatialQueryBatch::_RunSphereSweep(btCollisionWorld* world, uint32_t index) {
+		const SphereSweepQuery& query = SphereSweeps[index];
+		Hit& hit = SphereSweepHits[index];
+
+		btVector3 from = btVector3(query.From.x, query.From.y, query.From.z);
+		btVector3 to = btVector3(query.To.x, query.To.y, query.To.z);
+		btTransform fromTransform = btTransform(btQuaternion::getIdentity(), from);
+		btTransform toTransform = btTransform(btQuaternion::getIdentity(), to);
+
+		// Small enough to live on the stack, so sweeps don't need to allocate
+		btSphereShape sphere(query.Radius);
+		FilteredClosestCallback<btCollisionWorld::ClosestConvexResultCallback> callback(from, to, query.CollisionMask, query.HitTriggers);
+		world->convexSweepTest(&sphere, fromTransform, toTransform, callback);
+
+		hit.HasHit = callback.hasHit();
+		if (hit.HasHit) {
+			hit.Object   = GetOwningGameObject(callback.m_hitCollisionObject);
+			hit.Point    = ToGlm(callback.m_hitPointWorld);
+			hit.Normal   = ToGlm(callback.m_hitNormalWorld);
+			hit.Fraction = callback.m_closestHitFraction;
+		} else {
+			hit.Object.reset();
+			hit.Fraction = 1.0f;
+		}
+	}
+
+	void SpatialQueryBatch::_RunSphereOverlap(btCollisionWorld* world, uint32_t index) {
+		const SphereOverlapQuery& query = SphereOverlaps[index];
+		OverlapResult& result = SphereOverlapResults[index];
+
+		SphereOverlapCallback callback;
+		callback.Center        = btVector3(query.Center.x, query.Center.y, query.Center.z);
+		callback.Radius        = query.Radius;
+		callback.CollisionMask = query.CollisionMask;
+		callback.HitTriggers   = query.HitTriggers;
+		callback.Objects       = OverlapObjects.data() + result.FirstObject;
+		callback.MaxObjects    = query.MaxHits;
+		callback.ObjectCount   = 0;
+		callback.Truncated     = false;
+
+		btVector3 extents = btVector3(query.Radius, query.Radius, query.Radius);
+		world->getBroadphase()->aabbTest(callback.Center - extents, callback.Center + extents, callback);
+
+		result.ObjectCount = callback.ObjectCount;
+		result.Truncated   = callback.Truncated;
+
+		// Drop any objects left over from the last time the batch was run
+		for (uint32_t ix = callback.ObjectCount; ix < query.MaxHits; ix++) {
+			callback.Objects[ix].reset();
+		}
+	}
+}
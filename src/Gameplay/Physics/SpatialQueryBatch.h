@@ -0,0 +1,152 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Gameplay/GameObject.h"
+
+class btCollisionWorld;
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// A set of raycasts, sphere sweeps and sphere overlap tests that are run together against the physics world,
+	/// split across the thread pool. See Scene::RunSpatialQueries and Scene::QueueSpatialQueries
+	///
+	/// Batches are meant to be kept around and refilled every frame, the query and result arrays keep their
+	/// memory between runs so that running a batch doesn't need to allocate anything per query or hit
+	/// </summary>
+	class SpatialQueryBatch {
+	public:
+		typedef std::shared_ptr<SpatialQueryBatch> Sptr;
+
+		/// <summary>
+		/// A line from one point to another, finds the closest object the line hits
+		/// </summary>
+		struct RayQuery {
+			glm::vec3 From;
+			glm::vec3 To;
+			// Only objects in these collision groups will be hit
+			int       CollisionMask;
+			// Whether trigger volumes should be hit
+			bool      HitTriggers;
+		};
+
+		/// <summary>
+		/// A sphere moving from one point to another, finds the closest object the sphere hits
+		/// </summary>
+		struct SphereSweepQuery {
+			glm::vec3 From;
+			glm::vec3 To;
+			float     Radius;
+			int       CollisionMask;
+			bool      HitTriggers;
+		};
+
+		/// <summary>
+		/// Finds all objects who's bounding boxes touch a sphere, up to a given number of objects
+		/// </summary>
+		struct SphereOverlapQuery {
+			glm::vec3 Center;
+			float     Radius;
+			int       CollisionMask;
+			bool      HitTriggers;
+			// The most objects that will be stored for this query
+			uint32_t  MaxHits;
+		};
+
+		/// <summary>
+		/// The closest hit for a ray or sweep query
+		/// </summary>
+		struct Hit {
+			// False if the query didn't hit anything, in which case the rest of the hit is not valid
+			bool             HasHit;
+			// The object that was hit, may be empty for bullet objects that were not created by a component
+			GameObject::Wptr Object;
+			// The point and surface normal of the hit, in world space
+			glm::vec3        Point;
+			glm::vec3        Normal;
+			// How far along the query the hit happened, in the 0-1 range
+			float            Fraction;
+		};
+
+		/// <summary>
+		/// The objects found by an overlap query, as a range in OverlapObjects
+		/// </summary>
+		struct OverlapResult {
+			uint32_t FirstObject;
+			uint32_t ObjectCount;
+			// True if more than MaxHits objects were found, the extra objects are not stored
+			bool     Truncated;
+		};
+
+		std::vector<RayQuery>           Rays;
+		std::vector<SphereSweepQuery>   SphereSweeps;
+		std::vector<SphereOverlapQuery> SphereOverlaps;
+
+		// The results of the queries, in the same order as the queries once the batch has been run
+		std::vector<Hit>                RayHits;
+		std::vector<Hit>                SphereSweepHits;
+		std::vector<OverlapResult>      SphereOverlapResults;
+		// The objects found by all of the overlap queries, see OverlapResult
+		std::vector<GameObject::Wptr>   OverlapObjects;
+
+		SpatialQueryBatch();
+
+		/// <summary>
+		/// Adds a raycast to the batch
+		/// </summary>
+		/// <param name="from">The start of the ray in world space</param>
+		/// <param name="to">The end of the ray in world space</param>
+		/// <param name="collisionMask">The collision groups that the ray can hit</param>
+		/// <param name="hitTriggers">True if the ray should hit trigger volumes</param>
+		/// <returns>The index of the query in Rays and RayHits</returns>
+		uint32_t AddRay(const glm::vec3& from, const glm::vec3& to, int collisionMask = -1, bool hitTriggers = false);
+		/// <summary>
+		/// Adds a sphere sweep to the batch
+		/// </summary>
+		/// <param name="from">The start position of the sphere's center in world space</param>
+		/// <param name="to">The end position of the sphere's center in world space</param>
+		/// <param name="radius">The radius of the sphere</param>
+		/// <param name="collisionMask">The collision groups that the sphere can hit</param>
+		/// <param name="hitTriggers">True if the sphere should hit trigger volumes</param>
+		/// <returns>The index of the query in SphereSweeps and SphereSweepHits</returns>
+		uint32_t AddSphereSweep(const glm::vec3& from, const glm::vec3& to, float radius, int collisionMask = -1, bool hitTriggers = false);
+		/// <summary>
+		/// Adds a sphere overlap test to the batch
+		/// </summary>
+		/// <param name="center">The center of the sphere in world space</param>
+		/// <param name="radius">The radius of the sphere</param>
+		/// <param name="maxHits">The most objects to store for this query</param>
+		/// <param name="collisionMask">The collision groups that the sphere can overlap</param>
+		/// <param name="hitTriggers">True if the sphere should overlap trigger volumes</param>
+		/// <returns>The index of the query in SphereOverlaps and SphereOverlapResults</returns>
+		uint32_t AddSphereOverlap(const glm::vec3& center, float radius, uint32_t maxHits = 16, int collisionMask = -1, bool hitTriggers = false);
+
+		/// <summary>
+		/// Removes all queries and results from the batch, while keeping their memory
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Gets the total number of queries in the batch
+		/// </summary>
+		size_t GetQueryCount() const;
+
+		/// <summary>
+		/// Runs all the queries in the batch against a physics world, filling in the results. The world must
+		/// not be stepped or modified while this is running. Queries are only split across the thread pool
+		/// when bullet was built with BT_THREADSAFE, since it's broadphase isn't safe to query from multiple
+		/// threads otherwise
+		/// </summary>
+		/// <param name="world">The world to query</param>
+		void Run(btCollisionWorld* world);
+
+	protected:
+		// Runs the queries in [begin, end), indexing rays, then sweeps, then overlaps
+		void _RunRange(btCollisionWorld* world, size_t begin, size_t end);
+
+		void _RunRay(btCollisionWorld* world, uint32_t index);
+		void _RunSphereSweep(btCollisionWorld* world, uint32_t index);
+		void _RunSphereOverlap(btCollisionWorld* world, uint32_t index);
+	};
+}
@@ -1,5 +1,6 @@
 #include "Gameplay/Physics/TriggerVolume.h"
 
+#include <algorithm>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
 
 #include "Utils/GlmBulletConversions.h"
@@ -28,111 +29,117 @@ namespace Gameplay::Physics {
 		_HandleShapeDirty();
 		_HandleGroupDirty();
 
-		// Copy our transform info from OpenGL
-		GameObject* context = GetGameObject();
+		// Copy our transform info from OpenGL, this also picks up any change in scale
 		btTransform transform;
 		_CopyGameobjectTransformTo(transform);
 
-		_ghost->setWorldTransform(transform);
+		// Most triggers never move, so we only send the transform to Bullet when the gameobject has moved
+		bool moved = _HasGameobjectMoved();
+		if (moved) {
+			_ghost->setWorldTransform(transform);
+			_MarkGameobjectSynced();
+		}
+		_CountPush(moved);
 	}
 
-	void TriggerVolume::PhysicsPostStep(float dt) {
-		// This will store all the objects inside the trigger this frame
-		std::vector<std::weak_ptr<RigidBody>> thisFrameCollision;
+	void TriggerVolume::GatherContacts(btCollisionWorld* world) {
+		// The world has already found the contacts for every pair, including our ghosts, so we
+		// only need to hand each trigger the bodies that are touching it
+		btDispatcher* dispatcher = world->getDispatcher();
+		const int numManifolds = dispatcher->getNumManifolds();
+		for (int ix = 0; ix < numManifolds; ix++) {
+			btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(ix);
+			if (manifold->getNumContacts() == 0) {
+				continue;
+			}
 
-		// Get all our collisions from from the world
-		_scene->GetPhysicsWorld()->getDispatcher()->dispatchAllCollisionPairs(_ghost->getOverlappingPairCache(), _scene->GetPhysicsWorld()->getDispatchInfo(), _scene->GetPhysicsWorld()->getDispatcher());
-		btBroadphasePairArray& collisionPairs = _ghost->getOverlappingPairCache()->getOverlappingPairArray();
+			// Make sure one side is a trigger, and the other is a rigid body (no trigger-trigger interactions)
+			const btCollisionObject* ghost = manifold->getBody0();
+			const btCollisionObject* other = manifold->getBody1();
+			if (btGhostObject::upcast(ghost) == nullptr) {
+				std::swap(ghost, other);
+			}
+			if (btGhostObject::upcast(ghost) == nullptr || other->getInternalType() != btCollisionObject::CO_RIGID_BODY) {
+				continue;
+			}
 
-		// Determine how many objects are intersecting the volume
-		const int numObjects=collisionPairs.size();
-		thisFrameCollision.reserve(numObjects);
+			// Extract the weak pointers that we stored in our user pointers
+			std::shared_ptr<IComponent> trigger = reinterpret_cast<std::weak_ptr<IComponent>*>(ghost->getUserPointer())->lock();
+			TriggerVolume* volume = dynamic_cast<TriggerVolume*>(trigger.get());
+			if (volume != nullptr) {
+				volume->_AddContact(static_cast<const btRigidBody*>(other));
+			}
+		}
+	}
 
-		// Will store our contact manifolds, can be static to be shared between frames and instances
-		static btManifoldArray	m_manifoldArray;
+	void TriggerVolume::_AddContact(const btRigidBody* body) {
+		// Make sure the object's group matches our mask (since this isn't filtered for us)
+		if ((body->getBroadphaseHandle()->m_collisionFilterGroup & _collisionMask) == 0) {
+			return;
+		}
 
-		// Iterate over all the objects that we're colliding with
-		for (int i = 0; i < numObjects; ++i) {
-			// resize the number of manifolds to zero for everything we collide with
-			m_manifoldArray.resize(0);
+		// Make sure that the object is not a kinematic or static object (note: you may want
+		// to modify this behaviour depending on your game)
+		if (((body->getCollisionFlags() & btCollisionObject::CF_STATIC_OBJECT & btCollisionObject::CF_KINEMATIC_OBJECT) == 0) ||
+			((body->getCollisionFlags() & btCollisionObject::CF_STATIC_OBJECT) == *(_typeFlags & TriggerTypeFlags::Statics)) ||
+			((body->getCollisionFlags() & btCollisionObject::CF_KINEMATIC_OBJECT) == *(_typeFlags & TriggerTypeFlags::Kinematics))) {
 
-			// Get the btCollisionObject that we're colliding with
-			btCollisionObject *obj = _ghost->getOverlappingObject(i);
+			// Cast lock the raw pointer and cast up to a RigidBody
+			std::weak_ptr<IComponent> rawPtr = *reinterpret_cast<std::weak_ptr<IComponent>*>(body->getUserPointer());
+			std::shared_ptr<RigidBody> physicsPtr = std::dynamic_pointer_cast<RigidBody>(rawPtr.lock());
 
-			// Get the contact pair and resolve contact manifolds
-			btBroadphasePair* pair = &collisionPairs[i];
-			if (pair != nullptr && pair->m_algorithm != nullptr) {
-				pair->m_algorithm->getAllContactManifolds(m_manifoldArray);
-			} else {
-				continue;
+			// As long as we got a pointer out, we can store it for PhysicsPostStep
+			if (physicsPtr != nullptr && physicsPtr->GetGameObject() != GetGameObject()) {
+				_frameCollisions.push_back({ physicsPtr.get(), physicsPtr });
 			}
+		}
+	}
 
-			// Iterate over all the contact manifolds and check if any of them have contacts
-			bool hasCollision = false;
-			for (int j=0; j < m_manifoldArray.size(); j++) {
-				btPersistentManifold* manifold = m_manifoldArray[j];
-				if (manifold != nullptr && manifold->getNumContacts() > 0) {
-					hasCollision = true;
-					break;
-				}
+	void TriggerVolume::PhysicsPostStep(float dt) {
+		// A body can touch us with more than one collider, so we sort and remove duplicates. Since the previous
+		// frame is sorted the same way, we can find everything that entered or left in a single pass
+		auto byKey = [](const Contact& a, const Contact& b) { return std::less<const RigidBody*>()(a.Key, b.Key); };
+		std::sort(_frameCollisions.begin(), _frameCollisions.end(), byKey);
+		_frameCollisions.erase(std::unique(_frameCollisions.begin(), _frameCollisions.end(), [](const Contact& a, const Contact& b) {
+			return a.Key == b.Key;
+		}), _frameCollisions.end());
+
+		TriggerVolume::Sptr self = nullptr;
+		auto onEnter = [&](const Contact& contact) {
+			self = self != nullptr ? self : std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock());
+			std::shared_ptr<RigidBody> body = contact.Body.lock();
+			body->GetGameObject()->OnEnteredTrigger(self);
+			GetGameObject()->OnTriggerVolumeEntered(body);
+		};
+		auto onLeave = [&](const Contact& contact) {
+			// Bodies that have been destroyed since last frame can't be told that they left
+			std::shared_ptr<RigidBody> body = contact.Body.lock();
+			if (body != nullptr) {
+				self = self != nullptr ? self : std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock());
+				body->GetGameObject()->OnLeavingTrigger(self);
+				GetGameObject()->OnTriggerVolumeLeaving(body);
 			}
-
-			// If we have contacts and the object's group matches our mask (since this isn't filtered for us)
-			if (hasCollision && (obj->getBroadphaseHandle()->m_collisionFilterGroup & _collisionMask)) {
-				// Make sure the internal type is a bullet rigid body (no trigger-trigger interactions)
-				if (obj->getInternalType() == btCollisionObject::CO_RIGID_BODY) {
-					// Get the collision object as a btRigidBody
-					const btRigidBody *body = (const btRigidBody *)obj;
-
-					// Make sure that the object is not a kinematic or static object (note: you may want
-					// to modify this behaviour depending on your game)
-					if (((body->getCollisionFlags() & btCollisionObject::CF_STATIC_OBJECT & btCollisionObject::CF_KINEMATIC_OBJECT) == 0) ||
-						((body->getCollisionFlags() & btCollisionObject::CF_STATIC_OBJECT) == *(_typeFlags & TriggerTypeFlags::Statics)) ||
-						((body->getCollisionFlags() & btCollisionObject::CF_KINEMATIC_OBJECT) == *(_typeFlags & TriggerTypeFlags::Kinematics))) {
-
-						// Extract the weak pointer that we stored in all our rigidbody user pointers
-						std::weak_ptr<IComponent> rawPtr = *reinterpret_cast<std::weak_ptr<IComponent>*>(body->getUserPointer());
-						// Cast lock the raw pointer and cast up to a RigidBody
-						std::shared_ptr<RigidBody> physicsPtr = std::dynamic_pointer_cast<RigidBody>(rawPtr.lock());
-
-						// As long as we got a pointer out, we can proceed to try and invoke
-						if (physicsPtr != nullptr && physicsPtr->GetGameObject() != GetGameObject()) {
-							// Add the object to the known collisions for this frame
-							thisFrameCollision.push_back(physicsPtr);
-
-							// Check to see if the object has been added to our object cache
-							auto& it = std::find_if(_currentCollisions.begin(), _currentCollisions.end(), [&](const std::weak_ptr<RigidBody>& item) {
-								return item.lock() == physicsPtr;
-							});
-
-							// If the object is NOT in the cache, we invoke all the callbacks
-							if (it == _currentCollisions.end()) {
-								physicsPtr->GetGameObject()->OnEnteredTrigger(std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock()));
-								GetGameObject()->OnTriggerVolumeEntered(physicsPtr);
-							}
-						}
-					}
+		};
+
+		size_t prev = 0, next = 0;
+		while (prev < _currentCollisions.size() || next < _frameCollisions.size()) {
+			if (next == _frameCollisions.size() || (prev < _currentCollisions.size() && byKey(_currentCollisions[prev], _frameCollisions[next]))) {
+				onLeave(_currentCollisions[prev++]);
+			} else if (prev == _currentCollisions.size() || byKey(_frameCollisions[next], _currentCollisions[prev])) {
+				onEnter(_frameCollisions[next++]);
+			} else {
+				// A destroyed body's address can be reused by a new one, which has only just entered
+				if (_currentCollisions[prev].Body.expired()) {
+					onEnter(_frameCollisions[next]);
 				}
-
-			}
-		}
-	
-		// Compare our current frame list to the previous frame to see if anything has left
-		for (auto& weakPtr : _currentCollisions) {
-			// Search the the current list to see if the item still exists
-			auto& it = std::find_if(thisFrameCollision.begin(), thisFrameCollision.end(), [&](const std::weak_ptr<RigidBody>& item) {
-				return item.lock() == weakPtr.lock();
-			});
-
-			// If the item no longer exists in the list, we need to invoke exit callbacks
-			if (it == thisFrameCollision.end()) {
-				weakPtr.lock()->GetGameObject()->OnLeavingTrigger(std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock()));
-				GetGameObject()->OnTriggerVolumeLeaving(weakPtr.lock());
+				prev++;
+				next++;
 			}
 		}
 
-		// Load the contents of the current collision items into the cache
-		_currentCollisions.swap(thisFrameCollision);
+		// This frame's contacts become the ones we compare against next time
+		_currentCollisions.swap(_frameCollisions);
+		_frameCollisions.clear();
 	}
 
 	void TriggerVolume::Awake() {
@@ -146,12 +153,9 @@ namespace Gameplay::Physics {
 			collider->Awake(context);
 		}
 
-		// Create our compound shape and add all colliders
-		_shape = new btCompoundShape(true, _colliders.size());
-		_shape->setLocalScaling(ToBt(context->GetScale()));
-		for (auto& collider : _colliders) {
-			_AddColliderToShape(collider.get());
-		}
+		// Get a compound shape with all of our colliders, shared with any other objects with the same colliders and scale
+		_baseScale = _prevScale;
+		_RebuildShape();
 
 		// Create the ghost object
 		_ghost = new btPairCachingGhostObject();
@@ -163,6 +167,7 @@ namespace Gameplay::Physics {
 		btTransform transform;
 		_CopyGameobjectTransformTo(transform);
 		_ghost->setWorldTransform(transform);
+		_MarkGameobjectSynced();
 
 		// Add the object to the scene
 		_scene->GetPhysicsWorld()->addCollisionObject(_ghost);
@@ -192,6 +197,10 @@ namespace Gameplay::Physics {
 		return _ghost != nullptr ? _ghost->getBroadphaseHandle() : nullptr;
 	}
 
+	btCollisionObject* TriggerVolume::_GetCollisionObject() {
+		return _ghost;
+	}
+
 	void TriggerVolume::SetFlags(TriggerTypeFlags flags) {
 		_typeFlags = flags;
 	}
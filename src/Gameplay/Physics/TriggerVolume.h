@@ -39,6 +39,13 @@ namespace Gameplay::Physics {
 		/// <param name="dt">The time in seconds since the last frame</param>
 		virtual void PhysicsPostStep(float dt) override;
 
+		/// <summary>
+		/// Hands the bodies touching each trigger volume in the world to the triggers, from the contacts that the
+		/// world found during it's last step. Should be called once after stepping, before PhysicsPostStep
+		/// </summary>
+		/// <param name="world">The world to read the contacts from</param>
+		static void GatherContacts(btCollisionWorld* world);
+
 		void SetFlags(TriggerTypeFlags flags);
 		TriggerTypeFlags GetFlags() const;
 
@@ -54,9 +61,22 @@ namespace Gameplay::Physics {
 		btPairCachingGhostObject*   _ghost;
 		TriggerTypeFlags            _typeFlags;
 
-		std::vector<std::weak_ptr<RigidBody>> _currentCollisions;
+		// A body that's touching the trigger, the key is only used for sorting and comparing
+		struct Contact {
+			const RigidBody*          Key;
+			std::weak_ptr<RigidBody>  Body;
+		};
+
+		// The bodies that were inside the trigger last frame, sorted by key
+		std::vector<Contact> _currentCollisions;
+		// The bodies found by GatherContacts this frame
+		std::vector<Contact> _frameCollisions;
+
+		void _AddContact(const btRigidBody* body);
 
 		virtual btBroadphaseProxy* _GetBroadphaseHandle() override;
 
+		virtual btCollisionObject* _GetCollisionObject() override;
+
 	};
 }
\ No newline at end of file
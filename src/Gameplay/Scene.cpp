@@ -3,12 +3,17 @@
 #include <GLFW/glfw3.h>
 #include <locale>
 #include <codecvt>
+#include <algorithm>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 
 #include "Utils/FileHelpers.h"
 #include "Utils/GlmBulletConversions.h"
 
 #include "Gameplay/Physics/RigidBody.h"
 #include "Gameplay/Physics/TriggerVolume.h"
+#include "Gameplay/Physics/BulletTaskScheduler.h"
 #include "Gameplay/MeshResource.h"
 #include "Gameplay/Material.h"
 
@@ -23,6 +28,8 @@ namespace Gameplay {
 		_deletionQueue(std::vector<std::weak_ptr<GameObject>>()),
 		Lights(std::vector<Light>()),
 		IsPlaying(false),
+		PhysicsTimestep(1.0f / 60.0f),
+		MaxPhysicsSubsteps(5),
 		MainCamera(nullptr),
 		DefaultMaterial(nullptr),
 		_isAwake(false),
@@ -31,7 +38,22 @@ namespace Gameplay {
 		_skyboxMesh(nullptr),
 		_skyboxTexture(nullptr),
 		_skyboxRotation(glm::mat3(1.0f)),
-		_gravity(glm::vec3(0.0f, 0.0f, -9.81f))
+		_gravity(glm::vec3(0.0f, 0.0f, -9.81f)),
+		_physicsAccumulator(0.0f),
+		_physicsInterpolation(1.0f),
+		_physicsStepTime(0.0),
+		_physicsPreSyncTime(0.0),
+		_physicsPostSyncTime(0.0),
+		_isPhysicsMultithreaded(false),
+		_broadphaseType(PhysicsBroadphaseType::Dbvt),
+		_physicsWorldMin(glm::vec3(-1000.0f)),
+		_physicsWorldMax(glm::vec3(1000.0f)),
+		_axisSweepMaxHandles(AXIS_SWEEP_16BIT_HANDLES),
+		_solverIterations(10),
+		_contactBreakingThreshold(0.02f),
+		_physicsStepCount(0),
+		_physicsSyncStats(),
+		_solverPool(nullptr)
 	{
 		_lightingUbo = std::make_shared<UniformBuffer<LightingUboStruct>>();
 		_lightingUbo->GetData().AmbientCol = glm::vec3(0.1f);
@@ -60,6 +82,50 @@ namespace Gameplay {
 		_bulletDebugDraw->setDebugMode((btIDebugDraw::DebugDrawModes)mode);
 	}
 
+	void Scene::SetMultithreadedPhysics(bool value) {
+		if (value == _isPhysicsMultithreaded) {
+			return;
+		}
+		LOG_ASSERT(!_isAwake, "Physics threading must be set before the scene is awoken!");
+
+		_isPhysicsMultithreaded = value;
+		_RebuildPhysics();
+	}
+
+	void Scene::SetPhysicsBroadphase(PhysicsBroadphaseType type) {
+		if (type == _broadphaseType) {
+			return;
+		}
+		LOG_ASSERT(!_isAwake, "Physics broadphase must be set before the scene is awoken!");
+
+		_broadphaseType = type;
+		_RebuildPhysics();
+	}
+
+	void Scene::SetPhysicsWorldBounds(const glm::vec3& min, const glm::vec3& max) {
+		if (min == _physicsWorldMin && max == _physicsWorldMax) {
+			return;
+		}
+		LOG_ASSERT(!_isAwake, "Physics world bounds must be set before the scene is awoken!");
+		LOG_ASSERT(glm::all(glm::lessThan(min, max)), "Physics world bounds must have a positive size!");
+
+		_physicsWorldMin = min;
+		_physicsWorldMax = max;
+		// Only the axis sweep broadphase cares about the bounds
+		if (_broadphaseType == PhysicsBroadphaseType::AxisSweep) {
+			_RebuildPhysics();
+		}
+	}
+
+	void Scene::SetPhysicsSolverIterations(int value) {
+		_solverIterations = glm::max(value, 1);
+		_physicsWorld->getSolverInfo().m_numIterations = _solverIterations;
+	}
+
+	void Scene::SetContactBreakingThreshold(float value) {
+		_contactBreakingThreshold = glm::max(value, 0.0f);
+	}
+
 	BulletDebugMode Scene::GetPhysicsDebugDrawMode() const {
 		return (BulletDebugMode)_bulletDebugDraw->getDebugMode();
 	}
@@ -169,6 +235,19 @@ namespace Gameplay {
 			_skyboxMesh->GenerateMesh();
 		}
 
+		// The axis sweep broadphase has a fixed number of handles, so we make sure it has room for everything
+		// before any bodies get added to the world, with some to spare for objects created while playing
+		if (_broadphaseType == PhysicsBroadphaseType::AxisSweep) {
+			int physicsObjects = 0;
+			_components.Each<Gameplay::Physics::RigidBody>([&](const std::shared_ptr<Gameplay::Physics::RigidBody>&) { physicsObjects++; }, true);
+			_components.Each<Gameplay::Physics::TriggerVolume>([&](const std::shared_ptr<Gameplay::Physics::TriggerVolume>&) { physicsObjects++; }, true);
+			int handles = glm::max(physicsObjects * 2, AXIS_SWEEP_16BIT_HANDLES);
+			if (handles != _axisSweepMaxHandles) {
+				_axisSweepMaxHandles = handles;
+				_RebuildPhysics();
+			}
+		}
+
 		// Call awake on all gameobjects
 		for (auto& obj : _objects) {
 			obj->Awake();
@@ -180,23 +259,70 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
+		_physicsSyncStats = PhysicsSyncStats();
+		_physicsStepTime = 0.0;
+		_physicsPostSyncTime = 0.0;
+
+		// Bullet reads the contact breaking threshold from a global when it creates contacts, so we set it
+		// every frame in case another scene has changed it
+		gContactBreakingThreshold = _contactBreakingThreshold;
+
+		double syncStartTime = glfwGetTime();
 		_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
 			body->PhysicsPreStep(dt);
 		});
 		_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
 			body->PhysicsPreStep(dt);
 		});
+		_physicsPreSyncTime = glfwGetTime() - syncStartTime;
 
 		if (IsPlaying) {
+			// Physics always steps by the same amount, so it behaves the same at any frame rate. If we're too far
+			// behind to catch up within our step limit, we drop the extra time rather than falling further behind.
+			// The settings are public, so we make sure a bad value can't stall the frame or divide by zero
+			PhysicsTimestep    = glm::max(PhysicsTimestep, MIN_PHYSICS_TIMESTEP);
+			MaxPhysicsSubsteps = glm::max(MaxPhysicsSubsteps, 1);
+			_physicsAccumulator = glm::min(_physicsAccumulator + dt, PhysicsTimestep * MaxPhysicsSubsteps);
+			int steps = static_cast<int>(_physicsAccumulator / PhysicsTimestep);
+			_physicsAccumulator -= steps * PhysicsTimestep;
+
+			double startTime = glfwGetTime();
+			for (int step = 0; step < steps; step++) {
+				// Bodies that Bullet moves during the step record the step count, so it needs to be updated first
+				_physicsStepCount++;
+				_physicsWorld->stepSimulation(PhysicsTimestep, 0);
+			}
+			_physicsInterpolation = _physicsAccumulator / PhysicsTimestep;
+			_physicsStepTime = glfwGetTime() - startTime;
 
-			_physicsWorld->stepSimulation(dt, 1);
-
+			syncStartTime = glfwGetTime();
 			_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
 				body->PhysicsPostStep(dt);
 			});
+			Gameplay::Physics::TriggerVolume::GatherContacts(_physicsWorld);
 			_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
 				body->PhysicsPostStep(dt);
 			});
+			_physicsPostSyncTime = glfwGetTime() - syncStartTime;
+		}
+
+		// Queries run after the step, against bullet's transforms from the latest step. Rendered transforms are
+		// interpolated between the last two steps, so they can lag up to one step behind what the queries see
+		syncStartTime = glfwGetTime();
+		for (const auto& batch : _queuedQueries) {
+			batch->Run(_physicsWorld);
+		}
+		_queuedQueries.clear();
+		_physicsPostSyncTime += glfwGetTime() - syncStartTime;
+	}
+
+	void Scene::RunSpatialQueries(Physics::SpatialQueryBatch& batch) {
+		batch.Run(_physicsWorld);
+	}
+
+	void Scene::QueueSpatialQueries(const Physics::SpatialQueryBatch::Sptr& batch) {
+		if (std::find(_queuedQueries.begin(), _queuedQueries.end(), batch) == _queuedQueries.end()) {
+			_queuedQueries.push_back(batch);
 		}
 	}
 
@@ -279,6 +405,17 @@ namespace Gameplay {
 			result->SetAmbientLight((data["ambient"]));
 		}
 
+		if (data.contains("physics") && data["physics"].is_object()) {
+			const nlohmann::json& blob = data["physics"];
+			result->PhysicsTimestep    = glm::max(JsonGet(blob, "timestep", result->PhysicsTimestep), MIN_PHYSICS_TIMESTEP);
+			result->MaxPhysicsSubsteps = glm::max(JsonGet(blob, "max_substeps", result->MaxPhysicsSubsteps), 1);
+			result->SetPhysicsSolverIterations(JsonGet(blob, "solver_iterations", result->_solverIterations));
+			result->SetContactBreakingThreshold(JsonGet(blob, "contact_breaking_threshold", result->_contactBreakingThreshold));
+			result->SetPhysicsWorldBounds(JsonGet(blob, "world_min", result->_physicsWorldMin), JsonGet(blob, "world_max", result->_physicsWorldMax));
+			result->SetPhysicsBroadphase(JsonParseEnum(PhysicsBroadphaseType, blob, "broadphase", PhysicsBroadphaseType::Dbvt));
+			result->SetMultithreadedPhysics(JsonGet(blob, "multithreaded", false));
+		}
+
 		if (data.contains("skybox") && data["skybox"].is_object()) {
 			nlohmann::json& blob = data["skybox"].get<nlohmann::json>();
 			result->_skyboxMesh = ResourceManager::Get<MeshResource>(Guid(blob["mesh"]));
@@ -324,6 +461,16 @@ namespace Gameplay {
 
 		blob["ambient"] = GetAmbientLight();
 
+		blob["physics"] = nlohmann::json();
+		blob["physics"]["timestep"] = PhysicsTimestep;
+		blob["physics"]["max_substeps"] = MaxPhysicsSubsteps;
+		blob["physics"]["multithreaded"] = _isPhysicsMultithreaded;
+		blob["physics"]["broadphase"] = ~_broadphaseType;
+		blob["physics"]["world_min"] = _physicsWorldMin;
+		blob["physics"]["world_max"] = _physicsWorldMax;
+		blob["physics"]["solver_iterations"] = _solverIterations;
+		blob["physics"]["contact_breaking_threshold"] = _contactBreakingThreshold;
+
 		blob["skybox"] = nlohmann::json();
 		blob["skybox"]["mesh"] = _skyboxMesh ? _skyboxMesh->GetGUID().str() : "null";
 		blob["skybox"]["shader"] = _skyboxShader ? _skyboxShader->GetGUID().str() : "null";
@@ -378,32 +525,90 @@ namespace Gameplay {
 	}
 
 	void Scene::_InitPhysics() {
-		_collisionConfig = new btDefaultCollisionConfiguration();
-		_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
-		_broadphaseInterface = new btDbvtBroadphase();
+		_solverPool = nullptr;
+		if (_broadphaseType == PhysicsBroadphaseType::AxisSweep) {
+			btVector3 worldMin = btVector3(_physicsWorldMin.x, _physicsWorldMin.y, _physicsWorldMin.z);
+			btVector3 worldMax = btVector3(_physicsWorldMax.x, _physicsWorldMax.y, _physicsWorldMax.z);
+			// The 16 bit version is smaller and faster, but can't index more than 16384 objects
+			if (_axisSweepMaxHandles <= AXIS_SWEEP_16BIT_HANDLES) {
+				_broadphaseInterface = new btAxisSweep3(worldMin, worldMax, static_cast<unsigned short>(_axisSweepMaxHandles));
+			} else {
+				_broadphaseInterface = new bt32BitAxisSweep3(worldMin, worldMax, static_cast<unsigned int>(_axisSweepMaxHandles));
+			}
+		} else {
+			_broadphaseInterface = new btDbvtBroadphase();
+		}
 		_ghostCallback = new btGhostPairCallback();
 		_broadphaseInterface->getOverlappingPairCache()->setInternalGhostPairCallback(_ghostCallback);
-		_constraintSolver = new btSequentialImpulseConstraintSolver();
-		_physicsWorld = new btDiscreteDynamicsWorld(
-			_collisionDispatcher,
-			_broadphaseInterface,
-			_constraintSolver,
-			_collisionConfig
-		);
+
+		#if BT_THREADSAFE
+		if (_isPhysicsMultithreaded) {
+			// The scheduler has to be active before anything sizes it's per thread storage
+			BulletTaskScheduler* scheduler = BulletTaskScheduler::Get();
+
+			// Multithreaded scenes tend to be large, so we start with bigger pools to avoid falling back to the heap
+			btDefaultCollisionConstructionInfo constructionInfo;
+			constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 80000;
+			constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
+			_collisionConfig = new btDefaultCollisionConfiguration(constructionInfo);
+			_collisionDispatcher = new btCollisionDispatcherMt(_collisionConfig, 40);
+
+			// The world splits islands between a pool of solvers, and uses the multithreaded solver for large islands
+			btConstraintSolverPoolMt* solverPool = new btConstraintSolverPoolMt(scheduler->getNumThreads());
+			btSequentialImpulseConstraintSolverMt* solver = new btSequentialImpulseConstraintSolverMt();
+			_solverPool = solverPool;
+			_constraintSolver = solver;
+			_physicsWorld = new btDiscreteDynamicsWorldMt(
+				_collisionDispatcher,
+				_broadphaseInterface,
+				solverPool,
+				solver,
+				_collisionConfig
+			);
+			LOG_INFO("Created multithreaded physics world with {} threads", scheduler->getNumThreads());
+		} else
+		#else
+		if (_isPhysicsMultithreaded) {
+			LOG_WARN("Bullet was built without BT_THREADSAFE, using the single threaded physics world");
+		}
+		#endif
+		{
+			_collisionConfig = new btDefaultCollisionConfiguration();
+			_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
+			_constraintSolver = new btSequentialImpulseConstraintSolver();
+			_physicsWorld = new btDiscreteDynamicsWorld(
+				_collisionDispatcher,
+				_broadphaseInterface,
+				_constraintSolver,
+				_collisionConfig
+			);
+		}
+
 		_physicsWorld->setGravity(ToBt(_gravity));
+		_physicsWorld->getSolverInfo().m_numIterations = _solverIterations;
 		// TODO bullet debug drawing
 		_bulletDebugDraw = new BulletDebugDraw();
 		_physicsWorld->setDebugDrawer(_bulletDebugDraw);
 		_bulletDebugDraw->setDebugMode(btIDebugDraw::DBG_NoDebug);
 	}
 
+	void Scene::_RebuildPhysics() {
+		// Nothing has been added to the world yet, so we can just swap it out
+		BulletDebugMode debugMode = GetPhysicsDebugDrawMode();
+		_CleanupPhysics();
+		_InitPhysics();
+		SetPhysicsDebugDrawMode(debugMode);
+	}
+
 	void Scene::_CleanupPhysics() {
 		delete _physicsWorld;
 		delete _constraintSolver;
+		delete _solverPool;
 		delete _broadphaseInterface;
 		delete _ghostCallback;
 		delete _collisionDispatcher;
 		delete _collisionConfig;
+		delete _bulletDebugDraw;
 	}
 
 
@@ -433,9 +638,11 @@ namespace Gameplay {
 		}
 	}
 
-	void Scene::DrawSkybox()
+	void Scene::DrawSkybox(const std::shared_ptr<ShaderProgram>& shader /*= nullptr*/)
 	{
-		if (_skyboxShader != nullptr &&
+		const std::shared_ptr<ShaderProgram>& skyboxShader = shader != nullptr ? shader : _skyboxShader;
+
+		if (skyboxShader != nullptr &&
 			_skyboxMesh != nullptr &&
 			_skyboxMesh->Mesh != nullptr &&
 			_skyboxTexture != nullptr &&
@@ -445,9 +652,9 @@ namespace Gameplay {
 			glDisable(GL_CULL_FACE);
 			glDepthFunc(GL_LEQUAL); 
 
-			_skyboxShader->Bind();
-			_skyboxShader->SetUniformMatrix("u_ClippedView", MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
-			_skyboxShader->SetUniformMatrix("u_EnvironmentRotation", _skyboxRotation);
+			skyboxShader->Bind();
+			skyboxShader->SetUniformMatrix("u_ClippedView", MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
+			skyboxShader->SetUniformMatrix("u_EnvironmentRotation", _skyboxRotation);
 			_skyboxTexture->Bind(0);
 			_skyboxMesh->Mesh->Draw();
 
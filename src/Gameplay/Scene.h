@@ -1,4 +1,5 @@
 #pragma once
+#include <EnumToString.h>
 #include <btBulletDynamicsCommon.h>
 #include "BulletCollision/CollisionDispatch/btGhostObject.h"
 
@@ -7,12 +8,23 @@
 #include "Gameplay/Light.h"
 
 #include "Physics/BulletDebugDraw.h"
+#include "Physics/SpatialQueryBatch.h"
 
 #include "Graphics/Buffers/UniformBuffer.h"
 #include "Graphics/Textures/Texture3D.h"
 
 struct GLFWwindow;
 
+/// <summary>
+/// The broadphase algorithms that a scene's physics world can use to find pairs of objects that may be touching
+/// </summary>
+ENUM(PhysicsBroadphaseType, int,
+	// Bullet's dynamic AABB tree, works for worlds of any size and handles lots of moving objects well
+	Dbvt      = 0,
+	// Sweep and prune along each axis, needs to know the bounds of the world. Tends to be faster when most objects are still
+	AxisSweep = 1
+);
+
 class TextureCube;
 class ShaderProgram;
 
@@ -24,6 +36,7 @@ const int LIGHT_UBO_BINDING_SLOT = 0;
 namespace Gameplay {
 	namespace Physics {
 		class RigidBody;
+		class PhysicsBase;
 	}
 
 	class MeshResource;
@@ -40,6 +53,10 @@ namespace Gameplay {
 
 		static const int MAX_LIGHTS = 8;
 		static const int LIGHT_UBO_BINDING = 2;
+		// The shortest physics step we allow, anything shorter would need thousands of steps per second
+		static constexpr float MIN_PHYSICS_TIMESTEP = 0.0001f;
+		// The most objects the 16 bit axis sweep broadphase can hold, bigger scenes use the 32 bit version
+		static constexpr int AXIS_SWEEP_16BIT_HANDLES = 16384;
 
 		// Stores all the lights in our scene
 		std::vector<Light>         Lights;
@@ -52,6 +69,13 @@ namespace Gameplay {
 		// Whether the application is in "play mode", lets us leverage editors!
 		bool                       IsPlaying;
 
+		// The length of each physics step in seconds, the world always advances by whole steps.
+		// Values below MIN_PHYSICS_TIMESTEP are treated as MIN_PHYSICS_TIMESTEP
+		float                      PhysicsTimestep;
+		// The most physics steps we'll take in one frame. If we fall further behind than this, the extra
+		// time is dropped so that slow frames don't cause even slower frames. Always at least 1
+		int                        MaxPhysicsSubsteps;
+
 
 		Scene();
 		~Scene();
@@ -59,6 +83,83 @@ namespace Gameplay {
 		void SetPhysicsDebugDrawMode(BulletDebugMode mode);
 		BulletDebugMode GetPhysicsDebugDrawMode() const;
 
+		/// <summary>
+		/// Sets whether the physics world should use bullet's multithreaded world, dispatcher and solvers,
+		/// running on the shared thread pool. This re-creates the physics world, so it must be set before
+		/// the scene is awoken. Falls back to the single threaded world if bullet wasn't built with BT_THREADSAFE
+		/// </summary>
+		/// <param name="value">True to use the multithreaded world</param>
+		void SetMultithreadedPhysics(bool value);
+		/// <summary>
+		/// Gets whether the multithreaded physics world was requested for this scene
+		/// </summary>
+		bool GetMultithreadedPhysics() const { return _isPhysicsMultithreaded; }
+		/// <summary>
+		/// Gets the time spent stepping the physics world in the last frame, in seconds
+		/// </summary>
+		double GetPhysicsStepTime() const { return _physicsStepTime; }
+		/// <summary>
+		/// Gets the time spent sending gameobject transforms to Bullet in the last frame, in seconds
+		/// </summary>
+		double GetPhysicsPreSyncTime() const { return _physicsPreSyncTime; }
+		/// <summary>
+		/// Gets the time spent copying results out of Bullet in the last frame, including trigger events
+		/// and queued spatial queries, in seconds
+		/// </summary>
+		double GetPhysicsPostSyncTime() const { return _physicsPostSyncTime; }
+
+		/// <summary>
+		/// Sets the broadphase used by the physics world. This re-creates the physics world, so it must be
+		/// set before the scene is awoken
+		/// </summary>
+		/// <param name="type">The new broadphase type</param>
+		void SetPhysicsBroadphase(PhysicsBroadphaseType type);
+		PhysicsBroadphaseType GetPhysicsBroadphase() const { return _broadphaseType; }
+		/// <summary>
+		/// Sets the bounds of the world for the axis sweep broadphase. Objects outside of the bounds will
+		/// still be simulated, but the broadphase gets much slower for them. Must be set before the scene is awoken
+		/// </summary>
+		/// <param name="min">The minimum corner of the world</param>
+		/// <param name="max">The maximum corner of the world</param>
+		void SetPhysicsWorldBounds(const glm::vec3& min, const glm::vec3& max);
+		const glm::vec3& GetPhysicsWorldMin() const { return _physicsWorldMin; }
+		const glm::vec3& GetPhysicsWorldMax() const { return _physicsWorldMax; }
+		/// <summary>
+		/// Sets the number of iterations the constraint solver runs per step. More iterations make stacks
+		/// and joints more stable, at the cost of solver time. Default is 10
+		/// </summary>
+		/// <param name="value">The number of iterations, must be at least 1</param>
+		void SetPhysicsSolverIterations(int value);
+		int GetPhysicsSolverIterations() const { return _solverIterations; }
+		/// <summary>
+		/// Sets how far apart contact points can move before Bullet discards them. Bullet uses a relative threshold
+		/// (CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD), so this is a factor that gets multiplied by each shape's
+		/// angular motion disc (about it's bounding radius), not a distance. Larger values keep contacts around for
+		/// longer, which is more stable but can leave stale contacts. Default is 0.02
+		/// </summary>
+		/// <param name="value">The new threshold factor, negative values are clamped to 0</param>
+		void SetContactBreakingThreshold(float value);
+		float GetContactBreakingThreshold() const { return _contactBreakingThreshold; }
+
+		/// <summary>
+		/// Counts how many physics objects had their transforms copied between their gameobjects
+		/// and Bullet in the last frame, and how many were skipped because nothing had changed
+		/// </summary>
+		struct PhysicsSyncStats {
+			// Objects that were moved by outside code, and were sent to Bullet
+			int Pushed = 0;
+			// Objects that hadn't moved since they were last synced
+			int PushSkipped = 0;
+			// Dynamic bodies that Bullet moved, and were copied back to their gameobjects
+			int Pulled = 0;
+			// Dynamic bodies that were asleep, and were left alone
+			int PullSkipped = 0;
+		};
+		/// <summary>
+		/// Gets the transform sync counts from the last call to DoPhysics
+		/// </summary>
+		const PhysicsSyncStats& GetPhysicsSyncStats() const { return _physicsSyncStats; }
+
 		void SetSkyboxShader(const std::shared_ptr<ShaderProgram>& shader);
 		std::shared_ptr<ShaderProgram> GetSkyboxShader() const;
 
@@ -135,6 +236,33 @@ namespace Gameplay {
 		/// <param name="dt">The time in seconds since the last frame</param>
 		void DoPhysics(float dt);
 		/// <summary>
+		/// Gets how far we are between the last two physics steps, in the 0-1 range. Used by
+		/// rigid bodies to interpolate their transforms, since frames rarely line up with steps
+		/// </summary>
+		float GetPhysicsInterpolation() const { return _physicsInterpolation; }
+		/// <summary>
+		/// Gets the number of physics steps this scene has taken, rigid bodies use this to tell if
+		/// they were moved in the most recent step
+		/// </summary>
+		uint64_t GetPhysicsStepCount() const { return _physicsStepCount; }
+
+		/// <summary>
+		/// Runs a batch of raycasts, sweeps and overlap tests against the physics world right away. Large batches
+		/// are only split across the thread pool when bullet is built with BT_THREADSAFE, which nothing in this
+		/// project defines, so by default the batch runs serially on the calling thread. Must not be called while
+		/// the world is being stepped
+		/// </summary>
+		/// <param name="batch">The batch to run, it's results will be filled in</param>
+		void RunSpatialQueries(Physics::SpatialQueryBatch& batch);
+		/// <summary>
+		/// Queues a batch of queries to run at the end of the next call to DoPhysics, once the world has
+		/// been stepped. Queries see bullet's transforms from the latest step, which can be up to one step
+		/// ahead of the interpolated transforms that get rendered. Runs serially like RunSpatialQueries
+		/// unless bullet is built with BT_THREADSAFE. The results will be ready for the next Update
+		/// </summary>
+		/// <param name="batch">The batch to run, the scene holds onto it until it's been run</param>
+		void QueueSpatialQueries(const Physics::SpatialQueryBatch::Sptr& batch);
+		/// <summary>
 		/// Renders debug information for the physics scene
 		/// </summary>
 		void DrawPhysicsDebug();
@@ -176,7 +304,11 @@ namespace Gameplay {
 		/// </summary>
 		void DrawAllGameObjectGUIs();
 
-		void DrawSkybox();
+		/// <summary>
+		/// Draws the skybox for the scene
+		/// </summary>
+		/// <param name="shader">The shader to draw with (ex: a variant of the skybox shader), or nullptr to use the skybox shader</param>
+		void DrawSkybox(const std::shared_ptr<ShaderProgram>& shader = nullptr);
 
 		/// <summary>
 		/// Gets the scene's Bullet physics world
@@ -214,6 +346,7 @@ namespace Gameplay {
 	protected:
 		friend class HierarchyWindow;
 		friend class GameObject;
+		friend class Physics::PhysicsBase;
 
 		// The component manager will store all components for objects in this scene
 		ComponentManager _components;
@@ -228,6 +361,8 @@ namespace Gameplay {
 		btBroadphaseInterface*    _broadphaseInterface;
 		// Resolves contraints (ex: hinge constraints, angle axis, etc...)
 		btConstraintSolver*       _constraintSolver;
+		// The per thread solvers used by the multithreaded world, or nullptr
+		btConstraintSolver*       _solverPool;
 		// this is what allows us to get our pairs from the trigger volumes
 		btGhostPairCallback*      _ghostCallback;
 
@@ -239,6 +374,25 @@ namespace Gameplay {
 		// Our physics scene's global gravity, default matches earth's gravity (m/s^2)
 		glm::vec3 _gravity;
 
+		// The time that has passed that hasn't been simulated yet, always less than PhysicsTimestep after DoPhysics
+		float _physicsAccumulator;
+		float _physicsInterpolation;
+		double _physicsStepTime;
+		double _physicsPreSyncTime;
+		double _physicsPostSyncTime;
+		bool  _isPhysicsMultithreaded;
+		PhysicsBroadphaseType _broadphaseType;
+		glm::vec3 _physicsWorldMin;
+		glm::vec3 _physicsWorldMax;
+		// The number of objects the axis sweep broadphase has room for, sized in Awake
+		int   _axisSweepMaxHandles;
+		int   _solverIterations;
+		float _contactBreakingThreshold;
+		uint64_t _physicsStepCount;
+		PhysicsSyncStats _physicsSyncStats;
+		// Query batches waiting for the end of the next physics update
+		std::vector<Physics::SpatialQueryBatch::Sptr> _queuedQueries;
+
 		// Stores all the objects in our scene
 		std::vector<GameObject::Sptr>  _objects;
 		std::vector<std::weak_ptr<GameObject>>  _deletionQueue;
@@ -292,6 +446,11 @@ namespace Gameplay {
 		/// </summary>
 		void _InitPhysics();
 		/// <summary>
+		/// Replaces the physics world with a new one using our current settings, can only be used before
+		/// anything has been added to the world
+		/// </summary>
+		void _RebuildPhysics();
+		/// <summary>
 		/// Handles cleaning up bullet physics for this scene
 		/// </summary>
 		void _CleanupPhysics();
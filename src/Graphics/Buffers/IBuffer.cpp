@@ -5,7 +5,8 @@ IBuffer::IBuffer(BufferType type, BufferUsage usage) :
 	IGraphicsResource(),
 	_elementCount(0),
 	_elementSize(0),
-	_size(0)
+	_size(0),
+	_isImmutable(false)
 {
 	_type = type;
 	_usage = usage;
@@ -24,18 +25,39 @@ IBuffer::~IBuffer() {
 }
 
 void IBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) {
+	if (_isImmutable) {
+		LOG_ASSERT(false, "Cannot re-load data into a buffer with immutable storage!");
+		return;
+	}
+
 	// Note, this is part of the bindless state access stuff added in 4.5
 	glNamedBufferData(_rendererId, (GLsizeiptr)elementSize * elementCount, data, (GLenum)_usage);
 
 	_elementCount = elementCount;
 	_elementSize = elementSize;
 	_size = elementCount * elementSize;
+	_SetGpuMemoryUsage(_size);
+}
+
+void IBuffer::LoadStorage(const void* data, uint32_t elementSize, uint32_t elementCount, BufferStorageFlags flags) {
+	if (_isImmutable) {
+		LOG_ASSERT(false, "Buffer storage has already been allocated!");
+		return;
+	}
+
+	glNamedBufferStorage(_rendererId, (GLsizeiptr)elementSize * elementCount, data, *flags);
+
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+	_size = elementCount * elementSize;
+	_isImmutable = true;
+	_SetGpuMemoryUsage(_size);
 }
 
 void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize /*= true*/)
 {
 	if (elementSize * elementCount > _size) {
-		if (allowResize) {
+		if (allowResize && !_isImmutable) {
 			glNamedBufferData(_rendererId, (GLsizeiptr)elementSize * elementCount, data, (GLenum)_usage);
 
 			LOG_INFO("Expanding buffer from {} bytes to {} bytes", _size, elementCount * elementSize);
@@ -43,6 +65,7 @@ void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elemen
 			_elementCount = elementCount;
 			_elementSize = elementSize;
 			_size = elementCount * elementSize;
+			_SetGpuMemoryUsage(_size);
 		} else {
 			LOG_ASSERT(false, "Attempting to write beyond the end of the buffer!");
 		}
@@ -50,6 +73,7 @@ void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elemen
 		if (_size == 0) {
 			glNamedBufferData(_rendererId, (GLsizeiptr)elementSize * elementCount, data, (GLenum)_usage);
 			_size = elementCount * elementSize;
+			_SetGpuMemoryUsage(_size);
 		} else {
 			glNamedBufferSubData(_rendererId, 0, (GLsizeiptr)elementSize * elementCount, data);
 		}
@@ -22,6 +22,19 @@ ENUM_FLAGS(BufferMapMode, uint32_t,
 	Unsynchronized   = GL_MAP_UNSYNCHRONIZED_BIT
 );
 
+/// <summary>
+/// Flags for immutable buffer storage, see glBufferStorage
+/// </summary>
+ENUM_FLAGS(BufferStorageFlags, uint32_t,
+	None           = 0,
+	DynamicStorage = GL_DYNAMIC_STORAGE_BIT,
+	Read           = GL_MAP_READ_BIT,
+	Write          = GL_MAP_WRITE_BIT,
+	Persistent     = GL_MAP_PERSISTENT_BIT,
+	Coherent       = GL_MAP_COHERENT_BIT,
+	ClientStorage  = GL_CLIENT_STORAGE_BIT
+);
+
 /// <summary>
 /// This is our abstract base class for all our OpenGL buffer types
 /// </summary>
@@ -43,6 +56,17 @@ public:
 	/// <param name="elementCount">The number of elements to upload</param>
 	virtual void LoadData(const void* data, uint32_t elementSize, uint32_t elementCount);
 
+	/// <summary>
+	/// Allocates immutable storage for this buffer and fills it with data (glNamedBufferStorage). The buffer
+	/// can't be resized or loaded again afterwards, and can only be updated if flags includes DynamicStorage.
+	/// The data is copied during the call, so it can come straight from a memory mapped file
+	/// </summary>
+	/// <param name="data">The data that you want to load into the buffer</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to upload</param>
+	/// <param name="flags">The ways that the buffer can be accessed after creation</param>
+	virtual void LoadStorage(const void* data, uint32_t elementSize, uint32_t elementCount, BufferStorageFlags flags = BufferStorageFlags::None);
+
 	/// <summary>
 	/// Updates data within the buffer, optionally resizing the buffer
 	/// </summary>
@@ -83,6 +107,10 @@ public:
 	/// Returns the usage hint for this buffer (ex GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	/// </summary>
 	BufferUsage GetUsage() const { return _usage; }
+	/// <summary>
+	/// Returns true if this buffer's storage was created with LoadStorage, and can't be resized
+	/// </summary>
+	bool IsImmutable() const { return _isImmutable; }
 
 	/// <summary>
 	/// Maps the buffer's data to a pointer that the CPU can access. Note that unmap should be called
@@ -134,4 +162,5 @@ protected:
 	uint32_t _size; // The size of the buffer in bytes
 	BufferUsage _usage; // The buffer usage mode (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	BufferType _type; // The buffer type (ex GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)
+	bool _isImmutable; // True if the storage was allocated with glNamedBufferStorage
 };
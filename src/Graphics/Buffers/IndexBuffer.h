@@ -30,6 +30,9 @@ public:
 	inline void LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) override {
 		throw std::runtime_error("Must use the templated overload, or the LoadData that specifies the element type");
 	}
+	inline void LoadStorage(const void* data, uint32_t elementSize, uint32_t elementCount, BufferStorageFlags flags = BufferStorageFlags::None) override {
+		throw std::runtime_error("Must use the LoadStorage overload that specifies the element type");
+	}
 
 	/// <summary>
 	/// Loads some data into our index buffer, specifying the type of indices we are using via the elementType parameter
@@ -43,6 +46,19 @@ public:
 		_elementType = elementType;
 	}
 
+	/// <summary>
+	/// Loads indices into immutable storage, see IBuffer::LoadStorage
+	/// </summary>
+	/// <param name="data">The pointer to the data to load in</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to upload</param>
+	/// <param name="elementType">The type of elements you are storing (GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT)</param>
+	/// <param name="flags">The ways that the buffer can be accessed after creation</param>
+	inline void LoadStorage(const void* data, uint32_t elementSize, uint32_t elementCount, IndexType elementType, BufferStorageFlags flags = BufferStorageFlags::None) {
+		IBuffer::LoadStorage(data, elementSize, elementCount, flags);
+		_elementType = elementType;
+	}
+
 	/// <summary>
 	/// Loads data of a known type into this index buffer
 	/// </summary>
@@ -13,6 +13,7 @@ AbstractUniformBuffer::AbstractUniformBuffer(uint32_t sizeInBytes, BufferUsage u
 	_size = sizeInBytes;
 	memset(_rawData, 0, sizeInBytes);
 	glNamedBufferData(_rendererId, _size, _rawData, (GLenum)_usage);
+	_SetGpuMemoryUsage(_size);
 }
 
 void AbstractUniformBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) {
@@ -4,18 +4,23 @@ DebugDrawer::DebugDrawer() :
 	_colorStack(std::stack<glm::vec3>()),
 	_transformStack(std::stack<glm::mat4>()),
 	_viewProjection(glm::mat4(1.0f)),
-	_lineOffset(0),
-	_triangleOffset(0)
+	_lines(),
+	_tris()
 {
+	_lines.ReserveVertexSpace(LINE_BATCH_SIZE * 2);
+	_tris.ReserveVertexSpace(TRI_BATCH_SIZE * 3);
+
+	// The buffers are attached while empty so that the VAOs draw however many vertices are in
+	// them, then we allocate a full batch so that flushing only has to upload the used range
 	_linesVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
-	_linesVBO->LoadData<VertexPosCol>(nullptr, LINE_BATCH_SIZE * 2);
 	_linesVAO = VertexArrayObject::Create();
 	_linesVAO->AddVertexBuffer(_linesVBO, VertexPosCol::V_DECL);
+	_linesVBO->LoadData<VertexPosCol>(nullptr, LINE_BATCH_SIZE * 2);
 
 	_trisVBO = VertexBuffer::Create(BufferUsage::DynamicDraw);
-	_trisVBO->LoadData<VertexPosCol>(nullptr, TRI_BATCH_SIZE * 3);
 	_trisVAO = VertexArrayObject::Create();
 	_trisVAO->AddVertexBuffer(_trisVBO, VertexPosCol::V_DECL);
+	_trisVBO->LoadData<VertexPosCol>(nullptr, TRI_BATCH_SIZE * 3);
 
 	_colorStack.push(glm::vec3(1.0f));
 	_transformStack.push(glm::mat4(1.0f));
@@ -54,30 +59,31 @@ void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::
 
 void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& color1, const glm::vec3& color2)
 {
-	_lineBuffer[_lineOffset + 0].Color = glm::vec4(color1, 1.0f);
-	_lineBuffer[_lineOffset + 0].Position = p1;
-	_lineBuffer[_lineOffset + 1].Color = glm::vec4(color2, 1.0f);
-	_lineBuffer[_lineOffset + 1].Position = p2;
-
-	_lineOffset += 2;
-	if (_lineOffset >= LINE_BATCH_SIZE) {
+	uint32_t first;
+	VertexPosCol* verts = _lines.AppendVertices(2, first);
+	verts[0].Color = glm::vec4(color1, 1.0f);
+	verts[0].Position = p1;
+	verts[1].Color = glm::vec4(color2, 1.0f);
+	verts[1].Position = p2;
+
+	if (_lines.GetVertexCount() >= LINE_BATCH_SIZE * 2) {
 		FlushLines();
 	}
 }
 
 void DebugDrawer::FlushLines()
 {
-	if (_lineOffset > 0) {
+	if (_lines.GetVertexCount() > 0) {
 		__Shader->Bind();
 		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
 		int restorePoint = 0;
 		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
 		VertexArrayObject::Unbind();
-		_linesVBO->LoadData<VertexPosCol>(_lineBuffer, LINE_BATCH_SIZE * 2);
+		_linesVBO->UpdateData(_lines.GetVertexDataPtr(), sizeof(VertexPosCol), _lines.GetVertexCount(), true);
 		_linesVAO->Bind();
 		_linesVAO->Draw(DrawMode::LineList);
 		_linesVAO->Unbind();
-		_lineOffset = 0;
+		_lines.Reset();
 		if (restorePoint != 0) {
 			glBindVertexArray(restorePoint);
 		}
@@ -95,32 +101,33 @@ void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::v
 
 void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, const glm::vec3& c1, const glm::vec3& c2, const glm::vec3& c3)
 {
-	_triBuffer[_triangleOffset + 0].Color = glm::vec4(c1, 1.0f);
-	_triBuffer[_triangleOffset + 0].Position = p1;
-	_triBuffer[_triangleOffset + 1].Color = glm::vec4(c2, 1.0f);
-	_triBuffer[_triangleOffset + 1].Position = p2;
-	_triBuffer[_triangleOffset + 2].Color = glm::vec4(c3, 1.0f);
-	_triBuffer[_triangleOffset + 2].Position = p3;
-
-	_triangleOffset += 3;
-	if (_triangleOffset >= TRI_BATCH_SIZE) {
+	uint32_t first;
+	VertexPosCol* verts = _tris.AppendVertices(3, first);
+	verts[0].Color = glm::vec4(c1, 1.0f);
+	verts[0].Position = p1;
+	verts[1].Color = glm::vec4(c2, 1.0f);
+	verts[1].Position = p2;
+	verts[2].Color = glm::vec4(c3, 1.0f);
+	verts[2].Position = p3;
+
+	if (_tris.GetVertexCount() >= TRI_BATCH_SIZE * 3) {
 		FlushTris();
 	}
 }
 
 void DebugDrawer::FlushTris()
 {
-	if (_triangleOffset > 0) {
+	if (_tris.GetVertexCount() > 0) {
 		__Shader->Bind();
 		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
 		int restorePoint = 0;
 		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
 		VertexArrayObject::Unbind();
-		_trisVBO->LoadData<VertexPosCol>(_triBuffer, TRI_BATCH_SIZE * 3);
+		_trisVBO->UpdateData(_tris.GetVertexDataPtr(), sizeof(VertexPosCol), _tris.GetVertexCount(), true);
 		_trisVAO->Bind();
-		_trisVAO->Draw(DrawMode::LineList);
+		_trisVAO->Draw(DrawMode::TriangleList);
 		_trisVAO->Unbind();
-		_triangleOffset = 0;
+		_tris.Reset();
 		if (restorePoint != 0) {
 			glBindVertexArray(restorePoint);
 		}
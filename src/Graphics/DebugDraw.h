@@ -3,6 +3,7 @@
 #include <stack>
 #include "Graphics/VertexTypes.h"
 #include "Graphics/ShaderProgram.h"
+#include "Utils/MeshBuilder.h"
 
 /// <summary>
 /// Utility class for drawing lines and triangles in an immediate mode style
@@ -133,10 +134,9 @@ protected:
 	glm::mat4    _viewProjection;
 	glm::mat4    _worldMatrix;
 
-	size_t       _lineOffset;
-	VertexPosCol _lineBuffer[LINE_BATCH_SIZE * 2];
-	size_t       _triangleOffset;
-	VertexPosCol _triBuffer[TRI_BATCH_SIZE * 3];
+	// Reserved for a full batch up front, so drawing never allocates
+	MeshBuilder<VertexPosCol> _lines;
+	MeshBuilder<VertexPosCol> _tris;
 
 	VertexBuffer::Sptr _linesVBO;
 	VertexArrayObject::Sptr _linesVAO;
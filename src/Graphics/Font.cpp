@@ -295,6 +295,12 @@ GlyphInfo Font::__CreateGlyph(uint32_t index)
 	return info;
 }
 
+size_t Font::GetMemoryUsage() const
+{
+	// The TTF file is kept in memory alongside the baked atlas
+	return _fontData.size() + (_atlas != nullptr ? _atlas->GetMemoryUsage() : 0);
+}
+
 nlohmann::json Font::ToJson() const
 {
 	nlohmann::json blob = {
@@ -90,6 +90,7 @@
 		virtual glm::vec2 MeausureString(const std::wstring& text, const float scale = 1.0f);
 
 		virtual nlohmann::json ToJson() const override;
+		virtual size_t GetMemoryUsage() const override;
 		static Font::Sptr FromJson(const nlohmann::json& data);
 
 	protected:
@@ -329,6 +329,18 @@ GlResourceType Framebuffer::GetResourceClass() const {
 	return GlResourceType::FrameBuffer;
 }
 
+size_t Framebuffer::GetMemoryUsage() const {
+	// The framebuffer object itself has no storage, it's all in the attachments
+	size_t result = 0;
+	for (const auto& [attachment, target] : _targets) {
+		result += target.Resource != nullptr ? target.Resource->GetGpuMemoryUsage() : 0;
+	}
+	if (_unsampledFramebuffer != nullptr) {
+		result += _unsampledFramebuffer->GetMemoryUsage();
+	}
+	return result;
+}
+
 nlohmann::json Framebuffer::ToJson() const {
 	nlohmann::json result ={
 		{ "width", _description.Width },
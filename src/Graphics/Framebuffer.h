@@ -159,6 +159,11 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Framebuffer::Sptr FromJson(const nlohmann::json& blob);
+	/**
+	 * Gets the GPU memory used by all of this framebuffer's attachments, including the
+	 * resolve targets for multisampled framebuffers
+	 */
+	virtual size_t GetMemoryUsage() const override;
 
 protected:
 	// The max samples allowed by OpenGL
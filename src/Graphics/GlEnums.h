@@ -38,6 +38,11 @@ ENUM(InternalFormat, GLint,
 	Unknown      = GL_NONE,
 	Depth        = GL_DEPTH_COMPONENT,
 	DepthStencil = GL_DEPTH_STENCIL,
+	// Sized depth formats, these are what framebuffers use for their depth targets
+	Depth16      = GL_DEPTH_COMPONENT16,
+	Depth24      = GL_DEPTH_COMPONENT24,
+	Depth32      = GL_DEPTH_COMPONENT32,
+	Depth24Stencil8 = GL_DEPTH24_STENCIL8,
 	R8           = GL_R8,
 	R16          = GL_R16,
 	RG8          = GL_RG8,
@@ -45,11 +50,19 @@ ENUM(InternalFormat, GLint,
 	SRGB         = GL_SRGB8,
 	RGB10        = GL_RGB10,
 	RGB16        = GL_RGB16,
+	RGB16F       = GL_RGB16F,
 	RGB32F       = GL_RGB32F,
 	RGBA8        = GL_RGBA8,
 	SRGBA        = GL_SRGB8_ALPHA8,
 	RGBA16       = GL_RGBA16,
-	RGB32AF      = GL_RGBA32F
+	RGBA16F      = GL_RGBA16F,
+	RGB32AF      = GL_RGBA32F,
+	// Block compressed formats, S3TC is an extension so we use the raw values
+	BC1          = 0x83F0, // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+	BC3          = 0x83F3, // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	BC4          = GL_COMPRESSED_RED_RGTC1,
+	BC5          = GL_COMPRESSED_RG_RGTC2,
+	BC7          = GL_COMPRESSED_RGBA_BPTC_UNORM
 	// Note: There are sized internal formats but there is a LOT of them
 )
 
@@ -76,6 +89,7 @@ ENUM(PixelType, GLint,
 	Short   = GL_SHORT,
 	UInt    = GL_UNSIGNED_INT,
 	Int     = GL_INT,
+	Half    = GL_HALF_FLOAT,
 	Float   = GL_FLOAT
 )
 
@@ -117,9 +131,11 @@ constexpr size_t GetTexelComponentSize(PixelType type) {
 		return 1;
 	case PixelType::UShort:
 	case PixelType::Short:
+	case PixelType::Half:
 		return 2;
 	case PixelType::Int:
 	case PixelType::UInt:
+	case PixelType::Float:
 		return 4;
 	default:
 		LOG_ASSERT(false, "Unknown type: {}", type);
@@ -181,6 +197,41 @@ constexpr GLint GetTexelComponentCount(PixelFormat format) {
 	}
 }
 
+/*
+ * Returns true if the given internal format is block compressed
+ */
+constexpr bool IsCompressedFormat(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::BC1:
+		case InternalFormat::BC3:
+		case InternalFormat::BC4:
+		case InternalFormat::BC5:
+		case InternalFormat::BC7:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Gets the number of bytes used to store a single 4x4 block of a compressed format
+ * @param format The compressed internal format
+ * @returns The size of a block in bytes, or 0 if the format is not compressed
+ */
+constexpr size_t GetCompressedBlockSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::BC1:
+		case InternalFormat::BC4:
+			return 8;
+		case InternalFormat::BC3:
+		case InternalFormat::BC5:
+		case InternalFormat::BC7:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
 /*
  * Gets the number of bytes needed to represent a single texel of the given format and type
  * @param format The format of the texel
@@ -191,6 +242,60 @@ constexpr size_t GetTexelSize(PixelFormat format, PixelType type) {
 	return GetTexelComponentSize(type) * GetTexelComponentCount(format);
 }
 
+/*
+ * Gets the number of bytes the GPU uses to store a single texel of an uncompressed internal format.
+ * Drivers pad 3 component formats out to 4 components, so we report the padded size for those
+ * @param format The internal format of the texture
+ * @returns The size of a texel in bytes, or 0 if the format is compressed or unknown
+ */
+constexpr size_t GetTexelSize(InternalFormat format) {
+	switch (format) {
+		case InternalFormat::R8:
+			return 1;
+		case InternalFormat::R16:
+		case InternalFormat::RG8:
+		case InternalFormat::Depth16:
+			return 2;
+		case InternalFormat::Depth:
+		case InternalFormat::DepthStencil:
+		case InternalFormat::Depth24:
+		case InternalFormat::Depth32:
+		case InternalFormat::Depth24Stencil8:
+		case InternalFormat::RGB8:
+		case InternalFormat::SRGB:
+		case InternalFormat::RGB10:
+		case InternalFormat::RGBA8:
+		case InternalFormat::SRGBA:
+			return 4;
+		case InternalFormat::RGB16:
+		case InternalFormat::RGB16F:
+		case InternalFormat::RGBA16:
+		case InternalFormat::RGBA16F:
+			return 8;
+		case InternalFormat::RGB32F:
+		case InternalFormat::RGB32AF:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * Gets the number of bytes needed to store a single image of the given format and size
+ * @param format The internal format of the image
+ * @param width The width of the image, in texels
+ * @param height The height of the image, in texels
+ * @param depth The depth of the image, in texels
+ * @returns The size of the image in bytes
+ */
+constexpr size_t GetImageSize(InternalFormat format, uint32_t width, uint32_t height = 1, uint32_t depth = 1) {
+	// Compressed formats are stored in 4x4 blocks, so partial blocks still take up a whole block
+	if (IsCompressedFormat(format)) {
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * depth * GetCompressedBlockSize(format);
+	}
+	return (size_t)width * height * depth * GetTexelSize(format);
+}
+
 
 /*
 	* Represents the type of data used in a shader in a more useful format for us
@@ -809,6 +914,7 @@ ENUM(AttributeType, GLenum,
 	 UShort  = GL_UNSIGNED_SHORT,
 	 Int     = GL_INT,
 	 UInt    = GL_UNSIGNED_INT,
+	 HalfFloat = GL_HALF_FLOAT,
 	 Float   = GL_FLOAT,
 	 Double  = GL_DOUBLE,
 	 Unknown = GL_NONE
@@ -874,6 +980,37 @@ ENUM(RenderTargetType, uint32_t,
 	 Stencil16    = GL_STENCIL_INDEX16
 )
 
+/*
+ * Gets the number of bytes the GPU uses to store a single sample of a render target format.
+ * As with textures, 3 component and 24 bit formats are padded out to a full word
+ * @param format The format of the render target
+ * @returns The size of a sample in bytes, or 0 if the format is unknown
+ */
+constexpr size_t GetTexelSize(RenderTargetType format) {
+	switch (format) {
+		case RenderTargetType::ColorRed8:
+		case RenderTargetType::Stencil4:
+		case RenderTargetType::Stencil8:
+			return 1;
+		case RenderTargetType::ColorRG8:
+		case RenderTargetType::Depth16:
+		case RenderTargetType::Stencil16:
+			return 2;
+		case RenderTargetType::ColorRgba8:
+		case RenderTargetType::ColorRgb10:
+		case RenderTargetType::ColorRgb8:
+		case RenderTargetType::DepthStencil:
+		case RenderTargetType::Depth24:
+		case RenderTargetType::Depth32:
+			return 4;
+		case RenderTargetType::ColorRgb16F:
+		case RenderTargetType::ColorRgba16F:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
 /**
  * Enumerates the possible options for the glBindFramebuffer command
  */
@@ -6,6 +6,7 @@
 #include <codecvt>
 
 
+MeshBuilderArena<VertexPosColTex> GuiBatcher::_meshArena;
 std::unordered_map<Texture2D*, GuiBatcher::MeshData> GuiBatcher::_meshBuilders;
 
 VertexArrayObject::Sptr GuiBatcher::__vao = nullptr;
@@ -32,7 +33,7 @@ void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm:
 	verts[3].Position = __model * glm::vec3(max.x, min.y, 1.0f);
 		
 	// Grab mesh info for the texture batch
-	MeshData& mesh = _meshBuilders[tex.get()];
+	MeshData& mesh = __GetBatch(tex.get());
 	// We can use the vertex count for depth, so that things drawn later have a bit of spacing
 	float depth = mesh.Builder.GetVertexCount() / 1000.0f;
 
@@ -49,14 +50,13 @@ void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm:
 	verts[3].UV = glm::vec2(uvMax.x, uvMax.y);
 
 	// Add vertices and indices to range
-	uint32_t ix = mesh.Builder.AddVertexRange(verts, 4);
-	mesh.Builder.AddIndexTri(ix + 0, ix + 2, ix + 1);
-	mesh.Builder.AddIndexTri(ix + 0, ix + 3, ix + 2);
+	__PushQuad(mesh, verts, true);
 }
 
 void GuiBatcher::PushRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& color, const Texture2D::Sptr& tex, int edgeRadius)
 {
-	if (edgeRadius <= 0) {
+	// We need the size of the texture to work out the edges, which we won't have until it's loaded
+	if (edgeRadius <= 0 || tex == nullptr || tex->GetWidth() <= 2 || tex->GetHeight() <= 2) {
 		PushRect(min, max, color, tex, { 0,0 }, { 1,1 });
 	} 
 	else {
@@ -111,7 +111,7 @@ void GuiBatcher::RenderText(const std::wstring& text, const Font::Sptr& font, co
 	Texture2D::Sptr atlas = font->GetAtlas();
 
 	// Grab the mesh builder and make sure it's a texture batch
-	MeshData& mesh = _meshBuilders[atlas.get()];
+	MeshData& mesh = __GetBatch(atlas.get());
 	mesh.IsFont = true;
 
 	// Allocate some space for the vertices
@@ -156,9 +156,7 @@ void GuiBatcher::RenderText(const std::wstring& text, const Font::Sptr& font, co
 
 			verts[0].Position.z = verts[1].Position.z = verts[2].Position.z = verts[3].Position.z = depth;
 
-			uint32_t ix = mesh.Builder.AddVertexRange(verts, 4);
-			mesh.Builder.AddIndexTri(ix + 0, ix + 1, ix + 2);
-			mesh.Builder.AddIndexTri(ix + 0, ix + 2, ix + 3);
+			__PushQuad(mesh, verts, false);
 
 			// Advance the offset based on the size of the glyph
 			offset.x = glyph.OffsetX;
@@ -187,8 +185,17 @@ void GuiBatcher::Flush()
 	__StaticInit();
 
 	// Iterate over each texture and it's mesh
-	for (auto&[key, value] : _meshBuilders) {
-		Texture2D* tex = key;
+	for (auto it = _meshBuilders.begin(); it != _meshBuilders.end();) {
+		Texture2D* tex = it->first;
+		MeshData& value = it->second;
+
+		// Batches that weren't used since the last flush give their storage back to the arena, so
+		// that we don't hold on to memory (or texture pointers) for things that are no longer drawn
+		if (value.Builder.GetVertexCount() == 0) {
+			it = _meshBuilders.erase(it);
+			continue;
+		}
+
 		// If the texture exists and the mesh has data
 		if (tex != nullptr && value.Builder.GetIndexCount() > 0) {
 			// Update the VAO and it's buffers
@@ -204,13 +211,35 @@ void GuiBatcher::Flush()
 
 			// Draw geometry
 			__vao->Draw();
-
-			// Clear mesh
-			value.Builder.Reset();
 		}
+
+		// Clear mesh, keeping it's memory for the next batch
+		value.Builder.Reset();
+		it++;
 	}
 }
 
+GuiBatcher::MeshData& GuiBatcher::__GetBatch(Texture2D* texture) {
+	auto it = _meshBuilders.find(texture);
+	if (it == _meshBuilders.end()) {
+		it = _meshBuilders.emplace(texture, MeshData(_meshArena)).first;
+	}
+	return it->second;
+}
+
+void GuiBatcher::__PushQuad(MeshData& mesh, const VertexPosColTex* verts, bool flipWinding) {
+	static const uint32_t quadIndices[2][6] = {
+		{ 0, 1, 2, 0, 2, 3 },
+		{ 0, 2, 1, 0, 3, 2 }
+	};
+
+	// Append in place, the builder grows geometrically so this won't allocate once the batch has warmed up
+	uint32_t first;
+	VertexPosColTex* dest = mesh.Builder.AppendVertices(4, first);
+	std::copy(verts, verts + 4, dest);
+	mesh.Builder.AddIndexRange(quadIndices[flipWinding ? 1 : 0], 6, first);
+}
+
 void GuiBatcher::PushModelTransform(const glm::mat3& transform) {
 	__modelTransformStack.push_back(transform);
 	__model = __model * transform;
@@ -121,6 +121,10 @@
 		struct MeshData {
 			MeshBuilder<VertexPosColTex> Builder;
 			bool IsFont;
+
+			MeshData(MeshBuilderArena<VertexPosColTex>& arena) :
+				Builder(arena),
+				IsFont(false) {}
 		};
 
 		static glm::ivec2 __windowSize;
@@ -130,6 +134,8 @@
 		static std::vector<IRect> __scissorRects;
 		static ShaderProgram::Sptr __shader;
 		static ShaderProgram::Sptr __fontShader;
+		// Holds the storage of batches for textures that are no longer being drawn, must be declared before _meshBuilders
+		static MeshBuilderArena<VertexPosColTex> _meshArena;
 		static std::unordered_map<Texture2D*, MeshData> _meshBuilders;
 		static VertexArrayObject::Sptr __vao;
 		static VertexBuffer::Sptr __vbo;
@@ -139,4 +145,6 @@
 		static int __defaultEdgeRadius;
 
 		static void __StaticInit();
+		static MeshData& __GetBatch(Texture2D* texture);
+		static void __PushQuad(MeshData& mesh, const VertexPosColTex* verts, bool flipWinding);
 	};
@@ -1,9 +1,36 @@
 #include "Graphics/IGraphicsResource.h"
+#include "Utils/StringUtils.h"
+
+#include <mutex>
+#include <unordered_set>
+#include <typeinfo>
+
+// All of the graphics resources that currently exist, and the sum of their memory usage. These are
+// function statics so that they exist before any resource is created during static initialization
+static std::mutex& ResourceRegistryMutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+static std::unordered_set<const IGraphicsResource*>& ResourceRegistry() {
+	static std::unordered_set<const IGraphicsResource*> resources;
+	return resources;
+}
+static size_t totalGpuMemoryUsage = 0;
 
 IGraphicsResource::IGraphicsResource() :
 	_debugName(""),
-	_rendererId(0)
-{ }
+	_rendererId(0),
+	_gpuMemoryUsage(0)
+{
+	std::lock_guard<std::mutex> lock(ResourceRegistryMutex());
+	ResourceRegistry().insert(this);
+}
+
+IGraphicsResource::~IGraphicsResource() {
+	std::lock_guard<std::mutex> lock(ResourceRegistryMutex());
+	ResourceRegistry().erase(this);
+	totalGpuMemoryUsage -= _gpuMemoryUsage;
+}
 
 void IGraphicsResource::SetDebugName(const std::string& name)
 {
@@ -22,6 +49,48 @@ uint32_t IGraphicsResource::GetHandle() const {
 	return _rendererId;
 }
 
+void IGraphicsResource::_SetGpuMemoryUsage(size_t bytes) {
+	std::lock_guard<std::mutex> lock(ResourceRegistryMutex());
+	totalGpuMemoryUsage = totalGpuMemoryUsage - _gpuMemoryUsage + bytes;
+	_gpuMemoryUsage = bytes;
+}
+
+size_t IGraphicsResource::GetTotalGpuMemoryUsage() {
+	std::lock_guard<std::mutex> lock(ResourceRegistryMutex());
+	return totalGpuMemoryUsage;
+}
+
+std::map<std::string, IGraphicsResource::MemoryStats> IGraphicsResource::GetGpuMemoryUsageByType() {
+	std::map<std::string, MemoryStats> result;
+	EachResource([&](const IGraphicsResource& resource) {
+		MemoryStats& stats = result[GetTypeName(resource)];
+		stats.Bytes += resource._gpuMemoryUsage;
+		stats.Count++;
+	});
+	return result;
+}
+
+std::map<std::string, IGraphicsResource::MemoryStats> IGraphicsResource::GetGpuMemoryUsageByName() {
+	std::map<std::string, MemoryStats> result;
+	EachResource([&](const IGraphicsResource& resource) {
+		MemoryStats& stats = result[resource._debugName.empty() ? "<unnamed>" : resource._debugName];
+		stats.Bytes += resource._gpuMemoryUsage;
+		stats.Count++;
+	});
+	return result;
+}
+
+void IGraphicsResource::EachResource(const std::function<void(const IGraphicsResource&)>& callback) {
+	std::lock_guard<std::mutex> lock(ResourceRegistryMutex());
+	for (const IGraphicsResource* resource : ResourceRegistry()) {
+		callback(*resource);
+	}
+}
+
+std::string IGraphicsResource::GetTypeName(const IGraphicsResource& resource) {
+	return StringTools::SanitizeClassName(typeid(resource).name());
+}
+
 void IGraphicsResource::_SetRenderId(uint32_t renderId)
 {
 	_rendererId = renderId;
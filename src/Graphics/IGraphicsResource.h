@@ -2,6 +2,8 @@
 
 #include <string>
 #include <cstdint>
+#include <map>
+#include <functional>
 #include <glad/glad.h>
 #include <EnumToString.h>
 
@@ -29,13 +31,26 @@ ENUM(GlResourceType, GLenum,
 
 /**
  * Base class for all of our OpenGL graphics resources 
+ * 
+ * All live resources are tracked, along with the amount of GPU memory they have allocated, so
+ * that we can see where our VRAM is going and catch resources that are never released
  */
 class IGraphicsResource {
 public:
 	// For pointers and deletion of move and copy
 	DEFINE_RESOURCE(IGraphicsResource)
 
-	virtual ~IGraphicsResource() = default;
+	/**
+	 * Summarizes the GPU memory used by a group of resources
+	 */
+	struct MemoryStats {
+		// The total number of bytes allocated by the resources
+		size_t Bytes = 0;
+		// The number of resources in the group
+		size_t Count = 0;
+	};
+
+	virtual ~IGraphicsResource();
 
 	/**
 	 * Should be overridden in derived classes to return a resource type identifier
@@ -58,8 +73,45 @@ public:
 	 */
 	virtual uint32_t GetHandle() const;
 
+	/**
+	 * Gets the number of bytes of GPU memory allocated for this object's storage (ex: a texture's
+	 * mip chain, or a buffer's data store). This does not include other resources that this resource
+	 * uses, such as a framebuffer's attachments
+	 */
+	size_t GetGpuMemoryUsage() const { return _gpuMemoryUsage; }
+
+	/**
+	 * Gets the total GPU memory used by all live graphics resources, in bytes
+	 */
+	static size_t GetTotalGpuMemoryUsage();
+	/**
+	 * Gets the GPU memory used by live graphics resources, grouped by their class name (ex: Texture2D, VertexBuffer)
+	 */
+	static std::map<std::string, MemoryStats> GetGpuMemoryUsageByType();
+	/**
+	 * Gets the GPU memory used by live graphics resources, grouped by their debug names. Unnamed resources
+	 * are grouped under "<unnamed>"
+	 */
+	static std::map<std::string, MemoryStats> GetGpuMemoryUsageByName();
+	/**
+	 * Invokes a callback for every live graphics resource. The callback must not create or destroy
+	 * graphics resources
+	 * @param callback The function to invoke for each resource
+	 */
+	static void EachResource(const std::function<void(const IGraphicsResource&)>& callback);
+	/**
+	 * Gets the sanitized class name of a resource, for display and grouping
+	 */
+	static std::string GetTypeName(const IGraphicsResource& resource);
+
 protected:
 	IGraphicsResource();
+
+	/**
+	 * Should be called by derived classes whenever they allocate or re-allocate their storage
+	 * @param bytes The total number of bytes of GPU memory now allocated for this object
+	 */
+	void _SetGpuMemoryUsage(size_t bytes);
 	
 	/**
 	 * Updates the underlying render ID and ensures that the resources debug name
@@ -69,4 +121,5 @@ protected:
 
 	std::string _debugName;
 	uint32_t    _rendererId;
+	size_t      _gpuMemoryUsage;
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Graphics/Renderbuffer.h"
+#include <algorithm>
 
 Renderbuffer::Renderbuffer(const RenderbufferDescription& description) :
 	IGraphicsResource(),
@@ -12,6 +13,10 @@ Renderbuffer::Renderbuffer(const RenderbufferDescription& description) :
 	else {
 		glNamedRenderbufferStorage(_rendererId, *_description.Format, _description.Width, _description.Height);
 	}
+
+	// Each sample gets it's own storage
+	uint32_t samples = std::max<uint32_t>(_description.MultisampleCount, 1);
+	_SetGpuMemoryUsage((size_t)_description.Width * _description.Height * GetTexelSize(_description.Format) * samples);
 }
 
 Renderbuffer::~Renderbuffer() {
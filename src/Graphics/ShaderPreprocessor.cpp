@@ -0,0 +1,224 @@
+#include "Graphics/ShaderPreprocessor.h"
+#include <Logging.h>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/StringUtils.h"
+
+namespace fs = std::filesystem;
+
+std::unordered_map<std::string, ShaderPreprocessor::ParsedFile::Sptr> ShaderPreprocessor::_cache;
+std::recursive_mutex ShaderPreprocessor::_cacheMutex;
+
+std::string ShaderPreprocessor::Process(const std::string& filename, std::vector<std::string>* dependencies) {
+	std::lock_guard<std::recursive_mutex> lock(_cacheMutex);
+
+	std::string root = _NormalizePath(filename);
+
+	// Walk the include graph first, this validates all our cache entries and lets
+	// us figure out exactly how much memory we need for the output
+	std::vector<std::string> order;
+	std::unordered_map<std::string, ParsedFile::Sptr> files;
+	_CollectDependencies(root, order, files);
+
+	std::string result;
+	if (files[root] != nullptr) {
+		size_t totalSize = 0;
+		for (const auto& [path, file] : files) {
+			totalSize += file != nullptr ? file->Contents.size() : 0;
+		}
+		result.reserve(totalSize);
+
+		// Build the output in a single pass, each file is only emitted once
+		std::unordered_map<std::string, bool> emitted;
+		_Emit(root, result, files, emitted);
+	}
+
+	if (dependencies != nullptr) {
+		*dependencies = std::move(order);
+	}
+	return result;
+}
+
+std::vector<std::string> ShaderPreprocessor::GetIncludes(const std::string& filename) {
+	std::lock_guard<std::recursive_mutex> lock(_cacheMutex);
+	ParsedFile::Sptr file = _GetParsedFile(_NormalizePath(filename));
+	return file != nullptr ? file->Includes : std::vector<std::string>();
+}
+
+std::vector<std::string> ShaderPreprocessor::GetDependencies(const std::string& filename) {
+	std::lock_guard<std::recursive_mutex> lock(_cacheMutex);
+	std::vector<std::string> order;
+	std::unordered_map<std::string, ParsedFile::Sptr> files;
+	_CollectDependencies(_NormalizePath(filename), order, files);
+	return order;
+}
+
+uint64_t ShaderPreprocessor::GetDependencyHash(const std::string& filename) {
+	std::lock_guard<std::recursive_mutex> lock(_cacheMutex);
+	std::vector<std::string> order;
+	std::unordered_map<std::string, ParsedFile::Sptr> files;
+	_CollectDependencies(_NormalizePath(filename), order, files);
+
+	// FNV-1a, we just need something stable and cheap
+	const uint64_t prime = 0x100000001b3ull;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	auto mix = [&](const void* data, size_t size) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+		for (size_t ix = 0; ix < size; ix++) {
+			hash ^= bytes[ix];
+			hash *= prime;
+		}
+	};
+
+	for (const auto& path : order) {
+		mix(path.data(), path.size());
+		const ParsedFile::Sptr& file = files[path];
+		if (file != nullptr) {
+			int64_t  time = static_cast<int64_t>(file->WriteTime.time_since_epoch().count());
+			uint64_t size = static_cast<uint64_t>(file->FileSize);
+			mix(&time, sizeof(int64_t));
+			mix(&size, sizeof(uint64_t));
+		}
+	}
+	return hash;
+}
+
+void ShaderPreprocessor::Invalidate(const std::string& filename) {
+	std::lock_guard<std::recursive_mutex> lock(_cacheMutex);
+	_cache.erase(_NormalizePath(filename));
+}
+
+void ShaderPreprocessor::ClearCache() {
+	std::lock_guard<std::recursive_mutex> lock(_cacheMutex);
+	_cache.clear();
+}
+
+std::string ShaderPreprocessor::_NormalizePath(const fs::path& path) {
+	// Get a lexically normal path (ie with the ../ parts resolved), with consistent separators
+	return path.lexically_normal().generic_string();
+}
+
+ShaderPreprocessor::ParsedFile::Sptr ShaderPreprocessor::_GetParsedFile(const std::string& normalizedPath) {
+	// This checks the asset package as well, so packed shaders don't touch the disk
+	fs::file_time_type writeTime;
+	uintmax_t fileSize = 0;
+	if (!FileHelpers::GetFileInfo(normalizedPath, writeTime, fileSize)) {
+		LOG_WARN("Could not find shader source \"{}\"", normalizedPath);
+		return nullptr;
+	}
+
+	// If we have a cache entry and the file has not changed, we can use it as-is
+	auto it = _cache.find(normalizedPath);
+	if (it != _cache.end() && it->second->WriteTime == writeTime && it->second->FileSize == fileSize) {
+		return it->second;
+	}
+
+	// Otherwise read and parse the file, replacing any stale entry
+	std::shared_ptr<ParsedFile> file = std::make_shared<ParsedFile>();
+	file->WriteTime = writeTime;
+	file->FileSize  = fileSize;
+	file->Contents  = FileHelpers::ReadFile(normalizedPath);
+	_Parse(*file, fs::path(normalizedPath).parent_path());
+
+	_cache[normalizedPath] = file;
+	return file;
+}
+
+void ShaderPreprocessor::_Parse(ParsedFile& file, const fs::path& folder) {
+	// The token we're looking for, and it's length
+	const char* includeToken = "#include";
+	const size_t includeTokenLen = const_strlen(includeToken);
+
+	const std::string& text = file.Contents;
+	const size_t size = text.size();
+
+	// The start of the text span that we're currently building
+	size_t segmentStart = 0;
+	size_t lineStart = 0;
+
+	while (lineStart < size) {
+		// Find the end of the line
+		size_t eol = text.find_first_of("\r\n", lineStart);
+		if (eol == std::string::npos) {
+			eol = size;
+		}
+
+		// Directives must be the first thing on the line, ignoring indentation
+		size_t seek = lineStart;
+		while (seek < eol && (text[seek] == ' ' || text[seek] == '\t')) {
+			seek++;
+		}
+
+		if (eol - seek > includeTokenLen && text.compare(seek, includeTokenLen, includeToken) == 0) {
+			// Calculate the area from end of token to end of line, snip out as the path
+			std::string path = text.substr(seek + includeTokenLen, eol - seek - includeTokenLen);
+
+			// Trim whitespace and any quotes or brackets
+			StringTools::Trim(path);
+			StringTools::Trim(path, '"');
+			StringTools::LTrim(path, '<');
+			StringTools::RTrim(path, '>');
+
+			if (!path.empty()) {
+				// If it starts with '/', relative to application directory
+				// Otherwise relative to the current file
+				fs::path target = path[0] == '/' ? fs::path(path.substr(1)) : folder / path;
+
+				// The directive line is replaced with the included file, the line ending is kept
+				file.Segments.push_back({ segmentStart, lineStart - segmentStart, static_cast<int>(file.Includes.size()) });
+				file.Includes.push_back(_NormalizePath(target));
+				segmentStart = eol;
+			}
+		}
+
+		// Skip past the line ending (handles \r\n as well as \n)
+		lineStart = eol;
+		if (lineStart < size && text[lineStart] == '\r') lineStart++;
+		if (lineStart < size && text[lineStart] == '\n') lineStart++;
+	}
+
+	// Whatever is left after the last include is a trailing text span
+	if (segmentStart < size) {
+		file.Segments.push_back({ segmentStart, size - segmentStart, -1 });
+	}
+}
+
+void ShaderPreprocessor::_CollectDependencies(const std::string& normalizedPath, std::vector<std::string>& order, std::unordered_map<std::string, ParsedFile::Sptr>& files) {
+	// Each file only needs to be visited once
+	if (files.find(normalizedPath) != files.end()) {
+		return;
+	}
+
+	ParsedFile::Sptr file = _GetParsedFile(normalizedPath);
+	files[normalizedPath] = file;
+	order.push_back(normalizedPath);
+
+	if (file != nullptr) {
+		for (const auto& include : file->Includes) {
+			_CollectDependencies(include, order, files);
+		}
+	}
+}
+
+void ShaderPreprocessor::_Emit(const std::string& normalizedPath, std::string& output, const std::unordered_map<std::string, ParsedFile::Sptr>& files, std::unordered_map<std::string, bool>& emitted) {
+	// If we've already included the file, the directive is simply dropped
+	bool& wasEmitted = emitted[normalizedPath];
+	if (wasEmitted) {
+		return;
+	}
+	wasEmitted = true;
+
+	auto it = files.find(normalizedPath);
+	if (it == files.end() || it->second == nullptr) {
+		LOG_ASSERT(false, "File does not exist");
+		return;
+	}
+
+	const ParsedFile& file = *it->second;
+	for (const Segment& segment : file.Segments) {
+		output.append(file.Contents, segment.Offset, segment.Length);
+		if (segment.IncludeIndex >= 0) {
+			_Emit(file.Includes[segment.IncludeIndex], output, files, emitted);
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+
+/// <summary>
+/// Resolves #include directives in GLSL source files
+///
+/// Every file that is read is parsed once into a list of text spans and include
+/// directives, and cached by path. Cache entries are only re-parsed when the file's
+/// last write time or size changes on disk, so shared fragments like frame_uniforms.glsl
+/// are only read once no matter how many programs include them.
+///
+/// The include graph is exposed so that other systems (ex: a binary shader cache) can
+/// determine all the files a shader depends on, and key on their state
+/// </summary>
+class ShaderPreprocessor {
+public:
+	ShaderPreprocessor() = delete;
+
+	/// <summary>
+	/// Reads the given file and resolves all #include directives, in a single pass. Each
+	/// file will only be included once per call, subsequent includes of the same file are dropped
+	/// </summary>
+	/// <param name="filename">The path of the root file to load</param>
+	/// <param name="dependencies">If non-null, will be filled with all files that the result depends on, including the root</param>
+	/// <returns>The contents of the file with all includes resolved, or an empty string if the file could not be read</returns>
+	static std::string Process(const std::string& filename, std::vector<std::string>* dependencies = nullptr);
+
+	/// <summary>
+	/// Gets the files that are directly included by the given file (ie, the outgoing edges
+	/// of the file in the include graph)
+	/// </summary>
+	/// <param name="filename">The path of the file to query</param>
+	/// <returns>The normalized paths of all files included by the file, in the order they are included</returns>
+	static std::vector<std::string> GetIncludes(const std::string& filename);
+	/// <summary>
+	/// Gets all files that the given file depends on, directly or indirectly, including
+	/// the file itself. Files are listed in the order that they will be emitted
+	/// </summary>
+	/// <param name="filename">The path of the file to query</param>
+	static std::vector<std::string> GetDependencies(const std::string& filename);
+	/// <summary>
+	/// Calculates a hash from the paths, sizes and write times of every file in the
+	/// given file's dependency graph. This will change if any file in the graph is edited,
+	/// making it suitable as a cache key for compiled shaders
+	/// </summary>
+	/// <param name="filename">The path of the root file</param>
+	static uint64_t GetDependencyHash(const std::string& filename);
+
+	/// <summary>
+	/// Removes a single file from the cache, forcing it to be re-read the next time it is needed
+	/// </summary>
+	/// <param name="filename">The path of the file to invalidate</param>
+	static void Invalidate(const std::string& filename);
+	/// <summary>
+	/// Removes all files from the cache
+	/// </summary>
+	static void ClearCache();
+
+protected:
+	/// <summary>
+	/// Represents a single run of text in a source file, followed by an optional include directive
+	/// </summary>
+	struct Segment {
+		// The offset of the text in the file contents, in bytes
+		size_t Offset;
+		// The length of the text, in bytes
+		size_t Length;
+		// The index into the file's include list that follows this text, or -1 for none
+		int    IncludeIndex;
+	};
+
+	/// <summary>
+	/// Stores the parsed representation of a single source file
+	/// </summary>
+	struct ParsedFile {
+		typedef std::shared_ptr<const ParsedFile> Sptr;
+
+		// The state of the file on disk when it was parsed
+		std::filesystem::file_time_type WriteTime;
+		uintmax_t                       FileSize;
+
+		// The raw contents of the file, segments refer into this
+		std::string              Contents;
+		// The text spans and include directives, in file order
+		std::vector<Segment>     Segments;
+		// The normalized paths of all files this file includes
+		std::vector<std::string> Includes;
+	};
+
+	static std::unordered_map<std::string, ParsedFile::Sptr> _cache;
+	static std::recursive_mutex _cacheMutex;
+
+	/// <summary>
+	/// Gets the normalized form of a path, which we use as our cache key
+	/// </summary>
+	static std::string _NormalizePath(const std::filesystem::path& path);
+	/// <summary>
+	/// Gets the parsed form of the given file, re-parsing it if it has changed on disk since
+	/// it was cached. Returns nullptr if the file cannot be read
+	/// </summary>
+	static ParsedFile::Sptr _GetParsedFile(const std::string& normalizedPath);
+	/// <summary>
+	/// Parses the contents of a file into text segments and include directives
+	/// </summary>
+	static void _Parse(ParsedFile& file, const std::filesystem::path& folder);
+	/// <summary>
+	/// Collects the dependency graph of a file in emission order, skipping any files already visited
+	/// </summary>
+	static void _CollectDependencies(const std::string& normalizedPath, std::vector<std::string>& order, std::unordered_map<std::string, ParsedFile::Sptr>& files);
+	/// <summary>
+	/// Appends the resolved contents of a file to the output, skipping any files already visited
+	/// </summary>
+	static void _Emit(const std::string& normalizedPath, std::string& output, const std::unordered_map<std::string, ParsedFile::Sptr>& files, std::unordered_map<std::string, bool>& emitted);
+};
@@ -5,18 +5,21 @@
 #include <filesystem>
 
 #include "Utils/FileHelpers.h"
+#include "Graphics/ShaderPreprocessor.h"
 #include "Utils/JsonGlmHelpers.h"
 
 ShaderProgram::ShaderProgram() : 
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_varyingsInterleaved(true)
 {
 	_rendererId = glCreateProgram();
 }
 
 ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_varyingsInterleaved(true)
 {
 	_rendererId = glCreateProgram();
 	for (auto& [type, path] : filePaths) {
@@ -78,20 +81,23 @@ bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
 	// Store info about where we got this data from
 	_fileSourceMap[type].IsFilePath = false;
 	_fileSourceMap[type].Source = source;
+	_fileSourceMap[type].Dependencies.clear();
 
 	return status != GL_FALSE;
 }
 
 bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
 	// Make sure that the file exists before we try reading
-	if (std::filesystem::exists(path)) {
-		// Load the source from the file, using our helper that will
+	if (FileHelpers::Exists(path)) {
+		// Load the source from the file, using our preprocessor that will
 		// resolve #include directives
-		std::string source = FileHelpers::ReadResolveIncludes(path);
+		std::vector<std::string> dependencies;
+		std::string source = ShaderPreprocessor::Process(path, &dependencies);
 		// Pass off to LoadShaderPart
 		bool result =  LoadShaderPart(source.c_str(), type);
 		_fileSourceMap[type].IsFilePath = true;
 		_fileSourceMap[type].Source = path;
+		_fileSourceMap[type].Dependencies = std::move(dependencies);
 		if (result == false) {
 			LOG_ERROR("Source File: {}", path);
 		}
@@ -105,6 +111,10 @@ bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type
 bool ShaderProgram::Link() {
 
 	LOG_TRACE("Starting shader link:");
+
+	// Linking again means our sources have been reloaded, so any variants were built from the old ones.
+	// They'll get rebuilt from the new sources the next time they're requested
+	ClearVariants();
 	
 	// Attach all our shaders
 	for (auto& [type, id] : _handles) {
@@ -306,6 +316,90 @@ void ShaderProgram::SetUniform(int location, ShaderDataType type, void* data, in
 	}
 }
 
+/// <summary>
+/// Injects a list of #define directives into a GLSL source string, directly after
+/// the #version directive (which must be the first statement in the source)
+/// </summary>
+inline std::string InjectDefines(const std::string& source, const std::vector<std::string>& defines) {
+	std::string block;
+	for (const auto& define : defines) {
+		block += "#define " + define + "\n";
+	}
+
+	size_t insertAt = 0;
+	size_t version = source.find("#version");
+	if (version != std::string::npos) {
+		size_t eol = source.find('\n', version);
+		insertAt = eol == std::string::npos ? source.size() : eol + 1;
+	}
+
+	std::string result;
+	result.reserve(source.size() + block.size() + 1);
+	result.append(source, 0, insertAt);
+	// Handle #version being on the last line of the file
+	if (insertAt > 0 && source[insertAt - 1] != '\n') {
+		result += '\n';
+	}
+	result.append(block);
+	result.append(source, insertAt, std::string::npos);
+	return result;
+}
+
+ShaderProgram::Sptr ShaderProgram::GetVariant(uint32_t key, const std::vector<std::string>& defines) {
+	// If we've already tried building the variant, return what we got (even if it failed,
+	// we don't want to try compiling it again every time it's requested)
+	auto it = _variants.find(key);
+	if (it != _variants.end()) {
+		return it->second;
+	}
+
+	ShaderProgram::Sptr result = std::make_shared<ShaderProgram>();
+	bool success = !_fileSourceMap.empty();
+
+	std::string defineList;
+	for (const auto& define : defines) {
+		defineList += (defineList.empty() ? "" : " ") + define;
+	}
+	LOG_TRACE("Compiling variant of \"{}\" with [{}]", _debugName, defineList);
+
+	// Rebuild every stage from it's original source with our defines injected
+	for (const auto& [type, source] : _fileSourceMap) {
+		std::string code = source.IsFilePath ? ShaderPreprocessor::Process(source.Source) : source.Source;
+		success &= result->LoadShaderPart(InjectDefines(code, defines).c_str(), type);
+	}
+
+	if (success) {
+		if (!_varyings.empty()) {
+			std::vector<const char*> names;
+			names.reserve(_varyings.size());
+			for (const auto& name : _varyings) {
+				names.push_back(name.c_str());
+			}
+			result->RegisterVaryings(names.data(), static_cast<int>(names.size()), _varyingsInterleaved);
+		}
+		success = result->Link();
+	}
+
+	if (success) {
+		result->SetDebugName(_debugName + " [" + defineList + "]");
+	} else {
+		LOG_ERROR("Failed to build variant of \"{}\" with [{}]", _debugName, defineList);
+		result = nullptr;
+	}
+
+	_variants[key] = result;
+	return result;
+}
+
+void ShaderProgram::ClearVariants() {
+	_variants.clear();
+}
+
+int ShaderProgram::GetUniformLocation(const std::string& name) const {
+	auto it = _uniforms.find(name);
+	return it != _uniforms.end() ? it->second.Location : -1;
+}
+
 int ShaderProgram::__GetUniformLocation(const std::string& name) {
 	// Since the default constructor for UniformInfo sets location to -1,
 	// we can simply index the map and if it doesn't exist, the default
@@ -346,6 +440,17 @@ ShaderProgram::Sptr ShaderProgram::FromJson(const nlohmann::json& data) {
 	return result;
 }
 
+void ShaderProgram::PrefetchJson(const nlohmann::json& data) {
+	// The preprocessor caches every file it parses, so walking the include graph here means
+	// FromJson won't need to touch the disk, and only has to compile
+	for (auto& [key, blob] : data.items()) {
+		ShaderPartType type = ParseShaderPartType(key, ShaderPartType::Unknown);
+		if (type != ShaderPartType::Unknown && blob.contains("path")) {
+			ShaderPreprocessor::GetDependencies(blob["path"].get<std::string>());
+		}
+	}
+}
+
 void ShaderProgram::_Introspect() {
 	_IntrospectUniforms();
 	_IntrospectUnifromBlocks();
@@ -513,11 +618,27 @@ bool ShaderProgram::FindUniform(const std::string& name, UniformInfo* out) {
 	return false;
 }
 
+std::vector<std::string> ShaderProgram::GetSourceDependencies() const {
+	std::vector<std::string> result;
+	for (const auto& [type, source] : _fileSourceMap) {
+		for (const auto& path : source.Dependencies) {
+			if (std::find(result.begin(), result.end(), path) == result.end()) {
+				result.push_back(path);
+			}
+		}
+	}
+	return result;
+}
+
 GlResourceType ShaderProgram::GetResourceClass() const {
 	return GlResourceType::ShaderProgram;
 }
 
 void ShaderProgram::RegisterVaryings(const char* const* names, int numVaryings, bool interleaved /*= true*/)
 {
+	// Keep a copy so that we can register the same varyings on our variants
+	_varyings = std::vector<std::string>(names, names + numVaryings);
+	_varyingsInterleaved = interleaved;
+
 	glTransformFeedbackVaryings(_rendererId, numVaryings, names, interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
 }
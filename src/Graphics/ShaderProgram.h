@@ -93,7 +93,8 @@ public:
 	void RegisterVaryings(const char* const* names, int numVaryings, bool interleaved = true);
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader, and allows this shader program to be used. Any variants
+	/// built before relinking are cleared, see GetVariant
 	/// </summary>
 	/// <returns>True if the linking was successful, false if otherwise</returns>
 	bool Link();
@@ -109,6 +110,33 @@ public:
 
 	const std::unordered_map<std::string, UniformInfo>& GetUniforms() const { return _uniforms; }
 
+	/// <summary>
+	/// Gets a permutation of this shader that is compiled with the given preprocessor symbols
+	/// defined in every stage. Variants are compiled the first time they are requested, and then
+	/// cached in this program
+	/// </summary>
+	/// <param name="key">A key that uniquely identifies the set of defines, ex: a bitfield of features</param>
+	/// <param name="defines">The symbols to define, only used the first time a key is requested</param>
+	/// <returns>The shader variant, or nullptr if the variant could not be built</returns>
+	ShaderProgram::Sptr GetVariant(uint32_t key, const std::vector<std::string>& defines);
+	/// <summary>
+	/// Releases all variants that have been compiled from this shader
+	/// </summary>
+	void ClearVariants();
+
+	/// <summary>
+	/// Gets the location of the uniform with the given name, or -1 if the uniform
+	/// does not exist. Unlike SetUniform, will not modify the uniform map
+	/// </summary>
+	/// <param name="name">The name of the uniform to find</param>
+	int GetUniformLocation(const std::string& name) const;
+
+	/// <summary>
+	/// Gets all the source files that this shader was built from, including any
+	/// files pulled in via #include directives
+	/// </summary>
+	std::vector<std::string> GetSourceDependencies() const;
+
 	// Inherited from IGraphicsResource
 
 	virtual GlResourceType GetResourceClass() const override;
@@ -117,6 +145,10 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static ShaderProgram::Sptr FromJson(const nlohmann::json& data);
+	/// <summary>
+	/// Reads and parses all the source files for a manifest entry ahead of FromJson, called from worker threads
+	/// </summary>
+	static void PrefetchJson(const nlohmann::json& data);
 
 public:
 	bool FindUniform(const std::string& name, UniformInfo* out);
@@ -191,9 +223,18 @@ protected:
 	struct ShaderSource {
 		std::string Source;
 		bool        IsFilePath;
+		// All files the source was built from, if loaded from a file
+		std::vector<std::string> Dependencies;
 	};
 	std::unordered_map<ShaderPartType, ShaderSource> _fileSourceMap;
 
+	// Transform feedback varyings, stored so that variants can re-register them
+	std::vector<std::string> _varyings;
+	bool                     _varyingsInterleaved;
+
+	// Permutations of this shader, keyed by the caller's variant key
+	std::unordered_map<uint32_t, ShaderProgram::Sptr> _variants;
+
 	/// <summary>
 	/// Performs program introspection, where we examine the uniforms that
 	/// the program contains
@@ -0,0 +1,456 @@
+#include "Graphics/Textures/CompressedTextureCache.h"
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <algorithm>
+#include <Logging.h>
+
+#include "Utils/ThreadPool.h"
+#include "Utils/FileHelpers.h"
+#include "Utils/MemoryMappedFile.h"
+
+namespace fs = std::filesystem;
+
+const std::string compressedExtension = ".btex";
+
+/// <summary>
+/// Converts an 8 bit RGB color into a 5:6:5 color, rounding to nearest
+/// </summary>
+inline uint16_t PackRgb565(const float* color) {
+	uint16_t r = static_cast<uint16_t>(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	uint16_t g = static_cast<uint16_t>(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+	uint16_t b = static_cast<uint16_t>(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	return (r << 11) | (g << 5) | b;
+}
+
+/// <summary>
+/// Expands a 5:6:5 color back out to an 8 bit RGB color
+/// </summary>
+inline void UnpackRgb565(uint16_t value, float* color) {
+	color[0] = static_cast<float>((value >> 11) & 0x1F) * 255.0f / 31.0f;
+	color[1] = static_cast<float>((value >> 5)  & 0x3F) * 255.0f / 63.0f;
+	color[2] = static_cast<float>(value         & 0x1F) * 255.0f / 31.0f;
+}
+
+std::string CompressedTextureCache::GetCachePath(const std::string& sourceFile) {
+	return fs::path(sourceFile).replace_extension(compressedExtension).string();
+}
+
+bool CompressedTextureCache::LoadOrConvert(const std::vector<std::string>& sourceFiles, const std::string& cachePath, int targetChannels, bool generateMips, CompressedImage& result) {
+	if (sourceFiles.empty()) {
+		return false;
+	}
+
+	// Try the cache first, making sure it has the same layout that we're after
+	if (FileHelpers::IsNewerThan(cachePath, sourceFiles) && LoadFromFile(cachePath, result)) {
+		uint32_t expectedLevels = generateMips ? 1 + static_cast<uint32_t>(floor(log2(std::max(result.Width, result.Height)))) : 1;
+		if (result.NumFaces == sourceFiles.size() && result.NumLevels == expectedLevels) {
+			return true;
+		}
+	}
+
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point startTime = Clock::now();
+
+	// Decode all the source images
+	std::vector<ImageData> faces(sourceFiles.size());
+	for (size_t ix = 0; ix < sourceFiles.size(); ix++) {
+		faces[ix] = TextureLoader::DecodeImage(sourceFiles[ix], targetChannels);
+		if (!faces[ix].IsValid()) {
+			return false;
+		}
+	}
+
+	if (!Compress(faces.data(), static_cast<uint32_t>(faces.size()), generateMips, result)) {
+		LOG_WARN("Failed to compress texture \"{}\"", sourceFiles[0]);
+		return false;
+	}
+
+	// Even if the cache can't be written, we still have a perfectly good image
+	if (!SaveToFile(result, cachePath)) {
+		LOG_WARN("Failed to write compressed texture cache \"{}\"", cachePath);
+	}
+
+	std::chrono::duration<float> elapsed = Clock::now() - startTime;
+	LOG_TRACE("Compressed \"{}\" to {} in {} seconds ({}x{}, {} levels)", sourceFiles[0], ~result.Format, elapsed.count(), result.Width, result.Height, result.NumLevels);
+
+	return true;
+}
+
+bool CompressedTextureCache::Compress(const ImageData* faces, uint32_t numFaces, bool generateMips, CompressedImage& result) {
+	if (numFaces == 0 || !faces[0].IsValid()) {
+		return false;
+	}
+
+	// All faces must match, or we can't store them in a single texture
+	for (uint32_t ix = 1; ix < numFaces; ix++) {
+		if (!faces[ix].IsValid() || faces[ix].Width != faces[0].Width || faces[ix].Height != faces[0].Height || faces[ix].Channels != faces[0].Channels) {
+			return false;
+		}
+	}
+
+	result.Format    = ChooseFormat(faces, numFaces);
+	result.Width     = faces[0].Width;
+	result.Height    = faces[0].Height;
+	result.NumFaces  = numFaces;
+	result.NumLevels = generateMips ? 1 + static_cast<uint32_t>(floor(log2(std::max(result.Width, result.Height)))) : 1;
+	result.Levels.clear();
+	result.Levels.reserve((size_t)result.NumFaces * result.NumLevels);
+
+	// Work out where every level lives up front, so we can allocate the data in one go
+	const size_t blockSize = GetCompressedBlockSize(result.Format);
+	size_t totalSize = 0;
+	for (uint32_t face = 0; face < numFaces; face++) {
+		uint32_t width = result.Width, height = result.Height;
+		for (uint32_t level = 0; level < result.NumLevels; level++) {
+			size_t size = (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+			result.Levels.push_back({ width, height, totalSize, size });
+			totalSize += size;
+
+			width  = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+		}
+	}
+	result.Data.resize(totalSize);
+
+	// Faces are independent, so we can compress them all at once
+	ThreadPool::Get().ParallelFor(numFaces, 1, [&](size_t begin, size_t end) {
+		for (size_t face = begin; face < end; face++) {
+			const ImageData& image = faces[face];
+			uint32_t width = image.Width, height = image.Height;
+
+			// The encoders (and our downsampler) work on RGBA8, so expand whatever we were given.
+			// Single channel images are splatted into RGB so they downsample the same way
+			std::vector<uint8_t> rgba((size_t)width * height * 4);
+			const uint8_t* source = image.Pixels.get();
+			for (size_t ix = 0; ix < (size_t)width * height; ix++) {
+				const uint8_t* texel = source + ix * image.Channels;
+				uint8_t* target = rgba.data() + ix * 4;
+				target[0] = texel[0];
+				target[1] = image.Channels >= 2 ? texel[1] : texel[0];
+				target[2] = image.Channels >= 3 ? texel[2] : (image.Channels == 1 ? texel[0] : 0);
+				target[3] = image.Channels >= 4 ? texel[3] : 255;
+			}
+
+			for (uint32_t level = 0; level < result.NumLevels; level++) {
+				const CompressedImage::Level& info = result.GetLevel(static_cast<uint32_t>(face), level);
+				_CompressLevel(rgba.data(), width, height, result.Format, result.Data.data() + info.Offset);
+
+				if (level + 1 < result.NumLevels) {
+					// Box filter down to the next level, clamping at the edges for odd sizes
+					uint32_t nextWidth = std::max(1u, width / 2);
+					uint32_t nextHeight = std::max(1u, height / 2);
+					std::vector<uint8_t> next((size_t)nextWidth * nextHeight * 4);
+					for (uint32_t y = 0; y < nextHeight; y++) {
+						uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+						for (uint32_t x = 0; x < nextWidth; x++) {
+							uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+							for (int c = 0; c < 4; c++) {
+								uint32_t sum =
+									rgba[((size_t)y0 * width + x0) * 4 + c] + rgba[((size_t)y0 * width + x1) * 4 + c] +
+									rgba[((size_t)y1 * width + x0) * 4 + c] + rgba[((size_t)y1 * width + x1) * 4 + c];
+								next[((size_t)y * nextWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+							}
+						}
+					}
+					rgba.swap(next);
+					width = nextWidth;
+					height = nextHeight;
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+InternalFormat CompressedTextureCache::ChooseFormat(const ImageData* faces, uint32_t numFaces) {
+	switch (faces[0].Channels) {
+		case 1:
+			return InternalFormat::BC4;
+		case 2:
+			return InternalFormat::BC5;
+		case 3:
+			return InternalFormat::BC1;
+		default:
+			break;
+	}
+
+	// For RGBA, we only need to spend the extra space on alpha if the image actually uses it
+	for (uint32_t face = 0; face < numFaces; face++) {
+		const uint8_t* pixels = faces[face].Pixels.get();
+		size_t numTexels = (size_t)faces[face].Width * faces[face].Height;
+		for (size_t ix = 0; ix < numTexels; ix++) {
+			if (pixels[ix * 4 + 3] != 255) {
+				return InternalFormat::BC3;
+			}
+		}
+	}
+	return InternalFormat::BC1;
+}
+
+bool CompressedTextureCache::LoadFromFile(const std::string& filename, CompressedImage& result) {
+	// Mapping the file means the cache can be served straight out of the asset package
+	MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
+	if (file == nullptr) {
+		return false;
+	}
+	const uint8_t* seek = file->GetData();
+	const uint8_t* end  = seek + file->GetSize();
+
+	BinaryHeader header;
+	if (file->GetSize() >= sizeof(BinaryHeader)) {
+		memcpy(&header, seek, sizeof(BinaryHeader));
+		seek += sizeof(BinaryHeader);
+	}
+
+	// Make sure this is actually one of our files, and a version we can read
+	if (memcmp(header.HeaderBytes, BinaryHeader().HeaderBytes, 4) != 0 || header.Version != 0x01) {
+		LOG_WARN("\"{}\" is not a valid compressed texture", filename);
+		return false;
+	}
+	if (!IsCompressedFormat(header.Format) || header.NumFaces == 0 || header.NumLevels == 0) {
+		LOG_WARN("\"{}\" has an unsupported format or layout", filename);
+		return false;
+	}
+
+	result.Format    = header.Format;
+	result.Width     = header.Width;
+	result.Height    = header.Height;
+	result.NumFaces  = header.NumFaces;
+	result.NumLevels = header.NumLevels;
+	result.Levels.resize((size_t)header.NumFaces * header.NumLevels);
+
+	// Read the level table, and work out how big the data block is
+	std::vector<BinaryLevel> levels(result.Levels.size());
+	size_t levelTableSize = levels.size() * sizeof(BinaryLevel);
+	if ((size_t)(end - seek) < levelTableSize) {
+		LOG_WARN("Compressed texture \"{}\" is truncated", filename);
+		return false;
+	}
+	memcpy(levels.data(), seek, levelTableSize);
+	seek += levelTableSize;
+	size_t totalSize = 0;
+	for (size_t ix = 0; ix < levels.size(); ix++) {
+		result.Levels[ix] = { levels[ix].Width, levels[ix].Height, totalSize, levels[ix].Size };
+		totalSize += levels[ix].Size;
+	}
+
+	// All the level data is packed back to back, so we can grab it in a single copy
+	if ((size_t)(end - seek) < totalSize) {
+		LOG_WARN("Compressed texture \"{}\" is truncated", filename);
+		return false;
+	}
+	result.Data.assign(seek, seek + totalSize);
+	return true;
+}
+
+bool CompressedTextureCache::SaveToFile(const CompressedImage& image, const std::string& filename) {
+	// Two threads may be converting the same image, so this has to be written atomically
+	return FileHelpers::WriteFileAtomic(filename, [&](std::ostream& file) {
+		BinaryHeader header = BinaryHeader();
+		header.Version   = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
+		header.Format    = image.Format;
+		header.Width     = image.Width;
+		header.Height    = image.Height;
+		header.NumFaces  = static_cast<uint16_t>(image.NumFaces);
+		header.NumLevels = static_cast<uint16_t>(image.NumLevels);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+
+		for (const CompressedImage::Level& level : image.Levels) {
+			BinaryLevel entry = { level.Width, level.Height, static_cast<uint32_t>(level.Size) };
+			file.write(reinterpret_cast<const char*>(&entry), sizeof(BinaryLevel));
+		}
+		file.write(reinterpret_cast<const char*>(image.Data.data()), image.Data.size());
+		return true;
+	});
+}
+
+void CompressedTextureCache::_CompressLevel(const uint8_t* rgba, uint32_t width, uint32_t height, InternalFormat format, uint8_t* output) {
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	const size_t blockSize = GetCompressedBlockSize(format);
+
+	// Rows of blocks are independent, large levels are split across the pool
+	ThreadPool::Get().ParallelFor(blocksY, 0, [&](size_t begin, size_t end) {
+		uint8_t block[16 * 4];
+		uint8_t channel[16];
+
+		for (size_t by = begin; by < end; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				// Gather the 4x4 block, clamping to the edge for levels that aren't a multiple of 4
+				for (uint32_t py = 0; py < 4; py++) {
+					uint32_t y = std::min(static_cast<uint32_t>(by) * 4 + py, height - 1);
+					for (uint32_t px = 0; px < 4; px++) {
+						uint32_t x = std::min(bx * 4 + px, width - 1);
+						memcpy(block + (py * 4 + px) * 4, rgba + ((size_t)y * width + x) * 4, 4);
+					}
+				}
+
+				uint8_t* target = output + ((size_t)by * blocksX + bx) * blockSize;
+				switch (format) {
+					case InternalFormat::BC1:
+						_EncodeBC1(block, target);
+						break;
+					case InternalFormat::BC3:
+						for (int ix = 0; ix < 16; ix++) { channel[ix] = block[ix * 4 + 3]; }
+						_EncodeBC4(channel, target);
+						_EncodeBC1(block, target + 8);
+						break;
+					case InternalFormat::BC4:
+						for (int ix = 0; ix < 16; ix++) { channel[ix] = block[ix * 4]; }
+						_EncodeBC4(channel, target);
+						break;
+					case InternalFormat::BC5:
+						for (int ix = 0; ix < 16; ix++) { channel[ix] = block[ix * 4]; }
+						_EncodeBC4(channel, target);
+						for (int ix = 0; ix < 16; ix++) { channel[ix] = block[ix * 4 + 1]; }
+						_EncodeBC4(channel, target + 8);
+						break;
+					default:
+						LOG_ASSERT(false, "No encoder for format {}", ~format);
+						return;
+				}
+			}
+		}
+	});
+}
+
+void CompressedTextureCache::_EncodeBC1(const uint8_t* block, uint8_t* output) {
+	// Find the mean color of the block
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int ix = 0; ix < 16; ix++) {
+		for (int c = 0; c < 3; c++) {
+			mean[c] += block[ix * 4 + c];
+		}
+	}
+	for (int c = 0; c < 3; c++) {
+		mean[c] /= 16.0f;
+	}
+
+	// Build the covariance matrix, and find it's principal axis with a few rounds of power iteration.
+	// This is the line through color space that best fits the block
+	float cov[6] = { 0.0f };
+	for (int ix = 0; ix < 16; ix++) {
+		float r = block[ix * 4 + 0] - mean[0];
+		float g = block[ix * 4 + 1] - mean[1];
+		float b = block[ix * 4 + 2] - mean[2];
+		cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+		cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+	}
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iter = 0; iter < 8; iter++) {
+		float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		float length = std::max({ std::abs(x), std::abs(y), std::abs(z) });
+		if (length < 1e-6f) {
+			break;
+		}
+		axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+	}
+
+	// Project the colors onto the axis to find our endpoints
+	float minT = FLT_MAX, maxT = -FLT_MAX;
+	for (int ix = 0; ix < 16; ix++) {
+		float t =
+			(block[ix * 4 + 0] - mean[0]) * axis[0] +
+			(block[ix * 4 + 1] - mean[1]) * axis[1] +
+			(block[ix * 4 + 2] - mean[2]) * axis[2];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	// Inset the endpoints slightly, this lowers the error for the colors in between
+	float inset = (maxT - minT) / 16.0f;
+	float endpoints[2][3];
+	for (int c = 0; c < 3; c++) {
+		endpoints[0][c] = mean[c] + axis[c] * (maxT - inset);
+		endpoints[1][c] = mean[c] + axis[c] * (minT + inset);
+	}
+
+	uint16_t color0 = PackRgb565(endpoints[0]);
+	uint16_t color1 = PackRgb565(endpoints[1]);
+
+	// color0 > color1 selects the 4 color mode, which is what we want for opaque blocks
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1) {
+		float palette[4][3];
+		UnpackRgb565(color0, palette[0]);
+		UnpackRgb565(color1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		// Pick the closest palette entry for each texel
+		for (int ix = 0; ix < 16; ix++) {
+			float bestError = FLT_MAX;
+			uint32_t best = 0;
+			for (uint32_t entry = 0; entry < 4; entry++) {
+				float dr = block[ix * 4 + 0] - palette[entry][0];
+				float dg = block[ix * 4 + 1] - palette[entry][1];
+				float db = block[ix * 4 + 2] - palette[entry][2];
+				float error = dr * dr + dg * dg + db * db;
+				if (error < bestError) {
+					bestError = error;
+					best = entry;
+				}
+			}
+			indices |= best << (ix * 2);
+		}
+	}
+
+	// Everything is little endian
+	output[0] = color0 & 0xFF; output[1] = color0 >> 8;
+	output[2] = color1 & 0xFF; output[3] = color1 >> 8;
+	for (int ix = 0; ix < 4; ix++) {
+		output[4 + ix] = (indices >> (ix * 8)) & 0xFF;
+	}
+}
+
+void CompressedTextureCache::_EncodeBC4(const uint8_t* values, uint8_t* output) {
+	uint8_t minValue = 255, maxValue = 0;
+	for (int ix = 0; ix < 16; ix++) {
+		minValue = std::min(minValue, values[ix]);
+		maxValue = std::max(maxValue, values[ix]);
+	}
+
+	// max > min selects the 8 value mode, if they are equal every index is 0 which is still correct
+	uint64_t indices = 0;
+	if (maxValue != minValue) {
+		int palette[8];
+		palette[0] = maxValue;
+		palette[1] = minValue;
+		for (int ix = 2; ix < 8; ix++) {
+			palette[ix] = ((8 - ix) * maxValue + (ix - 1) * minValue + 3) / 7;
+		}
+
+		for (int ix = 0; ix < 16; ix++) {
+			int bestError = INT_MAX;
+			uint64_t best = 0;
+			for (int entry = 0; entry < 8; entry++) {
+				int error = std::abs(values[ix] - palette[entry]);
+				if (error < bestError) {
+					bestError = error;
+					best = entry;
+				}
+			}
+			indices |= best << (ix * 3);
+		}
+	}
+
+	output[0] = maxValue;
+	output[1] = minValue;
+	for (int ix = 0; ix < 6; ix++) {
+		output[2 + ix] = (indices >> (ix * 8)) & 0xFF;
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Graphics/GlEnums.h"
+#include "Graphics/Textures/TextureLoader.h"
+
+/// <summary>
+/// Stores a block compressed image, with all of it's faces and mip levels
+/// </summary>
+struct CompressedImage {
+	/// <summary>
+	/// Describes where a single face and mip level is stored in the data block
+	/// </summary>
+	struct Level {
+		uint32_t Width;
+		uint32_t Height;
+		size_t   Offset;
+		size_t   Size;
+	};
+
+	InternalFormat       Format;
+	uint32_t             Width;
+	uint32_t             Height;
+	uint32_t             NumFaces;
+	uint32_t             NumLevels;
+	// Face-major, so level L of face F is at index F * NumLevels + L
+	std::vector<Level>   Levels;
+	std::vector<uint8_t> Data;
+
+	CompressedImage() :
+		Format(InternalFormat::Unknown),
+		Width(0), Height(0),
+		NumFaces(0), NumLevels(0),
+		Levels(), Data() { }
+
+	/// <summary>
+	/// Returns true if the image contains compressed data
+	/// </summary>
+	bool IsValid() const { return IsCompressedFormat(Format) && !Data.empty(); }
+	/// <summary>
+	/// Gets the location of the given face and mip level in the data block
+	/// </summary>
+	const Level& GetLevel(uint32_t face, uint32_t level) const { return Levels[(size_t)face * NumLevels + level]; }
+};
+
+/// <summary>
+/// Converts images into block compressed textures with a precomputed mip chain, and caches
+/// the result to a binary file next to the source (similar to the OptimizedObjLoader's .bin files).
+/// Loading the cache skips decoding the source image and generating mips on the GPU, and the
+/// compressed data takes up 4-8x less memory than RGBA8
+///
+/// The encoder outputs BC1 (opaque color), BC3 (color + alpha), BC4 (single channel) or BC5 (two
+/// channels, ex: normal maps). The container and loader also accept BC7 data from external tools
+/// </summary>
+class CompressedTextureCache {
+public:
+	CompressedTextureCache() = delete;
+
+	/// <summary>
+	/// Gets the path of the cache file for the given source image
+	/// </summary>
+	/// <param name="sourceFile">The path of the source image</param>
+	static std::string GetCachePath(const std::string& sourceFile);
+
+	/// <summary>
+	/// Loads a compressed image from the cache, converting the source images and writing a new cache file
+	/// if the cache is missing, out of date, or does not match the requested layout. Safe to call from any thread
+	/// </summary>
+	/// <param name="sourceFiles">The source images, 1 for a regular texture or 6 for a cubemap</param>
+	/// <param name="cachePath">The path to the cache file</param>
+	/// <param name="targetChannels">The number of channels to decode the source with, or 0 to use the number in the file</param>
+	/// <param name="generateMips">True if the cache should contain a full mip chain</param>
+	/// <param name="result">The image to store the result in</param>
+	/// <returns>True if the image was loaded or converted</returns>
+	static bool LoadOrConvert(const std::vector<std::string>& sourceFiles, const std::string& cachePath, int targetChannels, bool generateMips, CompressedImage& result);
+
+	/// <summary>
+	/// Compresses a set of decoded images, which must all be the same size and channel count
+	/// </summary>
+	/// <param name="faces">The images to compress</param>
+	/// <param name="numFaces">The number of images</param>
+	/// <param name="generateMips">True to generate a full mip chain for each face</param>
+	/// <param name="result">The image to store the result in</param>
+	/// <returns>True if the images could be compressed</returns>
+	static bool Compress(const ImageData* faces, uint32_t numFaces, bool generateMips, CompressedImage& result);
+
+	/// <summary>
+	/// Picks the best supported compressed format for an image, based on it's channels and alpha
+	/// </summary>
+	static InternalFormat ChooseFormat(const ImageData* faces, uint32_t numFaces);
+
+	/// <summary>
+	/// Loads a compressed image from a cache file
+	/// </summary>
+	/// <param name="filename">The path to the cache file</param>
+	/// <param name="result">The image to store the result in</param>
+	/// <returns>True if the file was a valid cache file</returns>
+	static bool LoadFromFile(const std::string& filename, CompressedImage& result);
+	/// <summary>
+	/// Saves a compressed image to a cache file
+	/// </summary>
+	/// <param name="image">The image to save</param>
+	/// <param name="filename">The path to the cache file</param>
+	/// <returns>True if the file was written</returns>
+	static bool SaveToFile(const CompressedImage& image, const std::string& filename);
+
+protected:
+	// Will be put at the start of the binary file, contains info about the contents of the file
+	struct BinaryHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char           HeaderBytes[4] = { 'B', 'T', 'E', 'X' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint16_t       Version = 0;
+		// The compressed format of the data
+		InternalFormat Format = InternalFormat::Unknown;
+		// The size of the top mip level, in texels
+		uint32_t       Width = 0;
+		uint32_t       Height = 0;
+		// The number of faces (6 for cubemaps) and mip levels per face
+		uint16_t       NumFaces = 0;
+		uint16_t       NumLevels = 0;
+	};
+
+	// Stored after the header for every face and level, in the same order as the data
+	struct BinaryLevel {
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Size;
+	};
+
+	/// <summary>
+	/// Compresses a single RGBA8 image into the given output
+	/// </summary>
+	static void _CompressLevel(const uint8_t* rgba, uint32_t width, uint32_t height, InternalFormat format, uint8_t* output);
+	/// <summary>
+	/// Encodes a block of 16 RGBA texels as a BC1 color block
+	/// </summary>
+	static void _EncodeBC1(const uint8_t* block, uint8_t* output);
+	/// <summary>
+	/// Encodes a block of 16 single channel values as a BC4 block, as used by the alpha of BC3 and both channels of BC5
+	/// </summary>
+	static void _EncodeBC4(const uint8_t* values, uint8_t* output);
+};
@@ -1,11 +1,17 @@
 #include "ITexture.h"
+#include "Graphics/Textures/TextureLoader.h"
+#include <algorithm>
+#include <vector>
+#include <cstring>
 
 ITexture::Limits ITexture::__limits = ITexture::Limits();
 bool ITexture::__isStaticInit = false;
+std::unordered_map<TextureType, GLuint> ITexture::__placeholders;
 
 ITexture::ITexture(TextureType type) :
 	IGraphicsResource(),
-	_type(type)
+	_type(type),
+	_isResident(true)
 {
 	__StaticInit();
 	_Recreate();
@@ -17,9 +23,23 @@ void ITexture::_Recreate()
 		glDeleteTextures(1, &_rendererId);
 	}
 	glCreateTextures((GLenum)_type, 1, &_rendererId);
+	_SetGpuMemoryUsage(0);
+}
+
+void ITexture::_SetMemoryUsage(InternalFormat format, uint32_t levels, uint32_t width, uint32_t height, uint32_t depth, uint32_t layers, uint32_t samples)
+{
+	size_t result = 0;
+	for (uint32_t level = 0; level < levels; level++) {
+		result += GetImageSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u), std::max(depth >> level, 1u));
+	}
+	_SetGpuMemoryUsage(result * layers * samples);
 }
 
 ITexture::~ITexture() {
+	// Make sure the loader doesn't try to upload into us after we're gone
+	if (!_isResident) {
+		TextureLoader::Cancel(this);
+	}
 	if (glIsTexture(_rendererId)) {
 		glDeleteTextures(1, &_rendererId);
 		_rendererId = 0;
@@ -29,7 +49,7 @@ ITexture::~ITexture() {
 void ITexture::Bind(int slot) {
 	if (_rendererId != 0) {
 		// Instead of glActiveTexture + glBindTexture, we can one line it now :D
-		glBindTextureUnit(slot, _rendererId); 
+		glBindTextureUnit(slot, _isResident ? _rendererId : __GetPlaceholder(_type));
 	}
 }
 
@@ -43,6 +63,36 @@ void ITexture::Clear(const glm::vec4& color) {
 	}
 }
 
+bool ITexture::_VerifyLevelData(PixelFormat format, PixelType type, const void* data, size_t size) const {
+	if (_rendererId == 0 || data == nullptr) {
+		return false;
+	}
+
+	// Ask GL how big the level is, so we only compare the bytes that were uploaded
+	GLint width = 0, height = 0, depth = 0;
+	glGetTextureLevelParameteriv(_rendererId, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTextureLevelParameteriv(_rendererId, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTextureLevelParameteriv(_rendererId, 0, GL_TEXTURE_DEPTH, &depth);
+	size_t levelSize = GetTexelSize(format, type) * (size_t)width * (size_t)height * (size_t)depth;
+	if (levelSize == 0 || levelSize > size) {
+		return false;
+	}
+
+	std::vector<uint8_t> readBack(levelSize);
+	glGetTextureImage(_rendererId, 0, *format, *type, (GLsizei)levelSize, readBack.data());
+	return memcmp(readBack.data(), data, levelSize) == 0;
+}
+
+bool ITexture::IsLoading() const {
+	return !_isResident && TextureLoader::IsPending(this);
+}
+
+void ITexture::WaitUntilResident() {
+	if (!_isResident) {
+		TextureLoader::Wait(this);
+	}
+}
+
 GlResourceType ITexture::GetResourceClass() const {
 	return GlResourceType::Texture;
 }
@@ -77,3 +127,60 @@ ITexture::Limits ITexture::GetLimits() {
 	__StaticInit();
 	return __limits;
 }
+
+GLuint ITexture::__GetPlaceholder(TextureType type) {
+	auto it = __placeholders.find(type);
+	if (it != __placeholders.end()) {
+		return it->second;
+	}
+
+	// Plain white for regular textures, so that anything multiplied by it is unchanged
+	static const uint8_t white[4] = { 255, 255, 255, 255 };
+
+	GLuint result = 0;
+	glCreateTextures(*type, 1, &result);
+	switch (type) {
+		case TextureType::_1D:
+			glTextureStorage1D(result, 1, GL_RGBA8, 1);
+			glTextureSubImage1D(result, 0, 0, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+			break;
+		case TextureType::_2D:
+			glTextureStorage2D(result, 1, GL_RGBA8, 1, 1);
+			glTextureSubImage2D(result, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+			break;
+		case TextureType::Cubemap:
+			glTextureStorage2D(result, 1, GL_RGBA8, 1, 1);
+			for (int face = 0; face < 6; face++) {
+				glTextureSubImage3D(result, 0, 0, 0, face, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+			}
+			break;
+		case TextureType::_3D:
+		{
+			// 3D textures are used for LUTs, so we use a 2x2x2 identity LUT. With linear filtering
+			// and clamping this maps every color to itself
+			uint8_t identity[2 * 2 * 2 * 4];
+			for (int ix = 0; ix < 8; ix++) {
+				identity[ix * 4 + 0] = (ix & 1) ? 255 : 0;
+				identity[ix * 4 + 1] = (ix & 2) ? 255 : 0;
+				identity[ix * 4 + 2] = (ix & 4) ? 255 : 0;
+				identity[ix * 4 + 3] = 255;
+			}
+			glTextureStorage3D(result, 1, GL_RGBA8, 2, 2, 2);
+			glTextureSubImage3D(result, 0, 0, 0, 0, 2, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, identity);
+			glTextureParameteri(result, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(result, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(result, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+			break;
+		}
+		default:
+			// We don't load multisampled textures from files, so they never need a placeholder
+			LOG_WARN("No placeholder available for texture type {}", ~type);
+			break;
+	}
+	glTextureParameteri(result, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(result, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glObjectLabel(GL_TEXTURE, result, -1, "Placeholder");
+
+	__placeholders[type] = result;
+	return result;
+}
\ No newline at end of file
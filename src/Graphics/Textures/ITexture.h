@@ -2,6 +2,7 @@
 #include <memory>
 #include <glad/glad.h>
 #include <cstdint>
+#include <unordered_map>
 #include <GLM/glm.hpp>
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/IGraphicsResource.h"
@@ -48,6 +49,28 @@ public:
 	/// <param name="color">The color to clear to</param>
 	void Clear(const glm::vec4& color);
 
+	/// <summary>
+	/// Returns true if this texture's data has been uploaded to the GPU. Textures that are
+	/// loading in the background, or that failed to load, will bind a placeholder instead
+	/// </summary>
+	bool IsResident() const { return _isResident; }
+	/// <summary>
+	/// Returns true if this texture is still waiting on a background load
+	/// </summary>
+	bool IsLoading() const;
+	/// <summary>
+	/// Blocks until any background load for this texture has completed, must be called
+	/// from the GL thread
+	/// </summary>
+	void WaitUntilResident();
+
+	// Inherited from IResource
+
+	/// <summary>
+	/// Gets the number of bytes of GPU memory allocated for this texture, including all of it's mip levels
+	/// </summary>
+	virtual size_t GetMemoryUsage() const override { return GetGpuMemoryUsage(); }
+
 	// Inherited from IGraphicsResource
 
 	virtual GlResourceType GetResourceClass() const override;
@@ -60,14 +83,45 @@ protected:
 	/// </summary>
 	virtual void _Recreate();
 
+	/// <summary>
+	/// Updates the GPU memory usage for this texture after it's storage has been allocated
+	/// </summary>
+	/// <param name="format">The internal format of the texture</param>
+	/// <param name="levels">The number of mip levels that were allocated</param>
+	/// <param name="width">The width of the top mip level</param>
+	/// <param name="height">The height of the top mip level</param>
+	/// <param name="depth">The depth of the top mip level, for 3D textures</param>
+	/// <param name="layers">The number of images per level that do not shrink with the mip chain (ex: cubemap faces)</param>
+	/// <param name="samples">The number of samples per texel, for multisampled textures</param>
+	void _SetMemoryUsage(InternalFormat format, uint32_t levels, uint32_t width, uint32_t height = 1, uint32_t depth = 1, uint32_t layers = 1, uint32_t samples = 1);
+
+	/// <summary>
+	/// Reads back the top mip level of the texture and compares it to the data it was loaded from. Used when
+	/// loading textures from saved data, to catch textures that don't survive being saved and loaded
+	/// </summary>
+	/// <param name="format">The layout of the pixels in data</param>
+	/// <param name="type">The type of each component in data</param>
+	/// <param name="data">The data that was uploaded to the top level</param>
+	/// <param name="size">The number of bytes in data, must cover the whole level</param>
+	/// <returns>True if the texture's top level matches data</returns>
+	bool _VerifyLevelData(PixelFormat format, PixelType type, const void* data, size_t size) const;
+
 	TextureType _type; // The type for this texture, mainly used for debugging
+	bool _isResident;  // False while waiting on the TextureLoader
+
+	friend class TextureLoader;
 
 // STATIC SECTION
 private:
 	static Limits __limits;
 	static bool __isStaticInit;
+	static std::unordered_map<TextureType, GLuint> __placeholders;
 
 	static void __StaticInit();
+	/// <summary>
+	/// Gets a tiny texture of the given type to bind while the real data is loading
+	/// </summary>
+	static GLuint __GetPlaceholder(TextureType type);
 
 public:
 	/// <summary>
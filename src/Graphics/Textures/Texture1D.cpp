@@ -1,7 +1,7 @@
 #include "Texture1D.h"
 #include "Utils/Base64.h"
+#include "Utils/ResourceManager/BlobStorage.h"
 #include "Utils/JsonGlmHelpers.h"
-#include <stb_image.h>
 
 inline int CalcRequiredMipLevels(int size) {
 	return (1 + floor(log2(size)));
@@ -24,7 +24,11 @@ Texture1D::Texture1D(const Texture1DDescription& description) :
 {
 	_SetTextureParams();
 	if (!description.Filename.empty()) {
-		_LoadDataFromFile();
+		if (description.LoadAsync) {
+			_LoadDataFromFileAsync();
+		} else {
+			_LoadDataFromFile();
+		}
 	}
 }
 
@@ -78,14 +82,16 @@ nlohmann::json Texture1D::ToJson() const
 	}
 	else if (_pixelType != PixelType::Unknown) {
 		result["size"] = _description.Size;
+		result["internal_format"] = ~_description.Format;
 		result["format"] = ~_description.FormatHint;
 		result["pixel_type"] = ~_pixelType;
 
 		if (_description.Size > 0 && _description.FormatHint != PixelFormat::Unknown) {
 			size_t dataSize = GetTexelSize(_description.FormatHint, _pixelType) * _description.Size;
-			uint8_t* dataStore = new uint8_t[dataSize];
-			glGetTextureImage(_rendererId, 0, *_description.Format, *_pixelType, dataSize, dataStore);
-			result["data"] = Base64::Encode(dataStore, dataSize);
+			std::vector<uint8_t> dataStore(dataSize);
+			glGetTextureImage(_rendererId, 0, *_description.FormatHint, *_pixelType, (GLsizei)dataSize, dataStore.data());
+			// Pixel data goes into a binary sidecar file, rather than bloating the manifest
+			result["blob"] = BlobStorage::Write(GetGUID(), dataStore.data(), dataSize);
 		}
 	}
 	return result;
@@ -101,14 +107,34 @@ Texture1D::Sptr Texture1D::FromJson(const nlohmann::json& data)
 	description.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	description.GenerateMipMaps = JsonGet(data, "generate_mipmaps", false);
 	description.FormatHint = JsonParseEnum(PixelFormat, data, "format", PixelFormat::Unknown);
+	description.Format = JsonParseEnum(InternalFormat, data, "internal_format", InternalFormat::Unknown);
+	// Older manifests didn't save the internal format, so we guess it from the layout of the saved pixels
+	if (description.Format == InternalFormat::Unknown && description.Filename.empty() && description.FormatHint != PixelFormat::Unknown) {
+		description.Format = GetInternalFormatForChannels8(GetTexelComponentCount(description.FormatHint));
+	}
+	description.LoadAsync = JsonGet(data, "load_async", true);
 
 	Texture1D::Sptr result = std::make_shared<Texture1D>(description);
 
 	// If we embedded data into the JSON, load it now
-	if (description.Filename.empty() && data.contains("data") && data["data"].is_string()) {
+	if (description.Filename.empty() && data.contains("blob") && BlobStorage::IsReference(data["blob"])) {
+		PixelType type = JsonParseEnum(PixelType, data, "pixel_type", PixelType::Unknown);
+		BlobStorage::Blob blob = BlobStorage::Read(data["blob"]);
+		if (blob.IsValid() && blob.Size >= GetTexelSize(description.FormatHint, type) * description.Size) {
+			result->LoadData(description.Size, description.FormatHint, type, (void*)blob.Data);
+			// Make sure the texture actually kept what we saved, a bad format will silently drop the upload
+			if (!result->_VerifyLevelData(description.FormatHint, type, blob.Data, blob.Size)) {
+				LOG_WARN("Texture does not match it's saved blob after loading, it's internal format may not fit the saved pixels");
+			}
+		} else {
+			LOG_WARN("JSON blob had data, but failed to load to texture");
+		}
+	}
+	// Older manifests stored the data as Base64 in the JSON itself
+	else if (description.Filename.empty() && data.contains("data") && data["data"].is_string()) {
 		PixelType type = JsonParseEnum(PixelType, data, "pixel_type", PixelType::Unknown);
 		try {
-			std::string rawData = Base64::Decode(data['data'].get<std::string>());
+			std::string rawData = Base64::Decode(data["data"].get<std::string>());
 			result->LoadData(description.Size, description.FormatHint, type, rawData.data());
 		}
 		catch (std::runtime_error()) {
@@ -124,52 +150,64 @@ void Texture1D::_LoadDataFromFile()
 	LOG_ASSERT(_description.Size == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
-		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return;
-		}
+		ImageData image = TextureLoader::DecodeImage(_description.Filename, GetTexelComponentCount(_description.FormatHint));
+		_UploadImage(image, false);
+	}
 
-		// We should estimate a good format for our data
+	SetDebugName(_description.Filename);
+}
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+void Texture1D::_LoadDataFromFileAsync()
+{
+	LOG_ASSERT(_description.Size == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+	// The decode step runs on another thread, so it may only use copies of what it needs
+	std::shared_ptr<ImageData> image = std::make_shared<ImageData>();
+	std::string filename = _description.Filename;
+	int targetChannels = GetTexelComponentCount(_description.FormatHint);
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+	TextureLoader::Enqueue(this,
+		[image, filename, targetChannels]() { *image = TextureLoader::DecodeImage(filename, targetChannels); },
+		[this, image]() { return _UploadImage(*image, true); }
+	);
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Size = width * height;
+	SetDebugName(_description.Filename);
+}
 
-		// Allocates our memory
-		_SetTextureParams();
+bool Texture1D::_UploadImage(const ImageData& image, bool useUnpackBuffer)
+{
+	if (!image.IsValid()) {
+		return false;
+	}
 
-		// Upload data to our texture
-		LoadData(width * height, image_format, PixelType::UByte, data);
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(image.Channels);
+	PixelFormat    image_format = GetPixelFormatForChannels(image.Channels);
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+	// This is one of those poorly documented things in OpenGL
+	if ((image.Channels * image.Width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
 	}
 
-	SetDebugName(_description.Filename);
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Size = image.Width * image.Height;
+
+	// Allocates our memory
+	_SetTextureParams();
+
+	// Upload data to our texture, when streaming from a buffer the data pointer is an offset into the buffer
+	if (useUnpackBuffer) {
+		uint32_t buffer = TextureLoader::BeginUnpack(image.Pixels.get(), image.GetSizeInBytes());
+		LoadData(_description.Size, image_format, PixelType::UByte, nullptr);
+		TextureLoader::EndUnpack(buffer);
+	} else {
+		LoadData(_description.Size, image_format, PixelType::UByte, image.Pixels.get());
+	}
+
+	return true;
 }
 
 void Texture1D::_SetTextureParams()
@@ -178,6 +216,7 @@ void Texture1D::_SetTextureParams()
 	int layers = _description.GenerateMipMaps ? CalcRequiredMipLevels(_description.Size) : 1;
 	// Allocates the memory for our texture
 	glTextureStorage1D(_rendererId, layers, (GLenum)_description.Format, _description.Size);
+	_SetMemoryUsage(_description.Format, layers, _description.Size);
 
 	glTextureParameteri(_rendererId, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
 	glTextureParameteri(_rendererId, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
@@ -1,5 +1,6 @@
 #pragma once
 #include "ITexture.h"
+#include "TextureLoader.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -43,6 +44,12 @@ struct Texture1DDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// True if the file should be decoded on a worker thread and uploaded in the background,
+	/// the texture will bind a placeholder until it is resident
+	/// </summary>
+	bool           LoadAsync;
+
 	Texture1DDescription() :
 		Size(0),
 		Format(InternalFormat::Unknown),
@@ -51,7 +58,8 @@ struct Texture1DDescription {
 		MagnificationFilter(MagFilter::Linear),
 		GenerateMipMaps(true),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		LoadAsync(false)
 	{ }
 };
 
@@ -123,6 +131,18 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
+	/// Queues this texture to be loaded from the file specified in the description
+	/// by the TextureLoader
+	/// </summary>
+	void _LoadDataFromFileAsync();
+	/// <summary>
+	/// Allocates memory for a decoded image and uploads it's pixels as a single row
+	/// </summary>
+	/// <param name="image">The image to upload</param>
+	/// <param name="useUnpackBuffer">True to stream the pixels through a pixel unpack buffer</param>
+	/// <returns>True if the image was valid and has been uploaded</returns>
+	bool _UploadImage(const ImageData& image, bool useUnpackBuffer);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
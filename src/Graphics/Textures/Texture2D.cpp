@@ -1,9 +1,9 @@
 #include "Texture2D.h"
-#include <stb_image.h>
 #include <Logging.h>
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Utils/ResourceManager/BlobStorage.h"
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -27,18 +27,23 @@ nlohmann::json Texture2D::ToJson() const {
 
 	if (!_description.Filename.empty()) {
 		result["filename"] = _description.Filename;
+		if (_description.UseCompression) {
+			result["compress"] = true;
+		}
 	}
 	else if (_pixelType != PixelType::Unknown) {
 		result["size_x"] = _description.Width;
-		result["size_y"] = _description.Width;
+		result["size_y"] = _description.Height;
 
+		result["internal_format"] = ~_description.Format;
 		result["format"] = ~_description.FormatHint;
 		result["pixel_type"] = ~_pixelType;
 		if (_description.Width * _description.Height > 0 && _description.FormatHint != PixelFormat::Unknown) {
 			size_t dataSize = GetTexelSize(_description.FormatHint, _pixelType) * _description.Width * _description.Height;
-			uint8_t* dataStore = new uint8_t[dataSize];
-			glGetTextureImage(_rendererId, 0, *_description.Format, *_pixelType, dataSize, dataStore);
-			result["data"] = Base64::Encode(dataStore, dataSize);
+			std::vector<uint8_t> dataStore(dataSize);
+			glGetTextureImage(_rendererId, 0, *_description.FormatHint, *_pixelType, (GLsizei)dataSize, dataStore.data());
+			// Pixel data goes into a binary sidecar file, rather than bloating the manifest
+			result["blob"] = BlobStorage::Write(GetGUID(), dataStore.data(), dataSize);
 		}
 	}
 
@@ -48,21 +53,45 @@ nlohmann::json Texture2D::ToJson() const {
 Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 {
 	Texture2DDescription descr = Texture2DDescription();
-	descr.Filename = data["filename"];
+	descr.Filename = JsonGet<std::string>(data, "filename", "");
 	descr.HorizontalWrap = JsonParseEnum(WrapMode, data, "wrap_s", WrapMode::ClampToEdge);
 	descr.VerticalWrap   = JsonParseEnum(WrapMode, data, "wrap_t", WrapMode::ClampToEdge);
 	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "filter_min", MinFilter::NearestMipNearest);
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.MaxAnisotropic      = JsonGet(data, "anisotropic", 0.0f);
 	descr.GenerateMipMaps     = JsonGet(data, "generate_mipmaps", false);
+	descr.LoadAsync           = JsonGet(data, "load_async", true);
+	descr.UseCompression      = JsonGet(data, "compress", false);
+	descr.Width               = JsonGet(data, "size_x", descr.Width);
+	descr.Height              = JsonGet(data, "size_y", descr.Height);
+	descr.FormatHint          = JsonParseEnum(PixelFormat, data, "format", descr.FormatHint);
+	descr.Format              = JsonParseEnum(InternalFormat, data, "internal_format", InternalFormat::Unknown);
+	// Older manifests didn't save the internal format, so we guess it from the layout of the saved pixels
+	if (descr.Format == InternalFormat::Unknown && descr.Filename.empty() && descr.FormatHint != PixelFormat::Unknown) {
+		descr.Format = GetInternalFormatForChannels8(GetTexelComponentCount(descr.FormatHint));
+	}
 
 	Texture2D::Sptr result = std::make_shared<Texture2D>(descr);
 
 	// If we embedded data into the JSON, load it now
-	if (descr.Filename.empty() && data.contains("data") && data["data"].is_string()) {
+	if (descr.Filename.empty() && data.contains("blob") && BlobStorage::IsReference(data["blob"])) {
+		PixelType type = JsonParseEnum(PixelType, data, "pixel_type", PixelType::Unknown);
+		BlobStorage::Blob blob = BlobStorage::Read(data["blob"]);
+		if (blob.IsValid() && blob.Size >= GetTexelSize(descr.FormatHint, type) * descr.Width * descr.Height) {
+			result->LoadData(descr.Width, descr.Height, descr.FormatHint, type, (void*)blob.Data);
+			// Make sure the texture actually kept what we saved, a bad format will silently drop the upload
+			if (!result->_VerifyLevelData(descr.FormatHint, type, blob.Data, blob.Size)) {
+				LOG_WARN("Texture does not match it's saved blob after loading, it's internal format may not fit the saved pixels");
+			}
+		} else {
+			LOG_WARN("JSON blob had data, but failed to load to texture");
+		}
+	}
+	// Older manifests stored the data as Base64 in the JSON itself
+	else if (descr.Filename.empty() && data.contains("data") && data["data"].is_string()) {
 		PixelType type = JsonParseEnum(PixelType, data, "pixel_type", PixelType::Unknown);
 		try {
-			std::string rawData = Base64::Decode(data['data'].get<std::string>());
+			std::string rawData = Base64::Decode(data["data"].get<std::string>());
 			result->LoadData(descr.Width, descr.Height, descr.FormatHint, type, rawData.data());
 		}
 		catch (std::runtime_error()) {
@@ -80,7 +109,11 @@ Texture2D::Texture2D(const Texture2DDescription& description) :
 {
 	_SetTextureParams();
 	if (!description.Filename.empty()) {
-		_LoadDataFromFile();
+		if (description.LoadAsync) {
+			_LoadDataFromFileAsync();
+		} else {
+			_LoadDataFromFile();
+		}
 	}
 }
 
@@ -118,7 +151,8 @@ void Texture2D::SetAnisoLevel(float value) {
 		_description.MaxAnisotropic = glm::clamp(value, 1.0f, ITexture::GetLimits().MAX_ANISOTROPY);
 		glTextureParameterf(_rendererId, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
 
-		if (_description.GenerateMipMaps) {
+		// Compressed textures come with their mips, and can't have them generated by the GPU
+		if (_description.GenerateMipMaps && !IsCompressedFormat(_description.Format)) {
 			glGenerateTextureMipmap(_rendererId);
 		}
 	}
@@ -150,53 +184,112 @@ void Texture2D::_LoadDataFromFile() {
 	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
-		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
+		if (_description.UseCompression) {
+			CompressedImage image;
+			CompressedTextureCache::LoadOrConvert({ _description.Filename }, CompressedTextureCache::GetCachePath(_description.Filename), GetTexelComponentCount(_description.FormatHint), _description.GenerateMipMaps, image);
+			_UploadCompressed(image, false);
+		} else {
+			ImageData image = TextureLoader::DecodeImage(_description.Filename, GetTexelComponentCount(_description.FormatHint));
+			_UploadImage(image, false);
 		}
+	}
+	
+	SetDebugName(_description.Filename);
+}
 
-		// We should estimate a good format for our data
+void Texture2D::_LoadDataFromFileAsync() {
+	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+	// The decode step runs on another thread, so it may only use copies of what it needs
+	std::string filename = _description.Filename;
+	int targetChannels = GetTexelComponentCount(_description.FormatHint);
+
+	if (_description.UseCompression) {
+		// Converting is expensive, which makes it a great fit for the worker threads
+		std::shared_ptr<CompressedImage> compressed = std::make_shared<CompressedImage>();
+		bool generateMips = _description.GenerateMipMaps;
+		TextureLoader::Enqueue(this,
+			[compressed, filename, targetChannels, generateMips]() {
+				CompressedTextureCache::LoadOrConvert({ filename }, CompressedTextureCache::GetCachePath(filename), targetChannels, generateMips, *compressed);
+			},
+			[this, compressed]() { return _UploadCompressed(*compressed, true); }
+		);
+	} else {
+		std::shared_ptr<ImageData> image = std::make_shared<ImageData>();
+		TextureLoader::Enqueue(this, 
+			[image, filename, targetChannels]() { *image = TextureLoader::DecodeImage(filename, targetChannels); },
+			[this, image]() { return _UploadImage(*image, true); }
+		);
+	}
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+	SetDebugName(_description.Filename);
+}
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+bool Texture2D::_UploadImage(const ImageData& image, bool useUnpackBuffer) {
+	if (!image.IsValid()) {
+		return false;
+	}
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(image.Channels);
+	PixelFormat    image_format = GetPixelFormatForChannels(image.Channels);
 
-		// Allocates our memory
-		_SetTextureParams();
+	// This is one of those poorly documented things in OpenGL
+	if ((image.Channels * image.Width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+	}
 
-		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Width = image.Width;
+	_description.Height = image.Height;
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+	// Allocates our memory
+	_SetTextureParams();
+
+	// Upload data to our texture, when streaming from a buffer the data pointer is an offset into the buffer
+	if (useUnpackBuffer) {
+		uint32_t buffer = TextureLoader::BeginUnpack(image.Pixels.get(), image.GetSizeInBytes());
+		LoadData(image.Width, image.Height, image_format, PixelType::UByte, nullptr);
+		TextureLoader::EndUnpack(buffer);
+	} else {
+		LoadData(image.Width, image.Height, image_format, PixelType::UByte, image.Pixels.get());
 	}
-	
-	SetDebugName(_description.Filename);
+
+	return true;
+}
+
+bool Texture2D::_UploadCompressed(const CompressedImage& image, bool useUnpackBuffer) {
+	if (!image.IsValid() || image.NumFaces != 1) {
+		return false;
+	}
+
+	// Update our description to match what we loaded, the pixel type is cleared since
+	// compressed data can't be read back as regular pixels
+	_description.Format = image.Format;
+	_description.Width = image.Width;
+	_description.Height = image.Height;
+	_pixelType = PixelType::Unknown;
+
+	// Allocates our memory, the cache matches the number of levels we'll allocate here
+	_SetTextureParams();
+
+	// When streaming from a buffer, the data pointers become offsets into the buffer
+	uint32_t buffer = useUnpackBuffer ? TextureLoader::BeginUnpack(image.Data.data(), image.Data.size()) : 0;
+	const uint8_t* base = useUnpackBuffer ? nullptr : image.Data.data();
+
+	for (uint32_t level = 0; level < image.NumLevels; level++) {
+		const CompressedImage::Level& info = image.GetLevel(0, level);
+		glCompressedTextureSubImage2D(_rendererId, level, 0, 0, info.Width, info.Height, *image.Format, (GLsizei)info.Size, base + info.Offset);
+	}
+
+	if (useUnpackBuffer) {
+		TextureLoader::EndUnpack(buffer);
+	}
+
+	return true;
 }
 
 void Texture2D::_SetTextureParams() {
@@ -220,6 +313,7 @@ void Texture2D::_SetTextureParams() {
 			int layers = _description.GenerateMipMaps ? CalcRequiredMipLevels(_description.Width, _description.Height) : 1;
 			// Allocates the memory for our texture
 			glTextureStorage2D(_rendererId, layers, (GLenum)_description.Format, _description.Width, _description.Height);
+			_SetMemoryUsage(_description.Format, layers, _description.Width, _description.Height);
 
 			glTextureParameteri(_rendererId, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
 			glTextureParameteri(_rendererId, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
@@ -228,6 +322,7 @@ void Texture2D::_SetTextureParams() {
 		// Texture is multisampled, we need to allocate memory differently
 		else {
 			glTextureStorage2DMultisample(_rendererId, _description.MultisampleCount, *_description.Format, _description.Width, _description.Height, true);
+			_SetMemoryUsage(_description.Format, 1, _description.Width, _description.Height, 1, 1, _description.MultisampleCount);
 		}
 
 		glTextureParameteri(_rendererId, GL_TEXTURE_WRAP_S, (GLenum)_description.HorizontalWrap);
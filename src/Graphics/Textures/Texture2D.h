@@ -1,5 +1,7 @@
 #pragma once
 #include "ITexture.h"
+#include "TextureLoader.h"
+#include "CompressedTextureCache.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -60,6 +62,19 @@ struct Texture2DDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// True if the file should be decoded on a worker thread and uploaded in the background,
+	/// the texture will bind a placeholder until it is resident. Note that the size and format
+	/// of the texture will not be known until the load completes
+	/// </summary>
+	bool           LoadAsync;
+
+	/// <summary>
+	/// True if the file should be converted to a block compressed format with precomputed mip maps,
+	/// the result is cached next to the source file so later loads can skip decoding entirely
+	/// </summary>
+	bool           UseCompression;
+
 	Texture2DDescription() :
 		Width(0), Height(0),
 		Format(InternalFormat::Unknown),
@@ -71,7 +86,9 @@ struct Texture2DDescription {
 		GenerateMipMaps(true),
 		MultisampleCount(1),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		LoadAsync(false),
+		UseCompression(false)
 	{ }
 };
 
@@ -154,6 +171,25 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
+	/// Queues this texture to be loaded from the file specified in the description
+	/// by the TextureLoader
+	/// </summary>
+	void _LoadDataFromFileAsync();
+	/// <summary>
+	/// Allocates memory for a decoded image and uploads it's pixels, updating the description to match
+	/// </summary>
+	/// <param name="image">The image to upload</param>
+	/// <param name="useUnpackBuffer">True to stream the pixels through a pixel unpack buffer</param>
+	/// <returns>True if the image was valid and has been uploaded</returns>
+	bool _UploadImage(const ImageData& image, bool useUnpackBuffer);
+	/// <summary>
+	/// Allocates memory for a block compressed image and uploads all of it's mip levels
+	/// </summary>
+	/// <param name="image">The image to upload, must have a single face</param>
+	/// <param name="useUnpackBuffer">True to stream the blocks through a pixel unpack buffer</param>
+	/// <returns>True if the image was valid and has been uploaded</returns>
+	bool _UploadCompressed(const CompressedImage& image, bool useUnpackBuffer);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
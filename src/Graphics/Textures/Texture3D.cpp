@@ -1,12 +1,22 @@
 #include "Texture3D.h"
 #include "Utils/Base64.h"
+#include "Utils/ResourceManager/BlobStorage.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/FileHelpers.h"
 #include <Logging.h>
-#include <stb_image.h>
+#include <GLM/gtc/packing.hpp>
+#include "Graphics/Textures/TextureLoader.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <charconv>
+#include <cstring>
+
+// The extension used for binary LUT caches
+const std::string lutCacheExtension = ".blut";
+// The size of the 3D LUT that 1D LUTs get baked into
+const uint32_t lutBakedSize1D = 33;
 
 inline int CalcRequiredMipLevels(int width, int height, int depth) {
 	return (1 + floor(log2(std::max(width, std::max(height, depth)))));
@@ -53,11 +63,16 @@ void Texture3D::LoadData(uint32_t width, uint32_t height, uint32_t depth, PixelF
 
 	// Align the data store to the size of a single component to ensure we don't get weirdness with images that aren't RGBA
 	// See https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glPixelStore.xhtml
+	// Note that this is the unpack alignment, LUTs are often an odd size (ex: 33) so their rows are not 4 byte aligned
+	// The alignment is global state, so we put it back once we're done so other uploads aren't affected
 	int componentSize = (GLint)GetTexelComponentSize(type);
-	glPixelStorei(GL_PACK_ALIGNMENT, componentSize);
+	GLint prevAlignment = 4;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &prevAlignment);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, componentSize);
 
 	// Upload our data to our image
 	glTextureSubImage3D(_rendererId, 0, offsetX, offsetY, offsetZ, width, height, depth, (GLenum)format, (GLenum)type, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, prevAlignment);
 
 	// If requested, generate mip-maps for our texture
 	if (_description.GenerateMipMaps) {
@@ -84,14 +99,16 @@ nlohmann::json Texture3D::ToJson() const
 		result["size_y"] = _description.Height;
 		result["size_z"] = _description.Depth;
 
+		result["internal_format"] = ~_description.Format;
 		result["format"] = ~_description.FormatHint;
 		result["pixel_type"] = ~_pixelType;
 
 		if ((_description.Width * _description.Height * _description.Depth) > 0 && _description.FormatHint != PixelFormat::Unknown) {
 			size_t dataSize = GetTexelSize(_description.FormatHint, _pixelType) * _description.Width * _description.Height * _description.Depth;
-			uint8_t* dataStore = new uint8_t[dataSize];
-			glGetTextureImage(_rendererId, 0, *_description.Format, *_pixelType, dataSize, dataStore);
-			result["data"] = Base64::Encode(dataStore, dataSize);
+			std::vector<uint8_t> dataStore(dataSize);
+			glGetTextureImage(_rendererId, 0, *_description.FormatHint, *_pixelType, (GLsizei)dataSize, dataStore.data());
+			// Pixel data goes into a binary sidecar file, rather than bloating the manifest
+			result["blob"] = BlobStorage::Write(GetGUID(), dataStore.data(), dataSize);
 		}
 	}
 	return result;
@@ -114,14 +131,34 @@ Texture3D::Sptr Texture3D::FromJson(const nlohmann::json& data)
 	description.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	description.GenerateMipMaps = JsonGet(data, "generate_mipmaps", false);
 	description.FormatHint = JsonParseEnum(PixelFormat, data, "format", PixelFormat::Unknown);
+	description.Format = JsonParseEnum(InternalFormat, data, "internal_format", InternalFormat::Unknown);
+	// Older manifests didn't save the internal format, so we guess it from the layout of the saved pixels
+	if (description.Format == InternalFormat::Unknown && description.Filename.empty() && description.FormatHint != PixelFormat::Unknown) {
+		description.Format = GetInternalFormatForChannels8(GetTexelComponentCount(description.FormatHint));
+	}
+	description.LoadAsync = JsonGet(data, "load_async", true);
 
 	Texture3D::Sptr result = std::make_shared<Texture3D>(description);
 
 	// If we embedded data into the JSON, load it now
-	if (description.Filename.empty() && data.contains("data") && data["data"].is_string()) {
+	if (description.Filename.empty() && data.contains("blob") && BlobStorage::IsReference(data["blob"])) {
+		PixelType type = JsonParseEnum(PixelType, data, "pixel_type", PixelType::Unknown);
+		BlobStorage::Blob blob = BlobStorage::Read(data["blob"]);
+		if (blob.IsValid() && blob.Size >= GetTexelSize(description.FormatHint, type) * description.Width * description.Height * description.Depth) {
+			result->LoadData(description.Width, description.Height, description.Depth, description.FormatHint, type, (void*)blob.Data);
+			// Make sure the texture actually kept what we saved, a bad format will silently drop the upload
+			if (!result->_VerifyLevelData(description.FormatHint, type, blob.Data, blob.Size)) {
+				LOG_WARN("Texture does not match it's saved blob after loading, it's internal format may not fit the saved pixels");
+			}
+		} else {
+			LOG_WARN("JSON blob had data, but failed to load to texture");
+		}
+	}
+	// Older manifests stored the data as Base64 in the JSON itself
+	else if (description.Filename.empty() && data.contains("data") && data["data"].is_string()) {
 		PixelType type = JsonParseEnum(PixelType, data, "pixel_type", PixelType::Unknown);
 		try {
-			std::string rawData = Base64::Decode(data['data'].get<std::string>());
+			std::string rawData = Base64::Decode(data["data"].get<std::string>());
 			result->LoadData(description.Width, description.Height, description.Depth, description.FormatHint, type, rawData.data());
 		}
 		catch (std::runtime_error()) {
@@ -142,128 +179,350 @@ void Texture3D::_LoadDataFromFile()
 		StringTools::ToLower(extension);
 
 		if (extension.compare(".cube") == 0) {
-			_LoadCubeFile();
+			if (_description.LoadAsync) {
+				_LoadCubeFileAsync();
+			} else {
+				_LoadCubeFile();
+			}
 		}
 	}
 }
 
 void Texture3D::_LoadCubeFile()
 {
-	std::ifstream inFile(_description.Filename);
+	LutData lut;
+	if (_LoadLut(_description.Filename, lut)) {
+		_UploadLut(lut, false);
+	}
+}
+
+void Texture3D::_LoadCubeFileAsync()
+{
+	// The load step runs on another thread, so it may only use copies of what it needs
+	std::shared_ptr<LutData> lut = std::make_shared<LutData>();
+	std::string filename = _description.Filename;
+
+	TextureLoader::Enqueue(this,
+		[lut, filename]() { _LoadLut(filename, *lut); },
+		[this, lut]() { return _UploadLut(*lut, true); }
+	);
+}
 
-	if (!inFile.is_open()) {
-		LOG_WARN("Failed to open file .cube file: {}", _description.Filename);
-		return;
+bool Texture3D::_LoadLut(const std::string& filename, LutData& result)
+{
+	// Use the binary cache if it's still up to date
+	std::string cachePath = std::filesystem::path(filename).replace_extension(lutCacheExtension).string();
+	if (FileHelpers::IsNewerThan(cachePath, { filename }) && _LoadLutCache(cachePath, result)) {
+		return true;
 	}
 
-	glm::u8vec3* textureData = nullptr;
-	uint32_t lutSize{ 0 };
-	uint32_t ix{ 0 };
-	glm::vec3 rgb { 0, 0, 0 };
+	if (!_ParseCubeFile(filename, result)) {
+		return false;
+	}
 
-	std::string line;
-	// Iterate as long as we have lines from the file
-	while (std::getline(inFile, line)) {
+	// We still have a perfectly good LUT if the cache can't be written
+	if (!_SaveLutCache(cachePath, result)) {
+		LOG_WARN("Failed to write LUT cache \"{}\"", cachePath);
+	}
+	return true;
+}
 
-		// Trim whitespace from start and end of the line
-		StringTools::Trim(line);
+/// <summary>
+/// Skips spaces and tabs, stopping at the end of the line
+/// </summary>
+inline const char* SkipSpaces(const char* seek, const char* end) {
+	while (seek < end && (*seek == ' ' || *seek == '\t')) {
+		seek++;
+	}
+	return seek;
+}
 
-		// Skip empty lines
-		if (line.empty()) {
-			continue;
-		}
+/// <summary>
+/// Parses a float from the text, skipping leading whitespace. Clears success if no number could be read
+/// </summary>
+inline const char* ParseFloat(const char* seek, const char* end, float& result, bool& success) {
+	seek = SkipSpaces(seek, end);
+	// from_chars does not accept a leading +
+	if (seek < end && *seek == '+') {
+		seek++;
+	}
+	std::from_chars_result parse = std::from_chars(seek, end, result);
+	success = success && parse.ec == std::errc();
+	return parse.ptr;
+}
 
-		// Skip comments
-		else if (line[0] == '#') {
-			continue;
-		}
+/// <summary>
+/// Returns true if the line starts with the given keyword, followed by whitespace or the end of the line
+/// </summary>
+inline bool MatchKeyword(const char* seek, const char* end, const char* keyword, size_t length) {
+	return (size_t)(end - seek) >= length && memcmp(seek, keyword, length) == 0 &&
+		((size_t)(end - seek) == length || seek[length] == ' ' || seek[length] == '\t');
+}
 
-		// Handle sizing the LUT
-		else if (line.find("LUT_3D_SIZE") != std::string::npos) {
+bool Texture3D::_ParseCubeFile(const std::string& filename, LutData& result)
+{
+	MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
+	if (file == nullptr) {
+		LOG_WARN("Failed to open file .cube file: {}", filename);
+		return false;
+	}
 
-			// Skip over the LUT_3D_SIZE text and read in the value
-			std::stringstream lReader(line.substr(12));
-			lReader >> lutSize;
+	const char* seek = reinterpret_cast<const char*>(file->GetData());
+	const char* end  = seek + file->GetSize();
+
+	// The raw table from the file, 3 floats per entry with red changing fastest
+	std::vector<float> table;
+	uint32_t  tableSize = 0;
+	bool      is3D = true;
+	size_t    ix = 0;
+	glm::vec3 domainMin = glm::vec3(0.0f);
+	glm::vec3 domainMax = glm::vec3(1.0f);
+	std::string title;
+
+	// Single pass over the file, only looking at each character once
+	while (seek < end) {
+		// Find the extents of the line, ignoring any indentation
+		const char* lineEnd = static_cast<const char*>(memchr(seek, '\n', end - seek));
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		const char* next = lineEnd < end ? lineEnd + 1 : end;
+		const char* lineStop = lineEnd;
+		if (lineStop > seek && lineStop[-1] == '\r') {
+			lineStop--;
+		}
+		seek = SkipSpaces(seek, lineStop);
 
-			// Update the description's size
-			_description.Width = _description.Height = _description.Depth = lutSize;
+		// Skip empty lines and comments
+		if (seek == lineStop || *seek == '#') {
+			seek = next;
+			continue;
+		}
 
-			// If the size we read is non-zero, allocate our data!
-			if (lutSize > 0) {
-				// If we had data already, delete it
-				if (textureData != nullptr) {
-					delete[] textureData;
-				} 
+		// Data lines are by far the most common, so we check for them first
+		char first = *seek;
+		if ((first >= '0' && first <= '9') || first == '-' || first == '+' || first == '.') {
+			if (table.empty()) {
+				LOG_WARN("LUT \"{}\" has data before it's size, ignoring", filename);
+				return false;
+			}
+			// Make sure we don't cause a write access violation
+			if (ix >= table.size()) {
+				LOG_WARN("LUT \"{}\" has more entries than it's size, ignoring the extras", filename);
+				break;
+			}
 
-				// Allocate data to store texels in
-				textureData = new glm::u8vec3[(size_t)lutSize * lutSize * lutSize];
-				ix = 0;
+			bool success = true;
+			const char* cursor = ParseFloat(seek, lineStop, table[ix + 0], success);
+			cursor = ParseFloat(cursor, lineStop, table[ix + 1], success);
+			ParseFloat(cursor, lineStop, table[ix + 2], success);
+			if (!success) {
+				LOG_WARN("Malformed entry in LUT \"{}\": {}", filename, std::string(seek, lineStop));
+				return false;
 			}
+			ix += 3;
 		}
+		else if (MatchKeyword(seek, lineStop, "LUT_3D_SIZE", 11) || MatchKeyword(seek, lineStop, "LUT_1D_SIZE", 11)) {
+			is3D = seek[4] == '3';
+			const char* value = SkipSpaces(seek + 11, lineStop);
+			std::from_chars(value, lineStop, tableSize);
+			if (tableSize < 2) {
+				LOG_WARN("LUT \"{}\" has an invalid size", filename);
+				return false;
+			}
 
+			size_t numEntries = is3D ? (size_t)tableSize * tableSize * tableSize : tableSize;
+			table.assign(numEntries * 3, 0.0f);
+			ix = 0;
+		}
+		else if (MatchKeyword(seek, lineStop, "DOMAIN_MIN", 10) || MatchKeyword(seek, lineStop, "DOMAIN_MAX", 10)) {
+			glm::vec3& target = seek[8] == 'I' ? domainMin : domainMax;
+			bool success = true;
+			const char* cursor = ParseFloat(seek + 10, lineStop, target.x, success);
+			cursor = ParseFloat(cursor, lineStop, target.y, success);
+			ParseFloat(cursor, lineStop, target.z, success);
+			if (!success) {
+				LOG_WARN("Malformed domain in LUT \"{}\"", filename);
+			}
+		}
+		// Some tools (ex: Resolve) write the domain as a single range for all channels
+		else if (MatchKeyword(seek, lineStop, "LUT_3D_INPUT_RANGE", 18) || MatchKeyword(seek, lineStop, "LUT_1D_INPUT_RANGE", 18)) {
+			bool success = true;
+			const char* cursor = ParseFloat(seek + 18, lineStop, domainMin.x, success);
+			ParseFloat(cursor, lineStop, domainMax.x, success);
+			domainMin = glm::vec3(domainMin.x);
+			domainMax = glm::vec3(domainMax.x);
+		}
 		// We'll grab the title for our debug name, nice lil use of it
-		else if (line.find("TITLE") != std::string::npos) {
-
-			// Skip over the TITLE token and the space after it
-			std::string name = line.substr(6);
-
-			// Trim any excess whitespace
-			StringTools::Trim(name);
-
-			// We'll store this in the debug name
-			SetDebugName(name);
+		else if (MatchKeyword(seek, lineStop, "TITLE", 5)) {
+			title = std::string(seek + 5, lineStop);
+			StringTools::Trim(title);
+			StringTools::Trim(title, '"');
 		}
+		// Anything else is a keyword we don't support, which the spec says we can skip
+
+		seek = next;
+	}
 
-		else if (line.find("DOMAIN_MIN") != std::string::npos)
-		{ /* ignore for now */ }
+	if (table.empty()) {
+		LOG_WARN("Failed to load cube file: \"{}\"", filename);
+		return false;
+	}
+	if (ix != table.size()) {
+		LOG_WARN("LUT \"{}\" is missing entries, expected {} but found {}", filename, table.size() / 3, ix / 3);
+	}
 
-		else if (line.find("DOMAIN_MAX") != std::string::npos)
-		{ /* ignore for now */ }
+	// A zero sized domain would divide by zero when we resample
+	glm::vec3 domainSize = domainMax - domainMin;
+	if (domainSize.x <= 0.0f || domainSize.y <= 0.0f || domainSize.z <= 0.0f) {
+		LOG_WARN("LUT \"{}\" has an invalid domain, using 0-1", filename);
+		domainMin = glm::vec3(0.0f);
+		domainMax = glm::vec3(1.0f);
+		domainSize = glm::vec3(1.0f);
+	}
+	bool isDefaultDomain = domainMin == glm::vec3(0.0f) && domainMax == glm::vec3(1.0f);
 
-		else if (line.find("LUT_1D_SIZE") != std::string::npos)
-		{ /* ignore for now */ }
+	// 1D LUTs get baked into a 3D LUT, which is all the shader knows how to sample
+	result.Size = is3D ? tableSize : std::min(tableSize, lutBakedSize1D);
+	result.Title = title;
+	result.Mapping = nullptr;
 
-		// Reading data lines
-		else if (!line.empty() && textureData != nullptr) {
+	const uint32_t size = result.Size;
+	result.Texels.resize((size_t)size * size * size * 3);
 
-			// Make sure we don't case a write access violation
-			if (ix >= (lutSize * lutSize * lutSize) && lutSize > 0) {
-				LOG_ASSERT(false, "Attempting to write outside the bounds of the LUT");
+	if (is3D && isDefaultDomain) {
+		// The common case, we can just convert the table directly
+		for (size_t texel = 0; texel < result.Texels.size(); texel++) {
+			result.Texels[texel] = glm::packHalf1x16(table[texel]);
+		}
+	}
+	else {
+		// Converts a coordinate in the 0-1 range into a continuous index into the source table
+		auto toIndex = [&](float coord, int axis) {
+			float index = (coord - domainMin[axis]) / domainSize[axis] * (tableSize - 1);
+			return glm::clamp(index, 0.0f, static_cast<float>(tableSize - 1));
+		};
+		auto fetch = [&](uint32_t r, uint32_t g, uint32_t b) {
+			size_t entry = ((size_t)b * tableSize + g) * tableSize + r;
+			return glm::vec3(table[entry * 3], table[entry * 3 + 1], table[entry * 3 + 2]);
+		};
+
+		for (uint32_t b = 0; b < size; b++) {
+			for (uint32_t g = 0; g < size; g++) {
+				for (uint32_t r = 0; r < size; r++) {
+					glm::vec3 coord = glm::vec3(r, g, b) / static_cast<float>(size - 1);
+					glm::vec3 index = glm::vec3(toIndex(coord.x, 0), toIndex(coord.y, 1), toIndex(coord.z, 2));
+					glm::uvec3 low  = glm::uvec3(glm::floor(index));
+					glm::uvec3 high = glm::min(low + 1u, glm::uvec3(tableSize - 1));
+					glm::vec3  t    = index - glm::vec3(low);
+
+					glm::vec3 color;
+					if (is3D) {
+						// Trilinear sample of the source table
+						glm::vec3 c00 = glm::mix(fetch(low.x, low.y,  low.z),  fetch(high.x, low.y,  low.z),  t.x);
+						glm::vec3 c10 = glm::mix(fetch(low.x, high.y, low.z),  fetch(high.x, high.y, low.z),  t.x);
+						glm::vec3 c01 = glm::mix(fetch(low.x, low.y,  high.z), fetch(high.x, low.y,  high.z), t.x);
+						glm::vec3 c11 = glm::mix(fetch(low.x, high.y, high.z), fetch(high.x, high.y, high.z), t.x);
+						color = glm::mix(glm::mix(c00, c10, t.y), glm::mix(c01, c11, t.y), t.z);
+					}
+					else {
+						// Each channel is looked up independently in a 1D LUT
+						for (int c = 0; c < 3; c++) {
+							color[c] = glm::mix(table[low[c] * 3 + c], table[high[c] * 3 + c], t[c]);
+						}
+					}
+
+					size_t target = (((size_t)b * size + g) * size + r) * 3;
+					result.Texels[target + 0] = glm::packHalf1x16(color.r);
+					result.Texels[target + 1] = glm::packHalf1x16(color.g);
+					result.Texels[target + 2] = glm::packHalf1x16(color.b);
+				}
 			}
+		}
+	}
 
-			// Read RGB from the line
-			std::stringstream lReader(line);
-			lReader >> rgb.r >> rgb.g >> rgb.b;
+	return true;
+}
 
-			rgb = glm::clamp(rgb, glm::vec3(0), glm::vec3(1));
+bool Texture3D::_LoadLutCache(const std::string& filename, LutData& result)
+{
+	MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
+	if (file == nullptr || file->GetSize() < sizeof(LutHeader)) {
+		return false;
+	}
 
-			// Store in the array, converting to the correct scale for bytes
-			textureData[ix].r = static_cast<uint8_t>(rgb.r * 255);
-			textureData[ix].g = static_cast<uint8_t>(rgb.g * 255);
-			textureData[ix].b = static_cast<uint8_t>(rgb.b * 255);
+	// Make sure this is actually one of our files, and a version we can read
+	const LutHeader* header = reinterpret_cast<const LutHeader*>(file->GetData());
+	if (memcmp(header->HeaderBytes, LutHeader().HeaderBytes, 4) != 0 || header->Version != 0x01) {
+		return false;
+	}
 
-			// Move to the next texel
-			ix++;
-		}
-	} 
+	size_t texelOffset = sizeof(LutHeader) + header->TitleLength;
+	size_t texelSize = (size_t)header->Size * header->Size * header->Size * 3 * sizeof(uint16_t);
+	if (file->GetSize() < texelOffset + texelSize) {
+		LOG_WARN("LUT cache \"{}\" is truncated", filename);
+		return false;
+	}
 
-	if (textureData != nullptr) {
-		// Set the pixel format
-		_description.Format = InternalFormat::RGB8;
-		// We need to clamp to edge for LUTS
-		_description.WrapS = _description.WrapT = _description.WrapR = WrapMode::ClampToEdge;
+	// The title is padded with nulls, so we construct from the C string
+	result.Title   = std::string(reinterpret_cast<const char*>(file->GetData() + sizeof(LutHeader)), header->TitleLength).c_str();
+	result.Size    = header->Size;
+	result.Texels.clear();
+	result.Mapping       = file;
+	result.MappingOffset = texelOffset;
+	return true;
+}
 
-		// Allocate data and configure params
-		_SetTextureParams();
-		// Load data
-		LoadData(lutSize, lutSize, lutSize, PixelFormat::RGB, PixelType::UByte, textureData);
+bool Texture3D::_SaveLutCache(const std::string& filename, const LutData& lut)
+{
+	return FileHelpers::WriteFileAtomic(filename, [&](std::ostream& file) {
+		// Pad the title so that the texels are aligned
+		std::string title = lut.Title;
+		title.resize((title.size() + 3) & ~(size_t)3, '\0');
+
+		LutHeader header = LutHeader();
+		header.Version     = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
+		header.TitleLength = static_cast<uint16_t>(title.size());
+		header.Size        = lut.Size;
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(LutHeader));
+		file.write(title.data(), title.size());
+		file.write(reinterpret_cast<const char*>(lut.GetData()), lut.GetSizeInBytes());
+		return true;
+	});
+}
 
-		// Clean up after ourselves
-		delete[] textureData;
+bool Texture3D::_UploadLut(const LutData& lut, bool useUnpackBuffer)
+{
+	if (lut.GetData() == nullptr || lut.Size == 0) {
+		return false;
 	}
-	else {
-		LOG_WARN("Failed to load cube file: \"{}\"", _description.Filename);
+
+	// We'll store the title in the debug name
+	if (!lut.Title.empty()) {
+		SetDebugName(lut.Title);
+	}
+
+	// Update the description's size
+	_description.Width = _description.Height = _description.Depth = lut.Size;
+	// LUTs keep half float precision, unless 8 bit storage was explicitly requested
+	_description.Format = _description.Format == InternalFormat::RGB8 ? InternalFormat::RGB8 : InternalFormat::RGB16F;
+	// We need to clamp to edge for LUTS
+	_description.WrapS = _description.WrapT = _description.WrapR = WrapMode::ClampToEdge;
+
+	// Allocate data and configure params
+	_SetTextureParams();
+
+	// Load data, when streaming from a buffer the data pointer is an offset into the buffer
+	if (useUnpackBuffer) {
+		uint32_t buffer = TextureLoader::BeginUnpack(lut.GetData(), lut.GetSizeInBytes());
+		LoadData(lut.Size, lut.Size, lut.Size, PixelFormat::RGB, PixelType::Half, nullptr);
+		TextureLoader::EndUnpack(buffer);
+	} else {
+		LoadData(lut.Size, lut.Size, lut.Size, PixelFormat::RGB, PixelType::Half, (void*)lut.GetData());
 	}
+
+	return true;
 }
 
 void Texture3D::_SetTextureParams()
@@ -272,6 +531,7 @@ void Texture3D::_SetTextureParams()
 	int layers = _description.GenerateMipMaps ? CalcRequiredMipLevels(_description.Width, _description.Height, _description.Depth) : 1;
 	// Allocates the memory for our texture
 	glTextureStorage3D(_rendererId, layers, (GLenum)_description.Format, _description.Width, _description.Height, _description.Depth);
+	_SetMemoryUsage(_description.Format, layers, _description.Width, _description.Height, _description.Depth);
 
 	glTextureParameteri(_rendererId, GL_TEXTURE_MIN_FILTER, (GLenum)_description.MinificationFilter);
 	glTextureParameteri(_rendererId, GL_TEXTURE_MAG_FILTER, (GLenum)_description.MagnificationFilter);
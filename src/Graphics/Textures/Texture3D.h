@@ -1,5 +1,7 @@
 #pragma once
 #include "ITexture.h"
+#include <vector>
+#include "Utils/MemoryMappedFile.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -59,6 +61,12 @@ struct Texture3DDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// True if the file should be parsed on a worker thread and uploaded in the background,
+	/// the texture will bind a placeholder (an identity LUT) until it is resident
+	/// </summary>
+	bool           LoadAsync;
+
 	Texture3DDescription() :
 		Width(0), Height(0), Depth(0),
 		Format(InternalFormat::Unknown),
@@ -69,7 +77,8 @@ struct Texture3DDescription {
 		MagnificationFilter(MagFilter::Linear),
 		GenerateMipMaps(true),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		LoadAsync(false)
 	{ }
 };
 
@@ -155,11 +164,85 @@ protected:
 	/// Will overwrite description size
 	/// </summary>
 	void _LoadDataFromFile();
+	/// <summary>
+	/// Stores a 3D LUT that has been loaded into memory, as half float RGB texels
+	/// </summary>
+	struct LutData {
+		uint32_t               Size;
+		std::string            Title;
+		// Texels that we parsed ourselves
+		std::vector<uint16_t>  Texels;
+		// If loaded from a binary cache, the mapped file that the texels are stored in
+		MemoryMappedFile::Sptr Mapping;
+		// The offset of the texels in Mapping. We store an offset rather than a pointer so that copies stay valid
+		size_t                 MappingOffset;
+
+		LutData() : Size(0), Title(""), Texels(), Mapping(nullptr), MappingOffset(0) {}
+
+		/// <summary>
+		/// Gets the Size^3 RGB texels, from either Texels or Mapping, or nullptr if there are none
+		/// </summary>
+		const uint16_t* GetData() const {
+			if (Mapping != nullptr) {
+				return reinterpret_cast<const uint16_t*>(Mapping->GetData() + MappingOffset);
+			}
+			return Texels.empty() ? nullptr : Texels.data();
+		}
+		size_t GetSizeInBytes() const { return (size_t)Size * Size * Size * 3 * sizeof(uint16_t); }
+	};
+
+	// Will be put at the start of the binary LUT cache, contains info about the contents of the file
+	struct LutHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'B', 'L', 'U', 'T' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint16_t Version = 0;
+		// The length of the title that follows the header, padded to keep the texels aligned
+		uint16_t TitleLength = 0;
+		// The number of texels along each axis
+		uint32_t Size = 0;
+	};
+
 	/// <summary>
 	/// Loads a 3D LUT from a .cube file
 	/// </summary>
 	void _LoadCubeFile();
 	/// <summary>
+	/// Queues a 3D LUT to be loaded from a .cube file and uploaded by the TextureLoader
+	/// </summary>
+	void _LoadCubeFileAsync();
+	/// <summary>
+	/// Loads a LUT from it's binary cache if it is up to date, otherwise parses the .cube file
+	/// and writes a new cache. This is safe to call from any thread
+	/// </summary>
+	/// <param name="filename">The path of the .cube file to load</param>
+	/// <param name="result">The LUT data to fill in</param>
+	/// <returns>True if the LUT was loaded</returns>
+	static bool _LoadLut(const std::string& filename, LutData& result);
+	/// <summary>
+	/// Parses a .cube file in a single pass. 1D LUTs and LUTs with a custom DOMAIN_MIN/DOMAIN_MAX
+	/// are resampled into a 3D LUT over the 0-1 range, so that they can be sampled directly
+	/// </summary>
+	/// <param name="filename">The path of the file to parse</param>
+	/// <param name="result">The LUT data to fill in</param>
+	/// <returns>True if the file contained a LUT</returns>
+	static bool _ParseCubeFile(const std::string& filename, LutData& result);
+	/// <summary>
+	/// Maps a binary LUT cache into memory
+	/// </summary>
+	static bool _LoadLutCache(const std::string& filename, LutData& result);
+	/// <summary>
+	/// Writes a LUT to a binary cache file
+	/// </summary>
+	static bool _SaveLutCache(const std::string& filename, const LutData& lut);
+	/// <summary>
+	/// Allocates memory for a parsed LUT and uploads it's texels
+	/// </summary>
+	/// <param name="lut">The LUT to upload</param>
+	/// <param name="useUnpackBuffer">True to stream the texels through a pixel unpack buffer</param>
+	/// <returns>True if the LUT was valid and has been uploaded</returns>
+	bool _UploadLut(const LutData& lut, bool useUnpackBuffer);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
@@ -1,6 +1,6 @@
 #include "TextureCube.h"
 #include <filesystem>
-#include "stb_image.h"
+#include "Utils/ThreadPool.h"
 #include "Utils/JsonGlmHelpers.h"
 
 TextureCube::TextureCube(const std::string& baseFilename) :
@@ -31,6 +31,9 @@ nlohmann::json TextureCube::ToJson() const
 	nlohmann::json result;
 	result["filter_min"] = ~_description.MinificationFilter;
 	result["filter_mag"] = ~_description.MagnificationFilter;
+	if (_description.UseCompression) {
+		result["compress"] = true;
+	}
 	
 	if (!_description.FaceFileNames.empty()) {
 		result["face_filenames"] = nlohmann::json();
@@ -50,6 +53,8 @@ TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
 	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "filter_min", MinFilter::NearestMipNearest);
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.Filename       = JsonGet<std::string>(data, "base_filename", "");
+	descr.LoadAsync      = JsonGet(data, "load_async", true);
+	descr.UseCompression = JsonGet(data, "compress", false);
 	if (data.contains("face_filenames") && data["face_filenames"].is_object()) {
 		for (auto& [key, value] : data["face_filenames"].items()) {
 			CubeMapFace face = ParseCubeMapFace(key, CubeMapFace::Unknown);
@@ -95,75 +100,101 @@ void TextureCube::_LoadFromDescription()
 	}
 
 	// Load all the images into the texture
-	_LoadImages(_description.FaceFileNames);
+	if (_description.LoadAsync) {
+		_LoadImagesAsync(_description.FaceFileNames);
+	} else {
+		_LoadImages(_description.FaceFileNames);
+	}
 }
 
 void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
 {
-	// Will store all of our texture data, back to back in memory
-	uint8_t* datastore = nullptr;
-	// The size of a single face's texture, in bytes
-	size_t textureDataSize = 0;
+	if (_description.UseCompression) {
+		std::vector<std::string> sources;
+		std::string cachePath;
+		_GetCompressedSources(faceFilenames, sources, cachePath);
 
-	// The number of channels that we're expecting
-	int numChannels = 0;
+		CompressedImage image;
+		CompressedTextureCache::LoadOrConvert(sources, cachePath, 0, true, image);
+		_UploadCompressed(image, false);
+		return;
+	}
 
 	// Load all 6 faces
+	ImageData faces[6];
 	for (int ix = 0; ix < 6; ix++) {
-		CubeMapFace face = (CubeMapFace)ix;
-		
-		const std::string& filename = _description.FaceFileNames[face];
-		int fileWidth, fileHeight, fileNumChannels;
-
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 0);
-
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			if (data != nullptr) { delete[] datastore; }
-			LOG_ERROR("STBI Failed to load image from \"{}\"", filename);
-			return;
+		faces[ix] = TextureLoader::DecodeImage(faceFilenames.at((CubeMapFace)ix), 0);
+	}
+
+	_UploadFaces(faces, faceFilenames, false);
+}
+
+void TextureCube::_LoadImagesAsync(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
+{
+	if (_description.UseCompression) {
+		std::vector<std::string> sources;
+		std::string cachePath;
+		_GetCompressedSources(faceFilenames, sources, cachePath);
+
+		// Converting is expensive, which makes it a great fit for the worker threads
+		std::shared_ptr<CompressedImage> image = std::make_shared<CompressedImage>();
+		TextureLoader::Enqueue(this,
+			[image, sources, cachePath]() { CompressedTextureCache::LoadOrConvert(sources, cachePath, 0, true, *image); },
+			[this, image]() { return _UploadCompressed(*image, true); }
+		);
+		return;
+	}
+
+	// The decode step runs on another thread, so it may only use copies of what it needs
+	std::shared_ptr<ImageData[]> faces(new ImageData[6]);
+	std::unordered_map<CubeMapFace, std::string> filenames = faceFilenames;
+
+	TextureLoader::Enqueue(this,
+		[faces, filenames]() {
+			// Faces are independent, so we can decode them all at once
+			ThreadPool::Get().ParallelFor(6, 1, [&](size_t begin, size_t end) {
+				for (size_t ix = begin; ix < end; ix++) {
+					faces[ix] = TextureLoader::DecodeImage(filenames.at((CubeMapFace)ix), 0);
+				}
+			});
+		},
+		[this, faces, filenames]() { return _UploadFaces(faces.get(), filenames, true); }
+	);
+}
+
+bool TextureCube::_UploadFaces(const ImageData* faces, const std::unordered_map<CubeMapFace, std::string>& faceFilenames, bool useUnpackBuffer)
+{
+	// Make sure all the faces are usable before we allocate anything
+	for (int ix = 0; ix < 6; ix++) {
+		const std::string& filename = faceFilenames.at((CubeMapFace)ix);
+
+		// If we could not load any data, the decode will have already warned us
+		if (!faces[ix].IsValid()) {
+			LOG_ERROR("Failed to load cubemap face from \"{}\"", filename);
+			return false;
 		}
 		// If the texture is not square, warn and abort
-		if (fileWidth != fileHeight) {
-			if (data != nullptr) { delete[] datastore; }
+		if (faces[ix].Width != faces[ix].Height) {
 			LOG_ERROR("Image loaded from \"{}\" was not square", filename);
-			stbi_image_free(data);
-			return;
-		}
-		// If the dataStore is empty, this is the first texture we loaded
-		if (datastore == nullptr) {
-			// Store the size and number of channels
-			_description.Size = fileWidth;
-			numChannels = fileNumChannels;
-
-			// Get the format and pixel format for the number of channels
-			_description.Format = GetInternalFormatForChannels8(numChannels);
-			_description.FormatHint = GetPixelFormatForChannels(numChannels);
-
-			// Determine how many bytes we'll need to store a single face worth of data
-			textureDataSize = ((size_t)_description.Size * _description.Size * GetTexelSize(_description.FormatHint, PixelType::Byte));
-
-			// This is one of those poorly documented things in OpenGL
-			if ((GetTexelSize(_description.FormatHint, PixelType::Byte) * _description.Size) % 4 != 0) {
-				LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-			}
-
-			// Allocate the data store for our image data
-			datastore = new uint8_t[textureDataSize * 6];
+			return false;
 		}
-		// If this is NOT the first image, and it does not match previous images, abort
-		else if (fileWidth != _description.Size || fileNumChannels != numChannels) {
-			delete[] datastore;
+		// If it does not match the first face, abort
+		if (faces[ix].Width != faces[0].Width || faces[ix].Channels != faces[0].Channels) {
 			LOG_WARN("Image \"{}\" did not match size or format of texture cube", filename);
-			stbi_image_free(data);
-			return;
+			return false;
 		}
+	}
+
+	// Store the size and number of channels
+	_description.Size = faces[0].Width;
 
-		// Copy the data we loaded into the corresponding location in the data store
-		memcpy(datastore + textureDataSize * ix, data, textureDataSize);
-		stbi_image_free(data);
+	// Get the format and pixel format for the number of channels
+	_description.Format = GetInternalFormatForChannels8(faces[0].Channels);
+	_description.FormatHint = GetPixelFormatForChannels(faces[0].Channels);
+
+	// This is one of those poorly documented things in OpenGL
+	if ((GetTexelSize(_description.FormatHint, PixelType::Byte) * _description.Size) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
 	}
 
 	// Allocate memory and set up initial parameters
@@ -172,16 +203,68 @@ void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>
 	// Set our pixel alignment to a single byte so we don't get banding
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
 
-	// Upload our data to our image (note that the custom enum tools let us convert to base type [GLenum] with the * operator)
-	glTextureSubImage3D(_rendererId, 0, 0, 0, 0, _description.Size, _description.Size, 6, *_description.FormatHint, *PixelType::UByte, datastore);
-	delete[] datastore;
+	// Upload each face into it's layer of the cubemap (note that the custom enum tools let us convert to base type [GLenum] with the * operator)
+	for (int ix = 0; ix < 6; ix++) {
+		if (useUnpackBuffer) {
+			uint32_t buffer = TextureLoader::BeginUnpack(faces[ix].Pixels.get(), faces[ix].GetSizeInBytes());
+			glTextureSubImage3D(_rendererId, 0, 0, 0, ix, _description.Size, _description.Size, 1, *_description.FormatHint, *PixelType::UByte, nullptr);
+			TextureLoader::EndUnpack(buffer);
+		} else {
+			glTextureSubImage3D(_rendererId, 0, 0, 0, ix, _description.Size, _description.Size, 1, *_description.FormatHint, *PixelType::UByte, faces[ix].Pixels.get());
+		}
+	}
+
+	return true;
+}
+
+void TextureCube::_GetCompressedSources(const std::unordered_map<CubeMapFace, std::string>& faceFilenames, std::vector<std::string>& sources, std::string& cachePath) const
+{
+	sources.resize(6);
+	for (int ix = 0; ix < 6; ix++) {
+		sources[ix] = faceFilenames.at((CubeMapFace)ix);
+	}
+
+	// Cache next to the base file if we have one, otherwise next to the first face
+	cachePath = CompressedTextureCache::GetCachePath(_description.Filename.empty() ? sources[0] : _description.Filename);
+}
+
+bool TextureCube::_UploadCompressed(const CompressedImage& image, bool useUnpackBuffer)
+{
+	if (!image.IsValid() || image.NumFaces != 6 || image.Width != image.Height) {
+		return false;
+	}
+
+	_description.Size = image.Width;
+	_description.Format = image.Format;
+
+	// Allocate all the mip levels that came with the image
+	_SetTextureParams(image.NumLevels);
+
+	// When streaming from a buffer, the data pointers become offsets into the buffer
+	uint32_t buffer = useUnpackBuffer ? TextureLoader::BeginUnpack(image.Data.data(), image.Data.size()) : 0;
+	const uint8_t* base = useUnpackBuffer ? nullptr : image.Data.data();
+
+	// With DSA, cubemap faces are addressed as layers of a 3D image
+	for (uint32_t face = 0; face < 6; face++) {
+		for (uint32_t level = 0; level < image.NumLevels; level++) {
+			const CompressedImage::Level& info = image.GetLevel(face, level);
+			glCompressedTextureSubImage3D(_rendererId, level, 0, 0, face, info.Width, info.Height, 1, *image.Format, (GLsizei)info.Size, base + info.Offset);
+		}
+	}
+
+	if (useUnpackBuffer) {
+		TextureLoader::EndUnpack(buffer);
+	}
+
+	return true;
 }
 
-void TextureCube::_SetTextureParams(){
+void TextureCube::_SetTextureParams(int levels){
 	// Make sure the size is greater than zero and that we have a format specified before trying to set parameters
 	if (_description.Size > 0 && _description.Format != InternalFormat::Unknown) {
 		// Allocates the memory for our texture
-		glTextureStorage2D(_rendererId, 1, (GLenum)_description.Format, _description.Size, _description.Size);
+		glTextureStorage2D(_rendererId, levels, (GLenum)_description.Format, _description.Size, _description.Size);
+		_SetMemoryUsage(_description.Format, levels, _description.Size, _description.Size, 1, 6);
 
 		// Set up our texture parameters
 		glTextureParameteri(_rendererId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
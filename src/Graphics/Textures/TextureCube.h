@@ -1,6 +1,8 @@
 #pragma once
 #include <EnumToString.h>
 #include "ITexture.h"
+#include "TextureLoader.h"
+#include "CompressedTextureCache.h"
 
 /*
 0 	GL_TEXTURE_CUBE_MAP_POSITIVE_X
@@ -60,6 +62,18 @@ struct TextureCubeDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// True if the faces should be decoded on worker threads and uploaded in the background,
+	/// the texture will bind a placeholder until it is resident
+	/// </summary>
+	bool           LoadAsync;
+
+	/// <summary>
+	/// True if the faces should be converted to a block compressed format with precomputed mip maps,
+	/// the result is cached next to the source files so later loads can skip decoding entirely
+	/// </summary>
+	bool           UseCompression;
+
 	/// <summary>
 	/// Creates a default (empty) cubemap description
 	/// </summary>
@@ -69,7 +83,9 @@ struct TextureCubeDescription {
 		MinificationFilter(MinFilter::NearestMipLinear),
 		MagnificationFilter(MagFilter::Linear),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		LoadAsync(false),
+		UseCompression(false)
 	{ }
 };
 
@@ -116,9 +132,33 @@ protected:
 
 	virtual void _LoadFromDescription();
 	virtual void _LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
+	/// <summary>
+	/// Queues the faces to be decoded in parallel and uploaded by the TextureLoader
+	/// </summary>
+	virtual void _LoadImagesAsync(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
+	/// <summary>
+	/// Validates that all 6 decoded faces are square and match, then allocates memory and uploads them
+	/// </summary>
+	/// <param name="faces">The decoded faces, in CubeMapFace order</param>
+	/// <param name="faceFilenames">The files the faces were loaded from, for error reporting</param>
+	/// <param name="useUnpackBuffer">True to stream the pixels through pixel unpack buffers</param>
+	/// <returns>True if the faces were valid and have been uploaded</returns>
+	bool _UploadFaces(const ImageData* faces, const std::unordered_map<CubeMapFace, std::string>& faceFilenames, bool useUnpackBuffer);
+	/// <summary>
+	/// Gets the source files and cache path to use when loading a compressed cubemap
+	/// </summary>
+	void _GetCompressedSources(const std::unordered_map<CubeMapFace, std::string>& faceFilenames, std::vector<std::string>& sources, std::string& cachePath) const;
+	/// <summary>
+	/// Allocates memory for a block compressed cubemap and uploads all faces and mip levels
+	/// </summary>
+	/// <param name="image">The image to upload, must have 6 faces</param>
+	/// <param name="useUnpackBuffer">True to stream the blocks through a pixel unpack buffer</param>
+	/// <returns>True if the image was valid and has been uploaded</returns>
+	bool _UploadCompressed(const CompressedImage& image, bool useUnpackBuffer);
 
 	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
-	void _SetTextureParams();
+	/// <param name="levels">The number of mip levels to allocate</param>
+	void _SetTextureParams(int levels = 1);
 };
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "Graphics/Textures/TextureLoader.h"
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <Logging.h>
+
+#include "Graphics/Textures/ITexture.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/MemoryMappedFile.h"
+
+std::mutex TextureLoader::_mutex;
+std::condition_variable TextureLoader::_decodedSignal;
+std::deque<TextureLoader::Job::Sptr> TextureLoader::_decoded;
+std::vector<TextureLoader::Job::Sptr> TextureLoader::_pending;
+double TextureLoader::_frameBudget = 0.002;
+
+ImageData TextureLoader::DecodeImage(const std::string& filename, int desiredChannels, bool flipVertical) {
+	ImageData result;
+
+	// We decode from a mapping so that images in the asset package never touch the disk
+	MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
+	if (file == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\": could not open file", filename);
+		return ImageData();
+	}
+
+	// Note that we never touch stbi_set_flip_vertically_on_load, it's global state and
+	// would race with other decodes running on the pool, so we flip the rows ourselves
+	int numChannels = 0;
+	uint8_t* data = stbi_load_from_memory(file->GetData(), static_cast<int>(file->GetSize()), &result.Width, &result.Height, &numChannels, desiredChannels);
+	if (data == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\": {}", filename, stbi_failure_reason());
+		return ImageData();
+	}
+
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	result.Channels = desiredChannels != 0 ? desiredChannels : numChannels;
+	result.Pixels = std::shared_ptr<uint8_t>(data, [](uint8_t* ptr) { stbi_image_free(ptr); });
+
+	if (flipVertical) {
+		size_t stride = (size_t)result.Width * result.Channels;
+		std::vector<uint8_t> scratch(stride);
+		for (int top = 0, bottom = result.Height - 1; top < bottom; top++, bottom--) {
+			uint8_t* topRow    = data + stride * top;
+			uint8_t* bottomRow = data + stride * bottom;
+			memcpy(scratch.data(), topRow, stride);
+			memcpy(topRow, bottomRow, stride);
+			memcpy(bottomRow, scratch.data(), stride);
+		}
+	}
+
+	return result;
+}
+
+void TextureLoader::Enqueue(ITexture* owner, std::function<void()>&& decode, std::function<bool()>&& upload) {
+	LOG_ASSERT(owner != nullptr, "Texture loads must have an owner!");
+
+	Job::Sptr job = std::make_shared<Job>();
+	job->Owner       = owner;
+	job->Decode      = std::move(decode);
+	job->Upload      = std::move(upload);
+	job->IsCancelled = false;
+
+	owner->_isResident = false;
+	_pending.push_back(job);
+
+	ThreadPool::Get().Enqueue([job]() {
+		// Even if the decode blows up, we need to hand the job back or anyone waiting on it will hang
+		try {
+			job->Decode();
+		}
+		catch (const std::exception& e) {
+			LOG_ERROR("Failed to decode texture: {}", e.what());
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_decoded.push_back(job);
+		}
+		_decodedSignal.notify_all();
+	});
+}
+
+void TextureLoader::Update() {
+	typedef std::chrono::high_resolution_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	// Always upload at least one texture, otherwise a budget smaller than a single
+	// upload would stall loading forever
+	Job::Sptr job;
+	while ((job = _PopDecoded(false)) != nullptr) {
+		_Upload(job);
+
+		std::chrono::duration<double> elapsed = Clock::now() - start;
+		if (elapsed.count() >= _frameBudget) {
+			break;
+		}
+	}
+}
+
+void TextureLoader::Wait(const ITexture* owner) {
+	while (IsPending(owner)) {
+		_Upload(_PopDecoded(true));
+	}
+}
+
+void TextureLoader::WaitAll() {
+	while (!_pending.empty()) {
+		_Upload(_PopDecoded(true));
+	}
+}
+
+void TextureLoader::Cancel(const ITexture* owner) {
+	// The decoded queue may still hold these jobs, flagging them means they will
+	// be dropped when they get popped
+	auto it = std::remove_if(_pending.begin(), _pending.end(), [&](const Job::Sptr& job) {
+		if (job->Owner == owner) {
+			job->IsCancelled = true;
+			return true;
+		}
+		return false;
+	});
+	_pending.erase(it, _pending.end());
+}
+
+bool TextureLoader::IsPending(const ITexture* owner) {
+	return std::find_if(_pending.begin(), _pending.end(), [&](const Job::Sptr& job) { return job->Owner == owner; }) != _pending.end();
+}
+
+uint32_t TextureLoader::BeginUnpack(const void* data, size_t size) {
+	// We create a fresh buffer per upload and let the driver orphan it, so we never have to wait
+	// for a previous transfer to finish before we can write into a staging buffer
+	GLuint buffer = 0;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, size, nullptr, GL_MAP_WRITE_BIT);
+
+	void* mapped = glMapNamedBufferRange(buffer, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped != nullptr) {
+		memcpy(mapped, data, size);
+		glUnmapNamedBuffer(buffer);
+	} else {
+		// Mapping can fail on some drivers, fall back to a regular upload into the buffer
+		glDeleteBuffers(1, &buffer);
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, size, data, 0);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	return buffer;
+}
+
+void TextureLoader::EndUnpack(uint32_t buffer) {
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+}
+
+TextureLoader::Job::Sptr TextureLoader::_PopDecoded(bool wait) {
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (wait) {
+		_decodedSignal.wait(lock, []() { return !_decoded.empty(); });
+	}
+	else if (_decoded.empty()) {
+		return nullptr;
+	}
+
+	Job::Sptr result = _decoded.front();
+	_decoded.pop_front();
+	return result;
+}
+
+void TextureLoader::_Upload(const Job::Sptr& job) {
+	// The owner was destroyed or re-loaded while we were decoding
+	if (job->IsCancelled) {
+		return;
+	}
+
+	bool success = job->Upload();
+
+	_pending.erase(std::find(_pending.begin(), _pending.end(), job));
+	job->Owner->_isResident = success;
+
+	// Release anything the lambdas were holding on to (ex: decoded pixels)
+	job->Decode = nullptr;
+	job->Upload = nullptr;
+}
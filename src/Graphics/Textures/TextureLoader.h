@@ -0,0 +1,156 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+class ITexture;
+
+/// <summary>
+/// Stores the pixels of an image that has been decoded from a file, tightly packed
+/// with 8 bits per channel
+/// </summary>
+struct ImageData {
+	int Width;
+	int Height;
+	int Channels;
+	std::shared_ptr<uint8_t> Pixels;
+
+	ImageData() :
+		Width(0), Height(0), Channels(0),
+		Pixels(nullptr) { }
+
+	/// <summary>
+	/// Returns true if the image was decoded successfully
+	/// </summary>
+	bool IsValid() const { return Pixels != nullptr; }
+	/// <summary>
+	/// Gets the size of the pixel data, in bytes
+	/// </summary>
+	size_t GetSizeInBytes() const { return (size_t)Width * Height * Channels; }
+};
+
+/// <summary>
+/// Handles loading texture data in the background
+///
+/// Decoding image files (PNG, JPG, LUTs etc...) is by far the most expensive part of loading a texture,
+/// so textures can hand that work off to the shared thread pool. Once the pixels are ready, the
+/// upload step is run on the GL thread from Update, through a pixel unpack buffer, and we only
+/// process as many uploads as fit in the frame budget so loading does not cause hitches.
+///
+/// Textures that are still loading will bind a placeholder, see ITexture::IsResident
+/// </summary>
+class TextureLoader {
+public:
+	TextureLoader() = delete;
+
+	/// <summary>
+	/// Decodes an image file into memory, this is safe to call from any thread
+	/// </summary>
+	/// <param name="filename">The path of the image to load</param>
+	/// <param name="desiredChannels">The number of channels to convert the image to, or 0 to keep the number in the file</param>
+	/// <param name="flipVertical">True to flip the image so that the first row is the bottom of the image, as OpenGL expects</param>
+	/// <returns>The decoded image, check IsValid to determine if the load succeeded</returns>
+	static ImageData DecodeImage(const std::string& filename, int desiredChannels, bool flipVertical = true);
+
+	/// <summary>
+	/// Queues a load for a texture. The decode step will run on a worker thread, and must not touch
+	/// the texture or any GL state. The upload step runs on the GL thread during Update, and should
+	/// return true if the texture now has valid data
+	/// </summary>
+	/// <param name="owner">The texture that is being loaded</param>
+	/// <param name="decode">The function to run on a worker thread</param>
+	/// <param name="upload">The function to run on the GL thread once decode has finished</param>
+	static void Enqueue(ITexture* owner, std::function<void()>&& decode, std::function<bool()>&& upload);
+
+	/// <summary>
+	/// Uploads textures that have finished decoding, until the frame budget is exhausted. Should be
+	/// called once per frame from the GL thread
+	/// </summary>
+	static void Update();
+	/// <summary>
+	/// Blocks until the given texture has finished loading, uploading any other textures
+	/// that become ready in the mean time. Must be called from the GL thread
+	/// </summary>
+	/// <param name="owner">The texture to wait for</param>
+	static void Wait(const ITexture* owner);
+	/// <summary>
+	/// Blocks until all queued textures have finished loading. Must be called from the GL thread
+	/// </summary>
+	static void WaitAll();
+	/// <summary>
+	/// Cancels any pending uploads for the given texture, the decode will still complete
+	/// but the result will be discarded. Called when a texture is destroyed
+	/// </summary>
+	/// <param name="owner">The texture to cancel loads for</param>
+	static void Cancel(const ITexture* owner);
+
+	/// <summary>
+	/// Returns true if the given texture has a load in flight
+	/// </summary>
+	static bool IsPending(const ITexture* owner);
+	/// <summary>
+	/// Gets the number of textures that have not yet finished loading
+	/// </summary>
+	static size_t GetPendingCount() { return _pending.size(); }
+
+	/// <summary>
+	/// Gets the maximum time to spend uploading textures per frame, in seconds
+	/// </summary>
+	static double GetFrameBudget() { return _frameBudget; }
+	/// <summary>
+	/// Sets the maximum time to spend uploading textures per frame, in seconds. At least
+	/// one texture will always be uploaded per frame so that loading makes progress
+	/// </summary>
+	static void SetFrameBudget(double seconds) { _frameBudget = seconds; }
+
+	/// <summary>
+	/// Copies the given data into a new pixel unpack buffer and binds it. While bound, the data
+	/// pointer passed to glTextureSubImage* is treated as an offset into the buffer, so
+	/// LoadData should be called with nullptr. Must be followed by EndUnpack
+	/// </summary>
+	/// <param name="data">The data to upload</param>
+	/// <param name="size">The size of the data, in bytes</param>
+	/// <returns>The handle of the buffer, to be passed to EndUnpack</returns>
+	static uint32_t BeginUnpack(const void* data, size_t size);
+	/// <summary>
+	/// Unbinds and releases a pixel unpack buffer created by BeginUnpack. The driver will
+	/// keep the storage alive until any pending transfers have finished
+	/// </summary>
+	/// <param name="buffer">The buffer returned from BeginUnpack</param>
+	static void EndUnpack(uint32_t buffer);
+
+protected:
+	struct Job {
+		typedef std::shared_ptr<Job> Sptr;
+
+		ITexture*               Owner;
+		std::function<void()>   Decode;
+		std::function<bool()>   Upload;
+		// Only accessed from the GL thread
+		bool                    IsCancelled;
+	};
+
+	// Guards _decoded, which is filled by worker threads
+	static std::mutex              _mutex;
+	static std::condition_variable _decodedSignal;
+	static std::deque<Job::Sptr>   _decoded;
+
+	// All jobs that have not been uploaded yet, only accessed from the GL thread
+	static std::vector<Job::Sptr>  _pending;
+
+	static double _frameBudget;
+
+	/// <summary>
+	/// Pops the next decoded job, optionally blocking until one is ready
+	/// </summary>
+	static Job::Sptr _PopDecoded(bool wait);
+	/// <summary>
+	/// Runs the upload step for a job and removes it from the pending list
+	/// </summary>
+	static void _Upload(const Job::Sptr& job);
+};
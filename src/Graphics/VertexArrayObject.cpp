@@ -2,6 +2,7 @@
 #include "Buffers/IndexBuffer.h"
 #include "Buffers/VertexBuffer.h"
 #include "Logging.h"
+#include <algorithm>
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
@@ -163,6 +164,21 @@ VertexArrayObject::VertexBufferBinding* VertexArrayObject::GetBufferBinding(Attr
 	return nullptr;
 }
 
+size_t VertexArrayObject::GetBufferMemoryUsage() const {
+	size_t result = _indexBuffer != nullptr ? _indexBuffer->GetTotalSize() : 0;
+	for (size_t ix = 0; ix < _vertexBuffers.size(); ix++) {
+		const VertexBuffer::Sptr& buffer = _vertexBuffers[ix]->Buffer;
+		// Skip buffers that we've already counted for an earlier binding
+		bool counted = buffer == nullptr || std::any_of(_vertexBuffers.begin(), _vertexBuffers.begin() + ix, [&](const VertexBufferBinding* other) {
+			return other->Buffer == buffer;
+		});
+		if (!counted) {
+			result += buffer->GetTotalSize();
+		}
+	}
+	return result;
+}
+
 VertexArrayObject::Sptr VertexArrayObject::Clone() const
 {
 	VertexArrayObject::Sptr result = Create();
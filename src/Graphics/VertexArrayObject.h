@@ -120,6 +120,12 @@ public:
 	/// <returns>A const pointer to the binding, or nullptr if none is found</returns>
 	VertexBufferBinding* GetBufferBinding(AttribUsage usage);
 
+	/// <summary>
+	/// Gets the total size of the vertex and index buffers used by this VAO, in bytes. Buffers
+	/// that are bound more than once are only counted once
+	/// </summary>
+	size_t GetBufferMemoryUsage() const;
+
 	/// <summary>
 	/// Renders this VAO, using the specified draw mode
 	/// </summary>
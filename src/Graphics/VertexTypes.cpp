@@ -7,6 +7,8 @@ VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
 VertexPosNormTexColTangents* VPNTCT = nullptr;
+VertexPackedPosNormTexTangents* VPPNTT = nullptr;
+VertexPackedPosNormTexColTangents* VPPNTCT = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -41,4 +43,18 @@ const std::vector<BufferAttribute> VertexPosNormTexColTangents::V_DECL ={
 	BufferAttribute(4, 3, AttributeType::Float, sizeof(VertexPosNormTexColTangents), (size_t)&VPNTCT->Tangent, AttribUsage::Tangent),
 	BufferAttribute(5, 3, AttributeType::Float, sizeof(VertexPosNormTexColTangents), (size_t)&VPNTCT->BiTangent, AttribUsage::BiTangent)
 };
+// The packed normal and tangent go to their own slots, the shaders use those when the float normal is not bound
+const std::vector<BufferAttribute> VertexPackedPosNormTexTangents::V_DECL ={
+	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPackedPosNormTexTangents), (size_t)&VPPNTT->Position, AttribUsage::Position),
+	BufferAttribute(6, 2, AttributeType::Short, sizeof(VertexPackedPosNormTexTangents), (size_t)&VPPNTT->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexPackedPosNormTexTangents), (size_t)&VPPNTT->UV, AttribUsage::Texture),
+	BufferAttribute(7, 4, AttributeType::Short, sizeof(VertexPackedPosNormTexTangents), (size_t)&VPPNTT->Tangent, AttribUsage::Tangent, true)
+};
+const std::vector<BufferAttribute> VertexPackedPosNormTexColTangents::V_DECL ={
+	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, AttributeType::UByte, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Color, AttribUsage::Color, true),
+	BufferAttribute(6, 2, AttributeType::Short, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->UV, AttribUsage::Texture),
+	BufferAttribute(7, 4, AttributeType::Short, sizeof(VertexPackedPosNormTexColTangents), (size_t)&VPPNTCT->Tangent, AttribUsage::Tangent, true)
+};
 #pragma warning(pop)
\ No newline at end of file
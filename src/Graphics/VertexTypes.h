@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GLM/glm.hpp>
+#include <GLM/gtc/type_precision.hpp>
 #include "VertexArrayObject.h"
 
 
@@ -116,4 +117,35 @@ struct VertexPosNormTexColTangents {
 	{}
 
 	static const std::vector<BufferAttribute> V_DECL;
-};
\ No newline at end of file
+};
+
+/// <summary>
+/// A quantized version of VertexPosNormTexColTangents, used by version 2 binary meshes. Normals and
+/// tangents are octahedral encoded and decoded in the vertex shader (see vs_common.glsl)
+/// </summary>
+struct VertexPackedPosNormTexTangents {
+	glm::vec3    Position;
+	// Octahedral encoded normal, as normalized shorts
+	glm::i16vec2 Normal;
+	// Octahedral encoded tangent in xy, z is 1 since there's no color, w is the sign of the bitangent
+	glm::i16vec4 Tangent;
+	// Half float texture coordinates
+	glm::u16vec2 UV;
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// The same as VertexPackedPosNormTexTangents, with a color for meshes that don't use plain white
+/// </summary>
+struct VertexPackedPosNormTexColTangents {
+	glm::vec3    Position;
+	glm::i16vec2 Normal;
+	// Octahedral encoded tangent in xy, z is 0 since we have a color, w is the sign of the bitangent
+	glm::i16vec4 Tangent;
+	glm::u16vec2 UV;
+	// Color as normalized bytes
+	glm::u8vec4  Color;
+
+	static const std::vector<BufferAttribute> V_DECL;
+};
@@ -0,0 +1,347 @@
+#include "Utils/AssetPackage.h"
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+#include <Logging.h>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/StringUtils.h"
+#include "Utils/MeshFactory.h"
+#include "Gameplay/MeshResource.h"
+#include "Graphics/ShaderPreprocessor.h"
+
+namespace fs = std::filesystem;
+
+std::shared_mutex AssetPackage::_mutex;
+MemoryMappedFile::Sptr AssetPackage::_mapping = nullptr;
+std::unordered_map<std::string, AssetPackage::Entry> AssetPackage::_entries;
+
+// Extensions of files that may contain #include directives
+const std::unordered_set<std::string> shaderExtensions = { ".glsl", ".vert", ".frag", ".geom", ".tesc", ".tese", ".comp" };
+// Extensions of the caches we generate next to source files, which we want to ship with the source
+const std::string cacheExtensions[] = { ".bin", ".btex", ".blut", ".hull" };
+
+std::string AssetPackage::GetPackagePath(const std::string& scenePath) {
+	return fs::path(scenePath).replace_extension(".pak").string();
+}
+
+std::vector<std::string> AssetPackage::CollectFiles(const std::string& scenePath) {
+	// Assets are looked up by the paths the game uses, which are relative to the working
+	// directory, so we store the scene the same way if we can (ex: when picked from a file dialog)
+	fs::path scene = fs::path(scenePath);
+	if (scene.is_absolute()) {
+		fs::path relative = scene.lexically_relative(fs::current_path());
+		if (!relative.empty() && *relative.begin() != "..") {
+			scene = relative;
+		}
+	}
+
+	std::vector<std::string> candidates;
+	candidates.push_back(scene.string());
+
+	// This matches the manifest that Application::LoadScene will load
+	std::string manifestPath = fs::path(scenePath).stem().string() + "-manifest.json";
+	if (FileHelpers::Exists(manifestPath)) {
+		candidates.push_back(manifestPath);
+	}
+
+	// Any string in the scene or manifest that points to a file is something we need
+	size_t numRoots = candidates.size();
+	for (size_t ix = 0; ix < numRoots; ix++) {
+		try {
+			nlohmann::json blob = nlohmann::json::parse(FileHelpers::ReadFile(candidates[ix]));
+			_CollectPaths(blob, candidates);
+		}
+		catch (const std::exception& e) {
+			LOG_WARN("Failed to parse \"{}\" while collecting assets: {}", candidates[ix], e.what());
+		}
+	}
+
+	std::vector<std::string> result;
+	std::unordered_set<std::string> visited;
+	auto add = [&](const std::string& path) {
+		std::string normalized = _NormalizePath(path);
+		if (visited.insert(normalized).second) {
+			result.push_back(normalized);
+		}
+	};
+
+	for (const std::string& path : candidates) {
+		add(path);
+
+		std::string extension = fs::path(path).extension().string();
+		StringTools::ToLower(extension);
+
+		// Shaders need all the files they include
+		if (shaderExtensions.count(extension) > 0) {
+			for (const std::string& dependency : ShaderPreprocessor::GetDependencies(path)) {
+				if (FileHelpers::Exists(dependency)) {
+					add(dependency);
+				}
+			}
+		}
+
+		// Ship any caches we've built, so the package never needs to convert anything
+		for (const std::string& cacheExtension : cacheExtensions) {
+			if (extension == cacheExtension) {
+				continue;
+			}
+			std::string cachePath = fs::path(path).replace_extension(cacheExtension).string();
+			if (FileHelpers::Exists(cachePath)) {
+				add(cachePath);
+			}
+		}
+	}
+
+	return result;
+}
+
+bool AssetPackage::Write(const std::vector<std::string>& files, const std::string& packagePath) {
+	// Lay out the index first, so we know where every file is going to go
+	std::vector<BinaryEntry> entries;
+	std::string pathTable;
+	entries.reserve(files.size());
+	for (const std::string& file : files) {
+		BinaryEntry entry = BinaryEntry();
+		entry.PathOffset = static_cast<uint32_t>(pathTable.size());
+		entry.PathLength = static_cast<uint32_t>(file.size());
+		pathTable += file;
+		entries.push_back(entry);
+	}
+
+	auto align = [](uint64_t value) { return (value + _alignment - 1) & ~(uint64_t)(_alignment - 1); };
+
+	BinaryHeader header = BinaryHeader();
+	header.Version       = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
+	header.Alignment     = _alignment;
+	header.NumEntries    = static_cast<uint32_t>(entries.size());
+	header.PathTableSize = static_cast<uint32_t>(pathTable.size());
+
+	// We can't replace the package while it's mapped, so we unmount it and mount the new one
+	bool wasMounted = _NormalizePath(GetMountedPath()) == _NormalizePath(packagePath);
+	if (wasMounted) {
+		Unmount();
+	}
+
+	// Skip the index for now, we fill it in once we know the size of every file
+	uint64_t offset = align(sizeof(BinaryHeader) + entries.size() * sizeof(BinaryEntry) + pathTable.size());
+	bool success = FileHelpers::WriteFileAtomic(packagePath, [&](std::ostream& output) {
+		output.seekp(offset);
+
+		const char padding[_alignment] = { 0 };
+		for (size_t ix = 0; ix < files.size(); ix++) {
+			// We always pack what's on disk, Map and the file helpers would give us the mounted package's copy
+			MemoryMappedFile::Sptr file = std::make_shared<MemoryMappedFile>();
+			std::error_code error;
+			if (!file->Open(files[ix])) {
+				file = nullptr;
+				if (!fs::is_regular_file(files[ix], error)) {
+					LOG_WARN("Failed to open \"{}\" for packing, skipping", files[ix]);
+				}
+			}
+
+			fs::file_time_type writeTime = fs::last_write_time(files[ix], error);
+
+			// Empty files can't be mapped, so we store them with a size of 0
+			entries[ix].Offset    = offset;
+			entries[ix].Size      = file != nullptr ? file->GetSize() : 0;
+			entries[ix].WriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+			if (file != nullptr) {
+				output.write(reinterpret_cast<const char*>(file->GetData()), file->GetSize());
+				uint64_t next = align(offset + file->GetSize());
+				output.write(padding, next - offset - file->GetSize());
+				offset = next;
+			}
+		}
+
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+		output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(BinaryEntry));
+		output.write(pathTable.data(), pathTable.size());
+		return true;
+	});
+
+	if (wasMounted) {
+		Mount(packagePath);
+	}
+	if (!success) {
+		LOG_ERROR("Failed to write package \"{}\"", packagePath);
+		return false;
+	}
+
+	LOG_INFO("Packed {} files into \"{}\" ({} bytes)", files.size(), packagePath, offset);
+	return true;
+}
+
+bool AssetPackage::Build(const std::string& scenePath) {
+	return Write(CollectFiles(scenePath), GetPackagePath(scenePath));
+}
+
+bool AssetPackage::Mount(const std::string& packagePath) {
+	Unmount();
+
+	// We open the file directly, since Map would try and serve it from a package
+	MemoryMappedFile::Sptr mapping = std::make_shared<MemoryMappedFile>();
+	if (!mapping->Open(packagePath) || mapping->GetSize() < sizeof(BinaryHeader)) {
+		return false;
+	}
+
+	// Make sure this is actually one of our files, and a version we can read
+	const uint8_t* data = mapping->GetData();
+	const BinaryHeader* header = reinterpret_cast<const BinaryHeader*>(data);
+	if (memcmp(header->HeaderBytes, BinaryHeader().HeaderBytes, 4) != 0 || header->Version != 0x01) {
+		LOG_WARN("\"{}\" is not a valid asset package", packagePath);
+		return false;
+	}
+
+	size_t indexSize = sizeof(BinaryHeader) + header->NumEntries * sizeof(BinaryEntry) + header->PathTableSize;
+	if (mapping->GetSize() < indexSize) {
+		LOG_WARN("Asset package \"{}\" is truncated", packagePath);
+		return false;
+	}
+
+	const BinaryEntry* entries = reinterpret_cast<const BinaryEntry*>(data + sizeof(BinaryHeader));
+	const char* pathTable = reinterpret_cast<const char*>(entries + header->NumEntries);
+
+	std::unordered_map<std::string, Entry> index;
+	index.reserve(header->NumEntries);
+	uint32_t numStale = 0;
+	for (uint32_t ix = 0; ix < header->NumEntries; ix++) {
+		const BinaryEntry& entry = entries[ix];
+		if (entry.PathOffset + (size_t)entry.PathLength > header->PathTableSize || entry.Offset + entry.Size > mapping->GetSize()) {
+			LOG_WARN("Asset package \"{}\" has a corrupt entry, ignoring it", packagePath);
+			continue;
+		}
+
+		Entry result;
+		result.Offset    = static_cast<size_t>(entry.Offset);
+		result.Size      = static_cast<size_t>(entry.Size);
+		result.WriteTime = fs::file_time_type(fs::file_time_type::duration(entry.WriteTime));
+
+		// Loose files that were edited after packing win, this is the only time we check the disk for them
+		std::string path(pathTable + entry.PathOffset, entry.PathLength);
+		if (_IsStale(path, result)) {
+			numStale++;
+			continue;
+		}
+		index[path] = result;
+	}
+	if (numStale > 0) {
+		LOG_INFO("{} files in \"{}\" are older than the files on disk, using the disk copies", numStale, packagePath);
+	}
+
+	std::unique_lock<std::shared_mutex> lock(_mutex);
+	_mapping = mapping;
+	_entries = std::move(index);
+
+	LOG_INFO("Mounted asset package \"{}\" ({} files)", packagePath, _entries.size());
+	return true;
+}
+
+void AssetPackage::Unmount() {
+	std::unique_lock<std::shared_mutex> lock(_mutex);
+	_mapping = nullptr;
+	_entries.clear();
+}
+
+bool AssetPackage::IsMounted() {
+	std::shared_lock<std::shared_mutex> lock(_mutex);
+	return _mapping != nullptr;
+}
+
+std::string AssetPackage::GetMountedPath() {
+	std::shared_lock<std::shared_mutex> lock(_mutex);
+	return _mapping != nullptr ? _mapping->GetFilename() : "";
+}
+
+bool AssetPackage::Contains(const std::string& filename) {
+	Entry entry;
+	return GetEntry(filename, entry);
+}
+
+bool AssetPackage::GetEntry(const std::string& filename, Entry& result) {
+	std::shared_lock<std::shared_mutex> lock(_mutex);
+	// Skip normalizing the path if there's nothing to look in
+	if (_entries.empty()) {
+		return false;
+	}
+
+	auto it = _entries.find(_NormalizePath(filename));
+	if (it == _entries.end()) {
+		return false;
+	}
+	result = it->second;
+	return true;
+}
+
+MemoryMappedFile::Sptr AssetPackage::OpenFile(const std::string& filename) {
+	std::shared_lock<std::shared_mutex> lock(_mutex);
+	if (_entries.empty()) {
+		return nullptr;
+	}
+
+	auto it = _entries.find(_NormalizePath(filename));
+	if (it == _entries.end() || it->second.Size == 0) {
+		return nullptr;
+	}
+	return MemoryMappedFile::CreateView(_mapping, it->second.Offset, it->second.Size, filename);
+}
+
+void AssetPackage::Invalidate(const std::string& filename) {
+	std::unique_lock<std::shared_mutex> lock(_mutex);
+	if (!_entries.empty()) {
+		_entries.erase(_NormalizePath(filename));
+	}
+}
+
+std::string AssetPackage::_NormalizePath(const std::string& path) {
+	// Get a lexically normal path (ie with the ../ parts resolved), with consistent separators
+	return fs::path(path).lexically_normal().generic_string();
+}
+
+bool AssetPackage::_IsStale(const std::string& filename, const Entry& entry) {
+	// Shipped builds won't have the loose files, so this is only a stat that fails per entry when mounting
+	std::error_code error;
+	fs::file_time_type diskTime = fs::last_write_time(filename, error);
+	return !error && diskTime > entry.WriteTime;
+}
+
+void AssetPackage::_CollectPaths(const nlohmann::json& blob, std::vector<std::string>& result) {
+	// Generated meshes are cached by the hash of their parameters, see MeshResource::GetGeneratedCachePath.
+	// The convex hull cache next to it gets picked up with the rest of the cache extensions
+	if (blob.is_object() && blob.contains("params") && blob["params"].is_array()) {
+		try {
+			std::vector<MeshBuilderParam> params;
+			for (const auto& param : blob["params"]) {
+				if (!param.is_object() || !param.contains("type")) {
+					params.clear();
+					break;
+				}
+				params.push_back(MeshBuilderParam::FromJson(param));
+			}
+			if (!params.empty()) {
+				std::string cachePath = Gameplay::MeshResource::GetGeneratedCachePath(MeshBuilderParam::Hash(params));
+				if (FileHelpers::Exists(cachePath)) {
+					result.push_back(cachePath);
+				}
+			}
+		}
+		catch (const std::exception&) {
+			// Not a mesh resource, the rest of the blob still gets searched below
+		}
+	}
+
+	if (blob.is_string()) {
+		const std::string& value = blob.get_ref<const std::string&>();
+		// Most strings are names, GUIDs, or enum values, so we do a cheap check before hitting the disk
+		if (!value.empty() && value.size() < 260 && fs::path(value).has_extension() && FileHelpers::Exists(value)) {
+			result.push_back(value);
+		}
+	}
+	else if (blob.is_structured()) {
+		for (const auto& item : blob) {
+			_CollectPaths(item, result);
+		}
+	}
+}
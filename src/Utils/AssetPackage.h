@@ -0,0 +1,157 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <shared_mutex>
+#include <unordered_map>
+#include <json.hpp>
+
+#include "Utils/MemoryMappedFile.h"
+
+/// <summary>
+/// A single file archive containing all the assets that a scene needs (meshes, textures, shaders,
+/// LUTs, fonts, and the caches we generate for them)
+///
+/// A mounted package is memory mapped once, and the file helpers (FileHelpers::ReadFile,
+/// MemoryMappedFile::Map and everything built on them) will serve files from it instead of
+/// opening them on disk. Entries are aligned so they can be handed straight to the GPU
+///
+/// Loose files on disk that are newer than their packed copy when the package is mounted win over
+/// the package, so that editing an asset doesn't require rebuilding the package to see the change.
+/// We only check this when mounting, since stat-ing every file we open adds up, so loading the scene
+/// again is needed to pick up edits made while it's running. Files we write through the file helpers
+/// (ex: regenerated caches) are dropped from the package right away
+/// </summary>
+class AssetPackage {
+public:
+	AssetPackage() = delete;
+
+	/// <summary>
+	/// Describes where a file is stored in the package
+	/// </summary>
+	struct Entry {
+		size_t                          Offset;
+		size_t                          Size;
+		// The write time of the file when it was packed
+		std::filesystem::file_time_type WriteTime;
+	};
+
+	/// <summary>
+	/// Gets the path of the package for a scene file (ex: scene.json -> scene.pak)
+	/// </summary>
+	static std::string GetPackagePath(const std::string& scenePath);
+
+	/// <summary>
+	/// Collects all the files that a scene and it's manifest reference, including shader
+	/// includes and any binary caches that have been generated for them (including the
+	/// cache/meshes/ binaries and hulls for generated meshes)
+	/// </summary>
+	/// <param name="scenePath">The path to the scene file</param>
+	/// <returns>A list of normalized paths, with no duplicates</returns>
+	static std::vector<std::string> CollectFiles(const std::string& scenePath);
+	/// <summary>
+	/// Writes a package containing the given files
+	/// </summary>
+	/// <param name="files">The paths of the files to pack</param>
+	/// <param name="packagePath">The path of the package to write</param>
+	/// <returns>True if the package was written</returns>
+	static bool Write(const std::vector<std::string>& files, const std::string& packagePath);
+	/// <summary>
+	/// Packs everything a scene references into the package next to it
+	/// </summary>
+	/// <param name="scenePath">The path to the scene file</param>
+	/// <returns>True if the package was written</returns>
+	static bool Build(const std::string& scenePath);
+
+	/// <summary>
+	/// Maps a package into memory, and starts serving files from it. Any previously mounted
+	/// package is unmounted
+	/// </summary>
+	/// <param name="packagePath">The path of the package to mount</param>
+	/// <returns>True if the package was valid and has been mounted</returns>
+	static bool Mount(const std::string& packagePath);
+	/// <summary>
+	/// Stops serving files from the mounted package. Files that have already been opened
+	/// from the package remain valid
+	/// </summary>
+	static void Unmount();
+	/// <summary>
+	/// Returns true if a package is mounted
+	/// </summary>
+	static bool IsMounted();
+	/// <summary>
+	/// Gets the path of the mounted package, or an empty string if none is mounted
+	/// </summary>
+	static std::string GetMountedPath();
+
+	/// <summary>
+	/// Returns true if the mounted package contains the given file
+	/// </summary>
+	static bool Contains(const std::string& filename);
+	/// <summary>
+	/// Gets the location and write time of a file in the mounted package. Files that had been
+	/// modified on disk since they were packed when the package was mounted are treated as not being in the package
+	/// </summary>
+	/// <param name="filename">The path of the file to find</param>
+	/// <param name="result">Will store the entry if the file is found</param>
+	/// <returns>True if the file is in the package</returns>
+	static bool GetEntry(const std::string& filename, Entry& result);
+	/// <summary>
+	/// Opens a file from the mounted package, as a view into the package's mapping.
+	/// This is safe to call from any thread
+	/// </summary>
+	/// <param name="filename">The path of the file to open</param>
+	/// <returns>The file, or nullptr if it is not in the package or the disk copy is newer</returns>
+	static MemoryMappedFile::Sptr OpenFile(const std::string& filename);
+	/// <summary>
+	/// Stops serving a file from the mounted package, so that the copy on disk is used instead.
+	/// Should be called after writing a file that may have been packed
+	/// </summary>
+	/// <param name="filename">The path of the file that was written</param>
+	static void Invalidate(const std::string& filename);
+
+protected:
+	// Will be put at the start of the package, contains info about the contents of the file
+	struct BinaryHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char     HeaderBytes[4] = { 'A', 'P', 'A', 'K' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint16_t Version = 0;
+		// The alignment of every entry's data, in bytes
+		uint16_t Alignment = 0;
+		// The number of files in the package
+		uint32_t NumEntries = 0;
+		// The size of the path table that follows the entry table, in bytes
+		uint32_t PathTableSize = 0;
+	};
+
+	// Stored after the header for every file in the package
+	struct BinaryEntry {
+		uint64_t Offset;
+		uint64_t Size;
+		int64_t  WriteTime;
+		uint32_t PathOffset;
+		uint32_t PathLength;
+	};
+
+	// The alignment we use for entries, large enough for any SIMD loads or GPU uploads
+	static constexpr uint16_t _alignment = 64;
+
+	static std::shared_mutex _mutex;
+	static MemoryMappedFile::Sptr _mapping;
+	static std::unordered_map<std::string, Entry> _entries;
+
+	/// <summary>
+	/// Gets the normalized form of a path, which we use as our lookup key
+	/// </summary>
+	static std::string _NormalizePath(const std::string& path);
+	/// <summary>
+	/// Returns true if the file on disk has been written since it was packed, only checked when mounting
+	/// </summary>
+	static bool _IsStale(const std::string& filename, const Entry& entry);
+	/// <summary>
+	/// Recursively collects any strings in a JSON blob that are paths to existing files
+	/// </summary>
+	static void _CollectPaths(const nlohmann::json& blob, std::vector<std::string>& result);
+};
@@ -1,11 +1,22 @@
 #include "Utils/FileHelpers.h"
 #include <fstream>
 #include <filesystem>
+#include <atomic>
+#include <thread>
 #include <Logging.h>
 
 #include "Utils/StringUtils.h"
+#include "Utils/AssetPackage.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Graphics/ShaderPreprocessor.h"
 
 std::string FileHelpers::ReadFile(const std::string& filename) {
+	// Packed files are already in memory, no need to touch the disk
+	MemoryMappedFile::Sptr packed = AssetPackage::OpenFile(filename);
+	if (packed != nullptr) {
+		return std::string(reinterpret_cast<const char*>(packed->GetData()), packed->GetSize());
+	}
+
 	std::string result;
 	std::ifstream in(filename, std::ios::in | std::ios::binary); // ifstream closes itself due to RAII
 
@@ -31,72 +42,119 @@ std::string FileHelpers::ReadFile(const std::string& filename) {
 	return result;
 }
 
-std::string FileHelpers::ReadResolveIncludes(const std::string& filename, std::vector<std::string> resolvedPaths) {
-	// Read the entire file contents for processing
-	std::string result = ReadFile(filename);
-	// Determine where the file we just read resides on the filesystem
-	const std::filesystem::path folder = std::filesystem::path(filename).parent_path();
-
-	// The token we're looking for, and it's length
-	const char* includeToken = "#include";
-	const size_t includeTokenLen = const_strlen(includeToken);
-
-	// Look for the token in the file
-	size_t seek = result.find(includeToken, 0); 
-	// If we found it, there's work to do!
-	while (seek != std::string::npos) {
-		// Find the end of the line
-		size_t eol = result.find_first_of("\r\n", seek);
-		if (eol == std::string::npos) {
-			eol = result.size();
-		}
-
-		// Calculate the area from end of token to end of line, snip out as the path
-		size_t begin = seek + includeTokenLen + 1;
-		std::string path = result.substr(begin, eol - begin);
+std::string FileHelpers::ReadResolveIncludes(const std::string& filename) {
+	return ShaderPreprocessor::Process(filename);
+}
 
-		// Trim whitespace and any quotes 
-		StringTools::Trim(path);
-		StringTools::Trim(path, '"');
+void FileHelpers::WriteContentsToFile(const std::string& filename, const std::string& contents, bool append /*= false*/) {
+	std::ofstream output(filename, std::ios::out | (append ? std::ios::app : 0));
+	output << contents;
+	AssetPackage::Invalidate(filename);
+}
 
-		// Determine the file path
-		std::filesystem::path target;
-		// If it starts with '/', relative to application directory
-		if (path[0] == '/') {
-			target = path;
-		}
-		// Otherwise relative to the current directory
-		else {
-			target = folder / path;
+bool FileHelpers::WriteFileAtomic(const std::string& filename, const std::function<bool(std::ostream&)>& writer) {
+	// The counter keeps names unique within a thread, the thread ID keeps them unique between threads
+	static std::atomic<uint32_t> counter = 0;
+	std::string tempName = filename + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+		"." + std::to_string(counter++) + ".tmp";
+
+	bool success = false;
+	{
+		std::ofstream file(tempName, std::ios::out | std::ios::binary);
+		if (file) {
+			try {
+				success = writer(file);
+			}
+			catch (...) {
+				file.close();
+				std::error_code error;
+				std::filesystem::remove(tempName, error);
+				throw;
+			}
+			file.close();
+			// Closing flushes the stream, so this catches short writes as well as failed ones
+			success &= !file.fail();
 		}
-		// Get a lexically normal path (ie with the ../ parts resolved)
-		target = target.lexically_normal();
+	}
 
-		// If we haven't included the file yet, include it now
-		if (std::find(resolvedPaths.begin(), resolvedPaths.end(), target.string()) == resolvedPaths.end()) {
+	std::error_code error;
+	if (success) {
+		std::filesystem::rename(tempName, filename, error);
+		success = !error;
+	}
+	if (success) {
+		// The packed copy of this file (if any) is out of date now
+		AssetPackage::Invalidate(filename);
+	}
+	if (!success) {
+		LOG_WARN("Failed to write \"{}\"{}", filename, error ? ": " + error.message() : "");
+		std::filesystem::remove(tempName, error);
+	}
+	return success;
+}
 
-			// Make sure file exists, then load and resolve it's includes
-			LOG_ASSERT(std::filesystem::exists(target), "File does not exist");
-			std::string replacement = FileHelpers::ReadResolveIncludes(target.string(), resolvedPaths);
+bool FileHelpers::WriteFileAtomic(const std::string& filename, const void* data, size_t size) {
+	return WriteFileAtomic(filename, [&](std::ostream& file) {
+		file.write(reinterpret_cast<const char*>(data), size);
+		return true;
+	});
+}
 
-			// Inject result into our string
-			result.replace(seek, eol - seek, replacement);
-			// Look for more includes!
-			seek = result.find(includeToken, seek + replacement.length());
+bool FileHelpers::IsNewerThan(const std::string& filename, const std::vector<std::string>& sourceFiles) {
+	std::filesystem::file_time_type fileTime;
+	uintmax_t size;
+	if (!GetFileInfo(filename, fileTime, size)) {
+		return false;
+	}
 
-			resolvedPaths.push_back(target.string());
-		}
-		// File already included, remove the line and continue seeking
-		else {
-			result.replace(seek, eol - seek, "");
-			seek = result.find(includeToken, eol);
+	for (const std::string& source : sourceFiles) {
+		std::filesystem::file_time_type sourceTime;
+		if (GetFileInfo(source, sourceTime, size) && sourceTime > fileTime) {
+			return false;
 		}
 	}
+	return true;
+}
 
-	return result;
+bool FileHelpers::Exists(const std::string& filename) {
+	std::error_code error;
+	return AssetPackage::Contains(filename) || std::filesystem::is_regular_file(filename, error);
 }
 
-void FileHelpers::WriteContentsToFile(const std::string& filename, const std::string& contents, bool append /*= false*/) {
-	std::ofstream output(filename, std::ios::out | (append ? std::ios::app : 0));
-	output << contents;
+bool FileHelpers::GetFileInfo(const std::string& filename, std::filesystem::file_time_type& writeTime, uintmax_t& size) {
+	// The package keeps the write times from when it was built, so caches stay fresh
+	AssetPackage::Entry entry;
+	if (AssetPackage::GetEntry(filename, entry)) {
+		writeTime = entry.WriteTime;
+		size = entry.Size;
+		return true;
+	}
+
+	std::error_code error;
+	writeTime = std::filesystem::last_write_time(filename, error);
+	if (error) {
+		return false;
+	}
+	size = std::filesystem::file_size(filename, error);
+	return !error;
+}
+
+bool FileHelpers::HashFile(const std::string& filename, uint64_t& hash) {
+	// Hashes are used to tell when a source file has changed, so the copy on disk wins over the packed one
+	MemoryMappedFile::Sptr file = std::make_shared<MemoryMappedFile>();
+	if (!file->Open(filename)) {
+		file = AssetPackage::OpenFile(filename);
+	}
+	if (file == nullptr) {
+		return false;
+	}
+
+	const uint64_t prime = 0x100000001b3ull;
+	hash = 0xcbf29ce484222325ull;
+	const uint8_t* bytes = file->GetData();
+	for (size_t ix = 0; ix < file->GetSize(); ix++) {
+		hash ^= bytes[ix];
+		hash *= prime;
+	}
+	return true;
 }
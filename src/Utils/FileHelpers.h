@@ -2,12 +2,17 @@
 
 #include <string>
 #include <vector>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <cstdint>
 
 class FileHelpers {
 public:
 	FileHelpers() = delete;
 	/// <summary>
-	/// Reads the entire contents of a file into a string
+	/// Reads the entire contents of a file into a string. Files in the mounted AssetPackage
+	/// are read from the package instead of the disk
 	/// </summary>
 	/// <param name="filename">The path of the file to load</param>
 	/// <returns>The entire contents of the file stored in a string</returns>
@@ -16,11 +21,11 @@ public:
 	/// <summary>
 	/// Reads the entire contents of a file, and will also recursively include
 	/// any other files needed as indicated by a #include fileName on a line
+	/// Included files are cached, see ShaderPreprocessor for details
 	/// </summary>
 	/// <param name="filename">The path of the file to load</param>
-	/// <param name="resolvedPaths">The list of paths that have already been included</param>
 	/// <returns>The entire contents of the file, with includes resolved, stored in a string</returns>
-	static std::string ReadResolveIncludes(const std::string& filename, std::vector<std::string> resolvedPaths = std::vector<std::string>());
+	static std::string ReadResolveIncludes(const std::string& filename);
 
 	/// <summary>
 	/// Helper for writing the contents of a string into a file
@@ -29,4 +34,52 @@ public:
 	/// <param name="contents">The contents of the file to write</param>
 	/// <param name="append">True if contents should be appended to end of existing files</param>
 	static void WriteContentsToFile(const std::string& filename, const std::string& contents, bool append = false);
+
+	/// <summary>
+	/// Writes a file by writing to a uniquely named temporary file next to it, and then moving that over
+	/// the destination. Readers will never see a half written file, and multiple threads can write the
+	/// same file at once (the last one to finish wins)
+	/// </summary>
+	/// <param name="filename">The path of the file to write</param>
+	/// <param name="writer">Writes the contents to the stream, may return false to abandon the write</param>
+	/// <returns>True if the writer succeeded, the whole file was written, and it was moved into place</returns>
+	static bool WriteFileAtomic(const std::string& filename, const std::function<bool(std::ostream&)>& writer);
+	/// <summary>
+	/// Writes a block of memory to a file, see WriteFileAtomic above
+	/// </summary>
+	/// <param name="filename">The path of the file to write</param>
+	/// <param name="data">The data to write</param>
+	/// <param name="size">The number of bytes to write</param>
+	/// <returns>True if the file was written and moved into place</returns>
+	static bool WriteFileAtomic(const std::string& filename, const void* data, size_t size);
+
+	/// <summary>
+	/// Checks whether a generated file (ex: a binary cache) is up to date with the files it was generated from
+	/// </summary>
+	/// <param name="filename">The path of the generated file</param>
+	/// <param name="sourceFiles">The files that the generated file was built from, sources that do not exist are ignored</param>
+	/// <returns>True if the file exists and was written after all of the source files</returns>
+	static bool IsNewerThan(const std::string& filename, const std::vector<std::string>& sourceFiles);
+
+	/// <summary>
+	/// Checks whether a file exists, either in the mounted AssetPackage or on disk
+	/// </summary>
+	/// <param name="filename">The path of the file to check</param>
+	static bool Exists(const std::string& filename);
+	/// <summary>
+	/// Gets the last write time and size of a file, from the mounted AssetPackage or the disk
+	/// </summary>
+	/// <param name="filename">The path of the file to query</param>
+	/// <param name="writeTime">Will store the last write time of the file</param>
+	/// <param name="size">Will store the size of the file, in bytes</param>
+	/// <returns>True if the file exists</returns>
+	static bool GetFileInfo(const std::string& filename, std::filesystem::file_time_type& writeTime, uintmax_t& size);
+	/// <summary>
+	/// Hashes the contents of a file (FNV-1a). The file on disk is used if there is one, otherwise
+	/// the copy in the mounted AssetPackage is hashed
+	/// </summary>
+	/// <param name="filename">The path of the file to hash</param>
+	/// <param name="hash">Will store the hash of the file's contents</param>
+	/// <returns>True if the file could be read</returns>
+	static bool HashFile(const std::string& filename, uint64_t& hash);
 };
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/AssetPackage.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile() :
+	_data(nullptr),
+	_size(0),
+	_filename(""),
+	_fileHandle(nullptr),
+	_mappingHandle(nullptr),
+	_source(nullptr)
+{ }
+
+MemoryMappedFile::~MemoryMappedFile() {
+	Close();
+}
+
+bool MemoryMappedFile::Open(const std::string& filename) {
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	// Empty files can't be mapped
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_fileHandle = file;
+	_mappingHandle = mapping;
+	_data = static_cast<const uint8_t*>(view);
+	_size = static_cast<size_t>(size.QuadPart);
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	// Empty files can't be mapped
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping holds it's own reference to the file
+	close(file);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+
+	_data = static_cast<const uint8_t*>(view);
+	_size = static_cast<size_t>(info.st_size);
+#endif
+
+	_filename = filename;
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	// Views don't own their memory, the source will unmap it once it's no longer used
+	if (_source != nullptr) {
+		_source = nullptr;
+		_data = nullptr;
+		_size = 0;
+		_filename.clear();
+		return;
+	}
+
+#ifdef _WIN32
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != nullptr) {
+		CloseHandle(_mappingHandle);
+	}
+	if (_fileHandle != nullptr) {
+		CloseHandle(_fileHandle);
+	}
+#else
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+#endif
+
+	_data = nullptr;
+	_size = 0;
+	_fileHandle = nullptr;
+	_mappingHandle = nullptr;
+	_filename.clear();
+}
+
+MemoryMappedFile::Sptr MemoryMappedFile::Map(const std::string& filename) {
+	// Files in the asset package can be served without opening anything
+	MemoryMappedFile::Sptr packed = AssetPackage::OpenFile(filename);
+	if (packed != nullptr) {
+		return packed;
+	}
+
+	MemoryMappedFile::Sptr result = std::make_shared<MemoryMappedFile>();
+	return result->Open(filename) ? result : nullptr;
+}
+
+MemoryMappedFile::Sptr MemoryMappedFile::CreateView(const MemoryMappedFile::Sptr& source, size_t offset, size_t size, const std::string& filename) {
+	if (source == nullptr || !source->IsOpen() || offset + size > source->GetSize()) {
+		return nullptr;
+	}
+
+	MemoryMappedFile::Sptr result = std::make_shared<MemoryMappedFile>();
+	result->_source   = source;
+	result->_data     = source->GetData() + offset;
+	result->_size     = size;
+	result->_filename = filename;
+	return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Maps the contents of a file into memory as read-only data
+///
+/// The OS pages the file in as it is touched, so large binary caches can be read (or handed
+/// straight to OpenGL) without first copying them into a buffer of our own. The mapping
+/// stays valid until the object is closed or destroyed
+///
+/// Files can also be views into a larger mapping (ex: an entry in a mounted AssetPackage),
+/// in which case they keep the parent mapping alive
+/// </summary>
+class MemoryMappedFile final {
+public:
+	MAKE_PTRS(MemoryMappedFile);
+	NO_COPY(MemoryMappedFile);
+	NO_MOVE(MemoryMappedFile);
+
+	MemoryMappedFile();
+	~MemoryMappedFile();
+
+	/// <summary>
+	/// Maps the given file into memory, closing any file that was previously mapped
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	/// <returns>True if the file was mapped, false if it does not exist, is empty or could not be mapped</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Unmaps the file, any pointers into the data become invalid
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if a file is currently mapped
+	/// </summary>
+	bool IsOpen() const { return _data != nullptr; }
+	/// <summary>
+	/// Gets a pointer to the start of the mapped file
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Gets the size of the mapped file, in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+	/// <summary>
+	/// Gets the path of the mapped file
+	/// </summary>
+	const std::string& GetFilename() const { return _filename; }
+
+	/// <summary>
+	/// Maps a file into memory. If the file is stored in the mounted asset package, the result
+	/// is a view into the package instead of a new mapping
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	/// <returns>The mapped file, or nullptr if the file could not be mapped</returns>
+	static MemoryMappedFile::Sptr Map(const std::string& filename);
+	/// <summary>
+	/// Creates a view into a region of an already mapped file
+	/// </summary>
+	/// <param name="source">The mapped file to create a view into</param>
+	/// <param name="offset">The offset of the region from the start of the source, in bytes</param>
+	/// <param name="size">The size of the region, in bytes</param>
+	/// <param name="filename">The name to report for the view</param>
+	/// <returns>The view, or nullptr if the region is outside of the source</returns>
+	static MemoryMappedFile::Sptr CreateView(const MemoryMappedFile::Sptr& source, size_t offset, size_t size, const std::string& filename);
+
+protected:
+	const uint8_t* _data;
+	size_t         _size;
+	std::string    _filename;
+
+	// Platform handles for the file and the mapping
+	void*          _fileHandle;
+	void*          _mappingHandle;
+
+	// If this is a view, the file that actually owns the mapping
+	MemoryMappedFile::Sptr _source;
+};
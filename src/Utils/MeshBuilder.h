@@ -1,7 +1,80 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include "Graphics/VertexArrayObject.h"
 
+/// <summary>
+/// Holds on to the storage of mesh builders that are no longer in use, so that new builders can re-use it
+/// instead of allocating. Useful for geometry that is rebuilt every frame, where after the first few frames
+/// every builder can be served from the arena without touching the heap
+///
+/// The arena must outlive any builders that were created from it
+/// </summary>
+/// <typeparam name="VertType">The type of vertex that the builders are using</typeparam>
+template <typename VertType>
+class MeshBuilderArena
+{
+public:
+	MeshBuilderArena() :
+		_vertexBlocks(),
+		_indexBlocks() {}
+	~MeshBuilderArena() = default;
+
+	MeshBuilderArena(const MeshBuilderArena& other) = delete;
+	MeshBuilderArena& operator =(const MeshBuilderArena& other) = delete;
+
+	/// <summary>
+	/// Moves storage from the arena into the given vectors, which should be empty. If the arena
+	/// is empty the vectors are left as they are
+	/// </summary>
+	void Take(std::vector<VertType>& vertices, std::vector<uint32_t>& indices) {
+		if (!_vertexBlocks.empty()) {
+			vertices = std::move(_vertexBlocks.back());
+			_vertexBlocks.pop_back();
+		}
+		if (!_indexBlocks.empty()) {
+			indices = std::move(_indexBlocks.back());
+			_indexBlocks.pop_back();
+		}
+	}
+
+	/// <summary>
+	/// Clears the given vectors and stores their memory in the arena for later use
+	/// </summary>
+	void Return(std::vector<VertType>& vertices, std::vector<uint32_t>& indices) {
+		if (vertices.capacity() > 0) {
+			vertices.clear();
+			_vertexBlocks.push_back(std::move(vertices));
+		}
+		if (indices.capacity() > 0) {
+			indices.clear();
+			_indexBlocks.push_back(std::move(indices));
+		}
+	}
+
+	/// <summary>
+	/// Frees all of the memory held by the arena
+	/// </summary>
+	void Clear() {
+		_vertexBlocks.clear();
+		_indexBlocks.clear();
+	}
+
+	/// <summary>
+	/// Gets the number of bytes of storage that the arena is holding on to
+	/// </summary>
+	size_t GetReservedBytes() const {
+		size_t result = 0;
+		for (const auto& block : _vertexBlocks) { result += block.capacity() * sizeof(VertType); }
+		for (const auto& block : _indexBlocks) { result += block.capacity() * sizeof(uint32_t); }
+		return result;
+	}
+
+protected:
+	std::vector<std::vector<VertType>> _vertexBlocks;
+	std::vector<std::vector<uint32_t>> _indexBlocks;
+};
+
 /// <summary>
 /// A utility class that lets us add vertices and indices, then bake it into a final mesh, using interleaved
 /// vertex buffers
@@ -13,8 +86,29 @@ class MeshBuilder
 public:
 	MeshBuilder() :
 		_vertices(std::vector<VertType>()),
-		_indices(std::vector<uint32_t>()) {}
-	~MeshBuilder() = default;
+		_indices(std::vector<uint32_t>()),
+		_arena(nullptr) {}
+	/// <summary>
+	/// Creates a mesh builder that takes it's storage from an arena, and gives it back when destroyed
+	/// </summary>
+	/// <param name="arena">The arena to use, must outlive this builder</param>
+	explicit MeshBuilder(MeshBuilderArena<VertType>& arena) :
+		_vertices(std::vector<VertType>()),
+		_indices(std::vector<uint32_t>()),
+		_arena(&arena)
+	{
+		_arena->Take(_vertices, _indices);
+	}
+	~MeshBuilder() {
+		if (_arena != nullptr) {
+			_arena->Return(_vertices, _indices);
+		}
+	}
+
+	MeshBuilder(const MeshBuilder& other) = default;
+	MeshBuilder(MeshBuilder&& other) = default;
+	MeshBuilder& operator =(const MeshBuilder& other) = default;
+	MeshBuilder& operator =(MeshBuilder&& other) = default;
 
 	/// <summary>
 	/// Adds a new vertex to the mesh, returning it's index within the vertex buffer
@@ -35,9 +129,9 @@ public:
 	uint32_t AddVertexRange(const VertType* data, uint32_t count) {
 		uint32_t index = static_cast<uint32_t>(_vertices.size());
 		// Reserve space for the incoming vertices, ensures the underlying datastore will be large enough
-		_vertices.reserve(_vertices.size() + count);
+		ReserveVertexSpace(count);
 		// Copy data into the container, this will also update the container's size!
-		std::copy(data, data + count, std::back_inserter(_vertices));
+		_vertices.insert(_vertices.end(), data, data + count);
 		// Return the index of the start of the range
 		return index;
 	}
@@ -78,27 +172,74 @@ public:
 	/// <param name="c">The index of the third vertex</param>
 	void AddIndexTri(uint32_t a, uint32_t b, uint32_t c)
 	{
-		ReserveIndexSpace(3);
-		_indices.push_back(a);
-		_indices.push_back(b);
-		_indices.push_back(c);
+		uint32_t* indices = AppendIndices(3);
+		indices[0] = a;
+		indices[1] = b;
+		indices[2] = c;
+	}
+
+	/// <summary>
+	/// Adds a range of indices to this mesh, offsetting each of them by a base vertex
+	/// </summary>
+	/// <param name="data">The array of indices to add to this mesh</param>
+	/// <param name="count">The number of indices in data</param>
+	/// <param name="baseVertex">The value to add to each index, ex: the result of AddVertexRange</param>
+	void AddIndexRange(const uint32_t* data, size_t count, uint32_t baseVertex = 0) {
+		uint32_t* indices = AppendIndices(count);
+		for (size_t ix = 0; ix < count; ix++) {
+			indices[ix] = data[ix] + baseVertex;
+		}
+	}
+	/// <summary>
+	/// Adds a range of indices to this mesh, offsetting each of them by a base vertex
+	/// </summary>
+	/// <param name="data">The indices to add to this mesh</param>
+	/// <param name="baseVertex">The value to add to each index, ex: the result of AddVertexRange</param>
+	void AddIndexRange(const std::vector<uint32_t>& data, uint32_t baseVertex = 0) {
+		AddIndexRange(data.data(), data.size(), baseVertex);
+	}
+
+	/// <summary>
+	/// Adds count default constructed vertices to the end of the mesh, and returns a pointer to the first
+	/// one so they can be filled in place. The pointer is only valid until the next vertex is added
+	/// </summary>
+	/// <param name="count">The number of vertices to add</param>
+	/// <param name="firstIndex">Will store the index of the first new vertex</param>
+	VertType* AppendVertices(size_t count, uint32_t& firstIndex) {
+		firstIndex = static_cast<uint32_t>(_vertices.size());
+		ReserveVertexSpace(count);
+		_vertices.resize(_vertices.size() + count);
+		return _vertices.data() + firstIndex;
+	}
+	/// <summary>
+	/// Adds count indices to the end of the mesh, and returns a pointer to the first one so they
+	/// can be filled in place. The pointer is only valid until the next index is added
+	/// </summary>
+	/// <param name="count">The number of indices to add</param>
+	uint32_t* AppendIndices(size_t count) {
+		size_t first = _indices.size();
+		ReserveIndexSpace(count);
+		_indices.resize(first + count);
+		return _indices.data() + first;
 	}
 	
 	/// <summary>
-	/// Resizes the internal vector to allocate space for new vertices, can improve
-	/// performance when appending large meshes of a known size
+	/// Makes sure there is space for extendAmount more vertices, can improve performance when
+	/// appending large meshes of a known size. Storage grows geometrically, so calling this for
+	/// every small append is still cheap
 	/// </summary>
 	/// <param name="extendAmount">The number of vertices to reserve space for</param>
 	void ReserveVertexSpace(size_t extendAmount) {
-		_vertices.reserve(_vertices.size() + extendAmount);
+		_Grow(_vertices, _vertices.size() + extendAmount);
 	}
 	/// <summary>
-	/// Resizes the internal vector to allocate space for new indices, can improve
-	/// performance when appending large meshes of a known size
+	/// Makes sure there is space for extendAmount more indices, can improve performance when
+	/// appending large meshes of a known size. Storage grows geometrically, so calling this for
+	/// every small append is still cheap
 	/// </summary>
 	/// <param name="extendAmount">The number of indices to reserve space for</param>
 	void ReserveIndexSpace(size_t extendAmount) {
-		_indices.reserve(_indices.size() + extendAmount);
+		_Grow(_indices, _indices.size() + extendAmount);
 	}
 
 	/// <summary>
@@ -142,7 +283,7 @@ public:
 	}
 	
 	/// <summary>
-	/// Resets this mesh, removing all vertices and indices
+	/// Resets this mesh, removing all vertices and indices. The memory is kept for re-use
 	/// </summary>
 	void Reset() {
 		_vertices.clear();
@@ -169,4 +310,17 @@ protected:
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
+	// The arena to return our storage to, or nullptr if we own it
+	MeshBuilderArena<VertType>* _arena;
+
+	/// <summary>
+	/// Reserves space for at least count elements, at least doubling the capacity when it needs to grow.
+	/// reserve on it's own allocates exactly what's asked for, which makes repeated small reserves quadratic
+	/// </summary>
+	template <typename T>
+	static void _Grow(std::vector<T>& data, size_t count) {
+		if (count > data.capacity()) {
+			data.reserve(std::max(count, data.capacity() * 2));
+		}
+	}
 };
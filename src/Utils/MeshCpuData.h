@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Utils/MeshBuilder.h"
+
+/// <summary>
+/// A CPU side copy of the triangles in a mesh, for systems like physics that need to read the
+/// geometry after it has been uploaded, without reading it back from the GPU
+/// </summary>
+struct MeshCpuData {
+	typedef std::shared_ptr<MeshCpuData> Sptr;
+
+	std::vector<glm::vec3> Positions;
+	// 3 per triangle
+	std::vector<uint32_t>  Indices;
+
+	/// <summary>
+	/// Gets the number of bytes used by the positions and indices
+	/// </summary>
+	size_t GetMemoryUsage() const {
+		return Positions.capacity() * sizeof(glm::vec3) + Indices.capacity() * sizeof(uint32_t);
+	}
+
+	/// <summary>
+	/// Copies the positions and indices out of a mesh builder. Meshes without indices are treated as a triangle list
+	/// </summary>
+	/// <typeparam name="VertexType">The type of vertex in the mesh, must have a float3 Position field</typeparam>
+	/// <param name="mesh">The mesh to copy</param>
+	template <typename VertexType>
+	static Sptr FromBuilder(const MeshBuilder<VertexType>& mesh) {
+		Sptr result = std::make_shared<MeshCpuData>();
+		result->Positions.resize(mesh.GetVertexCount());
+		for (size_t ix = 0; ix < mesh.GetVertexCount(); ix++) {
+			result->Positions[ix] = mesh.GetVertexDataPtr()[ix].Position;
+		}
+
+		if (mesh.GetIndexCount() > 0) {
+			result->Indices.assign(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+		} else {
+			result->Indices.resize(mesh.GetVertexCount());
+			for (uint32_t ix = 0; ix < result->Indices.size(); ix++) {
+				result->Indices[ix] = ix;
+			}
+		}
+		return result;
+	}
+};
@@ -1,4 +1,5 @@
 #include "Utils/MeshFactory.h"
+#include <algorithm>
 
 MeshBuilderParam MeshBuilderParam::CreateCube(const glm::vec3& pos, const glm::vec3& scale, const glm::vec3& eulerDeg /*= glm::vec3(0.0f)*/, const glm::vec4& col /*= glm::vec4(1.0f)*/) {
 	MeshBuilderParam result;
@@ -78,4 +79,38 @@ nlohmann::json MeshBuilderParam::ToJson() const {
 		result["params"][key] = value;
 	}
 	return result;
+}
+
+uint64_t MeshBuilderParam::Hash(const std::vector<MeshBuilderParam>& params) {
+	uint64_t result = 0xcbf29ce484222325ull;
+	auto hashBytes = [&result](const void* data, size_t size) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+		for (size_t ix = 0; ix < size; ix++) {
+			result ^= bytes[ix];
+			result *= 0x100000001b3ull;
+		}
+	};
+
+	hashBytes(&MeshFactory::GENERATOR_VERSION, sizeof(uint32_t));
+	for (const MeshBuilderParam& param : params) {
+		int type = static_cast<int>(param.Type);
+		hashBytes(&type, sizeof(int));
+		hashBytes(&param.Color, sizeof(glm::vec4));
+
+		// The map's order isn't stable, so we hash the entries sorted by name
+		std::vector<const std::pair<const std::string, glm::vec3>*> entries;
+		entries.reserve(param.Params.size());
+		for (const auto& entry : param.Params) {
+			entries.push_back(&entry);
+		}
+		std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+		uint32_t count = static_cast<uint32_t>(entries.size());
+		hashBytes(&count, sizeof(uint32_t));
+		for (const auto* entry : entries) {
+			// Include the terminator, so that where one key ends can't be confused with the next
+			hashBytes(entry->first.c_str(), entry->first.size() + 1);
+			hashBytes(&entry->second, sizeof(glm::vec3));
+		}
+	}
+	return result;
 }
\ No newline at end of file
@@ -37,6 +37,12 @@ struct MeshBuilderParam {
 
 	static MeshBuilderParam FromJson(const nlohmann::json& blob);
 	nlohmann::json   ToJson() const;
+
+	/// <summary>
+	/// Hashes a list of parameters (FNV-1a), lists that generate the same mesh will have the same hash
+	/// </summary>
+	/// <param name="params">The parameters to hash, in the order they are applied</param>
+	static uint64_t Hash(const std::vector<MeshBuilderParam>& params);
 };
 
 
@@ -149,13 +155,20 @@ public:
 	static void InvertFaces(MeshBuilder<Vertex>& mesh);
 
 	/// <summary>
-	/// Calculates the tangents and bitangents from the normal and UV coords
+	/// Calculates the tangents and bitangents from the normal and UV coords, matching MikkTSpace
+	/// so that baked normal maps line up. See TangentGenerator
 	/// </summary>
 	/// <typeparam name="Vertex">The type of vertex the mesh consists of</typeparam>
 	/// <param name="mesh">The mesh to manipulate</param>
 	template <typename Vertex>
 	static void CalculateTBN(MeshBuilder<Vertex>& mesh);
 
+	/// <summary>
+	/// Included in MeshBuilderParam hashes, bump this when changing how meshes are generated so that
+	/// cached meshes are rebuilt
+	/// </summary>
+	inline static const uint32_t GENERATOR_VERSION = 1;
+
 protected:	
 	MeshFactory() = default;
 	~MeshFactory() = default;
@@ -0,0 +1,246 @@
+#include "Utils/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <GLM/gtc/packing.hpp>
+
+inline int16_t ToSnorm16(float value) {
+	return static_cast<int16_t>(glm::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters, uint32_t cacheSize) {
+	size_t triCount = indices.size() / 3;
+	if (clusters != nullptr) {
+		clusters->clear();
+	}
+	if (triCount == 0) {
+		return;
+	}
+
+	// Build the triangles that use each vertex, as one flat list with an offset per vertex
+	std::vector<uint32_t> liveCount(vertexCount, 0);
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		liveCount[indices[ix]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] = adjacencyOffsets[ix] + liveCount[ix];
+	}
+	std::vector<uint32_t> adjacency(adjacencyOffsets[vertexCount]);
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t ix = 0; ix < triCount * 3; ix++) {
+			adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+	}
+
+	// The time each vertex last entered the cache, we treat the cache as a FIFO
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool>     emitted(triCount, false);
+	// Vertices of recently emitted triangles, used to pick a new starting point once we reach a dead end
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(triCount * 3);
+
+	uint32_t timestamp = cacheSize + 1;
+	size_t   cursor = 0;
+	int64_t  fanning = 0;
+
+	// Moves on to the next vertex that still has triangles, either from the dead end stack or in input order
+	auto skipDeadEnd = [&]() -> int64_t {
+		while (!deadEnds.empty()) {
+			uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveCount[vertex] > 0) {
+				return vertex;
+			}
+		}
+		while (cursor < vertexCount) {
+			if (liveCount[cursor] > 0) {
+				return static_cast<int64_t>(cursor);
+			}
+			cursor++;
+		}
+		return -1;
+	};
+
+	while (fanning >= 0) {
+		candidates.clear();
+
+		// Emit all of the remaining triangles around the fanning vertex
+		for (uint32_t ix = adjacencyOffsets[fanning]; ix < adjacencyOffsets[fanning + 1]; ix++) {
+			uint32_t tri = adjacency[ix];
+			if (emitted[tri]) {
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++) {
+				uint32_t vertex = indices[tri * 3 + corner];
+				result.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCount[vertex]--;
+				if (timestamp - cacheTime[vertex] > cacheSize) {
+					cacheTime[vertex] = timestamp++;
+				}
+			}
+			emitted[tri] = true;
+		}
+
+		// Pick the candidate that will still be in the cache once all of it's triangles are emitted,
+		// preferring the oldest so that we use it before it's evicted
+		int64_t next = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (liveCount[vertex] == 0) {
+				continue;
+			}
+			int64_t priority = 0;
+			if (timestamp - cacheTime[vertex] + 2 * liveCount[vertex] <= cacheSize) {
+				priority = timestamp - cacheTime[vertex];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		// None of our neighbours have triangles left, so we're starting a new cluster somewhere else
+		if (next == -1) {
+			next = skipDeadEnd();
+			if (clusters != nullptr && next >= 0) {
+				clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+			}
+		}
+		fanning = next;
+	}
+
+	// The first cluster always starts at the beginning
+	if (clusters != nullptr && (clusters->empty() || clusters->front() != 0)) {
+		clusters->insert(clusters->begin(), 0);
+	}
+
+	indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& clusters) {
+	size_t triCount = indices.size() / 3;
+	if (clusters.size() < 2 || triCount == 0) {
+		return;
+	}
+
+	// Area weighted centroid of the whole mesh
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+	for (size_t tri = 0; tri < triCount; tri++) {
+		const glm::vec3& a = positions[indices[tri * 3 + 0]];
+		const glm::vec3& b = positions[indices[tri * 3 + 1]];
+		const glm::vec3& c = positions[indices[tri * 3 + 2]];
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCenter += (a + b + c) * (area / 3.0f);
+		meshArea += area;
+	}
+	meshCenter = meshArea > 0.0f ? meshCenter / meshArea : meshCenter;
+
+	// Clusters that face away from the center of the mesh are on the outside, and are likely to cover
+	// the rest of the mesh. Drawing them first lets the depth test reject more of what comes after
+	std::vector<float> sortKeys(clusters.size());
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+		size_t begin = clusters[cluster];
+		size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triCount;
+
+		glm::vec3 center = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		float area = 0.0f;
+		for (size_t tri = begin; tri < end; tri++) {
+			const glm::vec3& a = positions[indices[tri * 3 + 0]];
+			const glm::vec3& b = positions[indices[tri * 3 + 1]];
+			const glm::vec3& c = positions[indices[tri * 3 + 2]];
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float triArea = glm::length(cross);
+			center += (a + b + c) * (triArea / 3.0f);
+			normal += cross;
+			area += triArea;
+		}
+		center = area > 0.0f ? center / area : center;
+		float normalLength = glm::length(normal);
+		normal = normalLength > 0.0f ? normal / normalLength : normal;
+
+		sortKeys[cluster] = glm::dot(center - meshCenter, normal);
+	}
+
+	std::vector<uint32_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return sortKeys[a] > sortKeys[b];
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (uint32_t cluster : order) {
+		size_t begin = clusters[cluster];
+		size_t end = cluster + 1 < clusters.size() ? clusters[cluster + 1] : triCount;
+		result.insert(result.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+	}
+	indices = std::move(result);
+}
+
+uint32_t MeshOptimizer::_BuildFetchRemap(const std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& remap) {
+	remap.assign(vertexCount, UINT32_MAX);
+	uint32_t nextIndex = 0;
+	for (uint32_t index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = nextIndex++;
+		}
+	}
+	return nextIndex;
+}
+
+glm::vec2 MeshOptimizer::OctEncode(const glm::vec3& value) {
+	glm::vec3 n = value / (glm::abs(value.x) + glm::abs(value.y) + glm::abs(value.z));
+	glm::vec2 result = glm::vec2(n.x, n.y);
+	// The lower half of the octahedron is folded over the diagonals
+	if (n.z < 0.0f) {
+		result.x = (1.0f - glm::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		result.y = (1.0f - glm::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return result;
+}
+
+glm::vec3 MeshOptimizer::OctDecode(const glm::vec2& value) {
+	glm::vec3 n = glm::vec3(value.x, value.y, 1.0f - glm::abs(value.x) - glm::abs(value.y));
+	float t = glm::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+VertexPackedPosNormTexTangents MeshOptimizer::PackVertex(const VertexPosNormTexColTangents& vertex) {
+	VertexPackedPosNormTexTangents result;
+	result.Position = vertex.Position;
+
+	// Zero length vectors can't be encoded, so we fall back to something valid
+	glm::vec3 normal = glm::length(vertex.Normal) > 0.0f ? vertex.Normal : glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec3 tangent = glm::length(vertex.Tangent) > 0.0f ? vertex.Tangent : glm::vec3(1.0f, 0.0f, 0.0f);
+	glm::vec2 octNormal = OctEncode(normal);
+	glm::vec2 octTangent = OctEncode(tangent);
+	// The shader rebuilds the bitangent as cross(N, T), so we only need to know which way it points
+	float handedness = glm::dot(glm::cross(normal, tangent), vertex.BiTangent) < 0.0f ? -1.0f : 1.0f;
+
+	result.Normal  = glm::i16vec2(ToSnorm16(octNormal.x), ToSnorm16(octNormal.y));
+	result.Tangent = glm::i16vec4(ToSnorm16(octTangent.x), ToSnorm16(octTangent.y), ToSnorm16(1.0f), ToSnorm16(handedness));
+	result.UV      = glm::u16vec2(glm::packHalf1x16(vertex.UV.x), glm::packHalf1x16(vertex.UV.y));
+	return result;
+}
+
+VertexPackedPosNormTexColTangents MeshOptimizer::PackVertexWithColor(const VertexPosNormTexColTangents& vertex) {
+	VertexPackedPosNormTexTangents packed = PackVertex(vertex);
+
+	VertexPackedPosNormTexColTangents result;
+	result.Position = packed.Position;
+	result.Normal   = packed.Normal;
+	result.Tangent  = glm::i16vec4(packed.Tangent.x, packed.Tangent.y, 0, packed.Tangent.w);
+	result.UV       = packed.UV;
+	result.Color    = glm::u8vec4(glm::round(glm::clamp(vertex.Color, 0.0f, 1.0f) * 255.0f));
+	return result;
+}
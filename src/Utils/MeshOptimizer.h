@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/type_precision.hpp>
+
+#include "Graphics/VertexTypes.h"
+
+/// <summary>
+/// Helpers for preparing meshes for rendering, by re-ordering triangles and vertices to make better use
+/// of the GPU's caches, and quantizing vertex attributes to reduce their size
+/// </summary>
+class MeshOptimizer {
+public:
+	MeshOptimizer() = delete;
+
+	/// <summary>
+	/// The size of the post transform vertex cache we optimize for, a fairly conservative value
+	/// since actual GPUs vary a lot
+	/// </summary>
+	static constexpr uint32_t DefaultCacheSize = 16;
+
+	/// <summary>
+	/// Re-orders triangles to improve post transform vertex cache hits, using the Tipsify algorithm
+	/// (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+	/// </summary>
+	/// <param name="indices">The triangle list to re-order in place</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	/// <param name="clusters">If not null, will receive the index of the first triangle in each cluster, for use with OptimizeOverdraw</param>
+	/// <param name="cacheSize">The size of the vertex cache to optimize for</param>
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusters = nullptr, uint32_t cacheSize = DefaultCacheSize);
+
+	/// <summary>
+	/// Re-orders the clusters produced by OptimizeVertexCache so that triangles that are likely to occlude
+	/// others are drawn first, without affecting the vertex cache efficiency within each cluster
+	/// </summary>
+	/// <param name="indices">The triangle list to re-order in place</param>
+	/// <param name="positions">The positions of the vertices</param>
+	/// <param name="clusters">The index of the first triangle in each cluster</param>
+	static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& clusters);
+
+	/// <summary>
+	/// Re-orders vertices so that they are in the order that they are first used by the indices, which
+	/// improves pre transform cache hits. Unused vertices are removed
+	/// </summary>
+	/// <param name="indices">The triangle list, will be updated to use the new vertex indices</param>
+	/// <param name="vertices">The vertices to re-order in place</param>
+	template <typename VertexType>
+	static void OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<VertexType>& vertices);
+
+	/// <summary>
+	/// Encodes a unit vector as a point on an octahedron unfolded to a square, in the range [-1, 1]
+	/// </summary>
+	static glm::vec2 OctEncode(const glm::vec3& value);
+	/// <summary>
+	/// Decodes a unit vector encoded with OctEncode
+	/// </summary>
+	static glm::vec3 OctDecode(const glm::vec2& value);
+
+	/// <summary>
+	/// Quantizes a vertex for version 2 binary meshes
+	/// </summary>
+	/// <param name="vertex">The vertex to quantize</param>
+	static VertexPackedPosNormTexTangents PackVertex(const VertexPosNormTexColTangents& vertex);
+	/// <summary>
+	/// Quantizes a vertex for version 2 binary meshes, keeping it's color
+	/// </summary>
+	/// <param name="vertex">The vertex to quantize</param>
+	static VertexPackedPosNormTexColTangents PackVertexWithColor(const VertexPosNormTexColTangents& vertex);
+
+protected:
+	/// <summary>
+	/// Builds a mapping from old vertex indices to new ones, in order of first use
+	/// </summary>
+	/// <returns>The number of vertices that are used</returns>
+	static uint32_t _BuildFetchRemap(const std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& remap);
+};
+
+template <typename VertexType>
+void MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<VertexType>& vertices) {
+	std::vector<uint32_t> remap;
+	uint32_t usedCount = _BuildFetchRemap(indices, vertices.size(), remap);
+
+	std::vector<VertexType> result(usedCount);
+	for (size_t ix = 0; ix < vertices.size(); ix++) {
+		if (remap[ix] != UINT32_MAX) {
+			result[remap[ix]] = vertices[ix];
+		}
+	}
+	for (uint32_t& index : indices) {
+		index = remap[index];
+	}
+	vertices = std::move(result);
+}
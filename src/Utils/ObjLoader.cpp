@@ -8,23 +8,27 @@
 #include <filesystem>
 
 #include "Utils/StringUtils.h"
+#include "Utils/FileHelpers.h"
 
 VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 {
-	if (!std::filesystem::exists(filename)) {
-		LOG_WARN("Failed to find OBJ file: \"{}\"", filename);
+	std::vector<VertexPosNormTexCol> vertexData;
+	if (!ParseFile(filename, vertexData)) {
 		return nullptr;
 	}
+	return Bake(vertexData);
+}
 
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
-
-	// If our file fails to open, we will throw an error
-	if (!file) {
-		throw std::runtime_error("Failed to open file");
+bool ObjLoader::ParseFile(const std::string& filename, std::vector<VertexPosNormTexCol>& vertexData)
+{
+	if (!FileHelpers::Exists(filename)) {
+		LOG_WARN("Failed to find OBJ file: \"{}\"", filename);
+		return false;
 	}
 
+	// Read the whole file up front (this may come from the asset package)
+	std::istringstream file(FileHelpers::ReadFile(filename));
+
 	std::string line;
 	
 	// TODO: Load data from file
@@ -102,7 +106,8 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 	}
 
 	// TODO: Generate mesh from the data we loaded
-	std::vector<VertexPosNormTexCol> vertexData;
+	vertexData.clear();
+	vertexData.reserve(vertices.size());
 
 	for (int ix = 0; ix < vertices.size(); ix++) {
 		glm::ivec3 attribs = vertices[ix];
@@ -117,6 +122,15 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 		vertexData.push_back(VertexPosNormTexCol(position, normal, uv, color));
 	}
 
+	// Calculate and trace out how long it took us to load
+	float endTime = glfwGetTime();
+	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, vertexData.size(), 0);
+
+	return true;
+}
+
+VertexArrayObject::Sptr ObjLoader::Bake(const std::vector<VertexPosNormTexCol>& vertexData)
+{
 	// Create a vertex buffer and load all our vertex data
 	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create();
 	vertexBuffer->LoadData(vertexData.data(), vertexData.size());
@@ -126,11 +140,6 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 	result->AddVertexBuffer(vertexBuffer, VertexPosNormTexCol::V_DECL);
 
 	result->SetVDecl(VertexPosNormTexCol::V_DECL);
-	
-	// Calculate and trace out how long it took us to load
-	float endTime = glfwGetTime();
-	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, vertexData.size(), 0);
 
 	return result;
-	//return VertexArrayObject::Create();
 }
@@ -8,6 +8,19 @@ class ObjLoader
 public:
 	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
 
+	/// <summary>
+	/// Parses the vertices from an OBJ file, without touching OpenGL. This is safe to call from any thread
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to parse</param>
+	/// <param name="vertices">The list to store the vertices in</param>
+	/// <returns>True if the file was parsed</returns>
+	static bool ParseFile(const std::string& filename, std::vector<VertexPosNormTexCol>& vertices);
+	/// <summary>
+	/// Uploads vertices that were parsed with ParseFile to a new VAO
+	/// </summary>
+	/// <param name="vertices">The vertices to upload</param>
+	static VertexArrayObject::Sptr Bake(const std::vector<VertexPosNormTexCol>& vertices);
+
 protected:
 	ObjLoader() = default;
 	~ObjLoader() = default;
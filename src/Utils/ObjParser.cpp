@@ -0,0 +1,340 @@
+#include "Utils/ObjParser.h"
+
+#include <charconv>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Logging.h"
+
+// Chunks smaller than this aren't worth handing to another thread
+static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+// Marks an empty slot in the deduplication table
+static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+inline bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* SkipSpaces(const char* seek, const char* end) {
+	while (seek < end && IsSpace(*seek)) {
+		seek++;
+	}
+	return seek;
+}
+
+/// <summary>
+/// Parses up to count floats separated by whitespace, leaving any that are missing as 0
+/// </summary>
+inline const char* ParseFloats(const char* seek, const char* end, float* result, int count) {
+	for (int ix = 0; ix < count; ix++) {
+		seek = SkipSpaces(seek, end);
+		// from_chars doesn't accept a leading plus sign
+		if (seek < end && *seek == '+') {
+			seek++;
+		}
+		std::from_chars_result parsed = std::from_chars(seek, end, result[ix]);
+		if (parsed.ec != std::errc()) {
+			result[ix] = 0.0f;
+			return seek;
+		}
+		seek = parsed.ptr;
+	}
+	return seek;
+}
+
+/// <summary>
+/// Parses an integer, leaving the result as 0 if there is no number at the cursor
+/// </summary>
+inline const char* ParseInt(const char* seek, const char* end, int& result) {
+	result = 0;
+	std::from_chars_result parsed = std::from_chars(seek, end, result);
+	return parsed.ec == std::errc() ? parsed.ptr : seek;
+}
+
+inline uint32_t HashCorner(const glm::ivec3& corner) {
+	uint64_t hash = (uint64_t)(uint32_t)corner.x * 0x9E3779B97F4A7C15ull;
+	hash ^= (uint64_t)(uint32_t)corner.y * 0xC2B2AE3D27D4EB4Full;
+	hash ^= (uint64_t)(uint32_t)corner.z * 0x165667B19E3779F9ull;
+	return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+void ObjMeshData::Clear() {
+	Positions.clear();
+	UVs.clear();
+	Normals.clear();
+	Vertices.clear();
+	Indices.clear();
+}
+
+bool ObjParser::ParseFile(const std::string& filename, ObjMeshData& result, bool multithreaded) {
+	// Mapping lets the OS page the file in as we go, and works for files in the asset package
+	MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
+	if (file == nullptr) {
+		LOG_WARN("Failed to open OBJ file: \"{}\"", filename);
+		return false;
+	}
+
+	typedef std::chrono::high_resolution_clock Clock;
+	auto startTime = Clock::now();
+
+	Parse(reinterpret_cast<const char*>(file->GetData()), file->GetSize(), result, multithreaded);
+
+	std::chrono::duration<float> elapsed = Clock::now() - startTime;
+	LOG_TRACE("Parsed OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, elapsed.count(), result.Vertices.size(), result.Indices.size());
+	return true;
+}
+
+void ObjParser::Parse(const char* data, size_t size, ObjMeshData& result, bool multithreaded) {
+	result.Clear();
+
+	// Skip the byte order mark if the file has one
+	if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+		data += 3;
+		size -= 3;
+	}
+
+	// One chunk per thread (including this one), as long as the chunks are big enough
+	size_t numChunks = 1;
+	if (multithreaded) {
+		numChunks = std::max<size_t>(1, std::min<size_t>(ThreadPool::Get().GetThreadCount() + 1, size / MIN_CHUNK_SIZE));
+	}
+
+	// Split the file into roughly even chunks, moving each boundary forward to the start of the next line
+	const char* end = data + size;
+	std::vector<const char*> bounds(numChunks + 1);
+	bounds[0] = data;
+	bounds[numChunks] = end;
+	for (size_t ix = 1; ix < numChunks; ix++) {
+		const char* split = std::max(data + (size * ix) / numChunks, bounds[ix - 1]);
+		const char* newline = static_cast<const char*>(memchr(split, '\n', end - split));
+		bounds[ix] = newline != nullptr ? newline + 1 : end;
+	}
+
+	std::vector<Chunk> chunks(numChunks);
+	auto parseChunks = [&](size_t begin, size_t last) {
+		for (size_t ix = begin; ix < last; ix++) {
+			_ParseChunk(bounds[ix], bounds[ix + 1], chunks[ix]);
+		}
+	};
+	ThreadPool::Get().ParallelFor(numChunks, 1, parseChunks);
+
+	// Work out where each chunk's data lands in the merged lists
+	std::vector<glm::ivec4> offsets(numChunks + 1, glm::ivec4(0));
+	for (size_t ix = 0; ix < numChunks; ix++) {
+		offsets[ix + 1] = offsets[ix] + glm::ivec4(
+			(int)chunks[ix].Positions.size(),
+			(int)chunks[ix].UVs.size(),
+			(int)chunks[ix].Normals.size(),
+			(int)chunks[ix].Corners.size()
+		);
+	}
+	result.Positions.resize(offsets[numChunks].x);
+	result.UVs.resize(offsets[numChunks].y);
+	result.Normals.resize(offsets[numChunks].z);
+	std::vector<glm::ivec3> corners(offsets[numChunks].w);
+
+	// Each chunk writes to it's own range, so the merge can also be done in parallel
+	auto mergeChunks = [&](size_t begin, size_t last) {
+		for (size_t ix = begin; ix < last; ix++) {
+			Chunk& chunk = chunks[ix];
+			const glm::ivec4& offset = offsets[ix];
+			std::copy(chunk.Positions.begin(), chunk.Positions.end(), result.Positions.begin() + offset.x);
+			std::copy(chunk.UVs.begin(), chunk.UVs.end(), result.UVs.begin() + offset.y);
+			std::copy(chunk.Normals.begin(), chunk.Normals.end(), result.Normals.begin() + offset.z);
+
+			// Relative indices become absolute now that we know how many attributes came before this chunk
+			for (uint32_t component : chunk.RelativeComponents) {
+				chunk.Corners[component / 3][component % 3] += offset[component % 3];
+			}
+			std::copy(chunk.Corners.begin(), chunk.Corners.end(), corners.begin() + offset.w);
+
+			// Free the chunk's memory as we go, large files can have a lot of it
+			chunk = Chunk();
+		}
+	};
+	ThreadPool::Get().ParallelFor(numChunks, 1, mergeChunks);
+
+	_Deduplicate(corners, result);
+}
+
+void ObjParser::_ParseChunk(const char* seek, const char* end, Chunk& chunk) {
+	// The corners of the polygon on the current line, and which of their components are relative
+	std::vector<std::pair<glm::ivec3, uint8_t>> polygon;
+	polygon.reserve(8);
+
+	while (seek < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(seek, '\n', end - seek));
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+
+		const char* cursor = SkipSpaces(seek, lineEnd);
+		size_t length = lineEnd - cursor;
+
+		// Position
+		if (length > 1 && cursor[0] == 'v' && IsSpace(cursor[1])) {
+			glm::vec3 value;
+			ParseFloats(cursor + 2, lineEnd, &value.x, 3);
+			chunk.Positions.push_back(value);
+		}
+		// Texture coordinate
+		else if (length > 2 && cursor[0] == 'v' && cursor[1] == 't' && IsSpace(cursor[2])) {
+			glm::vec2 value;
+			ParseFloats(cursor + 3, lineEnd, &value.x, 2);
+			chunk.UVs.push_back(value);
+		}
+		// Normal
+		else if (length > 2 && cursor[0] == 'v' && cursor[1] == 'n' && IsSpace(cursor[2])) {
+			glm::vec3 value;
+			ParseFloats(cursor + 3, lineEnd, &value.x, 3);
+			chunk.Normals.push_back(value);
+		}
+		// Face, made up of v, v/vt, v//vn or v/vt/vn corners
+		else if (length > 1 && cursor[0] == 'f' && IsSpace(cursor[1])) {
+			polygon.clear();
+			cursor += 2;
+			const int counts[3] = { (int)chunk.Positions.size(), (int)chunk.UVs.size(), (int)chunk.Normals.size() };
+
+			while ((cursor = SkipSpaces(cursor, lineEnd)) < lineEnd) {
+				const char* start = cursor;
+				int values[3] = { 0, 0, 0 };
+				cursor = ParseInt(cursor, lineEnd, values[0]);
+				for (int component = 1; component < 3 && cursor < lineEnd && *cursor == '/'; component++) {
+					cursor = ParseInt(cursor + 1, lineEnd, values[component]);
+				}
+
+				// Skip over anything we couldn't make sense of
+				if (cursor == start) {
+					while (cursor < lineEnd && !IsSpace(*cursor)) {
+						cursor++;
+					}
+					continue;
+				}
+
+				// OBJ indices are 1 based, negative indices count back from the most recent attribute
+				glm::ivec3 corner(-1);
+				uint8_t relative = 0;
+				for (int component = 0; component < 3; component++) {
+					if (values[component] > 0) {
+						corner[component] = values[component] - 1;
+					}
+					else if (values[component] < 0) {
+						corner[component] = counts[component] + values[component];
+						relative |= 1 << component;
+					}
+				}
+				polygon.emplace_back(corner, relative);
+			}
+
+			// Triangulate as a fan around the first corner
+			for (size_t ix = 2; ix < polygon.size(); ix++) {
+				for (size_t corner : { (size_t)0, ix - 1, ix }) {
+					uint32_t cornerIndex = static_cast<uint32_t>(chunk.Corners.size());
+					chunk.Corners.push_back(polygon[corner].first);
+					for (int component = 0; component < 3; component++) {
+						if (polygon[corner].second & (1 << component)) {
+							chunk.RelativeComponents.push_back(cornerIndex * 3 + component);
+						}
+					}
+				}
+			}
+		}
+		// Anything else (comments, groups, materials, etc...) is ignored
+
+		seek = lineEnd + 1;
+	}
+}
+
+void ObjParser::_Deduplicate(const std::vector<glm::ivec3>& corners, ObjMeshData& result) {
+	const glm::ivec3 counts = glm::ivec3((int)result.Positions.size(), (int)result.UVs.size(), (int)result.Normals.size());
+
+	// Every corner could be unique, keeping the table at most half full keeps the probes short
+	size_t capacity = 16;
+	while (capacity < corners.size() * 2) {
+		capacity <<= 1;
+	}
+	const size_t mask = capacity - 1;
+	std::vector<uint32_t> table(capacity, EMPTY_SLOT);
+
+	result.Vertices.reserve(corners.size() / 2);
+	result.Indices.reserve(corners.size());
+
+	for (size_t tri = 0; tri + 2 < corners.size(); tri += 3) {
+		// Drop triangles that are missing a position, there's nothing we can draw for them
+		bool isValid = true;
+		for (size_t ix = tri; ix < tri + 3; ix++) {
+			isValid &= corners[ix].x >= 0 && corners[ix].x < counts.x;
+		}
+		if (!isValid) {
+			continue;
+		}
+
+		for (size_t ix = tri; ix < tri + 3; ix++) {
+			glm::ivec3 corner = corners[ix];
+			// UVs and normals are optional, so out of range ones are just treated as missing
+			if (corner.y >= counts.y) { corner.y = -1; }
+			if (corner.z >= counts.z) { corner.z = -1; }
+			corner = glm::max(corner, glm::ivec3(-1));
+
+			size_t slot = HashCorner(corner) & mask;
+			while (table[slot] != EMPTY_SLOT && result.Vertices[table[slot]] != corner) {
+				slot = (slot + 1) & mask;
+			}
+			if (table[slot] == EMPTY_SLOT) {
+				table[slot] = static_cast<uint32_t>(result.Vertices.size());
+				result.Vertices.push_back(corner);
+			}
+			result.Indices.push_back(table[slot]);
+		}
+	}
+}
+
+ObjParser::BenchmarkResult ObjParser::Benchmark(const std::string& filename, int iterations) {
+	typedef std::chrono::high_resolution_clock Clock;
+	BenchmarkResult result = BenchmarkResult();
+
+	// Runs a function the given number of times, returning the fastest time in seconds
+	auto time = [iterations](const std::function<void()>& func) {
+		double best = std::numeric_limits<double>::max();
+		for (int ix = 0; ix < std::max(iterations, 1); ix++) {
+			auto start = Clock::now();
+			func();
+			std::chrono::duration<double> elapsed = Clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	};
+
+	result.ObjLoaderTime = time([&]() {
+		std::vector<VertexPosNormTexCol> vertices;
+		ObjLoader::ParseFile(filename, vertices);
+	});
+	result.OptimizedLoaderTime = time([&]() {
+		delete OptimizedObjLoader::_LoadFromObjFile(filename);
+	});
+
+	ObjMeshData mesh;
+	result.SingleThreadedTime = time([&]() {
+		ParseFile(filename, mesh, false);
+	});
+	result.MultiThreadedTime = time([&]() {
+		ParseFile(filename, mesh, true);
+	});
+	result.NumVertices = mesh.Vertices.size();
+	result.NumIndices = mesh.Indices.size();
+
+	LOG_INFO("OBJ parser benchmark for \"{}\" ({} vertices, {} indices, best of {}):", filename, result.NumVertices, result.NumIndices, iterations);
+	LOG_INFO("\tObjLoader:              {:.4f}s", result.ObjLoaderTime);
+	LOG_INFO("\tOptimizedObjLoader:     {:.4f}s", result.OptimizedLoaderTime);
+	LOG_INFO("\tObjParser (1 thread):   {:.4f}s ({:.1f}x)", result.SingleThreadedTime, result.ObjLoaderTime / result.SingleThreadedTime);
+	LOG_INFO("\tObjParser ({} threads): {:.4f}s ({:.1f}x)", ThreadPool::Get().GetThreadCount() + 1, result.MultiThreadedTime, result.ObjLoaderTime / result.MultiThreadedTime);
+
+	return result;
+}
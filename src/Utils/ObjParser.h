@@ -0,0 +1,126 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+#include "Utils/MeshBuilder.h"
+
+/// <summary>
+/// The geometry from an OBJ file, with duplicate vertices merged
+/// </summary>
+struct ObjMeshData {
+	std::vector<glm::vec3>  Positions;
+	std::vector<glm::vec2>  UVs;
+	std::vector<glm::vec3>  Normals;
+	// The unique combinations of position, UV and normal indices used by the faces (0 based, -1 if missing)
+	std::vector<glm::ivec3> Vertices;
+	// Indices into Vertices, 3 per triangle. Polygons with more than 3 sides are triangulated as a fan
+	std::vector<uint32_t>   Indices;
+
+	/// <summary>
+	/// Removes all data from the mesh
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Adds the vertices and indices to a mesh builder, the vertex type must have
+	/// Position, Normal, UV and Color fields
+	/// </summary>
+	/// <param name="mesh">The mesh to add the data to</param>
+	/// <param name="color">The color to give all vertices</param>
+	template <typename VertexType>
+	void ToMesh(MeshBuilder<VertexType>& mesh, const glm::vec4& color = glm::vec4(1.0f)) const;
+};
+
+/// <summary>
+/// A fast OBJ parser, for large files that take too long with the stream based loaders
+///
+/// The file is memory mapped and split into line aligned chunks, which are parsed in parallel
+/// on the thread pool using std::from_chars. The chunks are then merged, and duplicate vertices
+/// are removed with an open addressing hash table
+/// </summary>
+class ObjParser {
+public:
+	ObjParser() = delete;
+
+	/// <summary>
+	/// The timings from comparing the parsers against each other, in seconds
+	/// </summary>
+	struct BenchmarkResult {
+		// ObjLoader::ParseFile
+		double ObjLoaderTime;
+		// OptimizedObjLoader's OBJ parsing (includes it's tangent calculation)
+		double OptimizedLoaderTime;
+		// This parser running on a single thread
+		double SingleThreadedTime;
+		// This parser using the thread pool
+		double MultiThreadedTime;
+		// The size of the parsed mesh
+		size_t NumVertices;
+		size_t NumIndices;
+	};
+
+	/// <summary>
+	/// Parses an OBJ file, without touching OpenGL. Safe to call from any thread
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to parse</param>
+	/// <param name="result">The mesh data to store the results in</param>
+	/// <param name="multithreaded">True to split the work across the thread pool</param>
+	/// <returns>True if the file could be read</returns>
+	static bool ParseFile(const std::string& filename, ObjMeshData& result, bool multithreaded = true);
+	/// <summary>
+	/// Parses OBJ data that is already in memory
+	/// </summary>
+	/// <param name="data">The text of the OBJ file</param>
+	/// <param name="size">The number of bytes in data</param>
+	/// <param name="result">The mesh data to store the results in</param>
+	/// <param name="multithreaded">True to split the work across the thread pool</param>
+	static void Parse(const char* data, size_t size, ObjMeshData& result, bool multithreaded = true);
+
+	/// <summary>
+	/// Times ObjLoader, OptimizedObjLoader and this parser (single and multithreaded) parsing the given
+	/// file, and logs the results. Only the CPU side parsing is measured, no OpenGL objects are created
+	/// </summary>
+	/// <param name="filename">The OBJ file to parse</param>
+	/// <param name="iterations">The number of times to parse the file with each loader, the fastest time is reported</param>
+	static BenchmarkResult Benchmark(const std::string& filename, int iterations = 3);
+
+protected:
+	// The results of parsing a single chunk of the file
+	struct Chunk {
+		std::vector<glm::vec3>  Positions;
+		std::vector<glm::vec2>  UVs;
+		std::vector<glm::vec3>  Normals;
+		// 3 per triangle, 0 based. Negative OBJ indices are stored relative to the start of the chunk
+		std::vector<glm::ivec3> Corners;
+		// The components of Corners that are relative (corner * 3 + component), fixed up once we know the offsets
+		std::vector<uint32_t>   RelativeComponents;
+	};
+
+	/// <summary>
+	/// Parses the lines in [begin, end), which must start at the beginning of a line
+	/// </summary>
+	static void _ParseChunk(const char* begin, const char* end, Chunk& chunk);
+	/// <summary>
+	/// Merges identical corners into unique vertices, and builds the index list. Triangles that
+	/// reference positions that don't exist are dropped
+	/// </summary>
+	static void _Deduplicate(const std::vector<glm::ivec3>& corners, ObjMeshData& result);
+};
+
+template <typename VertexType>
+void ObjMeshData::ToMesh(MeshBuilder<VertexType>& mesh, const glm::vec4& color) const {
+	// Our indices need to be offset if the mesh already has vertices in it
+	uint32_t baseVertex = static_cast<uint32_t>(mesh.GetVertexCount());
+	mesh.ReserveVertexSpace(Vertices.size());
+	for (const glm::ivec3& attribs : Vertices) {
+		VertexType vertex;
+		vertex.Position = Positions[attribs.x];
+		vertex.UV       = attribs.y >= 0 ? UVs[attribs.y] : glm::vec2(0.0f);
+		vertex.Normal   = attribs.z >= 0 ? Normals[attribs.z] : glm::vec3(0.0f, 0.0f, 1.0f);
+		vertex.Color    = color;
+		mesh.AddVertex(vertex);
+	}
+	mesh.AddIndexRange(Indices, baseVertex);
+}
@@ -7,8 +7,15 @@
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <cstring>
+#include <algorithm>
 
 #include "Utils/StringUtils.h"
+#include "Utils/FileHelpers.h"
+#include "Utils/AssetPackage.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/ThreadPool.h"
 #include "GLFW/glfw3.h"
 #include "Logging.h"
 
@@ -17,7 +24,10 @@ const std::string binaryExtension = ".bin";
 
 namespace fs = std::filesystem;
 
-VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename) {
+std::mutex OptimizedObjLoader::_conversionMutex;
+std::unordered_set<std::string> OptimizedObjLoader::_pendingConversions;
+
+VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& filename, MeshCpuData::Sptr* cpuData) {
 	// Get the file extension and lowercase it
 	fs::path filePath = std::filesystem::path(filename);
 	std::string extension = filePath.extension().string();
@@ -26,17 +36,31 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	// Load regular 'ol OBJ files
 	if (extension == ".obj") {
 		// Get the binary path
-		fs::path binPath = filePath.replace_extension(binaryExtension);
-		// If the file does not exist, convert the OBJ file to a binary file
-		if (!fs::exists(binPath)) {
-			ConvertToBinary(filename, binPath.string());
+		std::string binPath = fs::path(filename).replace_extension(binaryExtension).string();
+
+		// If the binary was built from this version of the OBJ, we can use it as is
+		{
+			MemoryMappedFile::Sptr binFile = MemoryMappedFile::Map(binPath);
+			if (binFile != nullptr && _IsBinaryCurrent(binFile, filename)) {
+				return _LoadFromBinFile(binFile, binPath, cpuData);
+			}
 		}
-		// Load the corresponding binary file
-		return _LoadFromBinFile(binPath.string());
+
+		// Otherwise we load the OBJ this time, and write a new binary in the background for next time. The source
+		// info is taken first so that an edit made while we're loading will be caught on the next load
+		SourceInfo source;
+		_GetSourceInfo(filename, source);
+		std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>> mesh(_LoadFromObjFile(filename));
+		VertexArrayObject::Sptr result = mesh->Bake();
+		if (cpuData != nullptr) {
+			*cpuData = MeshCpuData::FromBuilder(*mesh);
+		}
+		_QueueConversion(mesh, binPath, source);
+		return result;
 	} 
 	// Load our fancy binary files
 	else if (extension == ".bin") {
-		return _LoadFromBinFile(filename);
+		return _LoadFromBinFile(filename, cpuData);
 	}
 	// We've never met this extension in our life
 	else {
@@ -45,7 +69,16 @@ VertexArrayObject::Sptr OptimizedObjLoader::LoadFromFile(const std::string& file
 	}
 }
 
+bool OptimizedObjLoader::IsBinaryCurrent(const std::string& filename) {
+	MemoryMappedFile::Sptr binFile = MemoryMappedFile::Map(fs::path(filename).replace_extension(binaryExtension).string());
+	return binFile != nullptr && _IsBinaryCurrent(binFile, filename);
+}
+
 void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::string& outFile) {
+	// Get the source info before we load, in case the file changes while we're working
+	SourceInfo source;
+	_GetSourceInfo(inFile, source);
+
 	// Load in the input file
 	MeshBuilder<VertexPosNormTexColTangents>* mesh = _LoadFromObjFile(inFile);
 
@@ -63,7 +96,7 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 	}
 
 	// Save the mesh to the file
-	SaveBinaryFile(*mesh, outFileName);
+	_WritePackedBinaryFile(*mesh, outFileName, source);
 
 	float endTime = static_cast<float>(glfwGetTime());
 	LOG_TRACE("Converted OBJ file to binary \"{}\" in {} seconds ({} vertices, {} indices)", inFile, endTime - startTime, mesh->GetVertexCount(), mesh->GetIndexCount());
@@ -73,15 +106,14 @@ void OptimizedObjLoader::ConvertToBinary(const std::string& inFile, const std::s
 }
 
 MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(const std::string& filename) {
-	// Open our file in binary mode
-	std::ifstream file;
-	file.open(filename, std::ios::binary);
-
-	// If our file fails to open, we will throw an error
-	if (!file) {
+	// If our file does not exist, we will throw an error
+	if (!FileHelpers::Exists(filename)) {
 		throw std::runtime_error("Failed to open file");
 	}
 
+	// Read the whole file up front (this may come from the asset package)
+	std::istringstream file(FileHelpers::ReadFile(filename));
+
 	// Could also take this in as a parameter
 	glm::vec4 color = glm::vec4(1.0f);
 
@@ -233,81 +265,90 @@ MeshBuilder<VertexPosNormTexColTangents>* OptimizedObjLoader::_LoadFromObjFile(c
 	return mesh;
 }
 
-VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename) {
-
-	// Open the output file
-	std::ifstream file(filename, std::ios::binary);
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string& filename, MeshCpuData::Sptr* cpuData) {
+	// Map the file, this lets us hand the data straight to OpenGL (and serve it from the asset package)
+	MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
 	// If our file fails to open, we will throw an error
-	if (!file) { throw std::runtime_error("Failed to open file"); }
+	if (file == nullptr) { throw std::runtime_error("Failed to open file"); }
+
+	return _LoadFromBinFile(file, filename, cpuData);
+}
 
+VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const MemoryMappedFile::Sptr& file, const std::string& filename, MeshCpuData::Sptr* cpuData) {
 	float startTime = static_cast<float>(glfwGetTime());
 
 	// Get the file size so we can avoid reading past the end
-	file.seekg(0, std::ios::end);
-	size_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+	const uint8_t* data = file->GetData();
+	size_t size = file->GetSize();
 
 	// Read the header from the file
 	BinaryHeader header = BinaryHeader();
 	if (size >= sizeof(BinaryHeader)) {
-		file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+		memcpy(&header, data, sizeof(BinaryHeader));
 	} else {
 		LOG_ERROR("Not enough data in the file!");
 		return nullptr;
 	}
 
-	// TODO: validate header
+	// Make sure this is actually one of our files
+	if (memcmp(header.HeaderBytes, HEADER_BYTES, sizeof(HEADER_BYTES)) != 0) {
+		LOG_ERROR("\"{}\" is not a binary mesh file!", filename);
+		return nullptr;
+	}
+
+	// Version 2 has the same layout as version 1, except that the vertex data is aligned to 4 bytes
+	// (it may follow 16 bit indices). The packed vertex format is described by the attributes. Version 3
+	// adds the source info after the header
+	if (header.Version >= 0x01 && header.Version <= 0x03) {
+		size_t indexBytes = header.NumIndices * GetIndexTypeSize(header.IndicesType);
+		size_t indexPadding = header.Version >= 0x02 ? (4 - indexBytes % 4) % 4 : 0;
+		size_t sourceInfoBytes = header.Version >= 0x03 ? sizeof(SourceInfo) : 0;
 
-	// Handle our version
-	if (header.Version == 0x01) {
 		// Determine how many bytes we need in the file
 		size_t requiredBytes =
 			sizeof(BinaryHeader) +
+			sourceInfoBytes +
 			(header.NumAttributes * sizeof(BufferAttribute)) +
 			(header.VertexStride * (size_t)header.NumVertices) +
-			(header.NumIndices * GetIndexTypeSize(header.IndicesType));
+			indexBytes + indexPadding;
 
 		// Make sure there's enough data in the file
 		if (size < requiredBytes) {
 			LOG_ERROR("Not enough data in the file!");
 			return nullptr;
 		}
+		const uint8_t* seek = data + sizeof(BinaryHeader) + sourceInfoBytes;
 
 		// Read all attributes from the file, this is basically our VDECL
 		std::vector<BufferAttribute> vertexDeclaration;
 		vertexDeclaration.resize(header.NumAttributes);
-		for (int ix = 0; ix < header.NumAttributes; ix++) {
-			file.read(reinterpret_cast<char*>(&vertexDeclaration[ix]), sizeof(BufferAttribute));
-		}
+		memcpy(vertexDeclaration.data(), seek, header.NumAttributes * sizeof(BufferAttribute));
+		seek += header.NumAttributes * sizeof(BufferAttribute);
 
 		// These will have the buffer pointers
 		IndexBuffer::Sptr indices = nullptr;
 		VertexBuffer::Sptr vertices = nullptr;
 
+		// Copy the positions and indices out of the file while it's mapped, if the caller wants to keep them
+		if (cpuData != nullptr) {
+			*cpuData = _ReadCpuData(seek, header, vertexDeclaration);
+		}
+
 		// If we have index data, load it
 		if (header.NumIndices > 0) {
 			// Create index buffer
 			indices = IndexBuffer::Create(BufferUsage::StaticDraw);
 
-			// Create memory to store indices, then read from the file
-			void* dataStore = malloc(header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			file.read(reinterpret_cast<char*>(dataStore), header.NumIndices * GetIndexTypeSize(header.IndicesType));
-			
-			// Load data into OpenGL and free the CPU memory we allocated
-			indices->LoadData(dataStore, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
-			free(dataStore);
+			// Load data into immutable storage directly from the mapped file, no intermediate copies needed
+			indices->LoadStorage(seek, GetIndexTypeSize(header.IndicesType), header.NumIndices, header.IndicesType);
+			seek += indexBytes + indexPadding;
 		}
 
 		// Create a new VBO
 		vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
 
-		// Create memory to store vertices and load from file
-		void* vertexStore = malloc(header.NumVertices * (size_t)header.VertexStride);
-		file.read(reinterpret_cast<char*>(vertexStore), header.NumVertices * (size_t)header.VertexStride);
-
-		// Load data into OpenGL and free the CPU copy
-		vertices->LoadData(vertexStore, header.VertexStride, header.NumVertices);
-		free(vertexStore);
+		// Load data into immutable storage directly from the mapped file
+		vertices->LoadStorage(seek, header.VertexStride, header.NumVertices);
 
 		// Create the VAO and attach our index and vertex buffers
 		VertexArrayObject::Sptr result = VertexArrayObject::Create();
@@ -324,5 +365,268 @@ VertexArrayObject::Sptr OptimizedObjLoader::_LoadFromBinFile(const std::string&
 		return result;
 	}
 
+	LOG_ERROR("Unsupported binary mesh version {} in \"{}\"", header.Version, filename);
 	return nullptr;
 }
+
+MeshCpuData::Sptr OptimizedObjLoader::_ReadCpuData(const uint8_t* data, const BinaryHeader& header, const std::vector<BufferAttribute>& vertexDeclaration) {
+	auto posAttrib = std::find_if(vertexDeclaration.begin(), vertexDeclaration.end(), [](const BufferAttribute& attrib) {
+		return attrib.Usage == AttribUsage::Position && attrib.Type == AttributeType::Float && attrib.Size == 3;
+	});
+	if (posAttrib == vertexDeclaration.end()) {
+		LOG_WARN("Binary mesh does not have float positions, not keeping CPU data");
+		return nullptr;
+	}
+
+	MeshCpuData::Sptr result = std::make_shared<MeshCpuData>();
+
+	// Indices come first, followed by padding in versions 2 and up
+	size_t indexSize = GetIndexTypeSize(header.IndicesType);
+	size_t indexBytes = header.NumIndices * indexSize;
+	result->Indices.resize(header.NumIndices);
+	for (size_t ix = 0; ix < header.NumIndices; ix++) {
+		switch (header.IndicesType) {
+			case IndexType::UByte:
+				result->Indices[ix] = data[ix];
+				break;
+			case IndexType::UShort: {
+				uint16_t index;
+				memcpy(&index, data + ix * sizeof(uint16_t), sizeof(uint16_t));
+				result->Indices[ix] = index;
+				break;
+			}
+			default:
+				memcpy(&result->Indices[ix], data + ix * sizeof(uint32_t), sizeof(uint32_t));
+				break;
+		}
+	}
+	const uint8_t* vertices = data + indexBytes + (header.Version >= 0x02 ? (4 - indexBytes % 4) % 4 : 0);
+
+	result->Positions.resize(header.NumVertices);
+	for (size_t ix = 0; ix < header.NumVertices; ix++) {
+		memcpy(&result->Positions[ix], vertices + ix * header.VertexStride + posAttrib->Offset, sizeof(glm::vec3));
+	}
+
+	// Meshes without indices are a plain triangle list
+	if (result->Indices.empty()) {
+		result->Indices.resize(header.NumVertices);
+		for (uint32_t ix = 0; ix < header.NumVertices; ix++) {
+			result->Indices[ix] = ix;
+		}
+	}
+	return result;
+}
+
+void OptimizedObjLoader::ConvertIfStale(const std::string& filename) {
+	// Claim the file the same way queued conversions do, so we never write the same binary twice at once
+	std::string binPath = fs::path(filename).replace_extension(binaryExtension).string();
+	{
+		std::lock_guard<std::mutex> lock(_conversionMutex);
+		if (!_pendingConversions.insert(binPath).second) {
+			return;
+		}
+	}
+
+	try {
+		if (!IsBinaryCurrent(filename)) {
+			ConvertToBinary(filename, binPath);
+		}
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(_conversionMutex);
+		_pendingConversions.erase(binPath);
+		throw;
+	}
+
+	std::lock_guard<std::mutex> lock(_conversionMutex);
+	_pendingConversions.erase(binPath);
+}
+
+bool OptimizedObjLoader::_GetSourceInfo(const std::string& filename, SourceInfo& info) {
+	fs::file_time_type writeTime;
+	uintmax_t size;
+	if (!FileHelpers::GetFileInfo(filename, writeTime, size) || !FileHelpers::HashFile(filename, info.Hash)) {
+		info = SourceInfo();
+		return false;
+	}
+	info.Size = static_cast<uint64_t>(size);
+	info.WriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+	return true;
+}
+
+bool OptimizedObjLoader::_IsBinaryCurrent(const MemoryMappedFile::Sptr& file, const std::string& objFilename) {
+	if (file->GetSize() < sizeof(BinaryHeader) + sizeof(SourceInfo)) {
+		return false;
+	}
+	BinaryHeader header;
+	memcpy(&header, file->GetData(), sizeof(BinaryHeader));
+	if (memcmp(header.HeaderBytes, HEADER_BYTES, sizeof(HEADER_BYTES)) != 0) {
+		return false;
+	}
+
+	fs::file_time_type writeTime;
+	uintmax_t size;
+	// Without the OBJ (ex: only the binary was shipped) the binary is all we've got
+	if (!FileHelpers::GetFileInfo(objFilename, writeTime, size)) {
+		return true;
+	}
+	// Older versions don't know what they were built from, so we rebuild them
+	if (header.Version < 0x03) {
+		return false;
+	}
+
+	SourceInfo stored;
+	memcpy(&stored, file->GetData() + sizeof(BinaryHeader), sizeof(SourceInfo));
+	if (stored.Size != static_cast<uint64_t>(size)) {
+		return false;
+	}
+	if (stored.WriteTime == static_cast<int64_t>(writeTime.time_since_epoch().count())) {
+		return true;
+	}
+
+	// The file has been touched, but the contents may be the same (ex: a checkout or a save with no changes)
+	uint64_t hash;
+	if (!FileHelpers::HashFile(objFilename, hash) || hash != stored.Hash) {
+		return false;
+	}
+
+	// Store the new write time, so that we don't have to hash the file again on every load. Packed binaries
+	// can't be changed, and the loose file next to them (if any) may not be the one we just checked
+	stored.WriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+	if (!AssetPackage::Contains(file->GetFilename())) {
+		_UpdateSourceInfo(file->GetFilename(), stored);
+	}
+	return true;
+}
+
+void OptimizedObjLoader::_UpdateSourceInfo(const std::string& filename, const SourceInfo& source) {
+	// Only the source info changes, so we can patch it in place rather than writing the whole file again
+	std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+	if (file) {
+		file.seekp(sizeof(BinaryHeader));
+		file.write(reinterpret_cast<const char*>(&source), sizeof(SourceInfo));
+	}
+	if (!file) {
+		LOG_TRACE("Could not update the source info of \"{}\"", filename);
+	}
+}
+
+void OptimizedObjLoader::_QueueConversion(const std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>>& mesh, const std::string& outFilename, const SourceInfo& source) {
+	{
+		std::lock_guard<std::mutex> lock(_conversionMutex);
+		if (!_pendingConversions.insert(outFilename).second) {
+			return;
+		}
+	}
+
+	ThreadPool::Get().Enqueue([mesh, outFilename, source]() {
+		try {
+			_WritePackedBinaryFile(*mesh, outFilename, source);
+			LOG_TRACE("Rebuilt binary mesh \"{}\"", outFilename);
+		}
+		catch (const std::exception& e) {
+			LOG_WARN("Failed to write binary mesh \"{}\": {}", outFilename, e.what());
+		}
+
+		std::lock_guard<std::mutex> lock(_conversionMutex);
+		_pendingConversions.erase(outFilename);
+	});
+}
+
+void OptimizedObjLoader::SavePackedBinaryFile(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, const std::string& sourceFile) {
+	SourceInfo source;
+	if (!sourceFile.empty()) {
+		_GetSourceInfo(sourceFile, source);
+	}
+	_WritePackedBinaryFile(mesh, outFilename, source);
+}
+
+void OptimizedObjLoader::SavePackedBinaryFileAsync(const std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>>& mesh, const std::string& outFilename) {
+	_QueueConversion(mesh, outFilename, SourceInfo());
+}
+
+void OptimizedObjLoader::_WritePackedBinaryFile(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, const SourceInfo& source) {
+	std::vector<VertexPosNormTexColTangents> vertices(mesh.GetVertexDataPtr(), mesh.GetVertexDataPtr() + mesh.GetVertexCount());
+	std::vector<uint32_t> indices(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+
+	// Meshes without indices are just a list of triangles
+	if (indices.empty()) {
+		indices.resize(vertices.size());
+		for (uint32_t ix = 0; ix < indices.size(); ix++) {
+			indices[ix] = ix;
+		}
+	}
+
+	// Re-order the triangles, then the vertices to match the new triangle order
+	std::vector<uint32_t> clusters;
+	MeshOptimizer::OptimizeVertexCache(indices, vertices.size(), &clusters);
+	std::vector<glm::vec3> positions(vertices.size());
+	for (size_t ix = 0; ix < vertices.size(); ix++) {
+		positions[ix] = vertices[ix].Position;
+	}
+	MeshOptimizer::OptimizeOverdraw(indices, positions, clusters);
+	MeshOptimizer::OptimizeVertexFetch(indices, vertices);
+
+	// Most OBJ meshes are plain white, in which case we can skip storing the color
+	bool hasColor = std::any_of(vertices.begin(), vertices.end(), [](const VertexPosNormTexColTangents& vertex) {
+		return vertex.Color != glm::vec4(1.0f);
+	});
+
+	std::vector<uint8_t> vertexData;
+	const std::vector<BufferAttribute>* vertexDeclaration = nullptr;
+	uint16_t stride = 0;
+	if (hasColor) {
+		stride = sizeof(VertexPackedPosNormTexColTangents);
+		vertexDeclaration = &VertexPackedPosNormTexColTangents::V_DECL;
+		vertexData.resize(vertices.size() * stride);
+		for (size_t ix = 0; ix < vertices.size(); ix++) {
+			VertexPackedPosNormTexColTangents packed = MeshOptimizer::PackVertexWithColor(vertices[ix]);
+			memcpy(vertexData.data() + ix * stride, &packed, stride);
+		}
+	} else {
+		stride = sizeof(VertexPackedPosNormTexTangents);
+		vertexDeclaration = &VertexPackedPosNormTexTangents::V_DECL;
+		vertexData.resize(vertices.size() * stride);
+		for (size_t ix = 0; ix < vertices.size(); ix++) {
+			VertexPackedPosNormTexTangents packed = MeshOptimizer::PackVertex(vertices[ix]);
+			memcpy(vertexData.data() + ix * stride, &packed, stride);
+		}
+	}
+
+	// Use 16 bit indices when we can, halving the size of the index buffer
+	std::vector<uint8_t> indexData;
+	IndexType indexType = vertices.size() <= UINT16_MAX + 1 ? IndexType::UShort : IndexType::UInt;
+	if (indexType == IndexType::UShort) {
+		indexData.resize(indices.size() * sizeof(uint16_t));
+		uint16_t* shortIndices = reinterpret_cast<uint16_t*>(indexData.data());
+		for (size_t ix = 0; ix < indices.size(); ix++) {
+			shortIndices[ix] = static_cast<uint16_t>(indices[ix]);
+		}
+	} else {
+		indexData.resize(indices.size() * sizeof(uint32_t));
+		memcpy(indexData.data(), indices.data(), indexData.size());
+	}
+	// Keep the vertex data aligned
+	indexData.resize(indexData.size() + (4 - indexData.size() % 4) % 4, 0);
+
+	BinaryHeader header  = BinaryHeader();
+	header.Version       = 0x03;
+	header.NumIndices    = static_cast<uint32_t>(indices.size());
+	header.IndicesType   = indexType;
+	header.NumVertices   = static_cast<uint32_t>(vertices.size());
+	header.VertexStride  = stride;
+	header.NumAttributes = static_cast<uint8_t>(vertexDeclaration->size());
+
+	// Nothing can map a half written file, and a conversion from PrefetchJson can't collide with one queued by LoadFromFile
+	bool success = FileHelpers::WriteFileAtomic(outFilename, [&](std::ostream& file) {
+		file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+		file.write(reinterpret_cast<const char*>(&source), sizeof(SourceInfo));
+		file.write(reinterpret_cast<const char*>(vertexDeclaration->data()), vertexDeclaration->size() * sizeof(BufferAttribute));
+		file.write(reinterpret_cast<const char*>(indexData.data()), indexData.size());
+		file.write(reinterpret_cast<const char*>(vertexData.data()), vertexData.size());
+		return true;
+	});
+	if (!success) {
+		throw std::runtime_error("Failed to write \"" + outFilename + "\"");
+	}
+}
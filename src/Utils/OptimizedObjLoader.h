@@ -7,11 +7,15 @@
  */
 #pragma once
 #include <fstream>
+#include <mutex>
+#include <unordered_set>
 
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
 
 #include "Utils/MeshBuilder.h"
+#include "Utils/MeshCpuData.h"
+#include "Utils/MemoryMappedFile.h"
 
 /// <summary>
 /// An optimized OBJ loader that can convert an OBJ file to a binary representation
@@ -20,18 +24,32 @@
 class OptimizedObjLoader {
 public:
 	/// <summary>
-	/// Loads a VAO from an OBJ file. On the first time this is called for an OBJ file, will convert the OBJ file 
-	/// to a binary file and load that instead. On subsequent runs, the binary file will be loaded instead
+	/// Loads a VAO from an OBJ file. If there is an up to date binary file for the OBJ, it is mapped and uploaded
+	/// directly to the GPU. Otherwise the OBJ file is loaded, and the binary file is (re)built on a worker thread
+	/// so that the next load can use it
 	/// </summary>
 	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="cpuData">If not null, will receive a CPU side copy of the mesh's positions and indices</param>
 	/// <returns>A VAO loaded from disk</returns>
-	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, MeshCpuData::Sptr* cpuData = nullptr);
+	/// <summary>
+	/// Checks whether the binary file for an OBJ file exists, and was built from the current contents of the OBJ
+	/// </summary>
+	/// <param name="filename">The path to the .obj file</param>
+	/// <returns>True if the binary file can be used, or if the OBJ file does not exist and the binary is all we have</returns>
+	static bool IsBinaryCurrent(const std::string& filename);
 	/// <summary>
 	/// Manually converts an OBJ file into a binary mesh file
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
 	/// <param name="outFile">The output path for the bin file, or empty to use the inFile path and replace the extension with .bin</param>
 	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "");
+	/// <summary>
+	/// Converts an OBJ file to it's binary file if the binary is missing or out of date. If the same
+	/// file is already being converted on another thread, this returns right away instead of waiting
+	/// </summary>
+	/// <param name="filename">The path to the .obj file</param>
+	static void ConvertIfStale(const std::string& filename);
 
 	/// <summary>
 	/// Saves a mesh builder of the given type to a binary file
@@ -41,6 +59,21 @@ public:
 	/// <param name="outFilename"></param>
 	template <typename VertexType>
 	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename);
+	/// <summary>
+	/// Saves a mesh to a packed binary file. Triangles are re-ordered for the vertex cache and to reduce overdraw,
+	/// vertices are re-ordered by first use and quantized, and 16 bit indices are used when there are few enough vertices
+	/// </summary>
+	/// <param name="mesh">The mesh to save</param>
+	/// <param name="outFilename">The path to the file to write</param>
+	/// <param name="sourceFile">The file the mesh was loaded from, it's size, write time and hash are stored so stale binaries can be detected</param>
+	static void SavePackedBinaryFile(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, const std::string& sourceFile = "");
+	/// <summary>
+	/// Same as SavePackedBinaryFile, but the file is written on a worker thread. Does nothing if the
+	/// same file is already being written
+	/// </summary>
+	/// <param name="mesh">The mesh to save, must not be modified until the write is finished</param>
+	/// <param name="outFilename">The path to the file to write</param>
+	static void SavePackedBinaryFileAsync(const std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>>& mesh, const std::string& outFilename);
 
 protected:
 	// Will be put at the start of the binary file, contains info about the contents of the file
@@ -48,6 +81,8 @@ protected:
 		// A check value so we can ensure that we're loading in the right file type
 		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
 		// The version code, we can use this to create different loaders if our format changes
+		// Version 1 stores the mesh as is, version 2 stores a packed and optimized mesh (see SavePackedBinaryFile),
+		// version 3 is the same as version 2 with a SourceInfo after the header
 		uint16_t  Version = 0;
 		// The number of indices in the mesh
 		uint32_t  NumIndices = 0;
@@ -61,11 +96,60 @@ protected:
 		uint8_t   NumAttributes = 0;
 	};
 
+	// Describes the file that a binary file was built from, so we can tell when it is out of date
+	struct SourceInfo {
+		// The size of the source file in bytes
+		uint64_t Size = 0;
+		// The last write time of the source file, as ticks since the file clock's epoch
+		int64_t  WriteTime = 0;
+		// The FNV-1a hash of the source file, only checked when the write time has changed
+		uint64_t Hash = 0;
+	};
+
 	OptimizedObjLoader() = default;
 	~OptimizedObjLoader() = default;
 
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
-	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename, MeshCpuData::Sptr* cpuData = nullptr);
+	static VertexArrayObject::Sptr _LoadFromBinFile(const MemoryMappedFile::Sptr& file, const std::string& filename, MeshCpuData::Sptr* cpuData = nullptr);
+
+	/// <summary>
+	/// Copies the positions and indices out of a binary file's data
+	/// </summary>
+	/// <param name="data">The start of the index data (just after the attributes)</param>
+	/// <param name="header">The file's header</param>
+	/// <param name="vertexDeclaration">The attributes read from the file</param>
+	static MeshCpuData::Sptr _ReadCpuData(const uint8_t* data, const BinaryHeader& header, const std::vector<BufferAttribute>& vertexDeclaration);
+	/// <summary>
+	/// Gets the size, write time and hash of a file
+	/// </summary>
+	/// <returns>True if the file exists</returns>
+	static bool _GetSourceInfo(const std::string& filename, SourceInfo& info);
+	/// <summary>
+	/// Checks whether a mapped binary file was built from the current contents of the given OBJ file
+	/// </summary>
+	static bool _IsBinaryCurrent(const MemoryMappedFile::Sptr& file, const std::string& objFilename);
+	/// <summary>
+	/// Overwrites the source info stored in a binary file on disk, used when the source has been touched but not changed
+	/// </summary>
+	static void _UpdateSourceInfo(const std::string& filename, const SourceInfo& source);
+	/// <summary>
+	/// Writes the packed binary file with FileHelpers::WriteFileAtomic, so that a reader never sees
+	/// a partially written file. Throws if the file could not be written
+	/// </summary>
+	static void _WritePackedBinaryFile(const MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::string& outFilename, const SourceInfo& source);
+	/// <summary>
+	/// Writes the binary file for a mesh that has already been loaded on a worker thread, unless
+	/// the same file is already being written
+	/// </summary>
+	static void _QueueConversion(const std::shared_ptr<MeshBuilder<VertexPosNormTexColTangents>>& mesh, const std::string& outFilename, const SourceInfo& source);
+
+	// The binary files that are being written on worker threads
+	static std::mutex _conversionMutex;
+	static std::unordered_set<std::string> _pendingConversions;
+
+	// Needs access to the OBJ parsing for benchmarking
+	friend class ObjParser;
 };
 
 template <typename VertexType>
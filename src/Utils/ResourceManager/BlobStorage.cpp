@@ -0,0 +1,65 @@
+#include "Utils/ResourceManager/BlobStorage.h"
+#include <filesystem>
+#include <Logging.h>
+
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/FileHelpers.h"
+
+std::string BlobStorage::_directory = "blobs";
+
+void BlobStorage::SetDirectory(const std::string& directory) {
+	_directory = directory;
+}
+
+const std::string& BlobStorage::GetDirectory() {
+	return _directory;
+}
+
+nlohmann::json BlobStorage::Write(const Guid& owner, const void* data, size_t size) {
+	std::error_code error;
+	std::filesystem::create_directories(_directory, error);
+
+	std::string filename = (std::filesystem::path(_directory) / (owner.str() + ".bin")).generic_string();
+
+	// A manifest may still be referencing the old blob, so we can't leave a half written one behind
+	if (!FileHelpers::WriteFileAtomic(filename, data, size)) {
+		return nullptr;
+	}
+
+	// We store an offset so that multiple blobs can be packed into one file in the future
+	return nlohmann::json {
+		{ "file",   filename },
+		{ "offset", 0 },
+		{ "length", size }
+	};
+}
+
+BlobStorage::Blob BlobStorage::Read(const nlohmann::json& reference) {
+	Blob result;
+	if (!IsReference(reference)) {
+		return result;
+	}
+
+	std::string filename = reference["file"].get<std::string>();
+	size_t offset = JsonGet<size_t>(reference, "offset", 0);
+	size_t length = JsonGet<size_t>(reference, "length", 0);
+
+	MemoryMappedFile::Sptr file = MemoryMappedFile::Map(filename);
+	if (file == nullptr) {
+		LOG_WARN("Failed to open blob \"{}\"", filename);
+		return result;
+	}
+	if (offset + length > file->GetSize()) {
+		LOG_WARN("Blob \"{}\" is smaller than the manifest expects ({} bytes at {})", filename, length, offset);
+		return result;
+	}
+
+	result.Mapping = file;
+	result.Data    = file->GetData() + offset;
+	result.Size    = length;
+	return result;
+}
+
+bool BlobStorage::IsReference(const nlohmann::json& reference) {
+	return reference.is_object() && reference.contains("file") && reference["file"].is_string();
+}
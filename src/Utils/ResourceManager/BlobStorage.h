@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <json.hpp>
+
+#include "Utils/GUID.hpp"
+#include "Utils/MemoryMappedFile.h"
+
+/// <summary>
+/// Stores large binary data for resources (ex: pixels for textures that were generated at runtime)
+/// in sidecar files next to the manifest, instead of embedding it as Base64 in the JSON. The manifest
+/// only stores a small reference to the data, which is memory mapped when the resource is loaded
+/// </summary>
+class BlobStorage {
+public:
+	BlobStorage() = delete;
+
+	/// <summary>
+	/// A view into a blob that has been mapped into memory. The data stays valid for
+	/// as long as the blob is alive
+	/// </summary>
+	struct Blob {
+		MemoryMappedFile::Sptr Mapping;
+		const uint8_t*         Data;
+		size_t                 Size;
+
+		Blob() : Mapping(nullptr), Data(nullptr), Size(0) {}
+
+		bool IsValid() const { return Data != nullptr; }
+	};
+
+	/// <summary>
+	/// Sets the directory that new blobs will be written to. The resource manager sets this
+	/// to a folder next to the manifest when saving
+	/// </summary>
+	static void SetDirectory(const std::string& directory);
+	/// <summary>
+	/// Gets the directory that new blobs will be written to
+	/// </summary>
+	static const std::string& GetDirectory();
+
+	/// <summary>
+	/// Writes a blob of data for a resource, replacing any existing blob for that resource
+	/// </summary>
+	/// <param name="owner">The GUID of the resource that owns the data</param>
+	/// <param name="data">The data to write</param>
+	/// <param name="size">The size of the data, in bytes</param>
+	/// <returns>A JSON reference to the blob to store in the manifest, or null if the blob could not be written</returns>
+	static nlohmann::json Write(const Guid& owner, const void* data, size_t size);
+	/// <summary>
+	/// Maps the blob referenced by a manifest entry into memory
+	/// </summary>
+	/// <param name="reference">The JSON reference returned by Write</param>
+	/// <returns>The mapped blob, or an invalid blob if the reference or file is bad</returns>
+	static Blob Read(const nlohmann::json& reference);
+	/// <summary>
+	/// Returns true if the given JSON is a reference to a blob
+	/// </summary>
+	static bool IsReference(const nlohmann::json& reference);
+
+protected:
+	static std::string _directory;
+};
@@ -12,6 +12,15 @@
 /// Resources must additionally define a static method as such:
 /// static std::shared_ptr<Type> FromJson(const nlohmann::json&);
 /// where Type is the Type of resource
+///
+/// Resources may optionally define a static method as such:
+/// static void PrefetchJson(const nlohmann::json&);
+/// which performs any CPU side work for loading the resource (ex: reading files, converting
+/// caches) ahead of FromJson. It is called from worker threads, so it must not touch OpenGL
+///
+/// Resources that hold on to prefetched data until FromJson picks it up should also define:
+/// static void ClearPrefetched();
+/// which is called once a manifest has finished loading, to drop anything FromJson didn't use
 /// </summary>
 class IResource {
 public:
@@ -41,6 +50,13 @@ public:
 	/// <returns>The JSON blob for the resource</returns>
 	virtual nlohmann::json ToJson() const = 0;
 
+	/// <summary>
+	/// Gets the approximate number of bytes of CPU and GPU memory held by this resource. This
+	/// is used by the resource manager to enforce memory budgets, resources that don't hold
+	/// any significant data can leave this as 0
+	/// </summary>
+	virtual size_t GetMemoryUsage() const { return 0; }
+
 protected:
 	Guid _guid;
 	IResource() : _guid(Guid::New()){}
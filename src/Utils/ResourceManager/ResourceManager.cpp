@@ -3,12 +3,24 @@
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Utils/ResourceManager/BlobStorage.h"
+#include "Utils/ThreadPool.h"
+#include <filesystem>
+#include <future>
+#include <algorithm>
+#include <Logging.h>
 
-std::map<std::type_index, std::map<Guid, IResource::Sptr>> ResourceManager::_resources;
-std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
+std::vector<ResourceManager::ITypeStore*> ResourceManager::_stores;
+std::unordered_map<std::string, ResourceManager::ITypeStore*> ResourceManager::_storesByName;
 
 nlohmann::ordered_json ResourceManager::_manifest;
 
+uint64_t ResourceManager::_frameIndex = 0;
+uint32_t ResourceManager::_evictionDelay = 300;
+
+// How often Update checks the budgets, checking every frame would mean querying every resource every frame
+static constexpr uint64_t EVICTION_INTERVAL = 60;
+
 void ResourceManager::Init() {
 	// TODO: initialize the resource manager once it's a bit more complex
 	//_manifest["textures"]  = std::vector<nlohmann::json>();
@@ -21,40 +33,289 @@ const nlohmann::ordered_json& ResourceManager::GetManifest() {
 	return _manifest;
 }
 
-void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets) {
+void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets, const ProgressCallback& onProgress) {
 	std::string contents = FileHelpers::ReadFile(path);
-	nlohmann::ordered_json blob = nlohmann::ordered_json::parse(contents);
-	_manifest = blob;
+	_manifest = nlohmann::ordered_json::parse(contents);
+
+	// Update the lists of GUIDs that each type can load from the manifest
+	for (ITypeStore* store : _stores) {
+		_IndexManifest(*store);
+	}
 
 	if (preloadAssets) {
-		for (auto& [typeName, items] : blob.items()) {
-			auto& func = _typeLoaders[typeName];
-			if (func) {
-				for (auto& [guid, blob] : items.items()) {
-					func(blob);
+		_PreloadManifest(onProgress);
+	}
+}
+
+void ResourceManager::_AddStore(ITypeStore* store) {
+	_stores.push_back(store);
+	_storesByName[store->TypeName] = store;
+}
+
+void ResourceManager::_IndexManifest(ITypeStore& store) {
+	store.ManifestEntries.Clear();
+	auto it = _manifest.find(store.TypeName);
+	if (it == _manifest.end() || !it->is_object()) {
+		return;
+	}
+	for (auto& [guid, blob] : it->items()) {
+		store.ManifestEntries.Insert(Guid(guid), true);
+	}
+}
+
+/// <summary>
+/// Collects the indices of every resource that is referenced by GUID somewhere in the given JSON blob
+/// </summary>
+void CollectReferences(const nlohmann::json& blob, const std::unordered_map<std::string, size_t>& lookup, size_t self, std::vector<size_t>& result) {
+	if (blob.is_string()) {
+		auto it = lookup.find(blob.get_ref<const std::string&>());
+		if (it != lookup.end() && it->second != self && std::find(result.begin(), result.end(), it->second) == result.end()) {
+			result.push_back(it->second);
+		}
+	}
+	else if (blob.is_structured()) {
+		for (const auto& item : blob) {
+			CollectReferences(item, lookup, self, result);
+		}
+	}
+}
+
+void ResourceManager::_PreloadManifest(const ProgressCallback& onProgress) {
+	// A single resource in the manifest, and the resources that it references
+	struct Node {
+		ITypeStore*         Store;
+		std::string         Id;
+		// Shared with the prefetch jobs, so they never point into the node list
+		std::shared_ptr<const nlohmann::json> Data;
+		std::vector<size_t> Dependencies;
+		// 0 = not visited, 1 = being visited, 2 = sorted
+		int                 State;
+	};
+
+	// Gather all the resources we know how to load, keyed by GUID
+	std::vector<Node> nodes;
+	std::unordered_map<std::string, size_t> lookup;
+	for (auto& [typeName, items] : _manifest.items()) {
+		auto it = _storesByName.find(typeName);
+		if (it == _storesByName.end() || !it->second->Loader || !items.is_object()) {
+			continue;
+		}
+		for (auto& [guid, blob] : items.items()) {
+			if (it->second->IsLoaded(Guid(guid))) {
+				continue;
+			}
+			lookup[guid] = nodes.size();
+			nodes.push_back({ it->second, guid, std::make_shared<const nlohmann::json>(blob), {}, 0 });
+		}
+	}
+
+	// Any string that matches another resource's GUID is a reference to it (ex: a material's shader and textures)
+	for (size_t ix = 0; ix < nodes.size(); ix++) {
+		CollectReferences(*nodes[ix].Data, lookup, ix, nodes[ix].Dependencies);
+	}
+
+	// Sort so that every resource comes after it's dependencies, keeping manifest order where we can
+	std::vector<size_t> order;
+	order.reserve(nodes.size());
+	std::function<void(size_t)> visit = [&](size_t ix) {
+		Node& node = nodes[ix];
+		if (node.State == 2) {
+			return;
+		}
+		if (node.State == 1) {
+			LOG_WARN("Resource {} is part of a reference cycle, it may be loaded before it's dependencies", node.Id);
+			return;
+		}
+		node.State = 1;
+		for (size_t dependency : node.Dependencies) {
+			visit(dependency);
+		}
+		node.State = 2;
+		order.push_back(ix);
+	};
+	for (size_t ix = 0; ix < nodes.size(); ix++) {
+		visit(ix);
+	}
+
+	// If a loader or the progress callback throws, we still need to wait for the workers before we
+	// leave, and drop anything they prefetched that will never be used
+	std::vector<std::future<void>> prefetches(nodes.size());
+	struct PrefetchGuard {
+		std::vector<std::future<void>>& Prefetches;
+		~PrefetchGuard() {
+			for (std::future<void>& prefetch : Prefetches) {
+				if (prefetch.valid()) {
+					prefetch.wait();
 				}
 			}
+			for (ITypeStore* store : _stores) {
+				if (store->PrefetchCleanup) {
+					store->PrefetchCleanup();
+				}
+			}
+		}
+	} guard = { prefetches };
+
+	// Kick off all the CPU side work right away, in the order we'll need it. Stores live for the whole
+	// program, and the jobs hold their own reference to the JSON, so they don't depend on anything local
+	for (size_t ix : order) {
+		ITypeStore* store = nodes[ix].Store;
+		if (store->Prefetcher) {
+			std::shared_ptr<const nlohmann::json> data = nodes[ix].Data;
+			prefetches[ix] = ThreadPool::Get().Enqueue([store, data]() { store->Prefetcher(*data); });
+		}
+	}
+
+	// Create the resources on this thread, since this is where our GL context lives
+	LoadProgress progress = { 0, order.size(), "" };
+	for (size_t ix : order) {
+		Node& node = nodes[ix];
+		if (prefetches[ix].valid()) {
+			try {
+				prefetches[ix].get();
+			}
+			catch (const std::exception& e) {
+				LOG_WARN("Failed to prefetch {} {}: {}", node.Store->TypeName, node.Id, e.what());
+			}
+		}
+
+		// One broken resource shouldn't stop the rest of the manifest from loading
+		try {
+			node.Store->Loader(*node.Data);
+		}
+		catch (const std::exception& e) {
+			LOG_ERROR("Failed to load {} {}: {}", node.Store->TypeName, node.Id, e.what());
+		}
+
+		progress.Completed++;
+		progress.TypeName = node.Store->TypeName;
+		if (onProgress) {
+			onProgress(progress);
+		}
+	}
+}
+
+bool ResourceManager::SetMemoryBudget(const std::string& typeName, size_t bytes) {
+	auto it = _storesByName.find(typeName);
+	if (it == _storesByName.end()) {
+		LOG_WARN("Cannot set memory budget for \"{}\", it is not a resource type", typeName);
+		return false;
+	}
+	it->second->MemoryBudget = bytes;
+	return true;
+}
+
+void ResourceManager::SetEvictionDelay(uint32_t frames) {
+	_evictionDelay = frames;
+}
+
+uint64_t ResourceManager::GetFrameIndex() {
+	return _frameIndex;
+}
+
+void ResourceManager::Update() {
+	_frameIndex++;
+	if (_frameIndex % EVICTION_INTERVAL == 0) {
+		EvictUnused();
+	}
+}
+
+size_t ResourceManager::EvictUnused(bool ignoreBudgets) {
+	size_t freed = 0;
+	for (ITypeStore* store : _stores) {
+		if (ignoreBudgets) {
+			freed += _Evict(*store, 0, 0);
+		}
+		else if (store->MemoryBudget > 0) {
+			freed += _Evict(*store, store->MemoryBudget, _evictionDelay);
+		}
+	}
+	return freed;
+}
+
+bool ResourceManager::_Unload(ITypeStore& store, const Guid& id) {
+	// We can only unload resources that we know how to load again
+	if (!store.Loader || !store.ManifestEntries.Contains(id)) {
+		return false;
+	}
+
+	IResource::Sptr resource = store.Find(id);
+	if (resource == nullptr) {
+		return false;
+	}
+
+	// Capture any changes that were made at runtime, so that the resource comes back the same way
+	std::string guid = id.str();
+	nlohmann::ordered_json& entry = _manifest[store.TypeName][guid];
+	entry = resource->ToJson();
+	entry["guid"] = guid;
+
+	return store.Remove(id);
+}
+
+size_t ResourceManager::_Evict(ITypeStore& store, size_t budget, uint64_t minAge) {
+	std::vector<ResourceUsage> usage;
+	store.GetUsage(usage);
+
+	size_t total = 0;
+	for (const ResourceUsage& item : usage) {
+		total += item.MemoryUsage;
+	}
+	// A budget of 0 means we're unloading everything we can
+	if (budget > 0 && total <= budget) {
+		return 0;
+	}
+
+	// Oldest first, and for resources last used on the same frame, evict the largest first
+	std::sort(usage.begin(), usage.end(), [](const ResourceUsage& a, const ResourceUsage& b) {
+		return a.LastUsedFrame != b.LastUsedFrame ? a.LastUsedFrame < b.LastUsedFrame : a.MemoryUsage > b.MemoryUsage;
+	});
+
+	size_t freed = 0;
+	size_t evicted = 0;
+	for (const ResourceUsage& item : usage) {
+		if (budget > 0 && total - freed <= budget) {
+			break;
+		}
+		// Resources that are being used are never unloaded, the game would just keep the old one alive anyways
+		if (item.ExternalReferences > 0 || item.LastUsedFrame + minAge > _frameIndex) {
+			continue;
+		}
+		if (_Unload(store, item.ID)) {
+			freed += item.MemoryUsage;
+			evicted++;
 		}
 	}
+
+	if (evicted > 0) {
+		LOG_TRACE("Evicted {} {} resources, freeing {} KB ({} KB still loaded)", evicted, store.TypeName, freed / 1024, (total - freed) / 1024);
+	}
+	if (budget > 0 && total - freed > budget) {
+		LOG_TRACE("{} resources are using {} KB, over their budget of {} KB", store.TypeName, (total - freed) / 1024, budget / 1024);
+	}
+	return freed;
 }
 
 void ResourceManager::SaveManifest(const std::string& path) {
+	// Binary data for resources gets stored in a folder next to the manifest (ex: scene.json -> scene.blobs/)
+	BlobStorage::SetDirectory(std::filesystem::path(path).replace_extension(".blobs").generic_string());
+
 	// Update all resources in the manifest so they match their current representation
-	for (auto& [type, map] : _resources) {
-		std::string typeName = StringTools::SanitizeClassName(type.name());
-		for (auto& [guid, res] : map) {
+	for (ITypeStore* store : _stores) {
+		store->ForEach([&](const Guid& guid, const IResource::Sptr& res) {
 			if (res != nullptr) {
-				_manifest[typeName][guid.str()] = res->ToJson();
-				_manifest[typeName][guid.str()]["guid"] = res->GetGUID().str();
+				nlohmann::ordered_json& entry = _manifest[store->TypeName][guid.str()];
+				entry = res->ToJson();
+				entry["guid"] = res->GetGUID().str();
 			}
-		}
+		});
 	}
 	FileHelpers::WriteContentsToFile(path, _manifest.dump(1,'\t'));
 }
 
 void ResourceManager::Cleanup() {
-	for (auto& [type, map] : _resources) {
-		map.clear();
+	for (ITypeStore* store : _stores) {
+		store->Clear();
 	}
 }
 
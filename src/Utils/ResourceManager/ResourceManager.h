@@ -2,18 +2,55 @@
 
 #include <json.hpp>
 #include <unordered_map>
-#include <typeindex>
+#include <typeinfo>
+#include <vector>
+#include <functional>
 
 #include "Utils/GUID.hpp"
 #include "Utils/ResourceManager/IResource.h"
+#include "Utils/ResourceManager/ResourceTable.h"
 #include "Utils/StringUtils.h"
 
 /// <summary>
 /// Utility class for managing and loading resources from JSON
 /// manifest files
+///
+/// Types can be given a memory budget. Once a type goes over it's budget, resources
+/// that are only referenced by the resource manager are unloaded, least recently used
+/// first. Unloaded resources stay in the manifest, and are loaded again the next time
+/// they are requested via Get
 /// </summary>
 class ResourceManager {
 public:
+	/// <summary>
+	/// Describes how far along a manifest preload is
+	/// </summary>
+	struct LoadProgress {
+		// The number of resources that have been loaded
+		size_t      Completed;
+		// The total number of resources that will be loaded
+		size_t      Total;
+		// The type of the resource that was just loaded
+		std::string TypeName;
+
+		float GetPercent() const { return Total > 0 ? Completed / (float)Total : 1.0f; }
+	};
+	typedef std::function<void(const LoadProgress&)> ProgressCallback;
+
+	/// <summary>
+	/// Describes the memory use and activity of a single loaded resource
+	/// </summary>
+	struct ResourceUsage {
+		// The GUID of the resource
+		Guid     ID;
+		// The number of bytes reported by IResource::GetMemoryUsage
+		size_t   MemoryUsage;
+		// The last frame that the resource was requested or referenced outside of the manager
+		uint64_t LastUsedFrame;
+		// The number of shared pointers to the resource held outside of the resource manager
+		long     ExternalReferences;
+	};
+
 	/// <summary>
 	/// Initializes the resource manager and performs any first-time
 	/// setup required
@@ -30,8 +67,9 @@ public:
 	template <typename T, typename ... TArgs, typename = std::enable_if<is_valid_resource<T>()>::type>
 	static std::shared_ptr<T> CreateAsset(TArgs&&... args) {
 		// Create and store the asset
+		TypeStore<T>& store = _GetStore<T>();
 		std::shared_ptr<T> asset = std::make_shared<T>(std::forward<TArgs>(args)...);
-		_resources[std::type_index(typeid(T))][asset->IResource::GetGUID()] = asset;
+		store.Resources.Insert(asset->IResource::GetGUID(), { asset, _frameIndex });
 
 		// Get the JSON representation of the asset so we can store it in the manifest
 		nlohmann::json data = asset->ToJson();
@@ -41,7 +79,8 @@ public:
 		data["guid"] = guid;
 
 		// Store the JSON data in the resource manifest (based on the type's name)
-		_manifest[StringTools::SanitizeClassName(typeid(T).name())][guid] = data;
+		_manifest[store.TypeName][guid] = data;
+		store.ManifestEntries.Insert(asset->IResource::GetGUID(), true);
 		return asset;
 	}
 
@@ -53,26 +92,24 @@ public:
 	/// <returns>The resource with the given GUID, or nullptr if none exists</returns>
 	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
 	static std::shared_ptr<T> Get(Guid id) {
-		// Try and grab the asset from the resource pool
-		std::shared_ptr<T> result =  std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
-
-		// If the asset is null, we can try finding it in the manifest to load it
-		if (result == nullptr) {
-			// Get the type name it'll be stored under
-			std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		// Try and grab the asset from the resource pool, this does not allocate or modify the table
+		TypeStore<T>& store = _GetStore<T>();
+		typename TypeStore<T>::Entry* result = store.Resources.Find(id);
 
-			// If the manifest has an entry, we can load it!
-			if (_manifest[typeName].contains(id)) {
-				// Invoke the loader function with the manifest data
-				_typeLoaders[typeName](_manifest[typeName][id]);
+		// If the manifest has an entry, we can load it! This is also how evicted resources come back
+		if (result == nullptr && store.Loader && store.ManifestEntries.Contains(id)) {
+			// Invoke the loader function with the manifest data, then search again to get the resource
+			store.Loader(_manifest[store.TypeName][id.str()]);
+			result = store.Resources.Find(id);
+		}
 
-				// Search resources again to get the resource
-				return std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
-			}
+		if (result != nullptr) {
+			result->LastUsedFrame = _frameIndex;
+			return result->Resource;
 		}
 
-		// If result wasn't null, or couldn't be found in the manifest, return here
-		return result;
+		// The resource doesn't exist, or couldn't be found in the manifest
+		return nullptr;
 	}
 
 	/// <summary>
@@ -83,22 +120,36 @@ public:
 	/// <typeparam name=""></typeparam>
 	template <typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
 	static void RegisterType() {
-		// Extract the type name from a sanitized version of they typeid name
-		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		// The store has the sanitized type name, which is computed once when the store is created
+		TypeStore<T>& store = _GetStore<T>();
 
 		// Create the type loader for the type
-		_typeLoaders[typeName] = [](const nlohmann::json& data) {
-			IResource::Sptr res = T::FromJson(data);
+		store.Loader = [](const nlohmann::json& data) {
+			std::shared_ptr<T> res = T::FromJson(data);
 			res->OverrideGUID(Guid(data["guid"]));
-			_resources[std::type_index(typeid(T))][res->GetGUID()] = res;
+			_GetStore<T>().Resources.Insert(res->GetGUID(), { res, _frameIndex });
 			return res->GetGUID();
 		};
 
+		// If the type can do some of it's loading off the main thread, store that as well
+		if constexpr (test_prefetch<T, const nlohmann::json&>::value) {
+			store.Prefetcher = [](const nlohmann::json& data) {
+				T::PrefetchJson(data);
+			};
+		}
+		if constexpr (test_clear_prefetched<T>::value) {
+			store.PrefetchCleanup = []() {
+				T::ClearPrefetched();
+			};
+		}
+
 		// Make sure we haven't registered the type yet, then add an empty object
 		// to the manifest to ensure it can be saved
-		if (!_manifest.contains(typeName)) {
-			_manifest[typeName] = nlohmann::json();
+		if (!_manifest.contains(store.TypeName)) {
+			_manifest[store.TypeName] = nlohmann::json();
 		}
+		// If a manifest was loaded before the type was registered, pick up it's entries
+		_IndexManifest(store);
 	}
 
 	/// <summary>
@@ -112,19 +163,94 @@ public:
 		typename = typename std::enable_if<std::is_base_of<IResource, ResourceType>::value>::type>
 		static void Each(std::function<void(const std::shared_ptr<ResourceType>&)> callback, bool includeDisabled = false) {
 
-		// We can use typeid and type_index to get a unique ID for our types
-		std::type_index type = std::type_index(typeid(ResourceType));
-
-		// Iterate over all the resources in the store
-		for (auto& [key, value] : _resources[type]) {
+		// Iterate over all the resources in the store, they're already the right type so no casting is needed
+		_GetStore<ResourceType>().Resources.ForEach([&](const Guid& key, const typename TypeStore<ResourceType>::Entry& value) {
 			// If the pointer is alive and matches our enabled criteria, invoke the callback
-			if (value != nullptr) {
-				// Upcast to resource type and invoke the callback
-				callback(std::dynamic_pointer_cast<ResourceType>(value));
+			if (value.Resource != nullptr) {
+				callback(value.Resource);
 			}
-		}
+		});
 	}
 
+	/// <summary>
+	/// Unloads a resource, if it is in the manifest. The resource can still be retrieved via Get, which
+	/// will load it again. Any existing pointers to the resource are unaffected
+	/// </summary>
+	/// <typeparam name="T">The type of resource to unload</typeparam>
+	/// <param name="id">The ID of the resource to unload</param>
+	/// <returns>True if the resource was unloaded</returns>
+	template<typename T, typename = typename std::enable_if<is_valid_resource<T>()>::type>
+	static bool Unload(Guid id) {
+		return _Unload(_GetStore<T>(), id);
+	}
+
+	/// <summary>
+	/// Sets the maximum amount of memory that loaded resources of the given type should use. Once the
+	/// budget is exceeded, unused resources will be unloaded during Update
+	/// </summary>
+	/// <typeparam name="T">The type of resource to set the budget for</typeparam>
+	/// <param name="bytes">The budget in bytes, or 0 for no budget</param>
+	template<typename T, typename = typename std::enable_if<is_valid_resource<T>()>::type>
+	static void SetMemoryBudget(size_t bytes) {
+		_GetStore<T>().MemoryBudget = bytes;
+	}
+	/// <summary>
+	/// Sets the memory budget for a type using the name it is stored under in the manifest
+	/// </summary>
+	/// <param name="typeName">The name of the type, as it appears in the manifest</param>
+	/// <param name="bytes">The budget in bytes, or 0 for no budget</param>
+	/// <returns>True if the type has been registered, false if it could not be found</returns>
+	static bool SetMemoryBudget(const std::string& typeName, size_t bytes);
+	/// <summary>
+	/// Gets the memory budget for the given type, in bytes, or 0 if the type does not have a budget
+	/// </summary>
+	template<typename T, typename = typename std::enable_if<is_valid_resource<T>()>::type>
+	static size_t GetMemoryBudget() {
+		return _GetStore<T>().MemoryBudget;
+	}
+	/// <summary>
+	/// Gets the total memory used by all loaded resources of the given type, in bytes
+	/// </summary>
+	template<typename T, typename = typename std::enable_if<is_valid_resource<T>()>::type>
+	static size_t GetMemoryUsage() {
+		size_t result = 0;
+		_GetStore<T>().Resources.ForEach([&](const Guid&, const typename TypeStore<T>::Entry& entry) {
+			result += entry.Resource != nullptr ? entry.Resource->GetMemoryUsage() : 0;
+		});
+		return result;
+	}
+	/// <summary>
+	/// Gets the memory use and activity of every loaded resource of the given type
+	/// </summary>
+	template<typename T, typename = typename std::enable_if<is_valid_resource<T>()>::type>
+	static std::vector<ResourceUsage> GetUsage() {
+		std::vector<ResourceUsage> result;
+		_GetStore<T>().GetUsage(result);
+		return result;
+	}
+
+	/// <summary>
+	/// Sets how many frames a resource must go unused before it can be evicted to meet a budget
+	/// </summary>
+	static void SetEvictionDelay(uint32_t frames);
+	/// <summary>
+	/// Gets the index of the current frame, as counted by Update
+	/// </summary>
+	static uint64_t GetFrameIndex();
+
+	/// <summary>
+	/// Should be called once per frame from the main thread. Advances the frame counter used to track when
+	/// resources were last used, and periodically unloads unused resources from types that are over budget
+	/// </summary>
+	static void Update();
+	/// <summary>
+	/// Unloads least recently used resources that are not referenced outside of the resource manager, until
+	/// each type is within it's budget. Only resources in the manifest are unloaded, so they can be loaded again
+	/// </summary>
+	/// <param name="ignoreBudgets">True to unload all unused resources of every type, regardless of budgets or eviction delay</param>
+	/// <returns>The number of bytes that were freed</returns>
+	static size_t EvictUnused(bool ignoreBudgets = false);
+
 	/// <summary>
 	/// Gets the current JSON manifest
 	/// </summary>
@@ -132,10 +258,15 @@ public:
 	/// <summary>
 	/// Loads a manifest file into the resource manager. Note that this will not perform load on the assets themselves 
 	/// unless preloadAssets is set to true
+	/// 
+	/// When preloading, resources are loaded in dependency order (ex: shaders and textures before the materials
+	/// that use them). CPU side work is done on the thread pool, while OpenGL objects are only created on the
+	/// calling thread
 	/// </summary>
 	/// <param name="path">The path to the JSON manifest file</param>
 	/// <param name="preloadAssets">True if all assets should be loaded into memory</param>
-	static void LoadManifest(const std::string& path, bool preloadAssets = false);
+	/// <param name="onProgress">An optional callback to invoke as each resource is preloaded</param>
+	static void LoadManifest(const std::string& path, bool preloadAssets = false, const ProgressCallback& onProgress = nullptr);
 	/// <summary>
 	/// Saves the manifest to the given JSON file
 	/// </summary>
@@ -149,19 +280,156 @@ public:
 
 protected:
 	/// <summary>
-	/// This is a map of maps
-	/// The top level map uses type_index, so there's a map per resource type
-	/// The inner map handles mapping GUIDs to the corresponding resource
+	/// The resources of a single type, without knowing the type. This lets us iterate over all
+	/// our stores (ex: when saving) and look them up by the name used in the manifest
+	/// </summary>
+	struct ITypeStore {
+		// The sanitized name of the type, which is it's key in the manifest
+		std::string TypeName;
+		// Creates a resource from it's manifest entry, only set for registered types
+		std::function<Guid(const nlohmann::json&)> Loader;
+		// The optional CPU side loader for the type, which may be run on worker threads
+		std::function<void(const nlohmann::json&)> Prefetcher;
+		// Drops any prefetched data that the loader didn't use, only set for types with a prefetcher that keeps data
+		std::function<void()> PrefetchCleanup;
+		// The GUIDs of every entry of this type in the manifest, so misses don't need to search the JSON
+		ResourceTable<bool> ManifestEntries;
+		// The maximum number of bytes loaded resources of this type should use, or 0 for no limit
+		size_t MemoryBudget = 0;
+
+		virtual ~ITypeStore() = default;
+
+		/// <summary>
+		/// Returns true if a resource with the given GUID is loaded
+		/// </summary>
+		virtual bool IsLoaded(const Guid& id) const = 0;
+		/// <summary>
+		/// Gets the loaded resource with the given ID, or nullptr if it isn't loaded
+		/// </summary>
+		virtual IResource::Sptr Find(const Guid& id) const = 0;
+		/// <summary>
+		/// Removes a resource from the store, returning true if it was loaded
+		/// </summary>
+		virtual bool Remove(const Guid& id) = 0;
+		/// <summary>
+		/// Appends the usage for every loaded resource to the result. Resources that are referenced outside of
+		/// the manager are marked as used this frame
+		/// </summary>
+		virtual void GetUsage(std::vector<ResourceUsage>& result) = 0;
+		/// <summary>
+		/// Invokes a callback for every loaded resource
+		/// </summary>
+		virtual void ForEach(const std::function<void(const Guid&, const IResource::Sptr&)>& callback) const = 0;
+		/// <summary>
+		/// Releases all loaded resources
+		/// </summary>
+		virtual void Clear() = 0;
+	};
+
+	/// <summary>
+	/// Stores the resources of a single type, as concrete pointers in a flat hash table
+	/// </summary>
+	template <typename T>
+	struct TypeStore : public ITypeStore {
+		struct Entry {
+			std::shared_ptr<T> Resource;
+			uint64_t           LastUsedFrame = 0;
+		};
+		ResourceTable<Entry> Resources;
+
+		virtual bool IsLoaded(const Guid& id) const override {
+			return Resources.Contains(id);
+		}
+		virtual IResource::Sptr Find(const Guid& id) const override {
+			const Entry* entry = Resources.Find(id);
+			return entry != nullptr ? entry->Resource : nullptr;
+		}
+		virtual bool Remove(const Guid& id) override {
+			return Resources.Erase(id);
+		}
+		virtual void GetUsage(std::vector<ResourceUsage>& result) override {
+			Resources.ForEach([&](const Guid& id, const Entry& entry) {
+				if (entry.Resource == nullptr) {
+					return;
+				}
+				// The table holds one reference, anything else is being held by the game
+				long references = entry.Resource.use_count() - 1;
+				uint64_t lastUsed = references > 0 ? _frameIndex : entry.LastUsedFrame;
+				result.push_back({ id, entry.Resource->GetMemoryUsage(), lastUsed, references });
+			});
+			// Write back the frames for referenced resources, so they age from when they were last held
+			for (const ResourceUsage& usage : result) {
+				Entry* entry = Resources.Find(usage.ID);
+				if (entry != nullptr) {
+					entry->LastUsedFrame = usage.LastUsedFrame;
+				}
+			}
+		}
+		virtual void ForEach(const std::function<void(const Guid&, const IResource::Sptr&)>& callback) const override {
+			Resources.ForEach([&](const Guid& id, const Entry& value) { callback(id, value.Resource); });
+		}
+		virtual void Clear() override {
+			Resources.Clear();
+		}
+	};
+
+	/// <summary>
+	/// Gets the store for a type, creating it the first time it is used. After the first call this
+	/// is just a static variable access, so we never need to look up or hash the type
+	/// </summary>
+	template <typename T>
+	static TypeStore<T>& _GetStore() {
+		static TypeStore<T>* store = [] {
+			TypeStore<T>* result = new TypeStore<T>();
+			result->TypeName = StringTools::SanitizeClassName(typeid(T).name());
+			_AddStore(result);
+			return result;
+		}();
+		return *store;
+	}
+
+	/// <summary>
+	/// Adds a newly created store to our list of stores
+	/// </summary>
+	static void _AddStore(ITypeStore* store);
+	/// <summary>
+	/// Rebuilds the list of manifest GUIDs for a store from the manifest
+	/// </summary>
+	static void _IndexManifest(ITypeStore& store);
+	/// <summary>
+	/// Updates a resource's manifest entry and removes it from it's store, if it can be loaded again
+	/// </summary>
+	static bool _Unload(ITypeStore& store, const Guid& id);
+	/// <summary>
+	/// Unloads the least recently used resources in a store that are not referenced elsewhere, until
+	/// the store is using at most the given number of bytes
+	/// </summary>
+	/// <returns>The number of bytes that were freed</returns>
+	static size_t _Evict(ITypeStore& store, size_t budget, uint64_t minAge);
+
+	/// <summary>
+	/// All the type stores that have been created, in the order they were created
 	/// </summary>
-	static std::map<std::type_index, std::map<Guid, IResource::Sptr>> _resources;
+	static std::vector<ITypeStore*> _stores;
 	/// <summary>
-	/// This map stores registered types, so we can load them from JSON files
+	/// Maps the manifest names of types to their stores
 	/// </summary>
-	static std::map<std::string, std::function<Guid(const nlohmann::json&)>> _typeLoaders;
+	static std::unordered_map<std::string, ITypeStore*> _storesByName;
 
 	/// <summary>
 	/// We use an ORDERED JSON file to allow serializing types in the order they are registered.
 	/// This allows us to register dependencies before the dependent resource
 	/// </summary>
 	static nlohmann::ordered_json _manifest;
+
+	// The number of frames since the application started, used to track when resources were last used
+	static uint64_t _frameIndex;
+	// The number of frames a resource must go unused before it can be evicted
+	static uint32_t _evictionDelay;
+
+	/// <summary>
+	/// Loads every resource in the manifest that is not already loaded, in dependency order. CPU side work
+	/// is prefetched on the thread pool, and every prefetch has finished by the time this returns or throws
+	/// </summary>
+	static void _PreloadManifest(const ProgressCallback& onProgress);
 };
\ No newline at end of file
@@ -0,0 +1,203 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include "Utils/GUID.hpp"
+
+/// <summary>
+/// A flat hash table that maps GUIDs to values, using open addressing with linear probing
+///
+/// All entries live in a single array, so a lookup is one hash and a short scan over
+/// neighbouring slots. Lookups never allocate, and looking up a missing key never
+/// modifies the table (unlike std::map::operator[])
+/// </summary>
+/// <typeparam name="TValue">The type of value to store</typeparam>
+template <typename TValue>
+class ResourceTable {
+public:
+	ResourceTable() :
+		_slots(),
+		_count(0),
+		_tombstones(0)
+	{ }
+
+	/// <summary>
+	/// Gets a pointer to the value stored for a key
+	/// </summary>
+	/// <param name="key">The key to search for</param>
+	/// <returns>A pointer to the value, or nullptr if the key is not in the table</returns>
+	TValue* Find(const Guid& key) {
+		size_t index = _FindSlot(key);
+		return index != npos ? &_slots[index].Value : nullptr;
+	}
+	/// <summary>
+	/// Gets a pointer to the value stored for a key
+	/// </summary>
+	/// <param name="key">The key to search for</param>
+	/// <returns>A pointer to the value, or nullptr if the key is not in the table</returns>
+	const TValue* Find(const Guid& key) const {
+		size_t index = _FindSlot(key);
+		return index != npos ? &_slots[index].Value : nullptr;
+	}
+	/// <summary>
+	/// Returns true if the table contains the given key
+	/// </summary>
+	bool Contains(const Guid& key) const {
+		return _FindSlot(key) != npos;
+	}
+
+	/// <summary>
+	/// Stores a value for a key, replacing any existing value
+	/// </summary>
+	/// <param name="key">The key to store the value under</param>
+	/// <param name="value">The value to store</param>
+	void Insert(const Guid& key, const TValue& value) {
+		// Keep the load factor (including deleted slots) under 3/4 so probes stay short
+		if ((_count + _tombstones + 1) * 4 > _slots.size() * 3) {
+			_Rehash(_count * 2 >= _slots.size() / 2 ? _slots.size() * 2 : _slots.size());
+		}
+
+		size_t mask = _slots.size() - 1;
+		size_t index = _Hash(key) & mask;
+		size_t firstDeleted = npos;
+		while (_slots[index].State != SlotState::Empty) {
+			if (_slots[index].State == SlotState::Full && _slots[index].Key == key) {
+				_slots[index].Value = value;
+				return;
+			}
+			if (_slots[index].State == SlotState::Deleted && firstDeleted == npos) {
+				firstDeleted = index;
+			}
+			index = (index + 1) & mask;
+		}
+
+		// Re-use a deleted slot if we passed one, since the key is not in the table
+		if (firstDeleted != npos) {
+			index = firstDeleted;
+			_tombstones--;
+		}
+		_slots[index].Key   = key;
+		_slots[index].Value = value;
+		_slots[index].State = SlotState::Full;
+		_count++;
+	}
+
+	/// <summary>
+	/// Removes a key from the table
+	/// </summary>
+	/// <param name="key">The key to remove</param>
+	/// <returns>True if the key was in the table</returns>
+	bool Erase(const Guid& key) {
+		size_t index = _FindSlot(key);
+		if (index == npos) {
+			return false;
+		}
+
+		// We leave a marker behind so that probes for keys after this one still find them
+		_slots[index].Value = TValue();
+		_slots[index].State = SlotState::Deleted;
+		_count--;
+		_tombstones++;
+		return true;
+	}
+
+	/// <summary>
+	/// Removes all values from the table, keeping it's memory
+	/// </summary>
+	void Clear() {
+		for (Slot& slot : _slots) {
+			slot.Value = TValue();
+			slot.State = SlotState::Empty;
+		}
+		_count = 0;
+		_tombstones = 0;
+	}
+
+	/// <summary>
+	/// Gets the number of values in the table
+	/// </summary>
+	size_t Size() const { return _count; }
+
+	/// <summary>
+	/// Invokes a function for every key and value in the table
+	/// </summary>
+	/// <typeparam name="Func">A callable with the signature void(const Guid&, const TValue&)</typeparam>
+	template <typename Func>
+	void ForEach(Func&& func) const {
+		for (const Slot& slot : _slots) {
+			if (slot.State == SlotState::Full) {
+				func(slot.Key, slot.Value);
+			}
+		}
+	}
+
+protected:
+	static constexpr size_t npos = static_cast<size_t>(-1);
+	// The size of the table when we first insert, must be a power of two
+	static constexpr size_t _initialCapacity = 16;
+
+	enum class SlotState : uint8_t {
+		Empty,
+		Full,
+		Deleted
+	};
+
+	struct Slot {
+		Guid      Key;
+		TValue    Value;
+		SlotState State = SlotState::Empty;
+	};
+
+	std::vector<Slot> _slots;
+	size_t            _count;
+	size_t            _tombstones;
+
+	/// <summary>
+	/// Hashes a GUID. GUIDs are already random, so we only need to fold the bytes together
+	/// </summary>
+	static size_t _Hash(const Guid& key) {
+		uint64_t parts[2];
+		memcpy(parts, key.bytes(), sizeof(parts));
+		uint64_t hash = (parts[0] ^ (parts[1] * 0x9E3779B97F4A7C15ull));
+		return static_cast<size_t>(hash ^ (hash >> 32));
+	}
+
+	/// <summary>
+	/// Finds the slot holding a key, or npos if the key is not in the table
+	/// </summary>
+	size_t _FindSlot(const Guid& key) const {
+		if (_count == 0) {
+			return npos;
+		}
+
+		size_t mask = _slots.size() - 1;
+		size_t index = _Hash(key) & mask;
+		// The load factor guarantees that there's always an empty slot to stop on
+		while (_slots[index].State != SlotState::Empty) {
+			if (_slots[index].State == SlotState::Full && _slots[index].Key == key) {
+				return index;
+			}
+			index = (index + 1) & mask;
+		}
+		return npos;
+	}
+
+	/// <summary>
+	/// Re-inserts all values into a table of the given capacity, dropping any deleted slots
+	/// </summary>
+	void _Rehash(size_t capacity) {
+		capacity = capacity < _initialCapacity ? _initialCapacity : capacity;
+
+		std::vector<Slot> old = std::move(_slots);
+		_slots = std::vector<Slot>(capacity);
+		_count = 0;
+		_tombstones = 0;
+
+		for (Slot& slot : old) {
+			if (slot.State == SlotState::Full) {
+				Insert(slot.Key, slot.Value);
+			}
+		}
+	}
+};
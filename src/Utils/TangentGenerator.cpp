@@ -0,0 +1,379 @@
+#include "Utils/TangentGenerator.h"
+
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "Utils/ThreadPool.h"
+#include "Logging.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGENTS_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define TANGENTS_USE_SSE 0
+#endif
+
+// The number of triangles or vertices handed to each job, small enough to balance well on big meshes
+static constexpr size_t FACE_CHUNK_SIZE = 16 * 1024;
+static constexpr size_t VERTEX_CHUNK_SIZE = 8 * 1024;
+// Matches MikkTSpace's test for values that are too small to normalize
+static constexpr float EPSILON = std::numeric_limits<float>::min();
+
+// Abramowitz and Stegun 4.4.46, accurate to about 2e-8 radians. Used by both paths so that they agree
+static const float ACOS_COEFFS[8] = { 1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f, 0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f };
+static constexpr float PI = 3.14159265358979f;
+
+inline float FastAcos(float value) {
+	float x = std::abs(std::clamp(value, -1.0f, 1.0f));
+	float poly = ACOS_COEFFS[7];
+	for (int ix = 6; ix >= 0; ix--) {
+		poly = poly * x + ACOS_COEFFS[ix];
+	}
+	float result = std::sqrt(1.0f - x) * poly;
+	return value < 0.0f ? PI - result : result;
+}
+
+inline glm::vec3 ProjectOnPlane(const glm::vec3& value, const glm::vec3& normal) {
+	return value - normal * glm::dot(normal, value);
+}
+
+inline glm::vec3 SafeNormalize(const glm::vec3& value) {
+	float length = glm::length(value);
+	return length > EPSILON ? value / length : glm::vec3(0.0f);
+}
+
+void TangentGenerator::CornerFrames::Resize(size_t faceCount) {
+	FaceCount = faceCount;
+	TangentX.resize(faceCount * 3);
+	TangentY.resize(faceCount * 3);
+	TangentZ.resize(faceCount * 3);
+	BiTangentX.resize(faceCount * 3);
+	BiTangentY.resize(faceCount * 3);
+	BiTangentZ.resize(faceCount * 3);
+}
+
+void TangentGenerator::Calculate(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, size_t vertexCount,
+								 const uint32_t* indices, size_t indexCount, glm::vec3* tangents, glm::vec3* bitangents, bool multithreaded) {
+	_Calculate(positions, normals, uvs, vertexCount, indices, indexCount, tangents, bitangents, multithreaded, TANGENTS_USE_SSE);
+}
+
+void TangentGenerator::_Calculate(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, size_t vertexCount,
+								  const uint32_t* indices, size_t indexCount, glm::vec3* tangents, glm::vec3* bitangents, bool multithreaded, bool simd) {
+	size_t faceCount = indexCount / 3;
+
+	// Runs a job over a range, either on the thread pool or right here
+	auto run = [multithreaded](size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func) {
+		if (multithreaded) {
+			ThreadPool::Get().ParallelFor(count, chunkSize, func);
+		} else {
+			func(0, count);
+		}
+	};
+
+	// Build the list of corners that touch each vertex, in index order. Every vertex then sums it's
+	// own corners, instead of every triangle scattering into 3 vertices that other threads may be writing
+	std::vector<uint32_t> cornerOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < faceCount * 3; ix++) {
+		cornerOffsets[indices[ix] + 1]++;
+	}
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		cornerOffsets[ix + 1] += cornerOffsets[ix];
+	}
+	std::vector<uint32_t> corners(cornerOffsets[vertexCount]);
+	{
+		std::vector<uint32_t> fill(cornerOffsets.begin(), cornerOffsets.end() - 1);
+		for (size_t ix = 0; ix < faceCount * 3; ix++) {
+			corners[fill[indices[ix]]++] = static_cast<uint32_t>(ix);
+		}
+	}
+
+	// The frames are built around unit normals, so make sure we have them for every vertex
+	std::vector<glm::vec3> unitNormals(vertexCount);
+	run(vertexCount, VERTEX_CHUNK_SIZE, [&](size_t begin, size_t end) {
+		_ResolveNormals(positions, normals, indices, cornerOffsets, corners, begin, end, unitNormals.data());
+	});
+
+	// What each corner adds to it's vertex, triangles are independent so there's no need to synchronize
+	CornerFrames frames;
+	frames.Resize(faceCount);
+	run(faceCount, FACE_CHUNK_SIZE, [&](size_t begin, size_t end) {
+		if (simd) {
+			_CalculateCornersSimd(positions, unitNormals.data(), uvs, indices, begin, end, frames);
+		} else {
+			_CalculateCornersScalar(positions, unitNormals.data(), uvs, indices, begin, end, frames);
+		}
+	});
+
+	run(vertexCount, VERTEX_CHUNK_SIZE, [&](size_t begin, size_t end) {
+		_ResolveVertices(unitNormals.data(), frames, cornerOffsets, corners, begin, end, tangents, bitangents);
+	});
+}
+
+void TangentGenerator::_ResolveNormals(const glm::vec3* positions, const glm::vec3* normals, const uint32_t* indices,
+									   const std::vector<uint32_t>& cornerOffsets, const std::vector<uint32_t>& corners,
+									   size_t begin, size_t end, glm::vec3* result) {
+	for (size_t vertex = begin; vertex < end; vertex++) {
+		glm::vec3 normal = normals != nullptr ? SafeNormalize(normals[vertex]) : glm::vec3(0.0f);
+		if (glm::dot(normal, normal) == 0.0f) {
+			for (uint32_t ix = cornerOffsets[vertex]; ix < cornerOffsets[vertex + 1]; ix++) {
+				size_t first = (corners[ix] / 3) * 3;
+				const glm::vec3& a = positions[indices[first + 0]];
+				const glm::vec3& b = positions[indices[first + 1]];
+				const glm::vec3& c = positions[indices[first + 2]];
+				normal += glm::cross(b - a, c - a);
+			}
+			normal = SafeNormalize(normal);
+		}
+		result[vertex] = normal;
+	}
+}
+
+void TangentGenerator::_CalculateCornersScalar(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, const uint32_t* indices,
+											   size_t begin, size_t end, CornerFrames& frames) {
+	for (size_t face = begin; face < end; face++) {
+		const uint32_t* tri = indices + face * 3;
+
+		glm::vec3 d1 = positions[tri[1]] - positions[tri[0]];
+		glm::vec3 d2 = positions[tri[2]] - positions[tri[0]];
+		glm::vec2 t1 = uvs[tri[1]] - uvs[tri[0]];
+		glm::vec2 t2 = uvs[tri[2]] - uvs[tri[0]];
+
+		// Twice the signed area of the triangle in UV space, it's sign tells us if the UVs are mirrored.
+		// Triangles with no UV area don't contribute anything
+		float area = t1.x * t2.y - t1.y * t2.x;
+		float sign = std::abs(area) > EPSILON ? (area > 0.0f ? 1.0f : -1.0f) : 0.0f;
+		glm::vec3 tangent = SafeNormalize(d1 * t2.y - d2 * t1.y) * sign;
+		glm::vec3 bitangent = SafeNormalize(d2 * t1.x - d1 * t2.x) * sign;
+
+		for (int corner = 0; corner < 3; corner++) {
+			const glm::vec3& position = positions[tri[corner]];
+			const glm::vec3& normal = normals[tri[corner]];
+
+			// Like MikkTSpace, the weight is the angle of the corner after projecting onto the normal's plane
+			glm::vec3 edge1 = SafeNormalize(ProjectOnPlane(positions[tri[(corner + 1) % 3]] - position, normal));
+			glm::vec3 edge2 = SafeNormalize(ProjectOnPlane(positions[tri[(corner + 2) % 3]] - position, normal));
+			float angle = FastAcos(glm::dot(edge1, edge2));
+
+			glm::vec3 cornerTangent = SafeNormalize(ProjectOnPlane(tangent, normal)) * angle;
+			glm::vec3 cornerBiTangent = SafeNormalize(ProjectOnPlane(bitangent, normal)) * angle;
+
+			size_t slot = corner * frames.FaceCount + face;
+			frames.TangentX[slot] = cornerTangent.x;
+			frames.TangentY[slot] = cornerTangent.y;
+			frames.TangentZ[slot] = cornerTangent.z;
+			frames.BiTangentX[slot] = cornerBiTangent.x;
+			frames.BiTangentY[slot] = cornerBiTangent.y;
+			frames.BiTangentZ[slot] = cornerBiTangent.z;
+		}
+	}
+}
+
+#if TANGENTS_USE_SSE
+// A 3 component vector, with one triangle per lane
+struct Vec3x4 {
+	__m128 X, Y, Z;
+};
+
+inline Vec3x4 Sub(const Vec3x4& a, const Vec3x4& b) {
+	return { _mm_sub_ps(a.X, b.X), _mm_sub_ps(a.Y, b.Y), _mm_sub_ps(a.Z, b.Z) };
+}
+
+inline Vec3x4 Scale(const Vec3x4& a, const __m128& s) {
+	return { _mm_mul_ps(a.X, s), _mm_mul_ps(a.Y, s), _mm_mul_ps(a.Z, s) };
+}
+
+inline __m128 Dot(const Vec3x4& a, const Vec3x4& b) {
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.X, b.X), _mm_mul_ps(a.Y, b.Y)), _mm_mul_ps(a.Z, b.Z));
+}
+
+inline Vec3x4 ProjectOnPlane(const Vec3x4& value, const Vec3x4& normal) {
+	return Sub(value, Scale(normal, Dot(normal, value)));
+}
+
+// Scales to unit length, or to zero if too short to normalize, then multiplies by scale
+inline Vec3x4 SafeNormalize(const Vec3x4& value, const __m128& scale) {
+	__m128 length = _mm_sqrt_ps(Dot(value, value));
+	__m128 valid = _mm_cmpgt_ps(length, _mm_set1_ps(EPSILON));
+	// Avoid dividing by zero in the lanes we're about to throw away
+	__m128 divisor = _mm_or_ps(_mm_and_ps(valid, length), _mm_andnot_ps(valid, _mm_set1_ps(1.0f)));
+	return Scale(value, _mm_and_ps(valid, _mm_div_ps(scale, divisor)));
+}
+
+inline __m128 FastAcos(const __m128& value) {
+	__m128 signBit = _mm_set1_ps(-0.0f);
+	__m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+	__m128 x = _mm_andnot_ps(signBit, clamped);
+	__m128 poly = _mm_set1_ps(ACOS_COEFFS[7]);
+	for (int ix = 6; ix >= 0; ix--) {
+		poly = _mm_add_ps(_mm_mul_ps(poly, x), _mm_set1_ps(ACOS_COEFFS[ix]));
+	}
+	__m128 result = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)), poly);
+	__m128 negative = _mm_cmplt_ps(clamped, _mm_setzero_ps());
+	return _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(PI), result)), _mm_andnot_ps(negative, result));
+}
+#endif
+
+void TangentGenerator::_CalculateCornersSimd(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, const uint32_t* indices,
+											 size_t begin, size_t end, CornerFrames& frames) {
+#if TANGENTS_USE_SSE
+	size_t face = begin;
+	for (; face + 4 <= end; face += 4) {
+		// Gather 4 triangles, with one triangle per lane
+		Vec3x4 pos[3];
+		Vec3x4 normal[3];
+		__m128 u[3], v[3];
+		const uint32_t* tri = indices + face * 3;
+		for (int corner = 0; corner < 3; corner++) {
+			uint32_t i0 = tri[corner], i1 = tri[3 + corner], i2 = tri[6 + corner], i3 = tri[9 + corner];
+			pos[corner] = {
+				_mm_setr_ps(positions[i0].x, positions[i1].x, positions[i2].x, positions[i3].x),
+				_mm_setr_ps(positions[i0].y, positions[i1].y, positions[i2].y, positions[i3].y),
+				_mm_setr_ps(positions[i0].z, positions[i1].z, positions[i2].z, positions[i3].z)
+			};
+			normal[corner] = {
+				_mm_setr_ps(normals[i0].x, normals[i1].x, normals[i2].x, normals[i3].x),
+				_mm_setr_ps(normals[i0].y, normals[i1].y, normals[i2].y, normals[i3].y),
+				_mm_setr_ps(normals[i0].z, normals[i1].z, normals[i2].z, normals[i3].z)
+			};
+			u[corner] = _mm_setr_ps(uvs[i0].x, uvs[i1].x, uvs[i2].x, uvs[i3].x);
+			v[corner] = _mm_setr_ps(uvs[i0].y, uvs[i1].y, uvs[i2].y, uvs[i3].y);
+		}
+
+		// Same as the scalar path, see _CalculateCornersScalar
+		Vec3x4 d1 = Sub(pos[1], pos[0]);
+		Vec3x4 d2 = Sub(pos[2], pos[0]);
+		__m128 t1x = _mm_sub_ps(u[1], u[0]);
+		__m128 t1y = _mm_sub_ps(v[1], v[0]);
+		__m128 t2x = _mm_sub_ps(u[2], u[0]);
+		__m128 t2y = _mm_sub_ps(v[2], v[0]);
+
+		__m128 area = _mm_sub_ps(_mm_mul_ps(t1x, t2y), _mm_mul_ps(t1y, t2x));
+		__m128 hasArea = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), area), _mm_set1_ps(EPSILON));
+		__m128 sign = _mm_and_ps(hasArea, _mm_or_ps(_mm_and_ps(area, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f)));
+		Vec3x4 tangent = SafeNormalize(Sub(Scale(d1, t2y), Scale(d2, t1y)), sign);
+		Vec3x4 bitangent = SafeNormalize(Sub(Scale(d2, t1x), Scale(d1, t2x)), sign);
+
+		__m128 one = _mm_set1_ps(1.0f);
+		for (int corner = 0; corner < 3; corner++) {
+			const Vec3x4& n = normal[corner];
+			Vec3x4 edge1 = SafeNormalize(ProjectOnPlane(Sub(pos[(corner + 1) % 3], pos[corner]), n), one);
+			Vec3x4 edge2 = SafeNormalize(ProjectOnPlane(Sub(pos[(corner + 2) % 3], pos[corner]), n), one);
+			__m128 angle = FastAcos(Dot(edge1, edge2));
+
+			Vec3x4 cornerTangent = SafeNormalize(ProjectOnPlane(tangent, n), angle);
+			Vec3x4 cornerBiTangent = SafeNormalize(ProjectOnPlane(bitangent, n), angle);
+
+			size_t slot = corner * frames.FaceCount + face;
+			_mm_storeu_ps(&frames.TangentX[slot], cornerTangent.X);
+			_mm_storeu_ps(&frames.TangentY[slot], cornerTangent.Y);
+			_mm_storeu_ps(&frames.TangentZ[slot], cornerTangent.Z);
+			_mm_storeu_ps(&frames.BiTangentX[slot], cornerBiTangent.X);
+			_mm_storeu_ps(&frames.BiTangentY[slot], cornerBiTangent.Y);
+			_mm_storeu_ps(&frames.BiTangentZ[slot], cornerBiTangent.Z);
+		}
+	}
+	// Whatever doesn't fill a full set of lanes
+	_CalculateCornersScalar(positions, normals, uvs, indices, face, end, frames);
+#else
+	_CalculateCornersScalar(positions, normals, uvs, indices, begin, end, frames);
+#endif
+}
+
+void TangentGenerator::_ResolveVertices(const glm::vec3* normals, const CornerFrames& frames,
+										const std::vector<uint32_t>& cornerOffsets, const std::vector<uint32_t>& corners,
+										size_t begin, size_t end, glm::vec3* tangents, glm::vec3* bitangents) {
+	for (size_t vertex = begin; vertex < end; vertex++) {
+		const glm::vec3& normal = normals[vertex];
+
+		glm::vec3 tangent = glm::vec3(0.0f);
+		glm::vec3 bitangent = glm::vec3(0.0f);
+		for (uint32_t ix = cornerOffsets[vertex]; ix < cornerOffsets[vertex + 1]; ix++) {
+			size_t slot = frames.GetSlot(corners[ix]);
+			tangent += glm::vec3(frames.TangentX[slot], frames.TangentY[slot], frames.TangentZ[slot]);
+			bitangent += glm::vec3(frames.BiTangentX[slot], frames.BiTangentY[slot], frames.BiTangentZ[slot]);
+		}
+
+		tangent = SafeNormalize(tangent);
+		// No usable UVs around this vertex, pick any tangent so that the frame is still orthonormal
+		if (glm::dot(tangent, tangent) == 0.0f) {
+			glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			tangent = SafeNormalize(ProjectOnPlane(axis, normal));
+		}
+
+		// Store the bitangent the way MikkTSpace expects it to be rebuilt, cross(N, T) times the handedness
+		glm::vec3 rebuilt = glm::cross(normal, tangent);
+		float handedness = glm::dot(rebuilt, bitangent) < 0.0f ? -1.0f : 1.0f;
+
+		tangents[vertex] = tangent;
+		bitangents[vertex] = rebuilt * handedness;
+	}
+}
+
+TangentGenerator::BenchmarkResult TangentGenerator::Benchmark(size_t triangleCount, int iterations) {
+	typedef std::chrono::high_resolution_clock Clock;
+	BenchmarkResult result = BenchmarkResult();
+
+	// Generate a bumpy grid, with 2 triangles per cell
+	size_t gridSize = std::max<size_t>(1, static_cast<size_t>(std::sqrt(triangleCount / 2.0)));
+	size_t rowSize = gridSize + 1;
+	std::vector<glm::vec3> positions(rowSize * rowSize);
+	std::vector<glm::vec3> normals(rowSize * rowSize);
+	std::vector<glm::vec2> uvs(rowSize * rowSize);
+	for (size_t y = 0; y < rowSize; y++) {
+		for (size_t x = 0; x < rowSize; x++) {
+			float u = x / (float)gridSize;
+			float v = y / (float)gridSize;
+			float height = std::sin(u * 40.0f) * std::cos(v * 40.0f) * 0.05f;
+			positions[y * rowSize + x] = glm::vec3(u, v, height);
+			normals[y * rowSize + x] = SafeNormalize(glm::vec3(
+				-std::cos(u * 40.0f) * std::cos(v * 40.0f) * 2.0f,
+				std::sin(u * 40.0f) * std::sin(v * 40.0f) * 2.0f,
+				1.0f));
+			uvs[y * rowSize + x] = glm::vec2(u, v);
+		}
+	}
+	std::vector<uint32_t> indices;
+	indices.reserve(gridSize * gridSize * 6);
+	for (size_t y = 0; y < gridSize; y++) {
+		for (size_t x = 0; x < gridSize; x++) {
+			uint32_t a = static_cast<uint32_t>(y * rowSize + x);
+			uint32_t b = a + 1;
+			uint32_t c = a + static_cast<uint32_t>(rowSize);
+			uint32_t d = c + 1;
+			indices.insert(indices.end(), { a, b, d, a, d, c });
+		}
+	}
+	result.NumVertices = positions.size();
+	result.NumTriangles = indices.size() / 3;
+
+	std::vector<glm::vec3> tangents(positions.size());
+	std::vector<glm::vec3> bitangents(positions.size());
+
+	// Runs a path the given number of times, returning the fastest time in seconds
+	auto time = [&](bool multithreaded, bool simd) {
+		double best = std::numeric_limits<double>::max();
+		for (int ix = 0; ix < std::max(iterations, 1); ix++) {
+			auto start = Clock::now();
+			_Calculate(positions.data(), normals.data(), uvs.data(), positions.size(), indices.data(), indices.size(),
+					   tangents.data(), bitangents.data(), multithreaded, simd);
+			std::chrono::duration<double> elapsed = Clock::now() - start;
+			best = std::min(best, elapsed.count());
+		}
+		return best;
+	};
+
+	result.ScalarTime = time(false, false);
+	result.SimdTime = time(false, true);
+	result.MultiThreadedTime = time(true, true);
+
+	double megaTris = result.NumTriangles / 1000000.0;
+	LOG_INFO("Tangent generation benchmark ({} vertices, {} triangles, best of {}, SIMD {}):", result.NumVertices, result.NumTriangles, iterations, TANGENTS_USE_SSE ? "enabled" : "unavailable");
+	LOG_INFO("\tScalar (1 thread):    {:.4f}s ({:.1f} Mtri/s)", result.ScalarTime, megaTris / result.ScalarTime);
+	LOG_INFO("\tSIMD (1 thread):      {:.4f}s ({:.1f} Mtri/s)", result.SimdTime, megaTris / result.SimdTime);
+	LOG_INFO("\tSIMD ({} threads):    {:.4f}s ({:.1f} Mtri/s)", ThreadPool::Get().GetThreadCount() + 1, result.MultiThreadedTime, megaTris / result.MultiThreadedTime);
+
+	return result;
+}
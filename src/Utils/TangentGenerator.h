@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Generates per vertex tangent frames for normal mapping, following the same rules as MikkTSpace
+/// (Morten Mikkelsen, "Simulation of Wrinkled Surfaces Revisited") so that normal maps baked by
+/// other tools line up with what we render
+///
+/// The contribution of each triangle corner is calculated 4 triangles at a time with SSE when it's available,
+/// and both the triangle and vertex passes are split across the thread pool. Each vertex sums the corners
+/// around it in a fixed order, so the results don't depend on the number of threads
+/// </summary>
+class TangentGenerator {
+public:
+	TangentGenerator() = delete;
+
+	/// <summary>
+	/// The timings from running the generator on a generated mesh, in seconds
+	/// </summary>
+	struct BenchmarkResult {
+		// Plain C++ on a single thread
+		double ScalarTime;
+		// SIMD corner pass on a single thread
+		double SimdTime;
+		// SIMD corner pass, with every pass using the thread pool
+		double MultiThreadedTime;
+		// The size of the generated mesh
+		size_t NumVertices;
+		size_t NumTriangles;
+	};
+
+	/// <summary>
+	/// Calculates the tangent and bitangent of every vertex in an indexed triangle list
+	/// </summary>
+	/// <param name="positions">The positions of the vertices</param>
+	/// <param name="normals">The normals of the vertices, or nullptr to use the normals of the triangles around them</param>
+	/// <param name="uvs">The texture coordinates of the vertices</param>
+	/// <param name="vertexCount">The number of vertices in positions, normals, uvs, tangents and bitangents</param>
+	/// <param name="indices">The triangle list, 3 indices per triangle</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="tangents">Will receive the unit tangent of each vertex</param>
+	/// <param name="bitangents">Will receive the unit bitangent of each vertex, cross(normal, tangent) flipped to match the UV handedness</param>
+	/// <param name="multithreaded">True to split the work across the thread pool</param>
+	static void Calculate(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, size_t vertexCount,
+						  const uint32_t* indices, size_t indexCount, glm::vec3* tangents, glm::vec3* bitangents, bool multithreaded = true);
+
+	/// <summary>
+	/// Times the scalar, SIMD and multithreaded paths on a generated grid mesh, and logs the results
+	/// </summary>
+	/// <param name="triangleCount">The approximate number of triangles to generate</param>
+	/// <param name="iterations">The number of times to run each path, the fastest time is reported</param>
+	static BenchmarkResult Benchmark(size_t triangleCount = 1000000, int iterations = 3);
+
+protected:
+	// The angle weighted tangent and bitangent that each triangle corner adds to it's vertex, projected onto the
+	// vertex normal's plane. Components are stored separately, and grouped by which corner of the triangle they
+	// are (all first corners, then all second corners...) so that the SIMD pass can write 4 triangles at once
+	struct CornerFrames {
+		size_t FaceCount;
+		std::vector<float> TangentX, TangentY, TangentZ;
+		std::vector<float> BiTangentX, BiTangentY, BiTangentZ;
+
+		void Resize(size_t faceCount);
+		size_t GetSlot(size_t corner) const { return (corner % 3) * FaceCount + corner / 3; }
+	};
+
+	static void _Calculate(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, size_t vertexCount,
+						   const uint32_t* indices, size_t indexCount, glm::vec3* tangents, glm::vec3* bitangents, bool multithreaded, bool simd);
+
+	/// <summary>
+	/// Normalizes the vertex normals in [begin, end), replacing missing or zero length normals with the
+	/// area weighted normal of the triangles around the vertex
+	/// </summary>
+	static void _ResolveNormals(const glm::vec3* positions, const glm::vec3* normals, const uint32_t* indices,
+								const std::vector<uint32_t>& cornerOffsets, const std::vector<uint32_t>& corners,
+								size_t begin, size_t end, glm::vec3* result);
+	/// <summary>
+	/// Calculates what each corner of the triangles in [begin, end) adds to it's vertex
+	/// </summary>
+	static void _CalculateCornersScalar(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, const uint32_t* indices,
+										size_t begin, size_t end, CornerFrames& frames);
+	static void _CalculateCornersSimd(const glm::vec3* positions, const glm::vec3* normals, const glm::vec2* uvs, const uint32_t* indices,
+									  size_t begin, size_t end, CornerFrames& frames);
+	/// <summary>
+	/// Sums the corners around each vertex in [begin, end), and builds the final tangent frame
+	/// </summary>
+	static void _ResolveVertices(const glm::vec3* normals, const CornerFrames& frames,
+								 const std::vector<uint32_t>& cornerOffsets, const std::vector<uint32_t>& corners,
+								 size_t begin, size_t end, glm::vec3* tangents, glm::vec3* bitangents);
+};
@@ -0,0 +1,153 @@
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+thread_local uint32_t ThreadPool::_workerIndex = ~0u;
+
+ThreadPool::ThreadPool(uint32_t numThreads) :
+	_workers(),
+	_jobs(),
+	_mutex(),
+	_signal(),
+	_isShuttingDown(false)
+{
+	// Leave a core for the main thread if we can
+	if (numThreads == 0) {
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	_workers.reserve(numThreads);
+	for (uint32_t ix = 0; ix < numThreads; ix++) {
+		_workers.emplace_back(&ThreadPool::_WorkerMain, this, ix);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isShuttingDown = true;
+	}
+	_signal.notify_all();
+
+	for (auto& worker : _workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t begin, size_t end)>& func, uint32_t maxThreads /*= 0*/) {
+	if (count == 0) {
+		return;
+	}
+
+	// Default to a few chunks per thread, so that uneven work still balances out
+	if (chunkSize == 0) {
+		size_t targetChunks = static_cast<size_t>(GetThreadCount() + 1) * 4;
+		chunkSize = std::max<size_t>(1, (count + targetChunks - 1) / targetChunks);
+	}
+	size_t numChunks = (count + chunkSize - 1) / chunkSize;
+
+	// Small ranges aren't worth the overhead of waking workers
+	if (numChunks == 1) {
+		func(0, count);
+		return;
+	}
+
+	// State shared between the caller and the helpers, helpers may outlive this call
+	// if they are only picked up after all the chunks were taken
+	struct SharedState {
+		std::atomic<size_t>     NextChunk{ 0 };
+		std::atomic<size_t>     CompletedChunks{ 0 };
+		std::mutex              Mutex;
+		std::condition_variable Signal;
+		// The first exception thrown by func, remaining chunks are skipped once this is set
+		std::atomic<bool>       Failed{ false };
+		std::exception_ptr      Error;
+	};
+	std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
+
+	// The caller counts as one of the threads
+	size_t maxHelpers = maxThreads == 0 ? GetThreadCount() : std::min<size_t>(GetThreadCount(), maxThreads - 1);
+
+	// Grabs chunks until there are none left, waking the caller when the last one is done. Chunks always count
+	// as complete, even if func throws, otherwise the caller would wait forever
+	auto work = [state, count, chunkSize, numChunks, maxHelpers, &func](bool isHelper) {
+		// Any worker may pick up a helper job, so workers past the limit leave the chunks to the others
+		if (isHelper && _workerIndex >= maxHelpers) {
+			return;
+		}
+
+		size_t chunk;
+		while ((chunk = state->NextChunk.fetch_add(1)) < numChunks) {
+			if (!state->Failed.load()) {
+				try {
+					size_t begin = chunk * chunkSize;
+					func(begin, std::min(begin + chunkSize, count));
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(state->Mutex);
+					if (state->Error == nullptr) {
+						state->Error = std::current_exception();
+					}
+					state->Failed = true;
+				}
+			}
+			if (state->CompletedChunks.fetch_add(1) + 1 == numChunks) {
+				std::lock_guard<std::mutex> lock(state->Mutex);
+				state->Signal.notify_all();
+			}
+		}
+	};
+
+	// Helpers only touch func while there are chunks left, and we don't return until all chunks
+	// are done, so capturing it by reference is safe
+	size_t numHelpers = std::min<size_t>(maxHelpers, numChunks - 1);
+	for (size_t ix = 0; ix < numHelpers; ix++) {
+		_Push([work]() { work(true); });
+	}
+
+	// The calling thread pitches in, this also means we can't deadlock if called from a worker
+	work(false);
+
+	std::unique_lock<std::mutex> lock(state->Mutex);
+	state->Signal.wait(lock, [&]() { return state->CompletedChunks.load() == numChunks; });
+
+	// Exceptions from the helpers are passed on to the caller, like they would have been if the loop ran serially
+	if (state->Error != nullptr) {
+		std::rethrow_exception(state->Error);
+	}
+}
+
+ThreadPool& ThreadPool::Get() {
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::_Push(std::function<void()>&& job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(std::move(job));
+	}
+	_signal.notify_one();
+}
+
+void ThreadPool::_WorkerMain(uint32_t index) {
+	_workerIndex = index;
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_signal.wait(lock, [this]() { return _isShuttingDown || !_jobs.empty(); });
+
+			// Only exit once the queue has been drained
+			if (_jobs.empty()) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+		job();
+	}
+}
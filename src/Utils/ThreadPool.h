@@ -0,0 +1,89 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A fixed size pool of worker threads that can run jobs in the background
+///
+/// Jobs are run in the order they are submitted. Most systems should use the
+/// shared pool via ThreadPool::Get() rather than spinning up their own threads
+/// </summary>
+class ThreadPool final {
+public:
+	MAKE_PTRS(ThreadPool);
+	NO_COPY(ThreadPool);
+	NO_MOVE(ThreadPool);
+
+	/// <summary>
+	/// Creates a new thread pool with the given number of workers
+	/// </summary>
+	/// <param name="numThreads">The number of workers to create, or 0 to use one less than the number of hardware threads</param>
+	ThreadPool(uint32_t numThreads = 0);
+	/// <summary>
+	/// Waits for all queued jobs to complete, then shuts down the workers
+	/// </summary>
+	~ThreadPool();
+
+	/// <summary>
+	/// Gets the number of worker threads in this pool
+	/// </summary>
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+	/// <summary>
+	/// Queues a job to run on one of the worker threads
+	/// </summary>
+	/// <param name="func">The function to run</param>
+	/// <returns>A future that will hold the result of the function</returns>
+	template <typename Func>
+	auto Enqueue(Func&& func) -> std::future<decltype(func())> {
+		typedef decltype(func()) ResultType;
+
+		// packaged_task is move-only, so we wrap it in a shared pointer to stuff it in a std::function
+		std::shared_ptr<std::packaged_task<ResultType()>> task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+		std::future<ResultType> result = task->get_future();
+		_Push([task]() { (*task)(); });
+		return result;
+	}
+
+	/// <summary>
+	/// Splits the range [0, count) into chunks, and invokes func on each chunk in parallel. The
+	/// calling thread will also process chunks, and this will block until all chunks are complete.
+	/// It is safe to call this from within a job running on the pool. If func throws, the remaining chunks
+	/// are skipped and the first exception is rethrown on the calling thread once all chunks are done
+	/// </summary>
+	/// <param name="count">The number of elements to process</param>
+	/// <param name="chunkSize">The number of elements to process per invocation, or 0 to pick one based on the thread count</param>
+	/// <param name="func">The function to invoke, with the half open range [begin, end) to process</param>
+	/// <param name="maxThreads">
+	/// The most threads (including the caller) that may ever run func, or 0 for no limit. Only the first maxThreads - 1
+	/// workers will help, for libraries that hand out per thread storage the first time a thread calls into them
+	/// </param>
+	void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t begin, size_t end)>& func, uint32_t maxThreads = 0);
+
+	/// <summary>
+	/// Gets the shared thread pool for the application, creating it on first use
+	/// </summary>
+	static ThreadPool& Get();
+
+protected:
+	std::vector<std::thread>          _workers;
+	std::deque<std::function<void()>> _jobs;
+	std::mutex                        _mutex;
+	std::condition_variable           _signal;
+	bool                              _isShuttingDown;
+
+	// The index of the worker running on this thread, or ~0u if this thread isn't a worker
+	static thread_local uint32_t _workerIndex;
+
+	void _Push(std::function<void()>&& job);
+	void _WorkerMain(uint32_t index);
+};